@@ -61,6 +61,9 @@ SOURCES += \
     $$PWD/../functions/fit/p_bestfitcylinderfrompoints.cpp \
     $$PWD/../functions/fit/p_bestfitcircleinplane.cpp \
     $$PWD/../functions/fit/p_bestfitsphere.cpp \
+    $$PWD/../functions/fit/gausshelmert.cpp \
+    $$PWD/../functions/fit/pointmoments.cpp \
+    $$PWD/../functions/systemTransformation/helmertsolver.cpp \
     $$PWD/../functions/fit/p_bestfitcircleinplanefrompoints.cpp \
     $$PWD/../cf/cfutil.cpp \
     $$PWD/../cf/cffunctiondata.cpp \
@@ -101,6 +104,10 @@ HEADERS += \
     $$PWD/../functions/fit/p_bestfitcylinderfrompoints.h \
     $$PWD/../functions/fit/p_bestfitcircleinplane.h \
     $$PWD/../functions/fit/p_bestfitsphere.h \
+    $$PWD/../functions/fit/gausshelmert.h \
+    $$PWD/../functions/fit/pointmoments.h \
+    $$PWD/../functions/fit/fixedmatrix.h \
+    $$PWD/../functions/systemTransformation/helmertsolver.h \
     $$PWD/../functions/fit/p_bestfitcircleinplanefrompoints.h \
     $$PWD/../treeutil.h \
     $$PWD/../cf/cfutil.h \
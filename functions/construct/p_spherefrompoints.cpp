@@ -60,75 +60,30 @@ bool SphereFromPoints::setUpResult(Sphere &sphere){
         return false;
     }
 
-    //calculate centroid coordinates
-    OiVec centroid(3);
+    //Drixler (normal equations accumulated in one pass, coordinates reduced to the first point)
+    PointMoments moments;
     for(int i = 0; i < inputPoints.size(); i++){
-        centroid = centroid + inputPoints.at(i)->getPosition().getVector();
+        moments.add(inputPoints.at(i)->getPosition().getVector());
     }
-    centroid = centroid / inputPoints.size();
+    fixed::Mat<4, 4> N;
+    fixed::Vec<4> n;
+    moments.getSphereNormalEquations(N, n);
 
-    //Drixler
-    OiMat N(4, 4);
-    OiVec n(4);
-    for(int i = 0; i < inputPoints.size(); i++){
-        double x = 0.0;
-        double y = 0.0;
-        double z = 0.0;
-
-        x = inputPoints.at(i)->getPosition().getVector().getAt(0) - centroid.getAt(0);
-        y = inputPoints.at(i)->getPosition().getVector().getAt(1) - centroid.getAt(1);
-        z = inputPoints.at(i)->getPosition().getVector().getAt(2) - centroid.getAt(2);
-
-        double xx = x*x;
-        double yy = y*y;
-        double zz = z*z;
-        double xy = x*y;
-        double xz = x*z;
-        double yz = y*z;
-        double xyz2 = x*x + y*y + z*z;
-
-        N.setAt(0,0, N.getAt(0,0) + xx);
-        N.setAt(0,1, N.getAt(0,1) + xy);
-        N.setAt(0,2, N.getAt(0,2) + xz);
-        N.setAt(0,3, N.getAt(0,3) + x);
-        N.setAt(1,0, N.getAt(1,0) + xy);
-        N.setAt(1,1, N.getAt(1,1) + yy);
-        N.setAt(1,2, N.getAt(1,2) + yz);
-        N.setAt(1,3, N.getAt(1,3) + y);
-        N.setAt(2,0, N.getAt(2,0) + xz);
-        N.setAt(2,1, N.getAt(2,1) + yz);
-        N.setAt(2,2, N.getAt(2,2) + zz);
-        N.setAt(2,3, N.getAt(2,3) + z);
-        N.setAt(3,0, N.getAt(3,0) + x);
-        N.setAt(3,1, N.getAt(3,1) + y);
-        N.setAt(3,2, N.getAt(3,2) + z);
-        N.setAt(3,3, N.getAt(3,3) + 1.0);
-
-        n.setAt(0, n.getAt(0) + x*xyz2);
-        n.setAt(1, n.getAt(1) + y*xyz2);
-        n.setAt(2, n.getAt(2) + z*xyz2);
-        n.setAt(3, n.getAt(3) + xyz2);
-    }
-
-    OiMat Q(4,4);
-    try{
-        Q = N.inv();
-    }catch(exception &e){
-        emit this->sendMessage(e.what(), eErrorMessage);
+    fixed::Vec<4> a;
+    if(!fixed::solveSymmetric(N, -1.0 * n, a)){
+        emit this->sendMessage(QString("Cannot solve the normal equations of sphere %1").arg(sphere.getFeatureName()), eErrorMessage);
         return false;
     }
 
-    OiVec a = -1.0 * Q * n;
-
     double r = 0.0;
     double xm = 0.0;
     double ym = 0.0;
     double zm = 0.0;
 
     r = qSqrt( qAbs( 0.25 * (a.getAt(0)*a.getAt(0) + a.getAt(1)*a.getAt(1) + a.getAt(2)*a.getAt(2)) - a.getAt(3) ) );
-    xm = -0.5 * a.getAt(0) + centroid.getAt(0);
-    ym = -0.5 * a.getAt(1) + centroid.getAt(1);
-    zm = -0.5 * a.getAt(2) + centroid.getAt(2);
+    xm = -0.5 * a.getAt(0) + moments.getReference(0);
+    ym = -0.5 * a.getAt(1) + moments.getReference(1);
+    zm = -0.5 * a.getAt(2) + moments.getReference(2);
 
     //set approximate result
     Position position;
@@ -8,6 +8,7 @@
 #include "constructfunction.h"
 #include "oivec.h"
 #include "oimat.h"
+#include "pointmoments.h"
 
 using namespace oi;
 
@@ -0,0 +1,662 @@
+#ifndef FIXEDMATRIX_H
+#define FIXEDMATRIX_H
+
+#include <cmath>
+
+#include "oivec.h"
+#include "oimat.h"
+
+/*!
+ * Small matrices and vectors whose dimensions are known at compile time (3x3 rotations, 4x4 homogeneous matrices,
+ * 6x6 / 7x7 normal equations). They live on the stack and all loops have constant bounds, so the compiler can unroll
+ * and inline them. Use OiMat / OiVec at the API boundary (toOiMat, toOiVec and the converting constructors) and for
+ * everything whose size depends on the number of observations.
+ */
+namespace fixed{
+
+/*!
+ * \brief The Vec class
+ * Column vector with N elements (zero initialized)
+ */
+template<int N>
+class Vec
+{
+public:
+    static constexpr int size = N;
+
+    Vec(){
+        for(int i = 0; i < N; i++){
+            this->v[i] = 0.0;
+        }
+    }
+
+    //! \brief Copies the first N elements of the given vector (e.g. x, y, z of a homogeneous vector)
+    explicit Vec(const oi::OiVec &vec){
+        for(int i = 0; i < N; i++){
+            this->v[i] = vec.getAt(i);
+        }
+    }
+
+    //! \brief Returns the vector as OiVec
+    oi::OiVec toOiVec() const{
+        oi::OiVec result(N);
+        for(int i = 0; i < N; i++){
+            result.setAt(i, this->v[i]);
+        }
+        return result;
+    }
+
+    inline int getSize() const{
+        return N;
+    }
+
+    inline double getAt(const int &i) const{
+        return this->v[i];
+    }
+
+    inline void setAt(const int &i, const double &value){
+        this->v[i] = value;
+    }
+
+    inline double &operator()(const int &i){
+        return this->v[i];
+    }
+
+    inline const double &operator()(const int &i) const{
+        return this->v[i];
+    }
+
+    inline Vec &operator+=(const Vec &other){
+        for(int i = 0; i < N; i++){
+            this->v[i] += other.v[i];
+        }
+        return *this;
+    }
+
+    inline Vec &operator-=(const Vec &other){
+        for(int i = 0; i < N; i++){
+            this->v[i] -= other.v[i];
+        }
+        return *this;
+    }
+
+    inline Vec &operator*=(const double &s){
+        for(int i = 0; i < N; i++){
+            this->v[i] *= s;
+        }
+        return *this;
+    }
+
+    inline Vec operator+(const Vec &other) const{
+        Vec result(*this);
+        return result += other;
+    }
+
+    inline Vec operator-(const Vec &other) const{
+        Vec result(*this);
+        return result -= other;
+    }
+
+    inline Vec operator*(const double &s) const{
+        Vec result(*this);
+        return result *= s;
+    }
+
+    inline Vec operator/(const double &s) const{
+        Vec result(*this);
+        return result *= 1.0 / s;
+    }
+
+    //! \brief Returns the scalar product
+    inline double dot(const Vec &other) const{
+        double sum = 0.0;
+        for(int i = 0; i < N; i++){
+            sum += this->v[i] * other.v[i];
+        }
+        return sum;
+    }
+
+    //! \brief Returns the euclidean length
+    inline double norm() const{
+        return std::sqrt(this->dot(*this));
+    }
+
+private:
+    double v[N];
+
+};
+
+template<int N>
+inline Vec<N> operator*(const double &s, const Vec<N> &vec){
+    return vec * s;
+}
+
+//! \brief Returns the cross product a x b
+inline Vec<3> cross(const Vec<3> &a, const Vec<3> &b){
+    Vec<3> result;
+    result(0) = a(1) * b(2) - a(2) * b(1);
+    result(1) = a(2) * b(0) - a(0) * b(2);
+    result(2) = a(0) * b(1) - a(1) * b(0);
+    return result;
+}
+
+//! \brief Returns the homogeneous vector (x, y, z, 1) of the first three elements of the given vector
+inline Vec<4> homogeneous(const oi::OiVec &xyz){
+    Vec<4> result;
+    result(0) = xyz.getAt(0);
+    result(1) = xyz.getAt(1);
+    result(2) = xyz.getAt(2);
+    result(3) = 1.0;
+    return result;
+}
+
+/*!
+ * \brief The Mat class
+ * R x C matrix stored row major (zero initialized)
+ */
+template<int R, int C>
+class Mat
+{
+public:
+    static constexpr int rows = R;
+    static constexpr int cols = C;
+
+    Mat(){
+        for(int i = 0; i < R * C; i++){
+            this->m[i] = 0.0;
+        }
+    }
+
+    //! \brief Copies the upper left R x C block of the given matrix
+    explicit Mat(const oi::OiMat &mat){
+        for(int i = 0; i < R; i++){
+            for(int j = 0; j < C; j++){
+                this->m[i*C+j] = mat.getAt(i, j);
+            }
+        }
+    }
+
+    //! \brief Returns the identity matrix
+    static Mat identity(){
+        Mat result;
+        for(int i = 0; i < R && i < C; i++){
+            result.m[i*C+i] = 1.0;
+        }
+        return result;
+    }
+
+    //! \brief Returns the matrix as OiMat
+    oi::OiMat toOiMat() const{
+        oi::OiMat result(R, C);
+        for(int i = 0; i < R; i++){
+            for(int j = 0; j < C; j++){
+                result.setAt(i, j, this->m[i*C+j]);
+            }
+        }
+        return result;
+    }
+
+    inline int getRowCount() const{
+        return R;
+    }
+
+    inline int getColCount() const{
+        return C;
+    }
+
+    inline double getAt(const int &i, const int &j) const{
+        return this->m[i*C+j];
+    }
+
+    inline void setAt(const int &i, const int &j, const double &value){
+        this->m[i*C+j] = value;
+    }
+
+    inline double &operator()(const int &i, const int &j){
+        return this->m[i*C+j];
+    }
+
+    inline const double &operator()(const int &i, const int &j) const{
+        return this->m[i*C+j];
+    }
+
+    //! \brief Returns the column j
+    inline Vec<R> getCol(const int &j) const{
+        Vec<R> result;
+        for(int i = 0; i < R; i++){
+            result(i) = this->m[i*C+j];
+        }
+        return result;
+    }
+
+    //! \brief Returns the transposed matrix
+    inline Mat<C, R> t() const{
+        Mat<C, R> result;
+        for(int i = 0; i < R; i++){
+            for(int j = 0; j < C; j++){
+                result(j, i) = this->m[i*C+j];
+            }
+        }
+        return result;
+    }
+
+    inline Mat &operator+=(const Mat &other){
+        for(int i = 0; i < R * C; i++){
+            this->m[i] += other.m[i];
+        }
+        return *this;
+    }
+
+    inline Mat &operator-=(const Mat &other){
+        for(int i = 0; i < R * C; i++){
+            this->m[i] -= other.m[i];
+        }
+        return *this;
+    }
+
+    inline Mat &operator*=(const double &s){
+        for(int i = 0; i < R * C; i++){
+            this->m[i] *= s;
+        }
+        return *this;
+    }
+
+    inline Mat operator+(const Mat &other) const{
+        Mat result(*this);
+        return result += other;
+    }
+
+    inline Mat operator-(const Mat &other) const{
+        Mat result(*this);
+        return result -= other;
+    }
+
+    inline Mat operator*(const double &s) const{
+        Mat result(*this);
+        return result *= s;
+    }
+
+    template<int K>
+    inline Mat<R, K> operator*(const Mat<C, K> &other) const{
+        Mat<R, K> result;
+        for(int i = 0; i < R; i++){
+            for(int k = 0; k < C; k++){
+                const double mik = this->m[i*C+k];
+                for(int j = 0; j < K; j++){
+                    result(i, j) += mik * other(k, j);
+                }
+            }
+        }
+        return result;
+    }
+
+    inline Vec<R> operator*(const Vec<C> &vec) const{
+        Vec<R> result;
+        for(int i = 0; i < R; i++){
+            double sum = 0.0;
+            for(int j = 0; j < C; j++){
+                sum += this->m[i*C+j] * vec(j);
+            }
+            result(i) = sum;
+        }
+        return result;
+    }
+
+private:
+    double m[R * C];
+
+};
+
+template<int R, int C>
+inline Mat<R, C> operator*(const double &s, const Mat<R, C> &mat){
+    return mat * s;
+}
+
+/*!
+ * \brief addNormalEquations
+ * Adds the contribution of a block of observations to normal equations: n += a^T * a and c += a^T * l.
+ * Only the upper triangle of n is summed up and mirrored afterwards.
+ * \param n
+ * \param c
+ * \param a
+ * \param l
+ */
+template<int R, int U>
+inline void addNormalEquations(Mat<U, U> &n, Vec<U> &c, const Mat<R, U> &a, const Vec<R> &l){
+    for(int i = 0; i < U; i++){
+        for(int j = i; j < U; j++){
+            double sum = 0.0;
+            for(int k = 0; k < R; k++){
+                sum += a(k, i) * a(k, j);
+            }
+            n(i, j) += sum;
+            if(j != i){
+                n(j, i) = n(i, j);
+            }
+        }
+        double sum = 0.0;
+        for(int k = 0; k < R; k++){
+            sum += a(k, i) * l(k);
+        }
+        c(i) += sum;
+    }
+}
+
+/*!
+ * \brief cholesky
+ * Cholesky decomposition a = l * l^T of a symmetric positive definite matrix
+ * \param a
+ * \param l lower triangular matrix
+ * \return false if a is not (numerically) positive definite
+ */
+template<int N>
+bool cholesky(const Mat<N, N> &a, Mat<N, N> &l){
+    l = Mat<N, N>();
+    for(int j = 0; j < N; j++){
+        double d = a(j, j);
+        for(int k = 0; k < j; k++){
+            d -= l(j, k) * l(j, k);
+        }
+        if(!(d > 1e-14 * std::fabs(a(j, j)))){
+            return false;
+        }
+        const double ljj = std::sqrt(d);
+        l(j, j) = ljj;
+        for(int i = j + 1; i < N; i++){
+            double sum = a(i, j);
+            for(int k = 0; k < j; k++){
+                sum -= l(i, k) * l(j, k);
+            }
+            l(i, j) = sum / ljj;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief ldlt
+ * LDL^T decomposition a = l * diag(d) * l^T of a symmetric matrix (no square roots, d may be negative)
+ * \param a
+ * \param l unit lower triangular matrix
+ * \param d
+ * \return false if a pivot vanishes
+ */
+template<int N>
+bool ldlt(const Mat<N, N> &a, Mat<N, N> &l, Vec<N> &d){
+    l = Mat<N, N>::identity();
+    for(int j = 0; j < N; j++){
+        double dj = a(j, j);
+        for(int k = 0; k < j; k++){
+            dj -= l(j, k) * l(j, k) * d(k);
+        }
+        if(!(std::fabs(dj) > 1e-14 * std::fabs(a(j, j)))){
+            return false;
+        }
+        d(j) = dj;
+        for(int i = j + 1; i < N; i++){
+            double sum = a(i, j);
+            for(int k = 0; k < j; k++){
+                sum -= l(i, k) * l(j, k) * d(k);
+            }
+            l(i, j) = sum / dj;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief solveSymmetric
+ * Solves a * x = b for a symmetric matrix a (LDL^T)
+ * \param a
+ * \param b
+ * \param x
+ * \return false if a is singular
+ */
+template<int N>
+bool solveSymmetric(const Mat<N, N> &a, const Vec<N> &b, Vec<N> &x){
+    Mat<N, N> l;
+    Vec<N> d;
+    if(!ldlt(a, l, d)){
+        return false;
+    }
+    //l * y = b
+    for(int i = 0; i < N; i++){
+        double sum = b(i);
+        for(int k = 0; k < i; k++){
+            sum -= l(i, k) * x(k);
+        }
+        x(i) = sum;
+    }
+    //diag(d) * l^T * x = y
+    for(int i = N - 1; i >= 0; i--){
+        double sum = x(i) / d(i);
+        for(int k = i + 1; k < N; k++){
+            sum -= l(k, i) * x(k);
+        }
+        x(i) = sum;
+    }
+    return true;
+}
+
+/*!
+ * \brief solvePositiveDefinite
+ * Solves a * x = b for a symmetric positive definite matrix a (Cholesky), e.g. the normal equations of a fit
+ * \param a
+ * \param b
+ * \param x
+ * \return false if a is not (numerically) positive definite
+ */
+template<int N>
+bool solvePositiveDefinite(const Mat<N, N> &a, const Vec<N> &b, Vec<N> &x){
+    Mat<N, N> l;
+    if(!cholesky(a, l)){
+        return false;
+    }
+    //l * y = b
+    for(int i = 0; i < N; i++){
+        double sum = b(i);
+        for(int k = 0; k < i; k++){
+            sum -= l(i, k) * x(k);
+        }
+        x(i) = sum / l(i, i);
+    }
+    //l^T * x = y
+    for(int i = N - 1; i >= 0; i--){
+        double sum = x(i);
+        for(int k = i + 1; k < N; k++){
+            sum -= l(k, i) * x(k);
+        }
+        x(i) = sum / l(i, i);
+    }
+    return true;
+}
+
+/*!
+ * \brief solve
+ * Solves a * x = b for a general matrix a (Gaussian elimination with partial pivoting)
+ * \param a
+ * \param b
+ * \param x
+ * \return false if a is singular
+ */
+template<int N>
+bool solve(const Mat<N, N> &a, const Vec<N> &b, Vec<N> &x){
+    Mat<N, N> m = a;
+    Vec<N> c = b;
+    for(int j = 0; j < N; j++){
+        int pivot = j;
+        for(int i = j + 1; i < N; i++){
+            if(std::fabs(m(i, j)) > std::fabs(m(pivot, j))){
+                pivot = i;
+            }
+        }
+        if(!(std::fabs(m(pivot, j)) > 0.0)){
+            return false;
+        }
+        if(pivot != j){
+            for(int k = j; k < N; k++){
+                const double value = m(j, k);
+                m(j, k) = m(pivot, k);
+                m(pivot, k) = value;
+            }
+            const double value = c(j);
+            c(j) = c(pivot);
+            c(pivot) = value;
+        }
+        for(int i = j + 1; i < N; i++){
+            const double factor = m(i, j) / m(j, j);
+            for(int k = j; k < N; k++){
+                m(i, k) -= factor * m(j, k);
+            }
+            c(i) -= factor * c(j);
+        }
+    }
+    for(int i = N - 1; i >= 0; i--){
+        double sum = c(i);
+        for(int k = i + 1; k < N; k++){
+            sum -= m(i, k) * x(k);
+        }
+        x(i) = sum / m(i, i);
+    }
+    return true;
+}
+
+/*!
+ * \brief invertSymmetric
+ * Inverts a symmetric positive definite matrix (e.g. normal equations) by its Cholesky decomposition
+ * \param a
+ * \param inverse
+ * \return false if a is not (numerically) positive definite
+ */
+template<int N>
+bool invertSymmetric(const Mat<N, N> &a, Mat<N, N> &inverse){
+    Mat<N, N> l;
+    if(!cholesky(a, l)){
+        return false;
+    }
+    //l^-1 (lower triangular)
+    Mat<N, N> li;
+    for(int j = 0; j < N; j++){
+        li(j, j) = 1.0 / l(j, j);
+        for(int i = j + 1; i < N; i++){
+            double sum = 0.0;
+            for(int k = j; k < i; k++){
+                sum -= l(i, k) * li(k, j);
+            }
+            li(i, j) = sum / l(i, i);
+        }
+    }
+    //a^-1 = l^-T * l^-1
+    for(int i = 0; i < N; i++){
+        for(int j = i; j < N; j++){
+            double sum = 0.0;
+            for(int k = j; k < N; k++){
+                sum += li(k, i) * li(k, j);
+            }
+            inverse(i, j) = sum;
+            inverse(j, i) = sum;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief eigenSymmetric
+ * Eigenvalues and eigenvectors of a small symmetric matrix (cyclic Jacobi rotations), meant for the 3x3 scatter
+ * matrices of the fit functions and the 4x4 matrices of the quaternion approaches. The eigenvalues are sorted in
+ * descending order like the singular values of OiMat::svd, so that the last column of vectors belongs to the smallest
+ * eigenvalue.
+ * \param a
+ * \param values
+ * \param vectors eigenvectors (columns)
+ * \return false if the rotations did not converge
+ */
+template<int N>
+bool eigenSymmetric(const Mat<N, N> &a, Vec<N> &values, Mat<N, N> &vectors){
+
+    Mat<N, N> d = a;
+    vectors = Mat<N, N>::identity();
+
+    bool converged = false;
+    for(int sweep = 0; sweep < 50 && !converged; sweep++){
+
+        double offDiagonal = 0.0;
+        double diagonal = 0.0;
+        for(int i = 0; i < N; i++){
+            diagonal += d(i, i) * d(i, i);
+            for(int j = i + 1; j < N; j++){
+                offDiagonal += d(i, j) * d(i, j);
+            }
+        }
+        if(offDiagonal <= 1e-30 * diagonal || offDiagonal == 0.0){
+            converged = true;
+            break;
+        }
+
+        for(int p = 0; p < N - 1; p++){
+            for(int q = p + 1; q < N; q++){
+                const double apq = d(p, q);
+                if(apq == 0.0){
+                    continue;
+                }
+
+                //rotation that eliminates d(p, q)
+                const double theta = (d(q, q) - d(p, p)) / (2.0 * apq);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+
+                for(int k = 0; k < N; k++){
+                    const double dkp = d(k, p);
+                    const double dkq = d(k, q);
+                    d(k, p) = c * dkp - s * dkq;
+                    d(k, q) = s * dkp + c * dkq;
+                }
+                for(int k = 0; k < N; k++){
+                    const double dpk = d(p, k);
+                    const double dqk = d(q, k);
+                    d(p, k) = c * dpk - s * dqk;
+                    d(q, k) = s * dpk + c * dqk;
+                }
+                for(int k = 0; k < N; k++){
+                    const double vkp = vectors(k, p);
+                    const double vkq = vectors(k, q);
+                    vectors(k, p) = c * vkp - s * vkq;
+                    vectors(k, q) = s * vkp + c * vkq;
+                }
+            }
+        }
+
+    }
+
+    for(int i = 0; i < N; i++){
+        values(i) = d(i, i);
+    }
+
+    //sort descending (selection sort, N is small)
+    for(int i = 0; i < N - 1; i++){
+        int maxIndex = i;
+        for(int j = i + 1; j < N; j++){
+            if(values(j) > values(maxIndex)){
+                maxIndex = j;
+            }
+        }
+        if(maxIndex != i){
+            const double value = values(i);
+            values(i) = values(maxIndex);
+            values(maxIndex) = value;
+            for(int k = 0; k < N; k++){
+                const double vki = vectors(k, i);
+                vectors(k, i) = vectors(k, maxIndex);
+                vectors(k, maxIndex) = vki;
+            }
+        }
+    }
+
+    return converged;
+
+}
+
+}
+
+#endif // FIXEDMATRIX_H
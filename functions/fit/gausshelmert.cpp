@@ -0,0 +1,263 @@
+#include "gausshelmert.h"
+
+#include <cmath>
+#include <algorithm>
+#include <exception>
+
+/*!
+ * \brief GaussHelmert::GaussHelmert
+ * \param numUnknowns number of unknowns u
+ * \param numConditions number of conditions of each observation
+ * \param numComponents number of components of each observation
+ */
+GaussHelmert::GaussHelmert(const int &numUnknowns, const int &numConditions, const int &numComponents)
+    : numUnknowns(numUnknowns), numConditions(numConditions), numComponents(numComponents), numObservations(0),
+      dx(numUnknowns), qxx(numUnknowns, numUnknowns),
+      scratchP(numConditions * numConditions), scratchInverse(numConditions * numConditions),
+      scratchPA(numConditions * numUnknowns), scratchPW(numConditions), scratchK(numConditions){
+    this->clear();
+}
+
+/*!
+ * \brief GaussHelmert::clear
+ * Removes all observations and constraints (e.g. to start the next iteration)
+ */
+void GaussHelmert::clear(){
+
+    this->numObservations = 0;
+    this->a.clear();
+    this->b.clear();
+    this->w.clear();
+    this->p.clear();
+    this->n.assign(this->numUnknowns * this->numUnknowns, 0.0);
+    this->nw.assign(this->numUnknowns, 0.0);
+    this->constraints.clear();
+    this->constraintMisclosures.clear();
+    this->v.clear();
+    this->errorMessage.clear();
+
+}
+
+/*!
+ * \brief GaussHelmert::reserve
+ * Allocates the memory for the given number of observations
+ * \param numObservations
+ */
+void GaussHelmert::reserve(const int &numObservations){
+
+    this->a.reserve(numObservations * this->numConditions * this->numUnknowns);
+    this->b.reserve(numObservations * this->numConditions * this->numComponents);
+    this->w.reserve(numObservations * this->numConditions);
+    this->p.reserve(numObservations * this->numConditions * this->numConditions);
+    this->v.reserve(numObservations * this->numComponents);
+
+}
+
+/*!
+ * \brief GaussHelmert::addObservation
+ * Adds the linearized conditions of one observation and updates the reduced normal equations
+ * \param a numConditions x numUnknowns (row major)
+ * \param b numConditions x numComponents (row major)
+ * \param w numConditions misclosures
+ * \return false if B_i * B_i^T is singular
+ */
+bool GaussHelmert::addObservation(const double *a, const double *b, const double *w){
+
+    const int r = this->numConditions;
+    const int u = this->numUnknowns;
+    const int c = this->numComponents;
+
+    //P_i = (B_i * B_i^T)^-1
+    double *pi = this->scratchP.data();
+    for(int i = 0; i < r; i++){
+        for(int j = 0; j < r; j++){
+            double sum = 0.0;
+            for(int k = 0; k < c; k++){
+                sum += b[i*c+k] * b[j*c+k];
+            }
+            pi[i*r+j] = sum;
+        }
+    }
+    if(!GaussHelmert::invertSymmetric(pi, this->scratchInverse.data(), r)){
+        this->errorMessage = QString("The conditions of observation %1 are singular").arg(this->numObservations);
+        return false;
+    }
+
+    //N += A_i^T * P_i * A_i and nw += A_i^T * P_i * w_i
+    double *pa = this->scratchPA.data();
+    double *pw = this->scratchPW.data();
+    std::fill(pa, pa + r * u, 0.0);
+    std::fill(pw, pw + r, 0.0);
+    for(int i = 0; i < r; i++){
+        for(int k = 0; k < r; k++){
+            const double pik = pi[i*r+k];
+            for(int j = 0; j < u; j++){
+                pa[i*u+j] += pik * a[k*u+j];
+            }
+            pw[i] += pik * w[k];
+        }
+    }
+    for(int i = 0; i < r; i++){
+        for(int j = 0; j < u; j++){
+            const double aij = a[i*u+j];
+            for(int k = 0; k < u; k++){
+                this->n[j*u+k] += aij * pa[i*u+k];
+            }
+            this->nw[j] += aij * pw[i];
+        }
+    }
+
+    this->a.insert(this->a.end(), a, a + r * u);
+    this->b.insert(this->b.end(), b, b + r * c);
+    this->w.insert(this->w.end(), w, w + r);
+    this->p.insert(this->p.end(), pi, pi + r * r);
+    this->numObservations++;
+
+    return true;
+
+}
+
+/*!
+ * \brief GaussHelmert::addConstraint
+ * Adds a condition C * dx + g = 0 between the unknowns
+ * \param c numUnknowns coefficients
+ * \param g misclosure
+ */
+void GaussHelmert::addConstraint(const double *c, const double &g){
+    this->constraints.insert(this->constraints.end(), c, c + this->numUnknowns);
+    this->constraintMisclosures.push_back(g);
+}
+
+/*!
+ * \brief GaussHelmert::solve
+ * Solves the reduced normal equations (bordered by the constraints) for the increments of the unknowns and computes
+ * the corrections v_i = -B_i^T * P_i * (A_i * dx + w_i) of all observations
+ * \return false if the normal equations are singular
+ */
+bool GaussHelmert::solve(){
+
+    const int r = this->numConditions;
+    const int u = this->numUnknowns;
+    const int c = this->numComponents;
+    const int s = this->constraintMisclosures.size();
+
+    //[N C^T; C 0] * [dx; k] = [-nw; -g]
+    OiMat N(u + s, u + s);
+    OiVec rhs(u + s);
+    for(int i = 0; i < u; i++){
+        for(int j = 0; j < u; j++){
+            N.setAt(i, j, this->n[i*u+j]);
+        }
+        rhs.setAt(i, -this->nw[i]);
+    }
+    for(int i = 0; i < s; i++){
+        for(int j = 0; j < u; j++){
+            N.setAt(u + i, j, this->constraints[i*u+j]);
+            N.setAt(j, u + i, this->constraints[i*u+j]);
+        }
+        rhs.setAt(u + i, -this->constraintMisclosures[i]);
+    }
+
+    OiMat Q(u + s, u + s);
+    try{
+        Q = N.inv();
+    }catch(exception &e){
+        this->errorMessage = e.what();
+        return false;
+    }
+
+    OiVec x = Q * rhs;
+    for(int i = 0; i < u; i++){
+        if(std::isnan(x.getAt(i))){
+            this->errorMessage = "The normal equations are singular";
+            return false;
+        }
+        this->dx.setAt(i, x.getAt(i));
+        for(int j = 0; j < u; j++){
+            this->qxx.setAt(i, j, Q.getAt(i, j));
+        }
+    }
+
+    //corrections of the observations
+    this->v.assign(this->numObservations * c, 0.0);
+    double *k = this->scratchK.data();
+    for(int o = 0; o < this->numObservations; o++){
+        const double *ai = &this->a[o*r*u];
+        const double *bi = &this->b[o*r*c];
+        const double *wi = &this->w[o*r];
+        const double *pi = &this->p[o*r*r];
+
+        for(int i = 0; i < r; i++){
+            double misclosure = wi[i];
+            for(int j = 0; j < u; j++){
+                misclosure += ai[i*u+j] * this->dx.getAt(j);
+            }
+            k[i] = misclosure;
+        }
+        for(int j = 0; j < c; j++){
+            double vj = 0.0;
+            for(int i = 0; i < r; i++){
+                double pk = 0.0;
+                for(int l = 0; l < r; l++){
+                    pk += pi[i*r+l] * k[l];
+                }
+                vj -= bi[i*c+j] * pk;
+            }
+            this->v[o*c+j] = vj;
+        }
+    }
+
+    return true;
+
+}
+
+/*!
+ * \brief GaussHelmert::invertSymmetric
+ * Inverts a small symmetric positive definite matrix in place (Gauss-Jordan without pivoting)
+ * \param m size x size (row major)
+ * \param inverse size x size scratch buffer
+ * \param size
+ * \return false if the matrix is singular
+ */
+bool GaussHelmert::invertSymmetric(double *m, double *inverse, const int &size){
+
+    //1x1 blocks (one condition per observation) are the common case
+    if(size == 1){
+        if(m[0] <= 0.0){
+            return false;
+        }
+        m[0] = 1.0 / m[0];
+        return true;
+    }
+
+    double *inv = inverse;
+    std::fill(inv, inv + size * size, 0.0);
+    for(int i = 0; i < size; i++){
+        inv[i*size+i] = 1.0;
+    }
+    for(int i = 0; i < size; i++){
+        const double pivot = m[i*size+i];
+        if(pivot <= 0.0){
+            return false;
+        }
+        for(int j = 0; j < size; j++){
+            m[i*size+j] /= pivot;
+            inv[i*size+j] /= pivot;
+        }
+        for(int k = 0; k < size; k++){
+            if(k == i){
+                continue;
+            }
+            const double factor = m[k*size+i];
+            for(int j = 0; j < size; j++){
+                m[k*size+j] -= factor * m[i*size+j];
+                inv[k*size+j] -= factor * inv[i*size+j];
+            }
+        }
+    }
+    for(int i = 0; i < size * size; i++){
+        m[i] = inv[i];
+    }
+    return true;
+
+}
@@ -0,0 +1,100 @@
+#ifndef GAUSSHELMERT_H
+#define GAUSSHELMERT_H
+
+#include <QString>
+#include <vector>
+
+#include "oivec.h"
+#include "oimat.h"
+
+using namespace oi;
+using namespace std;
+
+/*!
+ * \brief The GaussHelmert class
+ * One linearized step of a Gauss-Helmert adjustment A * dx + B * v + w = 0 (Qll = I) for models whose conditions only
+ * depend on one observation each. B is then block diagonal (one numConditions x numComponents block per observation),
+ * so that B * B^T is block diagonal, too, and the normal equations N = sum(A_i^T * (B_i * B_i^T)^-1 * A_i) are reduced
+ * to numUnknowns x numUnknowns while the observations are added. A step costs O(n) time and memory instead of
+ * inverting the dense (n + u) x (n + u) bordered system.
+ * Additional conditions between the unknowns C * dx + g = 0 may be added with addConstraint.
+ */
+class GaussHelmert
+{
+public:
+    GaussHelmert(const int &numUnknowns, const int &numConditions, const int &numComponents);
+
+    void clear();
+    void reserve(const int &numObservations);
+
+    bool addObservation(const double *a, const double *b, const double *w);
+    void addConstraint(const double *c, const double &g);
+
+    bool solve();
+
+    //! \brief Returns the number of observations added since the last clear
+    inline int getObservationCount() const{
+        return this->numObservations;
+    }
+
+    //! \brief Returns the estimated increments of the unknowns
+    inline const OiVec &getDx() const{
+        return this->dx;
+    }
+
+    //! \brief Returns the cofactor matrix of the unknowns
+    inline const OiMat &getQxx() const{
+        return this->qxx;
+    }
+
+    //! \brief Returns the correction of the given component of an observation
+    inline double getV(const int &observation, const int &component) const{
+        return this->v[observation * this->numComponents + component];
+    }
+
+    //! \brief Returns the corrections of all observations (numComponents values per observation)
+    inline const vector<double> &getV() const{
+        return this->v;
+    }
+
+    //! \brief Returns the reason why addObservation or solve failed
+    inline const QString &getErrorMessage() const{
+        return this->errorMessage;
+    }
+
+private:
+    static bool invertSymmetric(double *m, double *inverse, const int &size);
+
+    int numUnknowns; //u
+    int numConditions; //conditions per observation
+    int numComponents; //components per observation (e.g. 3 for x, y, z)
+    int numObservations;
+
+    //blocks of all observations (needed to compute the corrections after the unknowns were solved)
+    vector<double> a; //numConditions x numUnknowns per observation
+    vector<double> b; //numConditions x numComponents per observation
+    vector<double> w; //numConditions per observation
+    vector<double> p; //(B_i * B_i^T)^-1, numConditions x numConditions per observation
+
+    //reduced normal equations
+    vector<double> n; //numUnknowns x numUnknowns
+    vector<double> nw; //A^T * P * w
+    vector<double> constraints; //numUnknowns values per constraint
+    vector<double> constraintMisclosures;
+
+    OiVec dx;
+    OiMat qxx;
+    vector<double> v;
+
+    //scratch buffers of addObservation and solve (sized once in the constructor to avoid allocations per observation)
+    vector<double> scratchP; //numConditions x numConditions
+    vector<double> scratchInverse; //numConditions x numConditions
+    vector<double> scratchPA; //numConditions x numUnknowns
+    vector<double> scratchPW; //numConditions
+    vector<double> scratchK; //numConditions
+
+    QString errorMessage;
+
+};
+
+#endif // GAUSSHELMERT_H
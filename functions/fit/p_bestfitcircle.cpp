@@ -97,124 +97,116 @@ bool BestFitCircle::exec(Circle &circle) {
 
 
 
+    // B*B^T ist blockdiagonal (2x2 je Punkt), daher werden die Normalgleichungen punktweise aufgebaut (siehe GaussHelmert).
+    // Vorzeichen: GaussHelmert loest A*du + B*v + w = 0, hier gilt B*v = A*du - w, daher werden -B und -w uebergeben.
     OiVec v(3*obsCount);
     OiMat Qxx(8,8);
 
-    OiMat A(2*obsCount, 8);
-    OiMat B(2*obsCount, 3*obsCount);
-    OiVec w(2*obsCount);
-    OiMat Pww(2*obsCount, 2*obsCount);
-    OiMat NGL(8, 8);
-    OiVec ngl(8);
-    OiMat NGLR(10, 10);
-    OiMat QxxR(10, 10);
-    OiVec nglr(10);
-    OiVec du(8);
-    OiVec duk(10);
+    GaussHelmert gaussHelmert(8, 2, 3);
+    gaussHelmert.reserve(obsCount);
+
+    double a[2*8];
+    double b[2*3];
+    double w[2];
+    double c[8];
 
     int iterations = 0;
     while(true){
 
+        gaussHelmert.clear();
         for(int i=0; i<obsCount; i++){
             double xP = x[i] - v.getAt(3*i);
             double yP = y[i] - v.getAt(3*i+1);
             double zP = z[i] - v.getAt(3*i+2);
 
+            for (int j=0; j<2*8; j++)
+                a[j] = 0.0;
+
             // Kugelparameter
-            A.setAt(i, Circle::unknownCenterX, -2.0*(xP - xc));
-            A.setAt(i, Circle::unknownCenterY, -2.0*(yP - yc));
-            A.setAt(i, Circle::unknownCenterZ, -2.0*(zP - zc));
-            A.setAt(i, Circle::unknownRadius, -2.0*rc);
-            //A.setAt(i, Circle::unknownNormalI, 0.0);
-            //A.setAt(i, Circle::unknownNormalJ, 0.0);
-            //A.setAt(i, Circle::unknownNormalK, 0.0);
-            //A.setAt(i, 7, 0.0);
+            a[Circle::unknownCenterX] = -2.0*(xP - xc);
+            a[Circle::unknownCenterY] = -2.0*(yP - yc);
+            a[Circle::unknownCenterZ] = -2.0*(zP - zc);
+            a[Circle::unknownRadius]  = -2.0*rc;
 
-            B.setAt(i, i*3,   2.0*(xP - xc));
-            B.setAt(i, i*3+1, 2.0*(yP - yc));
-            B.setAt(i, i*3+2, 2.0*(zP - zc));
+            b[0] = 2.0*(xP - xc);
+            b[1] = 2.0*(yP - yc);
+            b[2] = 2.0*(zP - zc);
 
-            w.setAt(i, rc*rc - ((xP-xc)*(xP-xc) + (yP-yc)*(yP-yc) + (zP-zc)*(zP-zc)));
+            w[0] = rc*rc - ((xP-xc)*(xP-xc) + (yP-yc)*(yP-yc) + (zP-zc)*(zP-zc));
 
             // Ebene in Normalform
-            //A.setAt(obsCount+i, 0.0);
-            //A.setAt(obsCount+i, 0.0);
-            //A.setAt(obsCount+i, 0.0);
-            //A.setAt(obsCount+i, 0.0);
-            A.setAt(obsCount+i, Circle::unknownNormalI, xP);
-            A.setAt(obsCount+i, Circle::unknownNormalJ, yP);
-            A.setAt(obsCount+i, Circle::unknownNormalK, zP);
-            A.setAt(obsCount+i, 7, -1.0);
+            a[8+Circle::unknownNormalI] = xP;
+            a[8+Circle::unknownNormalJ] = yP;
+            a[8+Circle::unknownNormalK] = zP;
+            a[8+7] = -1.0;
 
-            B.setAt(obsCount+i, i*3,   nx);
-            B.setAt(obsCount+i, i*3+1, ny);
-            B.setAt(obsCount+i, i*3+2, nz);
-
-            w.setAt(obsCount+i, d - (nx*xP + ny*yP + nz*zP));
-        }
-
-        w = -1*B*v + w;
+            b[3] = nx;
+            b[4] = ny;
+            b[5] = nz;
 
-        Pww = (B * B.t()).inv();
-        NGL = A.t() * Pww * A;
-        ngl = A.t() * Pww * w;
+            w[1] = d - (nx*xP + ny*yP + nz*zP);
 
-        for (int i=0; i<NGL.getRowCount(); i++) {
-            nglr.setAt(i, ngl.getAt(i));
-            for (int j=0; j<NGL.getColCount(); j++)
-                NGLR.setAt(i,j, NGL.getAt(i,j));
+            // w = -B*v + w
+            for (int j=0; j<2; j++) {
+                w[j] -= b[3*j]*v.getAt(3*i) + b[3*j+1]*v.getAt(3*i+1) + b[3*j+2]*v.getAt(3*i+2);
+                w[j] = -w[j];
+            }
+            for (int j=0; j<2*3; j++)
+                b[j] = -b[j];
+
+            if (!gaussHelmert.addObservation(a, b, w)) {
+                emit this->sendMessage(gaussHelmert.getErrorMessage(), eErrorMessage);
+                delete[] x;
+                delete[] y;
+                delete[] z;
+                return false;
+            }
         }
 
-        NGLR.setAt(NGL.getRowCount(), Circle::unknownCenterX, nx);
-        NGLR.setAt(NGL.getRowCount(), Circle::unknownCenterY, ny);
-        NGLR.setAt(NGL.getRowCount(), Circle::unknownCenterZ, nz);
-        NGLR.setAt(NGL.getRowCount(), Circle::unknownNormalI, xc);
-        NGLR.setAt(NGL.getRowCount(), Circle::unknownNormalJ, yc);
-        NGLR.setAt(NGL.getRowCount(), Circle::unknownNormalK, zc);
-        NGLR.setAt(NGL.getRowCount(), 7, -1.0);
-        nglr.setAt(NGL.getRowCount(), d - (nx*xc + ny*yc + nz*zc));
-
-        NGLR.setAt(NGL.getRowCount()+1, Circle::unknownNormalI, 2.0*nx);
-        NGLR.setAt(NGL.getRowCount()+1, Circle::unknownNormalJ, 2.0*ny);
-        NGLR.setAt(NGL.getRowCount()+1, Circle::unknownNormalK, 2.0*nz);
-        nglr.setAt(NGL.getRowCount()+1, 1.0 - (nx*nx + ny*ny + nz*nz));
-
-        NGLR.setAt(Circle::unknownCenterX, NGL.getRowCount(), nx);
-        NGLR.setAt(Circle::unknownCenterY, NGL.getRowCount(), ny);
-        NGLR.setAt(Circle::unknownCenterZ, NGL.getRowCount(), nz);
-        NGLR.setAt(Circle::unknownNormalI, NGL.getRowCount(), xc);
-        NGLR.setAt(Circle::unknownNormalJ, NGL.getRowCount(), yc);
-        NGLR.setAt(Circle::unknownNormalK, NGL.getRowCount(), zc);
-        NGLR.setAt(7, NGL.getRowCount(), -1.0);
-
-        NGLR.setAt(Circle::unknownNormalI, NGL.getRowCount()+1, 2.0*nx);
-        NGLR.setAt(Circle::unknownNormalJ, NGL.getRowCount()+1, 2.0*ny);
-        NGLR.setAt(Circle::unknownNormalK, NGL.getRowCount()+1, 2.0*nz);
+        // Restriktionen: Mittelpunkt liegt in der Ebene, Normalenvektor hat die Laenge 1
+        for (int j=0; j<8; j++)
+            c[j] = 0.0;
+        c[Circle::unknownCenterX] = nx;
+        c[Circle::unknownCenterY] = ny;
+        c[Circle::unknownCenterZ] = nz;
+        c[Circle::unknownNormalI] = xc;
+        c[Circle::unknownNormalJ] = yc;
+        c[Circle::unknownNormalK] = zc;
+        c[7] = -1.0;
+        gaussHelmert.addConstraint(c, -(d - (nx*xc + ny*yc + nz*zc)));
+
+        for (int j=0; j<8; j++)
+            c[j] = 0.0;
+        c[Circle::unknownNormalI] = 2.0*nx;
+        c[Circle::unknownNormalJ] = 2.0*ny;
+        c[Circle::unknownNormalK] = 2.0*nz;
+        gaussHelmert.addConstraint(c, -(1.0 - (nx*nx + ny*ny + nz*nz)));
+
+        if (!gaussHelmert.solve()) {
+            emit this->sendMessage(gaussHelmert.getErrorMessage(), eErrorMessage);
+            delete[] x;
+            delete[] y;
+            delete[] z;
+            return false;
+        }
+        const OiVec &du = gaussHelmert.getDx();
 
-        QxxR = NGLR.inv();
-        duk  = QxxR * nglr;
+        xc += du.getAt(Circle::unknownCenterX);
+        yc += du.getAt(Circle::unknownCenterY);
+        zc += du.getAt(Circle::unknownCenterZ);
+        rc += du.getAt(Circle::unknownRadius);
 
-        xc += duk.getAt(Circle::unknownCenterX);
-        yc += duk.getAt(Circle::unknownCenterY);
-        zc += duk.getAt(Circle::unknownCenterZ);
-        rc += duk.getAt(Circle::unknownRadius);
+        nx += du.getAt(Circle::unknownNormalI);
+        ny += du.getAt(Circle::unknownNormalJ);
+        nz += du.getAt(Circle::unknownNormalK);
+        d  += du.getAt(7);
 
-        nx += duk.getAt(Circle::unknownNormalI);
-        ny += duk.getAt(Circle::unknownNormalJ);
-        nz += duk.getAt(Circle::unknownNormalK);
-        d  += duk.getAt(7);
+        maxAbsDu = du.getAt(0);
+        for (int i=0; i<du.getSize(); i++)
+            maxAbsDu = max(maxAbsDu, fabs(du.getAt(i)));
 
-        maxAbsDu = duk.getAt(0);
-        for (int i=0; i<du.getSize(); i++) {
-            du.setAt(i, duk.getAt(i));
-            maxAbsDu = max(maxAbsDu, fabs(duk.getAt(i)));
-
-            // Dies waere nur am Ende der letzten Iteration notwendig
-            for (int j=0; j<du.getSize(); j++)
-                Qxx.setAt(i,j,QxxR.getAt(i,j));
-        }
-
-        v = B.t()*Pww*(A*du-w);
+        for (int i=0; i<v.getSize(); i++)
+            v.setAt(i, gaussHelmert.getV().at(i));
 
         if (iterations<maxItr && maxAbsDu < 1.0E-8) {
             qDebug() << "DEBUG: Found Solution!";
@@ -222,24 +214,19 @@ bool BestFitCircle::exec(Circle &circle) {
         }
         else if (iterations>maxItr) {
             qDebug() << "DEBUG: Estimation failed!";
+            delete[] x;
+            delete[] y;
+            delete[] z;
             return false;
         }
         iterations++;
 
     }
+    Qxx = gaussHelmert.getQxx();
 
-
-
-
-
-
-
-
-
-
-
-
-
+    delete[] x;
+    delete[] y;
+    delete[] z;
 
 /*
 
@@ -4,6 +4,7 @@
 #include "fitfunction.h"
 #include "oivec.h"
 #include "oimat.h"
+#include "gausshelmert.h"
 #include "cfitting_plane.h"
 #include "cfitting_sphere.h"
 
@@ -54,41 +54,22 @@ bool BestFitLine::setUpResult(Line &line){
         return false;
     }
 
-    //centroid
-    OiVec centroid(4);
+    //centroid and scatter matrix (accumulated in one pass)
+    PointMoments moments;
     foreach(const QPointer<Observation> &obs, inputObservations){
-        centroid = centroid + obs->getXYZ();
+        moments.add(obs->getXYZ());
     }
-    centroid = centroid * (1.0/inputObservations.size());
-    centroid.removeLast();
+    OiVec centroid = moments.getCentroid();
 
     //principle component analysis
-    OiMat a(inputObservations.size(), 3);
-    for(int i = 0; i < inputObservations.size(); i++){
-        a.setAt(i, 0, inputObservations.at(i)->getXYZ().getAt(0) - centroid.getAt(0));
-        a.setAt(i, 1, inputObservations.at(i)->getXYZ().getAt(1) - centroid.getAt(1));
-        a.setAt(i, 2, inputObservations.at(i)->getXYZ().getAt(2) - centroid.getAt(2));
-    }
-    OiMat ata = a.t() * a;
-    OiMat u(3,3);
-    OiVec d(3);
-    OiMat v(3,3);
-    ata.svd(u, d, v);
-
-    //get largest eigenvector which is r vector and v^T * v as sum of the 2 smaller eigenvectors
-    int eigenIndex = -1;
-    double eVal = 0.0;
-    double vtv = 0.0;
-    for(int i = 0; i < d.getSize(); i++){
-        if(d.getAt(i) > eVal || i == 0){
-            eVal = d.getAt(i);
-            eigenIndex = i;
-        }else{
-            vtv += d.getAt(i);
-        }
-    }
-    OiVec r(3);
-    u.getCol(r, eigenIndex);
+    fixed::Mat<3, 3> ata = moments.getScatterMatrix();
+    fixed::Mat<3, 3> u;
+    fixed::Vec<3> d;
+    fixed::eigenSymmetric(ata, d, u);
+
+    //get largest eigenvector which is r vector and v^T * v as sum of the 2 smaller eigenvectors (sorted descending)
+    double vtv = d.getAt(1) + d.getAt(2);
+    OiVec r = u.getCol(0).toOiVec();
     r.normalize();
 
     //check that the orientation of the line is from first to second observation
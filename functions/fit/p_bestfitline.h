@@ -8,6 +8,7 @@
 #include "fitfunction.h"
 #include "oivec.h"
 #include "oimat.h"
+#include "pointmoments.h"
 
 using namespace oi;
 using namespace std;
@@ -65,17 +65,15 @@ bool BestFitPlane::setUpResult(Plane &plane){
         return false;
     }
 
-    QList<IdPoint> points;
+    //centroid and scatter matrix (accumulated in one pass)
+    PointMoments moments;
     foreach(const QPointer<Observation> &obs, inputObservations) {
-        IdPoint point;
-        point.id = obs->getId();
-        point.xyz = obs->getXYZ();
-        points.append(point);
+        moments.add(obs->getXYZ());
     }
-    OiVec centroid(3);
+    OiVec centroid = moments.getCentroid();
     OiVec n(3);
     double eVal = 0.0;
-    if(!bestFitPlane(centroid, n, eVal, points)) {
+    if(!this->fitPlane(n, eVal, moments)) {
         emit this->sendMessage(QString("Cannot fit plane %1").arg(plane.getFeatureName()), eWarningMessage);
         return false;
     }
@@ -107,13 +105,11 @@ bool BestFitPlane::setUpResult(Plane &plane){
     foreach(const QPointer<Observation> &observation, allUsableObservations){
 
         //calculate residual vector
-        double distance = n.getAt(0) * observation->getXYZ().getAt(0)
-                + n.getAt(1) * observation->getXYZ().getAt(1)
-                + n.getAt(2) * observation->getXYZ().getAt(2) - dOrigin;
-        OiVec v_plane = distance * n;
+        const OiVec &xyz = observation->getXYZ();
+        double distance = n.getAt(0) * xyz.getAt(0) + n.getAt(1) * xyz.getAt(1) + n.getAt(2) * xyz.getAt(2) - dOrigin;
 
         //set up display residual
-        Function::addDisplayResidual(observation->getId(), v_plane.getAt(0), v_plane.getAt(1), v_plane.getAt(2), distance);
+        Function::addDisplayResidual(observation->getId(), distance * n.getAt(0), distance * n.getAt(1), distance * n.getAt(2), distance);
 
     }
 
@@ -132,3 +128,34 @@ bool BestFitPlane::setUpResult(Plane &plane){
     return true;
 
 }
+
+/*!
+ * \brief BestFitPlane::fitPlane
+ * Calculates the normal vector of the plane as eigenvector of the smallest eigenvalue of the scatter matrix
+ * \param n normal vector
+ * \param eVal smallest eigenvalue (sum of the squared distances of the points from the plane)
+ * \param moments
+ * \return
+ */
+bool BestFitPlane::fitPlane(OiVec &n, double &eVal, const PointMoments &moments){
+
+    if(moments.getCount() < 3){
+        return false;
+    }
+
+    fixed::Mat<3, 3> ata = moments.getScatterMatrix();
+    fixed::Mat<3, 3> u;
+    fixed::Vec<3> d;
+    if(!fixed::eigenSymmetric(ata, d, u)){
+        emit this->sendMessage("Eigenvalues of the scatter matrix did not converge", eErrorMessage);
+        return false;
+    }
+
+    //eigenvalues are sorted descending
+    eVal = d.getAt(2);
+    n = u.getCol(2).toOiVec();
+    n.normalize();
+
+    return true;
+
+}
@@ -8,6 +8,7 @@
 #include "fitfunction.h"
 #include "oivec.h"
 #include "oimat.h"
+#include "pointmoments.h"
 
 using namespace oi;
 
@@ -41,6 +42,7 @@ private:
     //##############
 
     bool setUpResult(Plane &plane);
+    bool fitPlane(OiVec &n, double &eVal, const PointMoments &moments);
 
 };
 
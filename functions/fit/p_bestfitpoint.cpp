@@ -82,45 +82,29 @@ bool BestFitPoint::setUpResult(Point &point){
         return false;
     }
 
-    //fill l vector
-    OiVec l;
+    //normal equations A^T * A and A^T * l (accumulated without setting up A)
+    PointMoments moments;
     foreach(const QPointer<Observation> &obs, inputObservations){
-        l.add( obs->getXYZ().getAt(0) );
-        l.add( obs->getXYZ().getAt(1) );
-        l.add( obs->getXYZ().getAt(2) );
-    }
-
-    //fill A matrix
-    OiMat a(l.getSize(), 3);
-    for(int i = 0; i < l.getSize(); i++){
-        if( (i%3) == 0 ){
-            a.setAt(i, Point::unknownCenterX, 1.0);
-        }else if( (i%3) == 1 ){
-            a.setAt(i, Point::unknownCenterY, 1.0);
-        }else if( (i%3) == 2 ){
-            a.setAt(i, Point::unknownCenterZ, 1.0);
-        }
+        moments.add(obs->getXYZ());
     }
 
     //adjust
-    OiMat n = a.t() * a;
-    OiVec c = a.t() * l;
-    OiMat qxx;
-    OiVec x, v;
-    try{
-        qxx = n.inv();
-        x = qxx * c;
-        v = a * x - l;
-    }catch(const logic_error &e){
-        emit this->sendMessage(e.what(), eErrorMessage);
-        return false;
-    }catch(const runtime_error &e){
-        emit this->sendMessage(e.what(), eErrorMessage);
+    fixed::Mat<3, 3> n;
+    fixed::Vec<3> c;
+    moments.getPointNormalEquations(n, c);
+    fixed::Mat<3, 3> qxx;
+    if(!fixed::invertSymmetric(n, qxx)){
+        emit this->sendMessage(QString("Cannot invert the normal equations of point %1").arg(point.getFeatureName()), eErrorMessage);
         return false;
     }
+    OiVec x = (qxx * c).toOiVec();
 
     //calculate point based corrections
     OiVec corr;
+    QSet<int> inputIds;
+    foreach(const QPointer<Observation> &observation, inputObservations){
+        inputIds.insert(observation->getId());
+    }
 
     foreach(const QPointer<Observation> &observation, allUsableObservations){
 
@@ -134,7 +118,7 @@ bool BestFitPoint::setUpResult(Point &point){
                           + qPow(_vz, 2)
                           );
 
-        if(inputObservations.contains(observation)) {
+        if(inputIds.contains(observation->getId())) {
             corr.add(_corr);
         }
 
@@ -153,7 +137,7 @@ bool BestFitPoint::setUpResult(Point &point){
 
     //set statistic
     this->statistic.setIsValid(true);
-    this->statistic.setQxx(qxx);
+    this->statistic.setQxx(qxx.toOiMat());
     this->statistic.setV(corr);
     this->statistic.setStdev(stdev);
     point.setStatistic(this->statistic);
@@ -3,11 +3,13 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QSet>
 #include <QtMath>
 
 #include "fitfunction.h"
 #include "oivec.h"
 #include "oimat.h"
+#include "pointmoments.h"
 
 using namespace oi;
 using namespace std;
@@ -61,76 +61,30 @@ bool BestFitSphere::exec(Sphere &sphere){
  */
 bool BestFitSphere::approximate(Sphere &sphere, const QList<QPointer<Observation> > &inputObservations){
 
-    //calculate centroid coordinates
-    OiVec centroid(4);
+    //Drixler (normal equations accumulated in one pass, coordinates reduced to the first point)
+    PointMoments moments;
     for(int i = 0; i < inputObservations.size(); i++){
-        centroid = centroid + inputObservations.at(i)->getXYZ();
+        moments.add(inputObservations.at(i)->getXYZ());
     }
-    centroid = centroid / inputObservations.size();
-    centroid.removeLast();
+    fixed::Mat<4, 4> N;
+    fixed::Vec<4> n;
+    moments.getSphereNormalEquations(N, n);
 
-    //Drixler
-    OiMat N(4, 4);
-    OiVec n(4);
-    for(int i = 0; i < inputObservations.size(); i++){
-        double x = 0.0;
-        double y = 0.0;
-        double z = 0.0;
-
-        x = inputObservations.at(i)->getXYZ().getAt(0) - centroid.getAt(0);
-        y = inputObservations.at(i)->getXYZ().getAt(1) - centroid.getAt(1);
-        z = inputObservations.at(i)->getXYZ().getAt(2) - centroid.getAt(2);
-
-        double xx = x*x;
-        double yy = y*y;
-        double zz = z*z;
-        double xy = x*y;
-        double xz = x*z;
-        double yz = y*z;
-        double xyz2 = x*x + y*y + z*z;
-
-        N.setAt(0,0, N.getAt(0,0) + xx);
-        N.setAt(0,1, N.getAt(0,1) + xy);
-        N.setAt(0,2, N.getAt(0,2) + xz);
-        N.setAt(0,3, N.getAt(0,3) + x);
-        N.setAt(1,0, N.getAt(1,0) + xy);
-        N.setAt(1,1, N.getAt(1,1) + yy);
-        N.setAt(1,2, N.getAt(1,2) + yz);
-        N.setAt(1,3, N.getAt(1,3) + y);
-        N.setAt(2,0, N.getAt(2,0) + xz);
-        N.setAt(2,1, N.getAt(2,1) + yz);
-        N.setAt(2,2, N.getAt(2,2) + zz);
-        N.setAt(2,3, N.getAt(2,3) + z);
-        N.setAt(3,0, N.getAt(3,0) + x);
-        N.setAt(3,1, N.getAt(3,1) + y);
-        N.setAt(3,2, N.getAt(3,2) + z);
-        N.setAt(3,3, N.getAt(3,3) + 1.0);
-
-        n.setAt(0, n.getAt(0) + x*xyz2);
-        n.setAt(1, n.getAt(1) + y*xyz2);
-        n.setAt(2, n.getAt(2) + z*xyz2);
-        n.setAt(3, n.getAt(3) + xyz2);
-    }
-
-    OiMat Q(4,4);
-    try{
-        Q = N.inv();
-    }catch(exception &e){
-        emit this->sendMessage(e.what(), eErrorMessage);
+    fixed::Vec<4> a;
+    if(!fixed::solveSymmetric(N, -1.0 * n, a)){
+        emit this->sendMessage(QString("Cannot solve the normal equations of sphere %1").arg(sphere.getFeatureName()), eErrorMessage);
         return false;
     }
 
-    OiVec a = -1.0 * Q * n;
-
     double r = 0.0;
     double xm = 0.0;
     double ym = 0.0;
     double zm = 0.0;
 
     r = qSqrt( qAbs( 0.25 * (a.getAt(0)*a.getAt(0) + a.getAt(1)*a.getAt(1) + a.getAt(2)*a.getAt(2)) - a.getAt(3) ) );
-    xm = -0.5 * a.getAt(0) + centroid.getAt(0);
-    ym = -0.5 * a.getAt(1) + centroid.getAt(1);
-    zm = -0.5 * a.getAt(2) + centroid.getAt(2);
+    xm = -0.5 * a.getAt(0) + moments.getReference(0);
+    ym = -0.5 * a.getAt(1) + moments.getReference(1);
+    zm = -0.5 * a.getAt(2) + moments.getReference(2);
 
     //set approximate result
     Position position;
@@ -159,82 +113,55 @@ bool BestFitSphere::fit(Sphere &sphere, const QList<QPointer<Observation> > &inp
     double zm = sphere.getPosition().getVector().getAt(2);
     double r = sphere.getRadius().getRadius();
 
-    OiVec xd(4);
+    //condition r0 - r = 0 of each observation (1 x 4 block of A, 1 x 3 block of B)
+    GaussHelmert gaussHelmert(4, 1, 3);
+    gaussHelmert.reserve(inputObservations.size());
+
+    double a[4];
+    double b[3];
+    double w = 0.0;
     double xdxd = 0.0;
     OiVec verb(inputObservations.size()*3);
     do{
 
-        OiMat A(inputObservations.size(), 4);
-        OiMat B(inputObservations.size(), inputObservations.size()*3);
-        OiVec w(inputObservations.size());
+        gaussHelmert.clear();
         for(int i = 0; i < inputObservations.size(); i++){
 
-            OiVec x = inputObservations.at(i)->getXYZ();
-            x.removeLast();
+            const OiVec &x = inputObservations.at(i)->getXYZ();
 
-            double r0 = qSqrt( (x.getAt(0) + verb.getAt(i*3) - xm) * (x.getAt(0) + verb.getAt(i*3) - xm)
-                               + (x.getAt(1) + verb.getAt(i*3+1) - ym) * (x.getAt(1) + verb.getAt(i*3+1) - ym)
-                               + (x.getAt(2) + verb.getAt(i*3+2) - zm) * (x.getAt(2) + verb.getAt(i*3+2) - zm) );
+            double dx = x.getAt(0) + verb.getAt(i*3) - xm;
+            double dy = x.getAt(1) + verb.getAt(i*3+1) - ym;
+            double dz = x.getAt(2) + verb.getAt(i*3+2) - zm;
+            double r0 = qSqrt(dx * dx + dy * dy + dz * dz);
 
-            A.setAt(i, 0, -1.0 * (x.getAt(0) + verb.getAt(i*3) - xm) / r0);
-            A.setAt(i, 1, -1.0 * (x.getAt(1) + verb.getAt(i*3+1) - ym) / r0);
-            A.setAt(i, 2, -1.0 * (x.getAt(2) + verb.getAt(i*3+2) - zm) / r0);
-            A.setAt(i, 3, -1.0);
+            a[0] = -1.0 * dx / r0;
+            a[1] = -1.0 * dy / r0;
+            a[2] = -1.0 * dz / r0;
+            a[3] = -1.0;
 
-            B.setAt(i, i*3, (x.getAt(0) + verb.getAt(i*3) - xm) / r0);
-            B.setAt(i, i*3+1, (x.getAt(1) + verb.getAt(i*3+1) - ym) / r0);
-            B.setAt(i, i*3+2, (x.getAt(2) + verb.getAt(i*3+2) - zm) / r0);
+            b[0] = dx / r0;
+            b[1] = dy / r0;
+            b[2] = dz / r0;
 
-            w.setAt(i, r0 - r);
+            w = r0 - r;
 
-        }
-
-        OiMat BBT = B * B.t();
-        OiMat AT = A.t();
-
-        OiMat N(inputObservations.size()+4, inputObservations.size()+4);
-        for(int i = 0; i < BBT.getRowCount(); i++){
-            for(int j = 0; j < BBT.getColCount(); j++){
-                N.setAt(i,j, BBT.getAt(i,j));
-            }
-        }
-        for(int i = 0; i < inputObservations.size(); i++){
-            for(int j = 0; j < 4; j++){
-                N.setAt(i, j+inputObservations.size(), A.getAt(i,j));
+            if(!gaussHelmert.addObservation(a, b, &w)){
+                emit this->sendMessage(gaussHelmert.getErrorMessage(), eErrorMessage);
+                return false;
             }
-        }
-        for(int i = 0; i < 4; i++){
-            for(int j = 0; j < inputObservations.size(); j++){
-                N.setAt(i+inputObservations.size(), j, AT.getAt(i,j));
-            }
-        }
 
-        for(int i = 0; i < 4; i++){
-            w.add(0.0);
         }
 
-        OiMat Q(inputObservations.size()+4, inputObservations.size()+4);
-        try{
-            Q = N.inv();
-        }catch(exception &e){
-            emit this->sendMessage(e.what(), eErrorMessage);
+        if(!gaussHelmert.solve()){
+            emit this->sendMessage(gaussHelmert.getErrorMessage(), eErrorMessage);
             return false;
         }
 
-        OiVec res = -1.0 * Q * w;
-
-        OiVec k(inputObservations.size());
-        for(int i = 0; i < inputObservations.size(); i++){
-            k.setAt(i, res.getAt(i));
-        }
-        for(int i = 0; i < 4; i++){
-            xd.setAt(i, res.getAt(i+inputObservations.size()));
-        }
-
-        OiVec vd = B.t() * k;
-
         //Unbekannte und Beobachtungen verbessern
-        verb = verb + vd;
+        for(int i = 0; i < verb.getSize(); i++){
+            verb.setAt(i, verb.getAt(i) + gaussHelmert.getV().at(i));
+        }
+        const OiVec &xd = gaussHelmert.getDx();
         xm += xd.getAt(0);
         ym += xd.getAt(1);
         zm += xd.getAt(2);
@@ -298,6 +225,7 @@ bool BestFitSphere::fit(Sphere &sphere, const QList<QPointer<Observation> > &inp
     //set statistic
     this->statistic.setIsValid(true);
     this->statistic.setStdev(stdv);
+    this->statistic.setQxx(gaussHelmert.getQxx());
     sphere.setStatistic(this->statistic);
 
     return true;
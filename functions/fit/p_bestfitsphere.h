@@ -8,6 +8,8 @@
 #include "fitfunction.h"
 #include "oivec.h"
 #include "oimat.h"
+#include "pointmoments.h"
+#include "gausshelmert.h"
 
 using namespace oi;
 
@@ -0,0 +1,145 @@
+#include "pointmoments.h"
+
+/*!
+ * \brief PointMoments::PointMoments
+ */
+PointMoments::PointMoments(){
+    this->clear();
+}
+
+/*!
+ * \brief PointMoments::clear
+ */
+void PointMoments::clear(){
+
+    this->count = 0;
+    this->sum4 = 0.0;
+    for(int i = 0; i < 3; i++){
+        this->reference[i] = 0.0;
+        this->sum[i] = 0.0;
+        this->sum3[i] = 0.0;
+    }
+    for(int i = 0; i < 6; i++){
+        this->sum2[i] = 0.0;
+    }
+
+}
+
+/*!
+ * \brief PointMoments::getCentroid
+ * \return
+ */
+OiVec PointMoments::getCentroid() const{
+
+    OiVec centroid(3);
+    if(this->count > 0){
+        for(int i = 0; i < 3; i++){
+            centroid.setAt(i, this->reference[i] + this->sum[i] / this->count);
+        }
+    }
+    return centroid;
+
+}
+
+/*!
+ * \brief PointMoments::getCentroid
+ * \param centroid
+ */
+void PointMoments::getCentroid(double (&centroid)[3]) const{
+
+    for(int i = 0; i < 3; i++){
+        centroid[i] = this->count > 0 ? this->reference[i] + this->sum[i] / this->count : 0.0;
+    }
+
+}
+
+/*!
+ * \brief PointMoments::getScatterMatrix
+ * Returns the sum of (p - centroid) * (p - centroid)^T over all points
+ * \return
+ */
+fixed::Mat<3, 3> PointMoments::getScatterMatrix() const{
+
+    fixed::Mat<3, 3> scatter;
+    if(this->count == 0){
+        return scatter;
+    }
+
+    int k = 0;
+    for(int i = 0; i < 3; i++){
+        for(int j = i; j < 3; j++){
+            double value = this->sum2[k++] - this->sum[i] * this->sum[j] / this->count;
+            scatter.setAt(i, j, value);
+            scatter.setAt(j, i, value);
+        }
+    }
+    return scatter;
+
+}
+
+/*!
+ * \brief PointMoments::getPointNormalEquations
+ * Returns A^T * A and A^T * l of the adjustment of one point from all points (A consists of 3x3 identity blocks)
+ * \param n
+ * \param c
+ */
+void PointMoments::getPointNormalEquations(fixed::Mat<3, 3> &n, fixed::Vec<3> &c) const{
+
+    n = fixed::Mat<3, 3>();
+    for(int i = 0; i < 3; i++){
+        n.setAt(i, i, this->count);
+        c.setAt(i, this->count * this->reference[i] + this->sum[i]);
+    }
+
+}
+
+/*!
+ * \brief PointMoments::getSphereNormalEquations
+ * Returns the normal equations n * a = -c of the algebraic sphere fit x^2 + y^2 + z^2 + a0*x + a1*y + a2*z + a3 = 0
+ * (Drixler) in coordinates reduced to getReference. The center is reference - 0.5 * (a0, a1, a2) and the radius is
+ * sqrt(0.25 * (a0^2 + a1^2 + a2^2) - a3).
+ * \param n
+ * \param c
+ */
+void PointMoments::getSphereNormalEquations(fixed::Mat<4, 4> &n, fixed::Vec<4> &c) const{
+
+    n = fixed::Mat<4, 4>();
+
+    int k = 0;
+    for(int i = 0; i < 3; i++){
+        for(int j = i; j < 3; j++){
+            n.setAt(i, j, this->sum2[k]);
+            n.setAt(j, i, this->sum2[k]);
+            k++;
+        }
+        n.setAt(i, 3, this->sum[i]);
+        n.setAt(3, i, this->sum[i]);
+        c.setAt(i, this->sum3[i]);
+    }
+    n.setAt(3, 3, this->count);
+    c.setAt(3, this->sum2[0] + this->sum2[3] + this->sum2[5]);
+
+}
+
+/*!
+ * \brief PointMoments::getSphereResidualSum
+ * Returns the sum of the squared algebraic residuals e = |d|^2 + a0*dx + a1*dy + a2*dz + a3 of a solution a of
+ * getSphereNormalEquations. For a point at distance v from the sphere e is approximately 2 * r * v.
+ * \param a
+ * \return
+ */
+double PointMoments::getSphereResidualSum(const fixed::Vec<4> &a) const{
+
+    const double sumNorm = this->sum2[0] + this->sum2[3] + this->sum2[5];
+
+    double sumEE = this->sum4 + 2.0 * a(3) * sumNorm + a(3) * a(3) * this->count;
+    int k = 0;
+    for(int i = 0; i < 3; i++){
+        sumEE += 2.0 * a(i) * (this->sum3[i] + a(3) * this->sum[i]);
+        for(int j = i; j < 3; j++){
+            sumEE += (i == j ? 1.0 : 2.0) * a(i) * this->sum2[k++] * a(j);
+        }
+    }
+    return sumEE;
+
+}
@@ -0,0 +1,109 @@
+#ifndef POINTMOMENTS_H
+#define POINTMOMENTS_H
+
+#include "oivec.h"
+#include "oimat.h"
+#include "fixedmatrix.h"
+
+using namespace oi;
+
+/*!
+ * \brief The PointMoments class
+ * Moments of a set of points that are accumulated in one pass (without storing the points or a design matrix).
+ * Points can also be removed again, so the point cloud segmentation keeps the moments of each shape up to date while
+ * the shape grows and refits it in O(1).
+ * The coordinates are reduced to the first point to keep the sums well conditioned for coordinates far from the origin.
+ * The moments provide the normal equations of the least squares point, the scatter matrix of the principal component
+ * fits of lines and planes and the normal equations of the algebraic sphere fit (Drixler).
+ */
+class PointMoments
+{
+public:
+    PointMoments();
+
+    void clear();
+
+    //! \brief Adds a point
+    inline void add(const double &x, const double &y, const double &z){
+
+        if(this->count == 0){
+            this->reference[0] = x;
+            this->reference[1] = y;
+            this->reference[2] = z;
+        }
+
+        this->update(x, y, z, 1.0);
+        this->count++;
+
+    }
+
+    //! \brief Removes a point that was added before (used to keep the moments of a growing and shrinking set up to date)
+    inline void remove(const double &x, const double &y, const double &z){
+
+        if(this->count <= 1){
+            this->clear();
+            return;
+        }
+
+        this->update(x, y, z, -1.0);
+        this->count--;
+
+    }
+
+    //! \brief Adds a point given as (homogeneous) coordinate vector
+    inline void add(const OiVec &xyz){
+        this->add(xyz.getAt(0), xyz.getAt(1), xyz.getAt(2));
+    }
+
+    //! \brief Returns the number of points
+    inline int getCount() const{
+        return this->count;
+    }
+
+    //! \brief Returns the point all coordinates are reduced to (the first point)
+    inline double getReference(const int &i) const{
+        return this->reference[i];
+    }
+
+    OiVec getCentroid() const;
+    void getCentroid(double (&centroid)[3]) const;
+    fixed::Mat<3, 3> getScatterMatrix() const;
+
+    void getPointNormalEquations(fixed::Mat<3, 3> &n, fixed::Vec<3> &c) const;
+    void getSphereNormalEquations(fixed::Mat<4, 4> &n, fixed::Vec<4> &c) const;
+    double getSphereResidualSum(const fixed::Vec<4> &a) const;
+
+private:
+    inline void update(const double &x, const double &y, const double &z, const double &sign){
+
+        const double dx = x - this->reference[0];
+        const double dy = y - this->reference[1];
+        const double dz = z - this->reference[2];
+        const double dd = dx*dx + dy*dy + dz*dz;
+
+        this->sum[0] += sign * dx;
+        this->sum[1] += sign * dy;
+        this->sum[2] += sign * dz;
+        this->sum2[0] += sign * dx*dx;
+        this->sum2[1] += sign * dx*dy;
+        this->sum2[2] += sign * dx*dz;
+        this->sum2[3] += sign * dy*dy;
+        this->sum2[4] += sign * dy*dz;
+        this->sum2[5] += sign * dz*dz;
+        this->sum3[0] += sign * dx*dd;
+        this->sum3[1] += sign * dy*dd;
+        this->sum3[2] += sign * dz*dd;
+        this->sum4 += sign * dd*dd;
+
+    }
+
+    int count;
+    double reference[3];
+    double sum[3]; //sum of d = p - reference
+    double sum2[6]; //upper triangle of sum of d * d^T
+    double sum3[3]; //sum of d * |d|^2
+    double sum4; //sum of |d|^4
+
+};
+
+#endif // POINTMOMENTS_H
@@ -9,7 +9,7 @@ PluginMetaData* PointCloudSegmentation::getMetaData() const{
     metaData->name = "PointCloudSegmentation";
     metaData->pluginName = "OpenIndy Default Plugin";
     metaData->author = "Benedikt Rauls";
-    metaData->description = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18 %19 %20")
+    metaData->description = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18 %19 %20 %21 %22 %23 %24 %25 %26 %27 %28 %29 %30")
     .arg("This function segments a pointcloud.")
     .arg("It is able to detect planes, spheres and/or cylinders based on the given input parameters.")
     .arg("<br><br> <u>parameter description:</u> <br>")
@@ -29,7 +29,17 @@ PluginMetaData* PointCloudSegmentation::getMetaData() const{
     .arg("<b>detectPlanes:</b> Defines wether the algorithm shall detect spheres.")
     .arg("<b>detectPlanes:</b> Defines wether the algorithm shall detect cylinders.")
     .arg("<b>finalFit:</b> Defines wether the extracted geometries shall be fit using all points.")
-    .arg("<b>outlierPercentage:</b> Estimated proportion of outliers in a leaf voxel.");
+    .arg("<b>outlierPercentage:</b> Estimated proportion of outliers in a leaf voxel.")
+    .arg("<b>numThreads:</b> Number of threads used to build the octree and to detect shapes (0 = all available cores).")
+    .arg("<b>randomSeed:</b> Seed of the random sampling (the same seed yields the same shapes).")
+    .arg("<b>linearOctree:</b> Defines wether the octree shall be built as linear (Morton ordered) octree.")
+    .arg("<b>timeBudget:</b> Maximum time in seconds spent on detecting shapes, the shapes found until then are kept (0 = unlimited).")
+    .arg("<b>streamShapes:</b> Defines wether each shape shall be added as soon as it is detected (without final review, merge and fit).")
+    .arg("<b>downsampling:</b> Reduces the pointcloud before the shapes are detected (voxelGrid = centroid of each voxel with at least two points, random = random subset of each voxel), all points are assigned to the shapes afterwards.")
+    .arg("<b>voxelSize:</b> Edge length of the voxels used for the downsampling (0 = no downsampling).")
+    .arg("<b>samplingRate:</b> Proportion of the points of each voxel that is kept by the random downsampling.")
+    .arg("<b>memoryBudget:</b> Memory in MB that may be used to segment a part of the pointcloud, larger pointclouds are split into tiles that are segmented one after the other and the shapes are stitched afterwards (0 = segment the whole pointcloud at once).")
+    .arg("<b>tileOverlap:</b> Distance by which each tile is extended into its neighbours (about the size of the largest sphere or cylinder).");
     metaData->iid = "de.openIndy.Plugin.Function.GenerateFeatureFunction.v001";
     return metaData;
 }
@@ -73,6 +83,15 @@ QMap<QString, int> PointCloudSegmentation::getIntegerParameter() const{
     intParams.insert("minPointsSphere", 500);
     intParams.insert("minPointsCylinder", 1000);
 
+    //number of threads used to detect shape candidates (0 = use all available cores)
+    intParams.insert("numThreads", 0);
+
+    //seed of the random sampling to be able to reproduce a segmentation
+    intParams.insert("randomSeed", 0);
+
+    //memory in MB that may be used to segment one tile of the pointcloud (0 = segment the whole pointcloud in memory)
+    intParams.insert("memoryBudget", 0);
+
     return intParams;
 
 }
@@ -97,6 +116,16 @@ QMap<QString, double> PointCloudSegmentation::getDoubleParameter() const{
     doubleParams.insert("minRadiusCylinder", 0.004);
     doubleParams.insert("maxRadiusCylinder", 0.300);
 
+    //maximum time in seconds spent on detecting shapes (0 = unlimited)
+    doubleParams.insert("timeBudget", 0.0);
+
+    //edge length of the voxels and proportion of points kept if the pointcloud is reduced before the detection
+    doubleParams.insert("voxelSize", 0.0);
+    doubleParams.insert("samplingRate", 0.1);
+
+    //distance by which each tile is extended into its neighbours if the pointcloud is segmented tile by tile
+    doubleParams.insert("tileOverlap", 0.0);
+
     return doubleParams;
 
 }
@@ -132,6 +161,22 @@ QMap<QString, QStringList> PointCloudSegmentation::getStringParameter() const{
     //finally fit the detected geometries
     stringParams.insert("finalFit", myBoolOptions);
 
+    //build the octree as linear octree (same leafs as the pointer based octree)
+    stringParams.insert("linearOctree", myBoolOptions);
+
+    //add each shape as soon as it is detected instead of waiting for the whole segmentation
+    QStringList myStreamOptions;
+    myStreamOptions.append("false");
+    myStreamOptions.append("true");
+    stringParams.insert("streamShapes", myStreamOptions);
+
+    //reduce the pointcloud before the detection (the shapes are detected in the reduced and fit in the full pointcloud)
+    QStringList myDownsamplingOptions;
+    myDownsamplingOptions.append("none");
+    myDownsamplingOptions.append("voxelGrid");
+    myDownsamplingOptions.append("random");
+    stringParams.insert("downsampling", myDownsamplingOptions);
+
     /*estimated percentage of outlier points in a leaf-voxel (between 0.1 and 0.9)
     0.1 means that most of the points in one leaf-voxel belong to the same shape and therefor nearly every
     combination of points (in that voxel) leads to the same shape.
@@ -154,16 +199,85 @@ bool PointCloudSegmentation::exec(PointCloud &p){
         //check if there are some points so that segmentation does make sense
         if(p.getPointCount() > 10){
 
+            /*
+             * get the user defined parameters
+             */
+
+            FunctionConfiguration userConfig = this->getFunctionConfiguration();
+            QMap<QString, QString> stringParams = userConfig.stringParameter;
+            QMap<QString, int> intParams = userConfig.intParameter;
+            QMap<QString, double> doubleParams = userConfig.doubleParameter;
+
+            //special plane, sphere and cylinder parameter
+            PlaneParameter pParam;
+            pParam.detectPlanes = stringParams.value("detectPlanes").compare("false");
+            pParam.maxDistance = doubleParams.value("maxDistancePlane");
+            pParam.minPoints = intParams.value("minPointsPlane");
+            SphereParameter sParam;
+            sParam.detectSpheres = stringParams.value("detectSpheres").compare("false");
+            sParam.maxDistance = doubleParams.value("maxDistanceSphere");
+            sParam.maxRadius = doubleParams.value("maxRadiusSphere");
+            sParam.minRadius = doubleParams.value("minRadiusSphere");
+            sParam.minPoints = intParams.value("minPointsSphere");
+            CylinderParameter cParam;
+            cParam.detectCylinders = stringParams.value("detectCylinders").compare("false");
+            cParam.maxDistance = doubleParams.value("maxDistanceCylinder");
+            cParam.maxRadius = doubleParams.value("maxRadiusCylinder");
+            cParam.minRadius = doubleParams.value("minRadiusCylinder");
+            cParam.minPoints = intParams.value("minPointsCylinder");
+
+            //set parameter for the segmentation algorithm
+            PS_InputParameter param;
+            param.leafSize = intParams.value("leafSize");
+            param.outlierPercentage = stringParams.value("outlierPercentage").toDouble();
+            qDebug() << "outlierper " << param.outlierPercentage;
+            param.fitSampleSize = 50; intParams.value("fitSampleSize");
+            param.finalFit = stringParams.value("finalFit").compare("false");
+            param.numThreads = intParams.value("numThreads");
+            param.randomSeed = (quint32)intParams.value("randomSeed");
+            param.linearOctree = stringParams.value("linearOctree").compare("false");
+            param.timeBudget = doubleParams.value("timeBudget");
+            param.streamShapes = (stringParams.value("streamShapes").compare("true") == 0);
+            param.downsampling = eNoDownsampling;
+            if(stringParams.value("downsampling").compare("voxelGrid") == 0){
+                param.downsampling = eVoxelGridDownsampling;
+            }else if(stringParams.value("downsampling").compare("random") == 0){
+                param.downsampling = eRandomDownsampling;
+            }
+            param.voxelSize = doubleParams.value("voxelSize");
+            param.samplingRate = doubleParams.value("samplingRate");
+            param.planeParams = pParam;
+            param.sphereParams = sParam;
+            param.cylinderParams = cParam;
+
+            //segment the pointcloud tile by tile (see PS_TiledSegmentation), the tiles are read from a copy of the points on disk
+            quint64 memoryBudget = (quint64)qMax(intParams.value("memoryBudget"), 0) << 20;
+            if(memoryBudget > 0){
+
+                QString fileName;
+                if(!this->writePoints(p, fileName)){
+                    this->writeToConsole("Point cloud data cannot be written to a temporary file");
+                    return false;
+                }
+
+                this->myHandler = new SegmentationConsumer(p);
+                this->myHandler->startTiledSegmentationTask(fileName, param, memoryBudget, doubleParams.value("tileOverlap"));
+
+                this->writeToConsole("Point cloud segmentation successfully started");
+                return true;
+
+            }
+
             PS_PointCloud myCloud;
 
-            vector<PS_Point_PC*> *myPoints = new vector<PS_Point_PC*>;
+            /*
+             * the points of the OpenIndy point cloud are single objects, so there are no coordinate arrays the store could view
+             * (see PS_PointStore::setView): copy them once into the contiguous arrays of the store
+             */
+            PS_PointStore *myPoints = new PS_PointStore();
+            myPoints->reserve(p.getPointCount());
             foreach(Point_PC *poi, p.getPointCloudPoints()){
-                PS_Point_PC *nPoi = new PS_Point_PC();
-                nPoi->isUsed = false;
-                nPoi->xyz[0] = poi->xyz[0];
-                nPoi->xyz[1] = poi->xyz[1];
-                nPoi->xyz[2] = poi->xyz[2];
-                myPoints->push_back(nPoi);
+                myPoints->append(poi->xyz[0], poi->xyz[1], poi->xyz[2]);
             }
 
             PS_BoundingBox_PC bbox;
@@ -174,51 +288,11 @@ bool PointCloudSegmentation::exec(PointCloud &p){
             bbox.min[1] = p.getBoundingBox().min[1];
             bbox.min[2] = p.getBoundingBox().min[2];
 
-            unsigned long numPoints = p.getPointCount();
-
-            bool checkLoad = myCloud.setCloud(myPoints, bbox, numPoints);
+            bool checkLoad = myCloud.setCloud(myPoints, bbox);
 
             //if successfully retrieved the point cloud data
             if(checkLoad){
 
-                /*
-                 * get the user defined parameters
-                 */
-
-                FunctionConfiguration userConfig = this->getFunctionConfiguration();
-                QMap<QString, QString> stringParams = userConfig.stringParameter;
-                QMap<QString, int> intParams = userConfig.intParameter;
-                QMap<QString, double> doubleParams = userConfig.doubleParameter;
-
-                //special plane, sphere and cylinder parameter
-                PlaneParameter pParam;
-                pParam.detectPlanes = stringParams.value("detectPlanes").compare("false");
-                pParam.maxDistance = doubleParams.value("maxDistancePlane");
-                pParam.minPoints = intParams.value("minPointsPlane");
-                SphereParameter sParam;
-                sParam.detectSpheres = stringParams.value("detectSpheres").compare("false");
-                sParam.maxDistance = doubleParams.value("maxDistanceSphere");
-                sParam.maxRadius = doubleParams.value("maxRadiusSphere");
-                sParam.minRadius = doubleParams.value("minRadiusSphere");
-                sParam.minPoints = intParams.value("minPointsSphere");
-                CylinderParameter cParam;
-                cParam.detectCylinders = stringParams.value("detectCylinders").compare("false");
-                cParam.maxDistance = doubleParams.value("maxDistanceCylinder");
-                cParam.maxRadius = doubleParams.value("maxRadiusCylinder");
-                cParam.minRadius = doubleParams.value("minRadiusCylinder");
-                cParam.minPoints = intParams.value("minPointsCylinder");
-
-                //set parameter for the segmentation algorithm
-                PS_InputParameter param;
-                param.leafSize = intParams.value("leafSize");
-                param.outlierPercentage = stringParams.value("outlierPercentage").toDouble();
-                qDebug() << "outlierper " << param.outlierPercentage;
-                param.fitSampleSize = 50; intParams.value("fitSampleSize");
-                param.finalFit = stringParams.value("finalFit").compare("false");
-                param.planeParams = pParam;
-                param.sphereParams = sParam;
-                param.cylinderParams = cParam;
-
                 this->myHandler = new SegmentationConsumer(p);
                 this->myHandler->startSegmentationTask(myCloud, param);
 
@@ -248,6 +322,40 @@ bool PointCloudSegmentation::exec(PointCloud &p){
 
 }
 
+/*!
+ * \brief PointCloudSegmentation::writePoints
+ * Write the points of the pointcloud to a temporary XYZ file that is read tile by tile (the file is removed by the
+ * SegmentationProducer after the segmentation)
+ * \param pointCloud
+ * \param fileName receives the name of the file
+ * \return
+ */
+bool PointCloudSegmentation::writePoints(PointCloud &pointCloud, QString &fileName){
+
+    QTemporaryFile file(QDir::tempPath() + "/pointcloudsegmentation_XXXXXX.xyz");
+    file.setAutoRemove(false);
+    if(!file.open()){
+        return false;
+    }
+    fileName = file.fileName();
+
+    //9 significant digits, so that each float is read back unchanged
+    QTextStream stream(&file);
+    stream.setRealNumberPrecision(9);
+    foreach(Point_PC *poi, pointCloud.getPointCloudPoints()){
+        stream << poi->xyz[0] << " " << poi->xyz[1] << " " << poi->xyz[2] << "\n";
+    }
+    stream.flush();
+
+    bool success = stream.status() == QTextStream::Ok;
+    file.close();
+    if(!success){
+        QFile::remove(fileName);
+    }
+    return success;
+
+}
+
 /*!
  * \brief PointCloudSegmentation::getResultProtocol
  * \return
@@ -9,6 +9,10 @@
 #include <QString>
 #include <QMap>
 #include <QStringList>
+#include <QFile>
+#include <QDir>
+#include <QTemporaryFile>
+#include <QTextStream>
 
 #include "generatefeaturefunction.h"
 
@@ -24,6 +28,7 @@
 #include "ps_planesegment.h"
 #include "ps_spheresegment.h"
 #include "ps_cylindersegment.h"
+#include "ps_tiledsegmentation.h"
 
 #include "ps_loadingdialog.h"
 
@@ -31,110 +36,96 @@ class SegmentationProducer : public QObject{
     Q_OBJECT
     QThread workerThread;
 
+public:
+    SegmentationProducer(QObject *parent = NULL) : QObject(parent), canceled(0), numPlanes(0), numSpheres(0), numCylinders(0){}
 
+    //! \brief Stops the detection of further shapes (may be called from any thread while startSegmentation is running)
+    void cancel(){
+        this->canceled.storeRelease(1);
+    }
 
 public slots:
     void startSegmentation(PS_PointCloud myCloud, PS_InputParameter param){
 
+        this->numPlanes = 0;
+        this->numSpheres = 0;
+        this->numCylinders = 0;
+
+        myCloud.setCancelFlag(&this->canceled);
+
         connect(&myCloud, SIGNAL(updateStatus(QString,int)), this, SLOT(updateStatus(QString,int)));
+        connect(&myCloud, SIGNAL(updateProgress(double)), this, SLOT(updateProgress(double)));
+
+        //hand each shape to the consumer as soon as it is accepted (the shape is converted right away in this thread and is final,
+        //because detectShapes skips the post-processing that would merge or drop it)
+        if(param.streamShapes){
+            connect(&myCloud, SIGNAL(planeAccepted(PS_PlaneSegment*)), this, SLOT(addPlane(PS_PlaneSegment*)), Qt::DirectConnection);
+            connect(&myCloud, SIGNAL(sphereAccepted(PS_SphereSegment*)), this, SLOT(addSphere(PS_SphereSegment*)), Qt::DirectConnection);
+            connect(&myCloud, SIGNAL(cylinderAccepted(PS_CylinderSegment*)), this, SLOT(addCylinder(PS_CylinderSegment*)), Qt::DirectConnection);
+        }
 
         myCloud.setUpOctree(param);
         myCloud.detectShapes(param);
 
-        int i = 1;
-
-        foreach(PS_PlaneSegment *p, myCloud.getDetectedPlanes()){
-
-            FeatureWrapper *myFeature = new FeatureWrapper();
-            Plane *myPlane = new Plane(true);
-            myPlane->setIsSolved(true);
-            myPlane->setFeatureName(QString("plane_%1").arg(i));
-            OiVec xyz(3);
-            OiVec ijk(3);
-            xyz.setAt(0, p->getDistance() * p->getIJK()[0]);
-            xyz.setAt(1, p->getDistance() * p->getIJK()[1]);
-            xyz.setAt(2, p->getDistance() * p->getIJK()[2]);
-            ijk.setAt(0, p->getIJK()[0]);
-            ijk.setAt(1, p->getIJK()[1]);
-            ijk.setAt(2, p->getIJK()[2]);
-            double checkA, checkB;
-            OiVec::dot(checkA, xyz, ijk);
-            OiVec xyz2 = -1.0 * xyz;
-            OiVec::dot(checkB, xyz2, ijk);
-            if(qAbs(checkA - p->getDistance()) > qAbs(checkB - p->getDistance())){
-                xyz = -1.0 * xyz;
+        //without streaming the shapes are handed over after review, merge, verify and final fit
+        if(!param.streamShapes){
+
+            foreach(PS_PlaneSegment *p, myCloud.getDetectedPlanes()){
+                this->addPlane(p);
             }
-            xyz.add(1.0);
-            ijk.add(1.0);
-            myPlane->xyz = xyz;
-            myPlane->ijk = ijk;
-            myFeature->setPlane(myPlane);
-            emit this->addFeature(myFeature);
 
-            i++;
+            foreach(PS_SphereSegment *s, myCloud.getDetectedSpheres()){
+                this->addSphere(s);
+            }
+
+            foreach(PS_CylinderSegment *c, myCloud.getDetectedCylinders()){
+                this->addCylinder(c);
+            }
 
         }
 
-        i = 1;
+        disconnect(&myCloud, 0, this, 0);
+        myCloud.setCancelFlag(NULL);
 
-        foreach(PS_SphereSegment *s, myCloud.getDetectedSpheres()){
+        emit this->stopThread();
 
-            FeatureWrapper *myFeature = new FeatureWrapper();
-            Sphere *mySphere = new Sphere(true);
-            mySphere->setIsSolved(true);
-            mySphere->setFeatureName(QString("sphere_%1").arg(i));
-            OiVec xyz(3);
-            double r;
-            xyz.setAt(0, s->getXYZ()[0]);
-            xyz.setAt(1, s->getXYZ()[1]);
-            xyz.setAt(2, s->getXYZ()[2]);
-            r = s->getRadius();
-            xyz.add(1.0);
-            mySphere->xyz = xyz;
-            mySphere->radius = r;
-            myFeature->setSphere(mySphere);
-            emit this->addFeature(myFeature);
+    }
 
-            i++;
+    void startTiledSegmentation(QString fileName, PS_InputParameter param, quint64 memoryBudget, double overlap){
 
-        }
+        this->numPlanes = 0;
+        this->numSpheres = 0;
+        this->numCylinders = 0;
 
-        i = 1;
-
-        foreach(PS_CylinderSegment *c, myCloud.getDetectedCylinders()){
-
-            FeatureWrapper *myFeature = new FeatureWrapper();
-            Cylinder *myCylinder = new Cylinder(true);
-            myCylinder->setIsSolved(true);
-            myCylinder->setFeatureName(QString("cylinder_%1").arg(i));
-            OiVec xyz(3);
-            OiVec ijk(3);
-            double r;
-            float h[3];
-            c->getX0(h);
-            xyz.setAt(0, h[0]);
-            xyz.setAt(1, h[1]);
-            xyz.setAt(2, h[2]);
-            c->getIJK(h);
-            ijk.setAt(0, h[0]);
-            ijk.setAt(1, h[1]);
-            ijk.setAt(2, h[2]);
-            r = c->getRadius();
-            xyz.add(1.0);
-            ijk.add(1.0);
-            myCylinder->xyz = xyz;
-            myCylinder->ijk = ijk;
-            myCylinder->radius = r;
-            myFeature->setCylinder(myCylinder);
-            emit this->addFeature(myFeature);
-
-            i++;
+        //only the points of one tile are in memory at once (the shapes are handed over after they were stitched)
+        PS_TiledSegmentation tiled;
+        tiled.setMemoryBudget(memoryBudget);
+        tiled.setOverlap(overlap);
+        tiled.setCancelFlag(&this->canceled);
 
-        }
+        connect(&tiled, SIGNAL(updateStatus(QString,int)), this, SLOT(updateStatus(QString,int)));
+        connect(&tiled, SIGNAL(updateProgress(double)), this, SLOT(updateProgress(double)));
+
+        if(tiled.segment(fileName, param)){
+
+            foreach(PS_PlaneSegment *p, tiled.getDetectedPlanes()){
+                this->addPlane(p);
+            }
 
-        disconnect(&myCloud, SIGNAL(updateStatus(QString,int)), this, SLOT(updateStatus(QString,int)));
+            foreach(PS_SphereSegment *s, tiled.getDetectedSpheres()){
+                this->addSphere(s);
+            }
+
+            foreach(PS_CylinderSegment *c, tiled.getDetectedCylinders()){
+                this->addCylinder(c);
+            }
+
+        }
 
+        disconnect(&tiled, 0, this, 0);
 
+        //the file was written by PointCloudSegmentation::exec only for this segmentation
+        QFile::remove(fileName);
 
         emit this->stopThread();
 
@@ -144,10 +135,108 @@ public slots:
         emit this->changeStatus(msg, status);
     }
 
+    void updateProgress(double fraction){
+        emit this->changeProgress(fraction);
+    }
+
+    void addPlane(PS_PlaneSegment *p){
+
+        this->numPlanes++;
+
+        FeatureWrapper *myFeature = new FeatureWrapper();
+        Plane *myPlane = new Plane(true);
+        myPlane->setIsSolved(true);
+        myPlane->setFeatureName(QString("plane_%1").arg(this->numPlanes));
+        OiVec xyz(3);
+        OiVec ijk(3);
+        xyz.setAt(0, p->getDistance() * p->getIJK()[0]);
+        xyz.setAt(1, p->getDistance() * p->getIJK()[1]);
+        xyz.setAt(2, p->getDistance() * p->getIJK()[2]);
+        ijk.setAt(0, p->getIJK()[0]);
+        ijk.setAt(1, p->getIJK()[1]);
+        ijk.setAt(2, p->getIJK()[2]);
+        double checkA, checkB;
+        OiVec::dot(checkA, xyz, ijk);
+        OiVec xyz2 = -1.0 * xyz;
+        OiVec::dot(checkB, xyz2, ijk);
+        if(qAbs(checkA - p->getDistance()) > qAbs(checkB - p->getDistance())){
+            xyz = -1.0 * xyz;
+        }
+        xyz.add(1.0);
+        ijk.add(1.0);
+        myPlane->xyz = xyz;
+        myPlane->ijk = ijk;
+        myFeature->setPlane(myPlane);
+        emit this->addFeature(myFeature);
+
+    }
+
+    void addSphere(PS_SphereSegment *s){
+
+        this->numSpheres++;
+
+        FeatureWrapper *myFeature = new FeatureWrapper();
+        Sphere *mySphere = new Sphere(true);
+        mySphere->setIsSolved(true);
+        mySphere->setFeatureName(QString("sphere_%1").arg(this->numSpheres));
+        OiVec xyz(3);
+        double r;
+        xyz.setAt(0, s->getXYZ()[0]);
+        xyz.setAt(1, s->getXYZ()[1]);
+        xyz.setAt(2, s->getXYZ()[2]);
+        r = s->getRadius();
+        xyz.add(1.0);
+        mySphere->xyz = xyz;
+        mySphere->radius = r;
+        myFeature->setSphere(mySphere);
+        emit this->addFeature(myFeature);
+
+    }
+
+    void addCylinder(PS_CylinderSegment *c){
+
+        this->numCylinders++;
+
+        FeatureWrapper *myFeature = new FeatureWrapper();
+        Cylinder *myCylinder = new Cylinder(true);
+        myCylinder->setIsSolved(true);
+        myCylinder->setFeatureName(QString("cylinder_%1").arg(this->numCylinders));
+        OiVec xyz(3);
+        OiVec ijk(3);
+        double r;
+        float h[3];
+        c->getX0(h);
+        xyz.setAt(0, h[0]);
+        xyz.setAt(1, h[1]);
+        xyz.setAt(2, h[2]);
+        c->getIJK(h);
+        ijk.setAt(0, h[0]);
+        ijk.setAt(1, h[1]);
+        ijk.setAt(2, h[2]);
+        r = c->getRadius();
+        xyz.add(1.0);
+        ijk.add(1.0);
+        myCylinder->xyz = xyz;
+        myCylinder->ijk = ijk;
+        myCylinder->radius = r;
+        myFeature->setCylinder(myCylinder);
+        emit this->addFeature(myFeature);
+
+    }
+
 signals:
     void stopThread();
     void changeStatus(QString, int);
+    void changeProgress(double);
     void addFeature(FeatureWrapper*);
+
+private:
+    QAtomicInt canceled; //polled by PS_PointCloud::detectShapes
+
+    //number of features of each type that were handed over (used for the feature names)
+    int numPlanes;
+    int numSpheres;
+    int numCylinders;
 };
 
 class SegmentationConsumer : public QObject{
@@ -162,12 +251,17 @@ public:
     SegmentationConsumer(PointCloud &myCloud, QObject *parent = NULL) : QObject(parent), myPointCloud(myCloud){
         qRegisterMetaType<PS_PointCloud>("PS_PointCloud");
         qRegisterMetaType<PS_InputParameter>("PS_InputParameter");
+        qRegisterMetaType<quint64>("quint64");
         this->mySegmenter = new SegmentationProducer();
         this->mySegmenter->moveToThread(&workerThread);
         connect(this, SIGNAL(startSegmentation(PS_PointCloud,PS_InputParameter)),
                 mySegmenter, SLOT(startSegmentation(PS_PointCloud,PS_InputParameter)));
+        connect(this, SIGNAL(startTiledSegmentation(QString,PS_InputParameter,quint64,double)),
+                mySegmenter, SLOT(startTiledSegmentation(QString,PS_InputParameter,quint64,double)));
         connect(mySegmenter, SIGNAL(stopThread()), this, SLOT(stopThread()));
         connect(mySegmenter, SIGNAL(changeStatus(QString,int)), &this->myDialog, SLOT(setStatus(QString,int)));
+        connect(mySegmenter, SIGNAL(changeProgress(double)), &this->myDialog, SLOT(setProgress(double)));
+        connect(&this->myDialog, SIGNAL(cancelRequested()), this, SLOT(cancelSegmentation()));
         connect(mySegmenter, SIGNAL(addFeature(FeatureWrapper*)), this, SLOT(addFeature(FeatureWrapper*)));
 
         workerThread.start();
@@ -185,8 +279,14 @@ public:
         emit this->startSegmentation(myCloud, param);
     }
 
+    void startTiledSegmentationTask(QString fileName, PS_InputParameter param, quint64 memoryBudget, double overlap){
+
+        emit this->startTiledSegmentation(fileName, param, memoryBudget, overlap);
+    }
+
 signals:
     void startSegmentation(PS_PointCloud myCloud, PS_InputParameter param);
+    void startTiledSegmentation(QString fileName, PS_InputParameter param, quint64 memoryBudget, double overlap);
 
 public slots:
     void stopThread(){
@@ -204,6 +304,11 @@ public slots:
         myPointCloud.addSegment(myFeature);
     }
 
+    void cancelSegmentation(){
+        //called directly, because the worker thread does not process events until the segmentation is done
+        this->mySegmenter->cancel();
+    }
+
 private:
     SegmentationProducer *mySegmenter;
 
@@ -230,6 +335,8 @@ protected:
 private:
     SegmentationConsumer *myHandler;
 
+    bool writePoints(PointCloud &pointCloud, QString &fileName);
+
 };
 
 #endif // P_POINTCLOUDSEGMENTATION_H
@@ -1,30 +1,19 @@
 #include "ps_cylindersegment.h"
 
-OiMat PS_CylinderSegment::Ralpha = OiMat(3,3);
-OiMat PS_CylinderSegment::Rbeta = OiMat(3,3);
-OiMat PS_CylinderSegment::Rall = OiMat(3,3);
-OiVec PS_CylinderSegment::x_m_n = OiVec(3);
-OiVec PS_CylinderSegment::n0 = OiVec(3);
-OiVec PS_CylinderSegment::a = OiVec(5);
-OiVec PS_CylinderSegment::b = OiVec(5);
-OiVec PS_CylinderSegment::X0 = OiVec(5);
-OiVec PS_CylinderSegment::x = OiVec(5);
-OiMat PS_CylinderSegment::H = OiMat(3,3);
-OiMat PS_CylinderSegment::u = OiMat(3,3);
-OiVec PS_CylinderSegment::d = OiVec(3);
-OiMat PS_CylinderSegment::v = OiMat(3,3);
-
-OiMat PS_CylinderSegment::verify_u(3,3);
-OiMat PS_CylinderSegment::verify_v(3,3);
-OiVec PS_CylinderSegment::verify_d(3);
-
-PS_CylinderSegment::PS_CylinderSegment(){
+#include "ps_instrumentation.h"
+
+PS_CylinderSegment::PS_CylinderSegment(PS_PointStore *store) : PS_ShapeSegment(store){
 
     //create cylinder states and make sure that myCylinderState points to the same object as myState
     this->myCylinderState = new CylinderState();
     this->myOldState = new CylinderState();
     this->myState = this->myCylinderState;
 
+    for(int i = 0; i < 3; i++){
+        this->axisX0[i] = 0.0f;
+        this->axisN0[i] = 0.0f;
+    }
+
 }
 
 PS_CylinderSegment::~PS_CylinderSegment(){
@@ -49,65 +38,60 @@ bool PS_CylinderSegment::writeToX3D(const QString &filePath){
  * \param param
  * \return
  */
-PS_CylinderSegment *PS_CylinderSegment::detectCylinder(const QList<PS_Point_PC*> &points, const PS_InputParameter &param){
+PS_CylinderSegment *PS_CylinderSegment::detectCylinder(PS_PointStore *store, const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator){
+
+    PS_SCOPED_TIMER(eDetectCylinder);
 
-    PS_CylinderSegment *result = new PS_CylinderSegment();
+    PS_CylinderSegment *result = new PS_CylinderSegment(store);
 
-    int numTrials = 0; //number of necessary trials
     int k = 9; //number of points in a required minimal set to define a cylinder (here 9 points)
-    float p = 1.0 - param.outlierPercentage; //probability of drawing a cylinder-point from the set of points
-    float s = 0.99; //required probability of detecting the cylinder in numTrials trials
 
-    float phk = p;
-    for(int i = 0; i < k-1; i++){
-        phk = phk * p;
+    //search the cylinder with the most inliers (at least 6 points and stop if the cylinder contains mostly all points of the voxel)
+    PS_CylinderSegment hypothesis(store);
+    PS_Ransac ransac(points, param, generator);
+    if(ransac.run(&hypothesis, result, k, param.cylinderParams.maxDistance, 6, 5)){
+        PS_CylinderSegment::checkPointsInCylinder(result, points, param, 1);
     }
 
-    //calculate the number of necessary trials
-    numTrials = (int)ceil(qLn(1.0f - s) / qLn(1.0f - phk));
-
-    //get numTrials random samples
-    QMap<int, QList<PS_Point_PC*> > randomSamples;
-    PS_GeneralMath::getRandomSubsets(randomSamples, numTrials, 9, points);
-
-    for(int i = 0; i < numTrials; i++){
-
-        //create cylinder from k points
-        PS_CylinderSegment *possibleSolution = new PS_CylinderSegment();
-        possibleSolution->minimumSolution(randomSamples.value(i));
-
-        //if the radius is too large/low or there is no solution then break and consider the next random sample
-        if(!possibleSolution->getIsValid() || possibleSolution->getRadius() > param.cylinderParams.maxRadius
-                || possibleSolution->getRadius() < param.cylinderParams.minRadius){
-            continue;
-        }
+    //seed the generator of the detected shape to be able to fit it by sample reproducibly
+    result->setRandomSeed(generator.next());
 
-        //if at least k+1 points are within the cylinder...
-        if(PS_CylinderSegment::checkPointsInCylinder(possibleSolution, points, param, 1) >= 6){
-
-            //...and the solution is better then the best one found before
-            if(possibleSolution->getPoints().size() > result->getPoints().size()){
-
-                //delete the old "best" cylinder
-                if(result != NULL){
-                    delete result;
-                }
-
-                //set the new cylinder as result
-                result = possibleSolution;
-
-                //if the cylinder contains mostly all points of the voxel then break the search
-                if(result->getPoints().size() >= points.size()-5){
-                    break;
-                }
-            }
+    return result;
 
-        }
+}
 
-    }
+/*!
+ * \brief PS_CylinderSegment::isPlausible
+ * Returns true if the cylinder is valid and its radius is within the user defined range
+ * \param param
+ * \return
+ */
+bool PS_CylinderSegment::isPlausible(const PS_InputParameter &param) const{
+    return this->myState->isValid && this->getRadius() <= param.cylinderParams.maxRadius
+            && this->getRadius() >= param.cylinderParams.minRadius;
+}
 
-    return result;
+/*!
+ * \brief PS_CylinderSegment::prepareInlierCheck
+ * Compute the cylinder axis that is used to check the distance of points from the cylinder
+ */
+void PS_CylinderSegment::prepareInlierCheck(){
+    this->getX0(this->axisX0);
+    this->getIJK(this->axisN0);
+}
 
+/*!
+ * \brief PS_CylinderSegment::checkInliers
+ * Check which of the given points lie in a small band around the cylinder surface (prepareInlierCheck has to be called before)
+ * \param points
+ * \param count
+ * \param threshold
+ * \param mask
+ * \return
+ */
+unsigned int PS_CylinderSegment::checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const{
+    return PS_DistanceKernels::cylinderInliers(this->myStore->getXArray(), this->myStore->getYArray(), this->myStore->getZArray(),
+                                               points, count, this->axisX0, this->axisN0, this->myCylinderState->radius, threshold, mask);
 }
 
 /*!
@@ -118,120 +102,33 @@ PS_CylinderSegment *PS_CylinderSegment::detectCylinder(const QList<PS_Point_PC*>
  * \param myPoints
  * \param param
  * \param toleranceFactor
+ * \param inlierMask scratch memory for the inlier mask, e.g. of a PS_ShapeTask (optional, a temporary mask is used if NULL)
  * \return
  */
-int PS_CylinderSegment::checkPointsInCylinder(PS_CylinderSegment *myCylinder, const QList<PS_Point_PC*> &myPoints, const PS_InputParameter &param, const int &toleranceFactor){
+int PS_CylinderSegment::checkPointsInCylinder(PS_CylinderSegment *myCylinder, const vector<quint32> &myPoints, const PS_InputParameter &param, const int &toleranceFactor,
+                                              vector<unsigned char> *inlierMask){
 
     int result = 0; //number of points that were added to the cylinder
 
     if(myCylinder->getIsValid()){
 
-        //get normal vector and 3D point on the cylinder axis
-        /*float ijk[3], x0[3];
-        myCylinder->getX0(x0);
-        myCylinder->getIJK(ijk);*/
-
-        PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-        PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(myCylinder->getAlpha()));
-        PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(myCylinder->getAlpha()));
-        PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(myCylinder->getAlpha()));
-        PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(myCylinder->getAlpha()));
-        PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(myCylinder->getBeta()));
-        PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(myCylinder->getBeta()));
-        PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-        PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(myCylinder->getBeta()));
-        PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(myCylinder->getBeta()));
-
-        PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
-
-        PS_CylinderSegment::x_m_n.setAt(0, myCylinder->getXYZ()[0]);
-        PS_CylinderSegment::x_m_n.setAt(1, myCylinder->getXYZ()[1]);
-        PS_CylinderSegment::x_m_n.setAt(2, 0.0);
-        OiMat::solve(PS_CylinderSegment::x_m_n, PS_CylinderSegment::Rall, (-1.0) * PS_CylinderSegment::x_m_n);
-
-        PS_CylinderSegment::n0.setAt(0, 0.0);
-        PS_CylinderSegment::n0.setAt(1, 0.0);
-        PS_CylinderSegment::n0.setAt(2, 1.0);
-        OiMat::solve(PS_CylinderSegment::n0, PS_CylinderSegment::Rall, PS_CylinderSegment::n0);
-
-        //iterate through all points to check wether they lie in a small band around the cylinder surface
-        for(unsigned int i = 0; i < myPoints.size(); i++){
+        //compute the cylinder axis
+        myCylinder->prepareInlierCheck();
 
-            PS_Point_PC *p = myPoints.at(i);
-
-            //if the point is not used for another shape
-            if(!p->isUsed){
-
-                float b[3]; //vector between point on cylinder axis and point p which is probably on cylinder
-                b[0] = p->xyz[0] - PS_CylinderSegment::x_m_n.getAt(0);
-                b[1] = p->xyz[1] - PS_CylinderSegment::x_m_n.getAt(1);
-                b[2] = p->xyz[2] - PS_CylinderSegment::x_m_n.getAt(2);
-
-                float n0CrossB[3]; //cross product of cylinder axis (length 1) and b
-                n0CrossB[0] = PS_CylinderSegment::n0.getAt(1) * b[2] - PS_CylinderSegment::n0.getAt(2) * b[1];
-                n0CrossB[1] = PS_CylinderSegment::n0.getAt(2) * b[0] - PS_CylinderSegment::n0.getAt(0) * b[2];
-                n0CrossB[2] = PS_CylinderSegment::n0.getAt(0) * b[1] - PS_CylinderSegment::n0.getAt(1) * b[0];
-
-                /*float b[3]; //vector between point on cylinder axis and point p which is probably on cylinder
-                b[0] = p->xyz[0] - x0[0];
-                b[1] = p->xyz[1] - x0[1];
-                b[2] = p->xyz[2] - x0[2];
-
-                float n0CrossB[3]; //cross product of cylinder axis (length 1) and b
-                n0CrossB[0] = ijk[1] * b[2] - ijk[2] * b[1];
-                n0CrossB[1] = ijk[2] * b[0] - ijk[0] * b[2];
-                n0CrossB[2] = ijk[0] * b[1] - ijk[1] * b[0];*/
-
-                /*PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-                PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(myCylinder->getAlpha()));
-                PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(myCylinder->getAlpha()));
-                PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(myCylinder->getAlpha()));
-                PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(myCylinder->getAlpha()));
-                PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(myCylinder->getBeta()));
-                PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(myCylinder->getBeta()));
-                PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-                PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(myCylinder->getBeta()));
-                PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(myCylinder->getBeta()));
-
-                PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
-
-                PS_CylinderSegment::x_m_n.setAt(0, myCylinder->getXYZ()[0]);
-                PS_CylinderSegment::x_m_n.setAt(1, myCylinder->getXYZ()[1]);
-                PS_CylinderSegment::x_m_n.setAt(2, 0.0);
-                OiMat::solve(PS_CylinderSegment::x_m_n, PS_CylinderSegment::Rall, (-1.0) * PS_CylinderSegment::x_m_n);
-
-                PS_CylinderSegment::n0.setAt(0, 0.0);
-                PS_CylinderSegment::n0.setAt(1, 0.0);
-                PS_CylinderSegment::n0.setAt(2, 1.0);
-                OiMat::solve(PS_CylinderSegment::n0, PS_CylinderSegment::Rall, PS_CylinderSegment::n0);
-
-                float b[3]; //vector between point on cylinder axis and point p which is probably on cylinder
-                b[0] = p->xyz[0] - PS_CylinderSegment::x_m_n.getAt(0);
-                b[1] = p->xyz[1] - PS_CylinderSegment::x_m_n.getAt(1);
-                b[2] = p->xyz[2] - PS_CylinderSegment::x_m_n.getAt(2);
-
-                float n0CrossB[3]; //cross product of cylinder axis (length 1) and b
-                n0CrossB[0] = PS_CylinderSegment::n0.getAt(1) * b[2] - PS_CylinderSegment::n0.getAt(2) * b[1];
-                n0CrossB[1] = PS_CylinderSegment::n0.getAt(2) * b[0] - PS_CylinderSegment::n0.getAt(0) * b[2];
-                n0CrossB[2] = PS_CylinderSegment::n0.getAt(0) * b[1] - PS_CylinderSegment::n0.getAt(1) * b[0];*/
-
-                float radiusActual = 0.0f; //smallest distance of point p to cylinder axis
-
-                radiusActual = qSqrt( n0CrossB[0]*n0CrossB[0] + n0CrossB[1]*n0CrossB[1] + n0CrossB[2]*n0CrossB[2] );
-
-                float distance = 0.0f;
-
-                distance = radiusActual - myCylinder->getRadius(); //distance error
-
-                //add the point to the cylinder if the distance is lower than a threshold
-                float absDist = qAbs(distance);
-                if(absDist < (((float)toleranceFactor) * param.cylinderParams.maxDistance)){
-                    myCylinder->addPoint(p);
-                    result++;
-                }
+        const PS_PointStore *store = myCylinder->getPointStore();
 
-            }
+        //check the distance of all points from the cylinder surface in one batch
+        vector<unsigned char> localMask;
+        vector<unsigned char> &mask = (inlierMask != NULL) ? *inlierMask : localMask;
+        mask.resize(myPoints.size());
+        myCylinder->checkInliers(myPoints.data(), myPoints.size(), ((float)toleranceFactor) * param.cylinderParams.maxDistance, mask.data());
 
+        //add all inliers that are not used for another shape to the cylinder
+        for(unsigned int i = 0; i < myPoints.size(); i++){
+            if(mask[i] && !store->isUsed(myPoints[i])){
+                myCylinder->addPoint(myPoints[i]);
+                result++;
+            }
         }
 
     }
@@ -246,7 +143,9 @@ int PS_CylinderSegment::checkPointsInCylinder(PS_CylinderSegment *myCylinder, co
  */
 void PS_CylinderSegment::fit(){
 
-    if(this->myState->myPoints.size() < 6){
+    PS_COUNT(eRefits, 1);
+
+    if(this->myPoints.size() < 6){
         this->myState->isValid = false;
         return;
     }
@@ -258,328 +157,38 @@ void PS_CylinderSegment::fit(){
     centroid[0] = 0.0;
     centroid[1] = 0.0;
     centroid[2] = 0.0;
-
-    //initialize variables
-    //OiVec L(numPoints*3); //observations
-    OiVec v(numPoints*3); //approximation of corrections
-    OiVec L0(numPoints*3); //L + v
-    //OiMat B(numPoints, 3*numPoints); //derivations with respect to (L+v0)
-    //OiMat A(numPoints, 5); //derivations with respect to unknowns
-    OiVec c(numPoints+5); //right side
-    //OiMat BBT(numPoints, numPoints);
-    //OiMat AT(5, numPoints);
-    OiMat N(numPoints+5, numPoints+5); //normal equation matrix
-    OiVec res(numPoints+5); //adjustment result
-    //OiVec k(numPoints);
-    double _r = 0.0, _X0 = 0.0, _Y0 = 0.0, _alpha = 0.0, _beta = 0.0;
-    double _r_armijo = 0.0, _X0_armijo = 0.0, _Y0_armijo = 0.0, _alpha_armijo = 0.0, _beta_armijo = 0.0;
-    double _x = 0.0, _y = 0.0, _z = 0.0;
-    double a1 = 0.0, a2 = 0.0;
-    double diff = 0.0, _xr = 0.0, _yr = 0.0;
-    double sigma = 2.0;
-
-    //set approximations of unknowns
-    _r = this->getRadius();
-    _X0 = this->getXYZ()[0];
-    _Y0 = this->getXYZ()[1];
-    _alpha = this->getAlpha();
-    _beta = this->getBeta();
-    for(int i = 0; i < 5; i++){
-        PS_CylinderSegment::x.setAt(i, 0.0);
-    }
-
-    //fill L vector
     for(int i = 0; i < numPoints; i++){
-        L0.setAt(i*3, this->myState->myPoints.at(i)->xyz[0]);
-        L0.setAt(i*3+1, this->myState->myPoints.at(i)->xyz[1]);
-        L0.setAt(i*3+2, this->myState->myPoints.at(i)->xyz[2]);
-
-        centroid[0] += this->myState->myPoints.at(i)->xyz[0];
-        centroid[1] += this->myState->myPoints.at(i)->xyz[1];
-        centroid[2] += this->myState->myPoints.at(i)->xyz[2];
+        centroid[0] += this->myStore->getX(this->myPoints[i]);
+        centroid[1] += this->myStore->getY(this->myPoints[i]);
+        centroid[2] += this->myStore->getZ(this->myPoints[i]);
     }
-    //L0 = L;
     centroid[0] = centroid[0] / (double)numPoints;
     centroid[1] = centroid[1] / (double)numPoints;
     centroid[2] = centroid[2] / (double)numPoints;
 
-    int numIterations = 0;
-
-    double stopAA = 0.0, stopBB = 0.0, stopXX = 0.0;
-    do{
-
-        //improve unknowns
-        _r += PS_CylinderSegment::x.getAt(0);
-        _X0 += PS_CylinderSegment::x.getAt(1);
-        _Y0 += PS_CylinderSegment::x.getAt(2);
-        _alpha += PS_CylinderSegment::x.getAt(3);
-        _beta += PS_CylinderSegment::x.getAt(4);
-
-        //improve observations
-        L0 = L0 + v;
-
-        //build rotations matrices
-        PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-        PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(_alpha));
-        PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(_alpha));
-        PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(_alpha));
-        PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(_alpha));
-        PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(_beta));
-        PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(_beta));
-        PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-        PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(_beta));
-        PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(_beta));
-
-        PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
-
-
-        //fill A and B matrix + w vector + rechte Seite
-        for(int i = 0; i < numPoints; i++){
-
-            _x = L0.getAt(i*3);
-            _y = L0.getAt(i*3+1);
-            _z = L0.getAt(i*3+2);
-
-            a1 = _X0 + _x * qCos(_beta) + _y * qSin(_alpha) * qSin(_beta) + _z * qCos(_alpha) * qSin(_beta);
-            a2 = _Y0 + _y * qCos(_alpha) - _z * qSin(_alpha);
-
-            //B.setAt(i, i*3, -1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2)); // x
-            //B.setAt(i, i*3+1, -1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)); // y
-            //B.setAt(i, i*3+2, -1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)); // z
-
-            //A
-            N.setAt(i, numPoints, 1.0);
-            N.setAt(i, numPoints+1, -1.0 * a1 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(i, numPoints+2, -1.0 * a2 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(i, numPoints+3, -1.0 * ((_y * qSin(_beta) * qCos(_alpha) - _z * qSin(_beta) * qSin(_alpha)) * a1 - (_y * qSin(_alpha) + _z * qCos(_alpha)) * a2) / qSqrt(a1*a1 + a2*a2));
-            N.setAt(i, numPoints+4, -1.0 * (_y * qSin(_alpha) * qCos(_beta) - _x * qSin(_beta) + _z * qCos(_alpha) * qCos(_beta)) * a1 / qSqrt(a1*a1 + a2*a2));
-
-            //AT
-            N.setAt(numPoints, i, 1.0);
-            N.setAt(numPoints+1, i, -1.0 * a1 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(numPoints+2, i, -1.0 * a2 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(numPoints+3, i, -1.0 * ((_y * qSin(_beta) * qCos(_alpha) - _z * qSin(_beta) * qSin(_alpha)) * a1 - (_y * qSin(_alpha) + _z * qCos(_alpha)) * a2) / qSqrt(a1*a1 + a2*a2));
-            N.setAt(numPoints+4, i, -1.0 * (_y * qSin(_alpha) * qCos(_beta) - _x * qSin(_beta) + _z * qCos(_alpha) * qCos(_beta)) * a1 / qSqrt(a1*a1 + a2*a2));
-
-            //BBT
-            N.setAt(i, i, (-1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2))*(-1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2))
-                        + (-1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2))*(-1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2))
-                        + (-1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2))*(-1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)));
-
-
-            //A.setAt(i, 0, 1.0); //r
-            //A.setAt(i, 1, -1.0 * a1 / qSqrt(a1*a1 + a2*a2)); // X0
-            //A.setAt(i, 2, -1.0 * a2 / qSqrt(a1*a1 + a2*a2)); // Y0
-            //A.setAt(i, 3, -1.0 * ((_y * qSin(_beta) * qCos(_alpha) - _z * qSin(_beta) * qSin(_alpha)) * a1 - (_y * qSin(_alpha) + _z * qCos(_alpha)) * a2) / qSqrt(a1*a1 + a2*a2)); // alpha
-            //A.setAt(i, 4, -1.0 * (_y * qSin(_alpha) * qCos(_beta) - _x * qSin(_beta) + _z * qCos(_alpha) * qCos(_beta)) * a1 / qSqrt(a1*a1 + a2*a2)); // beta
-
-            _xr = PS_CylinderSegment::Rall.getAt(0,0) * _x + PS_CylinderSegment::Rall.getAt(0,1) * _y + PS_CylinderSegment::Rall.getAt(0,2) * _z + X0.getAt(1);
-            _yr = PS_CylinderSegment::Rall.getAt(1,0) * _x + PS_CylinderSegment::Rall.getAt(1,1) * _y + PS_CylinderSegment::Rall.getAt(1,2) * _z + X0.getAt(2);
-
-            //genäherter Radius des Zylinders minus Abstand Punkt i zur z-Achse ist der Widerspruch
-            diff = _r - qSqrt(_xr*_xr + _yr*_yr);
-
-            c.setAt(i, diff);
-
-        }
-
-
-        //build normal equation
-        //BBT = B * B.t();
-        //AT = A.t();
-        /*for(int i = 0; i < (numPoints+5); i++){
-            for(int j = 0; j < (numPoints+5); j++){
-                if(i < numPoints && j < numPoints){
-                    //N.setAt(i, j, BBT.getAt(i, j));
-                }else if(i < numPoints && j >= numPoints){
-                    //N.setAt(i, j, A.getAt(i, (j-numPoints)));
-                }else if(i >= numPoints && j < numPoints){
-                    //N.setAt(i, j, AT.getAt((i-numPoints), j));
-                }else if(i >= numPoints && j >= numPoints){
-                    N.setAt(i, j, 0.0);
-                }
-            }
-        }*/
-
-
-        try{
-            if(!OiMat::solve(res, N, -1.0*c)){
-                this->myState->isValid = false;
-                return;
-            }
-            //res = -1.0 * N.inv() * c;
-        }catch(exception &e){
-            this->myState->isValid = false;
-            return;
-        }
-
-        //get results
-        /*for(int i = 0; i < numPoints; i++){
-            k.setAt(i, res.getAt(i));
-        }*/
-        for(int i = numPoints; i < numPoints+5; i++){
-            PS_CylinderSegment::x.setAt(i-numPoints, res.getAt(i));
-        }
-        //v = B.t() * k;
-
-        for(int i = 0; i < numPoints; ++i){
-
-            _x = this->getPoints().at(i)->xyz[0];
-            _y = this->getPoints().at(i)->xyz[1];
-            _z = this->getPoints().at(i)->xyz[2];
-
-            a1 = _X0 + _x * qCos(_beta) + _y * qSin(_alpha) * qSin(_beta) + _z * qCos(_alpha) * qSin(_beta);
-            a2 = _Y0 + _y * qCos(_alpha) - _z * qSin(_alpha);
-
-            //B.setAt(i, i*3, -1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2)); // x
-            //B.setAt(i, i*3+1, -1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)); // y
-            //B.setAt(i, i*3+2, -1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)); // z
-
-            v.setAt(i*3, (-1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2)) * res.getAt(i));
-            v.setAt(i*3+1, (-1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)) * res.getAt(i));
-            v.setAt(i*3+2, (-1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)) * res.getAt(i));
-
-
-
-            /*vx = verb.getAt(i*3);
-            vy = verb.getAt(i*3+1);
-            vz = verb.getAt(i*3+2);
-
-            double r0 = qSqrt( (x + vx - xm) * (x + vx - xm)
-                               + (y + vy - ym) * (y + vy - ym)
-                               + (z + vz - zm) * (z + vz - zm) );
-
-            a1 = (x + vx - xm) / r0;
-            a2 = (y + vy - ym) / r0;
-            a3 = (z + vz - zm) / r0;
-
-            verb.setAt(i*3, vx + res.getAt(i) * a1);
-            verb.setAt(i*3+1, vy + res.getAt(i) * a2);
-            verb.setAt(i*3+2, vz + res.getAt(i) * a3);*/
-
-        }
-
-
-        //s0 a posteriori
-        //double sigma = 0.0;
-        //sigma = qSqrt((v.t() * v).getAt(0) / 13.0);
-
-        //Armijo Regel
-        do{
-
-            sigma = sigma / 2.0;
-
-            _r_armijo = _r + sigma * PS_CylinderSegment::x.getAt(0);
-            _X0_armijo = _X0 + sigma * PS_CylinderSegment::x.getAt(1);
-            _Y0_armijo = _Y0 + sigma * PS_CylinderSegment::x.getAt(2);
-            _alpha_armijo = _alpha + sigma * PS_CylinderSegment::x.getAt(3);
-            _beta_armijo = _beta + sigma * PS_CylinderSegment::x.getAt(4);
-
-            for(int i = 0; i < 5; i++){
-                _x = L0.getAt(i*3);
-                _y = L0.getAt(i*3+1);
-                _z = L0.getAt(i*3+2);
-
-                PS_CylinderSegment::a.setAt(i, _r_armijo - qSqrt( (_X0_armijo + _x*qCos(_beta_armijo) + _y*qSin(_alpha_armijo)*qSin(_beta_armijo) + _z*qCos(_alpha_armijo)*qSin(_beta_armijo))*(_X0_armijo + _x*qCos(_beta_armijo) + _y*qSin(_alpha_armijo)*qSin(_beta_armijo) + _z*qCos(_alpha_armijo)*qSin(_beta_armijo))
-                                       + (_Y0_armijo + _y*qCos(_alpha_armijo) - _z*qSin(_alpha_armijo))*(_Y0_armijo + _y*qCos(_alpha_armijo) - _z*qSin(_alpha_armijo)) ));
-
-                PS_CylinderSegment::b.setAt(i, _r - qSqrt( (_X0 + _x*qCos(_beta) + _y*qSin(_alpha)*qSin(_beta) + _z*qCos(_alpha)*qSin(_beta))*(_X0 + _x*qCos(_beta) + _y*qSin(_alpha)*qSin(_beta) + _z*qCos(_alpha)*qSin(_beta))
-                                               + (_Y0 + _y*qCos(_alpha) - _z*qSin(_alpha))*(_Y0 + _y*qCos(_alpha) - _z*qSin(_alpha)) ));
-            }
-
-        OiVec::dot(stopAA, PS_CylinderSegment::a,PS_CylinderSegment::a);
-        OiVec::dot(stopBB, PS_CylinderSegment::b,PS_CylinderSegment::b);
-
-
-        //}while( OiVec::dot(a,a) > 0.5 * OiVec::dot(b,b) );
-        }while( stopAA > ( stopBB - 2.0 * 0.001 * sigma * stopBB ) );
-
-        PS_CylinderSegment::x = sigma * PS_CylinderSegment::x;
-
-        //neue Verbesserungen
-        //v = B.t() * sigma * k;
-
-        numIterations++;
-        OiVec::dot(stopXX, PS_CylinderSegment::x,PS_CylinderSegment::x);
-
-    }while( (stopXX > 0.0000001) && numIterations < 16 );
-
-
-    if(numIterations >= 16){
+    //adjust the cylinder starting at the current approximation (r, X0, Y0, alpha, beta)
+    double unknowns[5] = {this->getRadius(), this->getXYZ()[0], this->getXYZ()[1], this->getAlpha(), this->getBeta()};
+    if(!this->adjust(this->myPoints, unknowns)){
         this->myState->isValid = false;
         return;
     }
 
-    _r += PS_CylinderSegment::x.getAt(0);
-    _X0 += PS_CylinderSegment::x.getAt(1);
-    _Y0 += PS_CylinderSegment::x.getAt(2);
-    _alpha += PS_CylinderSegment::x.getAt(3);
-    _beta += PS_CylinderSegment::x.getAt(4);
-
-
     //calc sigma
-    PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-    PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(_alpha));
-    PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(_alpha));
-    PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(_alpha));
-    PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(_alpha));
-    PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(_beta));
-    PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(_beta));
-    PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-    PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(_beta));
-    PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(_beta));
-
-    PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
-
-    PS_CylinderSegment::x_m_n.setAt(0, this->getXYZ()[0]);
-    PS_CylinderSegment::x_m_n.setAt(1, this->getXYZ()[1]);
-    PS_CylinderSegment::x_m_n.setAt(2, 0.0);
-    OiMat::solve(PS_CylinderSegment::x_m_n, PS_CylinderSegment::Rall, (-1.0) * PS_CylinderSegment::x_m_n);
-    //PS_CylinderSegment::x_m_n = (PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha).inv() * ((-1.0) * PS_CylinderSegment::x_m_n);
-
-    PS_CylinderSegment::n0.setAt(0, 0.0);
-    PS_CylinderSegment::n0.setAt(1, 0.0);
-    PS_CylinderSegment::n0.setAt(2, 1.0);
-    OiMat::solve(PS_CylinderSegment::n0, PS_CylinderSegment::Rall, PS_CylinderSegment::n0);
-    //PS_CylinderSegment::n0 = (PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha).inv() * PS_CylinderSegment::n0;
-
-
+    double x0[3], n0[3];
+    PS_CylinderSegment::getAxis(unknowns[3], unknowns[4], unknowns[1], unknowns[2], x0, n0);
 
     double sumVV = 0.0;
-    for(int i = 0; i < this->myState->myPoints.size(); i++){
-
-        _x = this->myState->myPoints.at(i)->xyz[0];
-        _y = this->myState->myPoints.at(i)->xyz[1];
-        _z = this->myState->myPoints.at(i)->xyz[2];
-
-        float b[3]; //vector between point on cylinder axis and point p which is probably on cylinder
-        b[0] = _x - PS_CylinderSegment::x_m_n.getAt(0);
-        b[1] = _y - PS_CylinderSegment::x_m_n.getAt(1);
-        b[2] = _z - PS_CylinderSegment::x_m_n.getAt(2);
-
-        float n0CrossB[3]; //cross product of cylinder axis (length 1) and b
-        n0CrossB[0] = PS_CylinderSegment::n0.getAt(1) * b[2] - PS_CylinderSegment::n0.getAt(2) * b[1];
-        n0CrossB[1] = PS_CylinderSegment::n0.getAt(2) * b[0] - PS_CylinderSegment::n0.getAt(0) * b[2];
-        n0CrossB[2] = PS_CylinderSegment::n0.getAt(0) * b[1] - PS_CylinderSegment::n0.getAt(1) * b[0];
-
-        float radiusActual = 0.0f; //smallest distance of point p to cylinder axis
-
-        radiusActual = qSqrt( n0CrossB[0]*n0CrossB[0] + n0CrossB[1]*n0CrossB[1] + n0CrossB[2]*n0CrossB[2] );
-
-        float distance = 0.0f;
-
-        distance = radiusActual - _r; //distance error
-
+    for(int i = 0; i < numPoints; i++){
+        const double distance = PS_CylinderSegment::getAxisDistance(this->myStore->getX(this->myPoints[i]), this->myStore->getY(this->myPoints[i]),
+                                                                    this->myStore->getZ(this->myPoints[i]), x0, n0) - unknowns[0];
         sumVV += distance * distance;
-
     }
 
-
-    this->myCylinderState->radius = _r;
-    this->myCylinderState->xyz[0] = _X0;
-    this->myCylinderState->xyz[1] = _Y0;
-    this->myCylinderState->alpha = _alpha;
-    this->myCylinderState->beta = _beta;
+    this->myCylinderState->radius = unknowns[0];
+    this->myCylinderState->xyz[0] = unknowns[1];
+    this->myCylinderState->xyz[1] = unknowns[2];
+    this->myCylinderState->alpha = unknowns[3];
+    this->myCylinderState->beta = unknowns[4];
     this->myState->mainFocus[0] = centroid[0];
     this->myState->mainFocus[1] = centroid[1];
     this->myState->mainFocus[2] = centroid[2];
@@ -595,7 +204,9 @@ void PS_CylinderSegment::fit(){
  */
 void PS_CylinderSegment::fitBySample(int numPoints){
 
-    if(this->myState->myPoints.size() < 6 || numPoints < 6){
+    PS_COUNT(eRefits, 1);
+
+    if(this->myPoints.size() < 6 || numPoints < 6){
         this->myState->isValid = false;
         return;
     }
@@ -604,9 +215,13 @@ void PS_CylinderSegment::fitBySample(int numPoints){
     if(numPoints > this->getPoints().size()){
         numPoints = this->getPoints().size();
     }
-    QMap<int, QList<PS_Point_PC*> > randomSampleMap;
-    PS_GeneralMath::getRandomSubsets(randomSampleMap, 1, numPoints, this->getPoints());
-    QList<PS_Point_PC*> &randomSample = randomSampleMap.first();
+    QMap<int, vector<quint32> > randomSampleMap;
+    PS_GeneralMath::getRandomSubsets(randomSampleMap, 1, numPoints, this->myPoints, this->myRandom);
+    if(randomSampleMap.isEmpty()){
+        this->myState->isValid = false;
+        return;
+    }
+    vector<quint32> &randomSample = randomSampleMap.first();
 
     if(randomSample.size() == 0){
         this->myState->isValid = false;
@@ -618,50 +233,81 @@ void PS_CylinderSegment::fitBySample(int numPoints){
     centroid[0] = 0.0;
     centroid[1] = 0.0;
     centroid[2] = 0.0;
-    for(int i = 0; i < this->myState->myPoints.size(); i++){
-        centroid[0] += this->myState->myPoints.at(i)->xyz[0];
-        centroid[1] += this->myState->myPoints.at(i)->xyz[1];
-        centroid[2] += this->myState->myPoints.at(i)->xyz[2];
+    for(unsigned int i = 0; i < this->myPoints.size(); i++){
+        centroid[0] += this->myStore->getX(this->myPoints[i]);
+        centroid[1] += this->myStore->getY(this->myPoints[i]);
+        centroid[2] += this->myStore->getZ(this->myPoints[i]);
     }
-    centroid[0] = centroid[0] / (double)this->myState->myPoints.size();
-    centroid[1] = centroid[1] / (double)this->myState->myPoints.size();
-    centroid[2] = centroid[2] / (double)this->myState->myPoints.size();
-
-    //initialize variables
-    //OiVec L(numPoints*3); //observations
-    OiVec v(numPoints*3); //approximation of corrections
-    OiVec L0(numPoints*3); //L + v
-    //OiMat B(numPoints, 3*numPoints); //derivations with respect to (L+v0)
-    //OiMat A(numPoints, 5); //derivations with respect to unknowns
-    OiVec c(numPoints+5); //right side
-    //OiMat BBT(numPoints, numPoints);
-    //OiMat AT(5, numPoints);
-    OiMat N(numPoints+5, numPoints+5); //normal equation matrix
-    OiVec res(numPoints+5); //adjustment result
-    //OiVec k(numPoints);
-    double _r = 0.0, _X0 = 0.0, _Y0 = 0.0, _alpha = 0.0, _beta = 0.0;
+    centroid[0] = centroid[0] / (double)this->myPoints.size();
+    centroid[1] = centroid[1] / (double)this->myPoints.size();
+    centroid[2] = centroid[2] / (double)this->myPoints.size();
+
+    //adjust the cylinder starting at the current approximation (r, X0, Y0, alpha, beta)
+    double unknowns[5] = {this->getRadius(), this->getXYZ()[0], this->getXYZ()[1], this->getAlpha(), this->getBeta()};
+    if(!this->adjust(randomSample, unknowns)){
+        this->myState->isValid = false;
+        return;
+    }
+
+    //calc sigma of the sample points
+    double x0[3], n0[3];
+    PS_CylinderSegment::getAxis(unknowns[3], unknowns[4], unknowns[1], unknowns[2], x0, n0);
+
+    double sumVV = 0.0;
+    for(int i = 0; i < numPoints; i++){
+        const double distance = PS_CylinderSegment::getAxisDistance(this->myStore->getX(randomSample[i]), this->myStore->getY(randomSample[i]),
+                                                                    this->myStore->getZ(randomSample[i]), x0, n0) - unknowns[0];
+        sumVV += distance * distance;
+    }
+
+    this->myCylinderState->radius = unknowns[0];
+    this->myCylinderState->xyz[0] = unknowns[1];
+    this->myCylinderState->xyz[1] = unknowns[2];
+    this->myCylinderState->alpha = unknowns[3];
+    this->myCylinderState->beta = unknowns[4];
+    this->myState->mainFocus[0] = centroid[0];
+    this->myState->mainFocus[1] = centroid[1];
+    this->myState->mainFocus[2] = centroid[2];
+    this->myState->sigma = qSqrt( sumVV / ((double)numPoints - 5.0) );
+    this->myState->isValid = true;
+
+}
+
+/*!
+ * \brief PS_CylinderSegment::adjust
+ * Gauss-Helmert adjustment of a cylinder through the given points. BBT is diagonal, so the normal equations
+ *  | BBT  A | | k |   | -w |
+ *  | AT   0 | | x | = |  0 |
+ * are reduced to the 5x5 system (AT * BBT^-1 * A) * x = -AT * BBT^-1 * w and k is computed point by point.
+ * \param points
+ * \param unknowns approximation of the unknowns (r, X0, Y0, alpha, beta) which is replaced by the adjusted values
+ * \return false if the adjustment did not converge
+ */
+bool PS_CylinderSegment::adjust(const vector<quint32> &points, double (&unknowns)[5]) const{
+
+    const int numPoints = points.size();
+
+    double _r = unknowns[0], _X0 = unknowns[1], _Y0 = unknowns[2], _alpha = unknowns[3], _beta = unknowns[4];
     double _r_armijo = 0.0, _X0_armijo = 0.0, _Y0_armijo = 0.0, _alpha_armijo = 0.0, _beta_armijo = 0.0;
     double _x = 0.0, _y = 0.0, _z = 0.0;
-    double a1 = 0.0, a2 = 0.0;
-    double diff = 0.0, _xr = 0.0, _yr = 0.0;
+    double a1 = 0.0, a2 = 0.0, s = 0.0;
     double sigma = 2.0;
-    //OiVec ua;
-
-    //set approximations of unknowns
-    _r = this->getRadius();
-    _X0 = this->getXYZ()[0];
-    _Y0 = this->getXYZ()[1];
-    _alpha = this->getAlpha();
-    _beta = this->getBeta();
-    for(int i = 0; i < 5; i++){
-        PS_CylinderSegment::x.setAt(i, 0.0);
-    }
+
+    vector<double> L0(numPoints*3); //observations + corrections
+    vector<double> b(numPoints*3); //derivations with respect to the observations
+    vector<double> bbt(numPoints);
+    vector<double> w(numPoints);
+    vector<double> a(numPoints*5); //derivations with respect to the unknowns
+    fixed::Mat<5, 5> n;
+    fixed::Vec<5> rhs;
+    fixed::Vec<5> x; //corrections of unknowns
+    double armijoA[5], armijoB[5];
 
     //fill L vector
     for(int i = 0; i < numPoints; i++){
-        L0.setAt(i*3, randomSample.at(i)->xyz[0]);
-        L0.setAt(i*3+1, randomSample.at(i)->xyz[1]);
-        L0.setAt(i*3+2, randomSample.at(i)->xyz[2]);
+        L0[i*3] = this->myStore->getX(points[i]);
+        L0[i*3+1] = this->myStore->getY(points[i]);
+        L0[i*3+2] = this->myStore->getZ(points[i]);
     }
 
     int numIterations = 0;
@@ -670,248 +316,129 @@ void PS_CylinderSegment::fitBySample(int numPoints){
     do{
 
         //improve unknowns
-        _r += PS_CylinderSegment::x.getAt(0);
-        _X0 += PS_CylinderSegment::x.getAt(1);
-        _Y0 += PS_CylinderSegment::x.getAt(2);
-        _alpha += PS_CylinderSegment::x.getAt(3);
-        _beta += PS_CylinderSegment::x.getAt(4);
-
-        //improve observations
-        L0 = L0 + v;
-
-        //build rotations matrices
-        PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-        PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(_alpha));
-        PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(_alpha));
-        PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(_alpha));
-        PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(_alpha));
-        PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(_beta));
-        PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(_beta));
-        PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-        PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(_beta));
-        PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(_beta));
-
-        PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
+        _r += x(0);
+        _X0 += x(1);
+        _Y0 += x(2);
+        _alpha += x(3);
+        _beta += x(4);
+
+        const double ca = qCos(_alpha), sa = qSin(_alpha);
+        const double cb = qCos(_beta), sb = qSin(_beta);
+
+        n = fixed::Mat<5, 5>();
+        rhs = fixed::Vec<5>();
 
         //fill A and B matrix + w vector + rechte Seite
         for(int i = 0; i < numPoints; i++){
 
-            _x = L0.getAt(i*3);
-            _y = L0.getAt(i*3+1);
-            _z = L0.getAt(i*3+2);
-
-            a1 = _X0 + _x * qCos(_beta) + _y * qSin(_alpha) * qSin(_beta) + _z * qCos(_alpha) * qSin(_beta);
-            a2 = _Y0 + _y * qCos(_alpha) - _z * qSin(_alpha);
+            _x = L0[i*3];
+            _y = L0[i*3+1];
+            _z = L0[i*3+2];
 
-            //A
-            N.setAt(i, numPoints, 1.0);
-            N.setAt(i, numPoints+1, -1.0 * a1 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(i, numPoints+2, -1.0 * a2 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(i, numPoints+3, -1.0 * ((_y * qSin(_beta) * qCos(_alpha) - _z * qSin(_beta) * qSin(_alpha)) * a1 - (_y * qSin(_alpha) + _z * qCos(_alpha)) * a2) / qSqrt(a1*a1 + a2*a2));
-            N.setAt(i, numPoints+4, -1.0 * (_y * qSin(_alpha) * qCos(_beta) - _x * qSin(_beta) + _z * qCos(_alpha) * qCos(_beta)) * a1 / qSqrt(a1*a1 + a2*a2));
+            a1 = _X0 + _x * cb + _y * sa * sb + _z * ca * sb;
+            a2 = _Y0 + _y * ca - _z * sa;
+            s = qSqrt(a1*a1 + a2*a2);
 
-            //AT
-            N.setAt(numPoints, i, 1.0);
-            N.setAt(numPoints+1, i, -1.0 * a1 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(numPoints+2, i, -1.0 * a2 / qSqrt(a1*a1 + a2*a2));
-            N.setAt(numPoints+3, i, -1.0 * ((_y * qSin(_beta) * qCos(_alpha) - _z * qSin(_beta) * qSin(_alpha)) * a1 - (_y * qSin(_alpha) + _z * qCos(_alpha)) * a2) / qSqrt(a1*a1 + a2*a2));
-            N.setAt(numPoints+4, i, -1.0 * (_y * qSin(_alpha) * qCos(_beta) - _x * qSin(_beta) + _z * qCos(_alpha) * qCos(_beta)) * a1 / qSqrt(a1*a1 + a2*a2));
+            double *ai = &a[i*5];
+            ai[0] = 1.0; //r
+            ai[1] = -1.0 * a1 / s; // X0
+            ai[2] = -1.0 * a2 / s; // Y0
+            ai[3] = -1.0 * ((_y * sb * ca - _z * sb * sa) * a1 - (_y * sa + _z * ca) * a2) / s; // alpha
+            ai[4] = -1.0 * (_y * sa * cb - _x * sb + _z * ca * cb) * a1 / s; // beta
 
-            //BBT
-            N.setAt(i, i, (-1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2))*(-1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2))
-                        + (-1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2))*(-1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2))
-                        + (-1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2))*(-1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)));
+            b[i*3] = -1.0 * cb * a1 / s; // x
+            b[i*3+1] = -1.0 * (sa * sb * a1 + ca * a2) / s; // y
+            b[i*3+2] = -1.0 * (ca * sb * a1 - sa * a2) / s; // z
+            bbt[i] = b[i*3]*b[i*3] + b[i*3+1]*b[i*3+1] + b[i*3+2]*b[i*3+2];
 
-            _xr = PS_CylinderSegment::Rall.getAt(0,0) * _x + PS_CylinderSegment::Rall.getAt(0,1) * _y + PS_CylinderSegment::Rall.getAt(0,2) * _z + X0.getAt(1);
-            _yr = PS_CylinderSegment::Rall.getAt(1,0) * _x + PS_CylinderSegment::Rall.getAt(1,1) * _y + PS_CylinderSegment::Rall.getAt(1,2) * _z + X0.getAt(2);
+            //genäherter Radius des Zylinders minus Abstand Punkt i zur Zylinderachse ist der Widerspruch
+            w[i] = _r - s;
 
-            //genäherter Radius des Zylinders minus Abstand Punkt i zur z-Achse ist der Widerspruch
-            diff = _r - qSqrt(_xr*_xr + _yr*_yr);
+            if(!(bbt[i] > 0.0)){
+                return false;
+            }
 
-            c.setAt(i, diff);
+            for(int j = 0; j < 5; j++){
+                const double aj = ai[j] / bbt[i];
+                rhs(j) -= aj * w[i];
+                for(int l = j; l < 5; l++){
+                    n(j, l) += aj * ai[l];
+                }
+            }
 
         }
-
-        try{
-            if(!OiMat::solve(res, N, -1.0*c)){
-                this->myState->isValid = false;
-                return;
+        for(int j = 1; j < 5; j++){
+            for(int l = 0; l < j; l++){
+                n(j, l) = n(l, j);
             }
-            //res = -1.0 * N.inv() * c;
-        }catch(exception &e){
-            this->myState->isValid = false;
-            return;
         }
 
-        //get results
-        for(int i = numPoints; i < numPoints+5; i++){
-            PS_CylinderSegment::x.setAt(i-numPoints, res.getAt(i));
+        if(!fixed::solvePositiveDefinite(n, rhs, x)){
+            return false;
         }
 
+        //improve observations by v = BT * k with k = BBT^-1 * (-w - A * x)
         for(int i = 0; i < numPoints; ++i){
-
-            _x = this->getPoints().at(i)->xyz[0];
-            _y = this->getPoints().at(i)->xyz[1];
-            _z = this->getPoints().at(i)->xyz[2];
-
-            a1 = _X0 + _x * qCos(_beta) + _y * qSin(_alpha) * qSin(_beta) + _z * qCos(_alpha) * qSin(_beta);
-            a2 = _Y0 + _y * qCos(_alpha) - _z * qSin(_alpha);
-
-            v.setAt(i*3, (-1.0 * qCos(_beta) * a1 / qSqrt(a1*a1 + a2*a2)) * res.getAt(i));
-            v.setAt(i*3+1, (-1.0 * (qSin(_alpha) * qSin(_beta) * a1 + qCos(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)) * res.getAt(i));
-            v.setAt(i*3+2, (-1.0 * (qCos(_alpha) * qSin(_beta) * a1 - qSin(_alpha) * a2) / qSqrt(a1*a1 + a2*a2)) * res.getAt(i));
-
+            const double *ai = &a[i*5];
+            const double k = (-1.0 * w[i] - (ai[0]*x(0) + ai[1]*x(1) + ai[2]*x(2) + ai[3]*x(3) + ai[4]*x(4))) / bbt[i];
+            L0[i*3] += b[i*3] * k;
+            L0[i*3+1] += b[i*3+1] * k;
+            L0[i*3+2] += b[i*3+2] * k;
         }
 
-        //s0 a posteriori
-        //double sigma = 0.0;
-        //sigma = qSqrt((v.t() * v).getAt(0) / 13.0);
-
-
         //Armijo Regel
         do{
 
             sigma = sigma / 2.0;
 
-            _r_armijo = _r + sigma * PS_CylinderSegment::x.getAt(0);
-            _X0_armijo = _X0 + sigma * PS_CylinderSegment::x.getAt(1);
-            _Y0_armijo = _Y0 + sigma * PS_CylinderSegment::x.getAt(2);
-            _alpha_armijo = _alpha + sigma * PS_CylinderSegment::x.getAt(3);
-            _beta_armijo = _beta + sigma * PS_CylinderSegment::x.getAt(4);
+            _r_armijo = _r + sigma * x(0);
+            _X0_armijo = _X0 + sigma * x(1);
+            _Y0_armijo = _Y0 + sigma * x(2);
+            _alpha_armijo = _alpha + sigma * x(3);
+            _beta_armijo = _beta + sigma * x(4);
 
             for(int i = 0; i < 5; i++){
-                _x = L0.getAt(i*3);
-                _y = L0.getAt(i*3+1);
-                _z = L0.getAt(i*3+2);
+                _x = L0[i*3];
+                _y = L0[i*3+1];
+                _z = L0[i*3+2];
 
-                PS_CylinderSegment::a.setAt(i, _r_armijo - qSqrt( (_X0_armijo + _x*qCos(_beta_armijo) + _y*qSin(_alpha_armijo)*qSin(_beta_armijo) + _z*qCos(_alpha_armijo)*qSin(_beta_armijo))*(_X0_armijo + _x*qCos(_beta_armijo) + _y*qSin(_alpha_armijo)*qSin(_beta_armijo) + _z*qCos(_alpha_armijo)*qSin(_beta_armijo))
-                                       + (_Y0_armijo + _y*qCos(_alpha_armijo) - _z*qSin(_alpha_armijo))*(_Y0_armijo + _y*qCos(_alpha_armijo) - _z*qSin(_alpha_armijo)) ));
+                armijoA[i] = _r_armijo - qSqrt( (_X0_armijo + _x*qCos(_beta_armijo) + _y*qSin(_alpha_armijo)*qSin(_beta_armijo) + _z*qCos(_alpha_armijo)*qSin(_beta_armijo))*(_X0_armijo + _x*qCos(_beta_armijo) + _y*qSin(_alpha_armijo)*qSin(_beta_armijo) + _z*qCos(_alpha_armijo)*qSin(_beta_armijo))
+                                       + (_Y0_armijo + _y*qCos(_alpha_armijo) - _z*qSin(_alpha_armijo))*(_Y0_armijo + _y*qCos(_alpha_armijo) - _z*qSin(_alpha_armijo)) );
 
-                PS_CylinderSegment::b.setAt(i, _r - qSqrt( (_X0 + _x*qCos(_beta) + _y*qSin(_alpha)*qSin(_beta) + _z*qCos(_alpha)*qSin(_beta))*(_X0 + _x*qCos(_beta) + _y*qSin(_alpha)*qSin(_beta) + _z*qCos(_alpha)*qSin(_beta))
-                                               + (_Y0 + _y*qCos(_alpha) - _z*qSin(_alpha))*(_Y0 + _y*qCos(_alpha) - _z*qSin(_alpha)) ));
+                armijoB[i] = _r - qSqrt( (_X0 + _x*cb + _y*sa*sb + _z*ca*sb)*(_X0 + _x*cb + _y*sa*sb + _z*ca*sb)
+                                         + (_Y0 + _y*ca - _z*sa)*(_Y0 + _y*ca - _z*sa) );
             }
 
-            OiVec::dot(stopAA, PS_CylinderSegment::a,PS_CylinderSegment::a);
-            OiVec::dot(stopBB, PS_CylinderSegment::b,PS_CylinderSegment::b);
+            stopAA = 0.0;
+            stopBB = 0.0;
+            for(int i = 0; i < 5; i++){
+                stopAA += armijoA[i] * armijoA[i];
+                stopBB += armijoB[i] * armijoB[i];
+            }
 
-        //}while( OiVec::dot(a,a) > 0.5 * OiVec::dot(b,b) );
         }while( stopAA > ( stopBB - 2.0 * 0.001 * sigma * stopBB ) );
 
-        PS_CylinderSegment::x = sigma * PS_CylinderSegment::x;
-
-        //neue Verbesserungen
-        //v = B.t() * sigma * k;
+        stopXX = 0.0;
+        for(int i = 0; i < 5; i++){
+            x(i) = sigma * x(i);
+            stopXX += x(i) * x(i);
+        }
 
         numIterations++;
-        OiVec::dot(stopXX, PS_CylinderSegment::x,PS_CylinderSegment::x);
 
     }while( (stopXX > 0.0000001) && numIterations < 16 );
 
     if(numIterations >= 16){
-        this->myState->isValid = false;
-        return;
+        return false;
     }
 
-    _r += PS_CylinderSegment::x.getAt(0);
-    _X0 += PS_CylinderSegment::x.getAt(1);
-    _Y0 += PS_CylinderSegment::x.getAt(2);
-    _alpha += PS_CylinderSegment::x.getAt(3);
-    _beta += PS_CylinderSegment::x.getAt(4);
-
-    //calc sigma
-    PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-    PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(_alpha));
-    PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(_alpha));
-    PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(_alpha));
-    PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(_alpha));
-    PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(_beta));
-    PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(_beta));
-    PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-    PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(_beta));
-    PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(_beta));
-
-    PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
-
-    PS_CylinderSegment::x_m_n.setAt(0, this->getXYZ()[0]);
-    PS_CylinderSegment::x_m_n.setAt(1, this->getXYZ()[1]);
-    PS_CylinderSegment::x_m_n.setAt(2, 0.0);
-    OiMat::solve(PS_CylinderSegment::x_m_n, PS_CylinderSegment::Rall, (-1.0) * PS_CylinderSegment::x_m_n);
-    //PS_CylinderSegment::x_m_n = (PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha).inv() * ((-1.0) * PS_CylinderSegment::x_m_n);
-
-    PS_CylinderSegment::n0.setAt(0, 0.0);
-    PS_CylinderSegment::n0.setAt(1, 0.0);
-    PS_CylinderSegment::n0.setAt(2, 1.0);
-    OiMat::solve(PS_CylinderSegment::n0, PS_CylinderSegment::Rall, PS_CylinderSegment::n0);
-    //PS_CylinderSegment::n0 = (PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha).inv() * PS_CylinderSegment::n0;
-
-    double sumVV = 0.0;
-    /*for(int i = 0; i < this->myState->myPoints.size(); i++){
-
-        _x = this->myState->myPoints.at(i)->xyz[0];
-        _y = this->myState->myPoints.at(i)->xyz[1];
-        _z = this->myState->myPoints.at(i)->xyz[2];
-
-        float b[3]; //vector between point on cylinder axis and point p which is probably on cylinder
-        b[0] = _x - PS_CylinderSegment::x_m_n.getAt(0);
-        b[1] = _y - PS_CylinderSegment::x_m_n.getAt(1);
-        b[2] = _z - PS_CylinderSegment::x_m_n.getAt(2);
-
-        float n0CrossB[3]; //cross product of cylinder axis (length 1) and b
-        n0CrossB[0] = PS_CylinderSegment::n0.getAt(1) * b[2] - PS_CylinderSegment::n0.getAt(2) * b[1];
-        n0CrossB[1] = PS_CylinderSegment::n0.getAt(2) * b[0] - PS_CylinderSegment::n0.getAt(0) * b[2];
-        n0CrossB[2] = PS_CylinderSegment::n0.getAt(0) * b[1] - PS_CylinderSegment::n0.getAt(1) * b[0];
-
-        float radiusActual = 0.0f; //smallest distance of point p to cylinder axis
-
-        radiusActual = qSqrt( n0CrossB[0]*n0CrossB[0] + n0CrossB[1]*n0CrossB[1] + n0CrossB[2]*n0CrossB[2] );
-
-        float distance = 0.0f;
-
-        distance = radiusActual - _r; //distance error
-
-        sumVV += distance * distance;
-
-    }*/
-
-    for(int i = 0; i < numPoints; i++){
-
-        _x = randomSample.at(i)->xyz[0];
-        _y = randomSample.at(i)->xyz[1];
-        _z = randomSample.at(i)->xyz[2];
-
-        float b[3]; //vector between point on cylinder axis and point p which is probably on cylinder
-        b[0] = _x - PS_CylinderSegment::x_m_n.getAt(0);
-        b[1] = _y - PS_CylinderSegment::x_m_n.getAt(1);
-        b[2] = _z - PS_CylinderSegment::x_m_n.getAt(2);
-
-        float n0CrossB[3]; //cross product of cylinder axis (length 1) and b
-        n0CrossB[0] = PS_CylinderSegment::n0.getAt(1) * b[2] - PS_CylinderSegment::n0.getAt(2) * b[1];
-        n0CrossB[1] = PS_CylinderSegment::n0.getAt(2) * b[0] - PS_CylinderSegment::n0.getAt(0) * b[2];
-        n0CrossB[2] = PS_CylinderSegment::n0.getAt(0) * b[1] - PS_CylinderSegment::n0.getAt(1) * b[0];
-
-        float radiusActual = 0.0f; //smallest distance of point p to cylinder axis
-
-        radiusActual = qSqrt( n0CrossB[0]*n0CrossB[0] + n0CrossB[1]*n0CrossB[1] + n0CrossB[2]*n0CrossB[2] );
-
-        float distance = 0.0f;
+    unknowns[0] = _r + x(0);
+    unknowns[1] = _X0 + x(1);
+    unknowns[2] = _Y0 + x(2);
+    unknowns[3] = _alpha + x(3);
+    unknowns[4] = _beta + x(4);
 
-        distance = radiusActual - _r; //distance error
-
-        sumVV += distance * distance;
-
-    }
-
-    this->myCylinderState->radius = _r;
-    this->myCylinderState->xyz[0] = _X0;
-    this->myCylinderState->xyz[1] = _Y0;
-    this->myCylinderState->alpha = _alpha;
-    this->myCylinderState->beta = _beta;
-    this->myState->mainFocus[0] = centroid[0];
-    this->myState->mainFocus[1] = centroid[1];
-    this->myState->mainFocus[2] = centroid[2];
-    //this->myState->sigma = qSqrt( sumVV / ((double)this->myState->myPoints.size() - 5.0) );
-    this->myState->sigma = qSqrt( sumVV / ((double)numPoints - 5.0) );
-    this->myState->isValid = true;
+    return true;
 
 }
 
@@ -920,7 +447,7 @@ void PS_CylinderSegment::fitBySample(int numPoints){
  * Calculate cylinder from 9 or more points
  * \param points
  */
-void PS_CylinderSegment::minimumSolution(const QList<PS_Point_PC *> &points){
+void PS_CylinderSegment::minimumSolution(const vector<quint32> &points){
 
     if(points.size() < 9){
         this->myState->isValid = false;
@@ -935,10 +462,10 @@ void PS_CylinderSegment::minimumSolution(const QList<PS_Point_PC *> &points){
     centroid[1] = 0.0;
     centroid[2] = 0.0;
     for(int i = 0; i < numPoints; i++){
-        PS_Point_PC *p = points.at(i);
-        centroid[0] += p->xyz[0];
-        centroid[1] += p->xyz[1];
-        centroid[2] += p->xyz[2];
+        quint32 p = points[i];
+        centroid[0] += this->myStore->getX(p);
+        centroid[1] += this->myStore->getY(p);
+        centroid[2] += this->myStore->getZ(p);
     }
     centroid[0] = centroid[0] / (float)numPoints;
     centroid[1] = centroid[1] / (float)numPoints;
@@ -947,89 +474,54 @@ void PS_CylinderSegment::minimumSolution(const QList<PS_Point_PC *> &points){
     //centroid of transformed 2D (x,y) coordinates
     double centroid2D[2];
 
-    for(int i = 0; i < 3; i++){
-        for(int j = 0; j < 3; j++){
-            PS_CylinderSegment::H.setAt(i, j, 0.0);
-        }
-    }
-
-    /*double H_val[9];
-    for(int i = 0; i < 9; i++){
-        H_val[i] = 0.0;
-    }*/
+    //covariance matrix of the centroid reduced coordinates
+    fixed::Mat<3, 3> H;
     for (int k = 0; k < numPoints; k++) {
-        PS_Point_PC *p = points.at(k);
+        quint32 p = points[k];
+        const double cr[3] = {this->myStore->getX(p) - centroid[0], this->myStore->getY(p) - centroid[1], this->myStore->getZ(p) - centroid[2]};
         for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                double a = 0.0, b = 0.0;
-                if (i == 0)
-                    a = p->xyz[0] - centroid[0];
-                else if (i == 1)
-                    a = p->xyz[1] - centroid[1];
-                else
-                    a = p->xyz[2] - centroid[2];
-                if (j == 0)
-                    b = p->xyz[0] - centroid[0];
-                else if (j == 1)
-                    b = p->xyz[1] - centroid[1];
-                else
-                    b = p->xyz[2] - centroid[2];
-                //H_val[i*3+j] = H_val[i*3+j] + a * b;
-                PS_CylinderSegment::H.setAt(i,j, PS_CylinderSegment::H.getAt(i,j) + a * b);
+            for (int j = i; j < 3; j++) {
+                H(i, j) += cr[i] * cr[j];
             }
         }
     }
-    /*for(int i = 0; i < 3; i++){
-        for(int j = 0; j < 3; j++){
-            PS_CylinderSegment::H.setAt(i,j, H_val[i*3+j]);
-        }
-    }*/
+    H(1, 0) = H(0, 1);
+    H(2, 0) = H(0, 2);
+    H(2, 1) = H(1, 2);
 
-    try{
-        PS_CylinderSegment::H.svd(PS_CylinderSegment::u, PS_CylinderSegment::d, PS_CylinderSegment::v);
-    }catch(exception &e){
-        qDebug() << "SVD error cylinder minimum solution: " << e.what();
-        this->myState->isValid = false;
-        return;
-    }
+    fixed::Vec<3> eigenValues;
+    fixed::Mat<3, 3> eigenVectors;
+    fixed::eigenSymmetric(H, eigenValues, eigenVectors);
 
     //final solutions of cylinder approximation
     double alpha_n = 0.0, beta_n = 0.0, radius_n = 0.0, x_m_n = 0.0, y_m_n = 0.0;
 
     double vv_ref = numeric_limits<double>::max();//1000.0;
 
-    OiVec pn; //possible normal vector
+    double pn[3]; //possible normal vector
     double a = 0.0, b = 0.0; //sin + cos of rotation angles
     double a_alpha = 0.0, b_alpha = 0.0, a_beta = 0.0, b_beta = 0.0; //possible rotation angles (check acos + asin)
     double alpha = 0.0, beta = 0.0; //rotation angles
     double _y = 0.0, _z = 0.0;
     double tx = 0.0, ty = 0.0; //transformed 2D coordinates
     double x_m = 0.0, y_m = 0.0, radius = 0.0, sum_vv = 0.0; //result parameters in circle fit
-    OiVec v;
-
-    //a matrices for circle adjustment
-    OiVec A1(numPoints);
-    OiMat A2(numPoints,3);
-
-    //result vector for circle fit
-    OiVec s(3);
-
-    //rotated 2D points
-    QList<float> points2D_x;
-    QList<float> points2D_y;
+    double R[3][3]; //rotation matrix
 
-    //rotated centroid reduced 2D points
-    QList<float> centroidreduced2D_x;
-    QList<float> centroidreduced2D_y;
+    //normal equations and result vector for circle fit
+    fixed::Mat<3, 3> N;
+    fixed::Vec<3> n, s;
 
     //one of the eigen-vectors is the approximate cylinder axis
     for(int i = 0; i < 3; i++){
 
-        PS_CylinderSegment::u.getCol(pn, i); //Eigenvektor
+        //Eigenvektor
+        pn[0] = eigenVectors(0, i);
+        pn[1] = eigenVectors(1, i);
+        pn[2] = eigenVectors(2, i);
 
         //calculate rotations angles
-        a = qSqrt(1.0 / (1.0 + (pn.getAt(2)/pn.getAt(1))*(pn.getAt(2)/pn.getAt(1))));
-        b = a * pn.getAt(2) / pn.getAt(1);
+        a = qSqrt(1.0 / (1.0 + (pn[2]/pn[1])*(pn[2]/pn[1])));
+        b = a * pn[2] / pn[1];
 
         b_alpha = qAcos(b);
         a_alpha = qAsin(a);
@@ -1048,14 +540,14 @@ void PS_CylinderSegment::minimumSolution(const QList<PS_Point_PC *> &points){
         }
 
         //Eigenvektor transformieren --> y-Komponente sollte jetzt 0 sein
-        _y = pn.getAt(1);
-        _z = pn.getAt(2);
-        pn.setAt(1, _y * qCos(alpha) - _z * qSin(alpha));
-        pn.setAt(2, _y * qSin(alpha) + _z * qCos(alpha));
+        _y = pn[1];
+        _z = pn[2];
+        pn[1] = _y * qCos(alpha) - _z * qSin(alpha);
+        pn[2] = _y * qSin(alpha) + _z * qCos(alpha);
 
         a = 0.0, b = 0.0;
-        a = qSqrt(1.0 / (1.0 + (-1.0 * pn.getAt(2) / pn.getAt(0))*(-1.0 * pn.getAt(2) / pn.getAt(0))));
-        b = -1.0 * pn.getAt(2) * a / pn.getAt(0);
+        a = qSqrt(1.0 / (1.0 + (-1.0 * pn[2] / pn[0])*(-1.0 * pn[2] / pn[0])));
+        b = -1.0 * pn[2] * a / pn[0];
 
         b_beta = qAcos(b);
         a_beta = qAsin(a);
@@ -1073,87 +565,63 @@ void PS_CylinderSegment::minimumSolution(const QList<PS_Point_PC *> &points){
             beta = this->getCorrespondingCos(b_beta);
         }
 
-        //set up rotations matrices
-        PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-        PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(alpha));
-        PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(alpha));
-        PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(alpha));
-        PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(alpha));
-        PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(beta));
-        PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(beta));
-        PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-        PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(beta));
-        PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(beta));
-
-        PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
+        //set up rotation matrix
+        PS_CylinderSegment::getRotation(alpha, beta, R);
 
         //circle fit to determine midpoint and radius
 
-        //clear transformed point lists
-        points2D_x.clear();
-        points2D_y.clear();
-        centroidreduced2D_x.clear();
-        centroidreduced2D_y.clear();
-
         //reset 2D centroid and recalculate with new rotation
         centroid2D[0] = 0.0;
         centroid2D[1] = 0.0;
-
         for(int j = 0; j < numPoints; j++){
-            PS_Point_PC *p = points.at(j);
-
-            tx = PS_CylinderSegment::Rall.getAt(0,0)*p->xyz[0]
-                    + PS_CylinderSegment::Rall.getAt(0,1)*p->xyz[1]
-                    + PS_CylinderSegment::Rall.getAt(0,2)*p->xyz[2];
-            ty = PS_CylinderSegment::Rall.getAt(1,0)*p->xyz[0]
-                    + PS_CylinderSegment::Rall.getAt(1,1)*p->xyz[1]
-                    + PS_CylinderSegment::Rall.getAt(1,2)*p->xyz[2];
-
-            points2D_x.append( tx );
-            points2D_y.append( ty );
-
-            centroid2D[0] += tx;
-            centroid2D[1] += ty;
+            quint32 p = points[j];
+            centroid2D[0] += R[0][0]*this->myStore->getX(p) + R[0][1]*this->myStore->getY(p) + R[0][2]*this->myStore->getZ(p);
+            centroid2D[1] += R[1][0]*this->myStore->getX(p) + R[1][1]*this->myStore->getY(p) + R[1][2]*this->myStore->getZ(p);
         }
         centroid2D[0] = centroid2D[0] / (float)numPoints;
         centroid2D[1] = centroid2D[1] / (float)numPoints;
 
+        //normal equations of the centroid reduced 2D points (A2 = [x y 1], A1 = x^2 + y^2)
+        N = fixed::Mat<3, 3>();
+        n = fixed::Vec<3>();
         for(int j = 0; j < numPoints; j++){
-            centroidreduced2D_x.append( points2D_x.at(j) - centroid2D[0] );
-            centroidreduced2D_y.append( points2D_y.at(j) - centroid2D[1] );
-        }
-
-        //fill a matrices
-        for(int j = 0; j < numPoints; j++){
-            tx = centroidreduced2D_x.at(j);
-            ty = centroidreduced2D_y.at(j);
-
-            A1.setAt(j, tx*tx + ty*ty);
-
-            A2.setAt(j,0,tx);
-            A2.setAt(j,1,ty);
-            A2.setAt(j,2,1.0);
+            quint32 p = points[j];
+            tx = R[0][0]*this->myStore->getX(p) + R[0][1]*this->myStore->getY(p) + R[0][2]*this->myStore->getZ(p) - centroid2D[0];
+            ty = R[1][0]*this->myStore->getX(p) + R[1][1]*this->myStore->getY(p) + R[1][2]*this->myStore->getZ(p) - centroid2D[1];
+
+            const double row[3] = {tx, ty, 1.0};
+            const double a1 = tx*tx + ty*ty;
+            for(int k = 0; k < 3; k++){
+                n(k) -= row[k] * a1;
+                for(int l = k; l < 3; l++){
+                    N(k, l) += row[k] * row[l];
+                }
+            }
         }
+        N(1, 0) = N(0, 1);
+        N(2, 0) = N(0, 2);
+        N(2, 1) = N(1, 2);
 
-        try{
-            if(!OiMat::solve(s, A2.t() * A2, -1.0 * A2.t() * A1)){
-                this->myState->isValid = false;
-                return;
-            }
-            //s = -1.0 * (A2.t() * A2).inv() * A2.t() * A1;
-        }catch(const exception &e){
-            qDebug() << "inv error cylinder minimum solution: " << e.what();
+        if(!fixed::solvePositiveDefinite(N, n, s)){
             this->myState->isValid = false;
             return;
         }
 
         //midpoint + radius
-        x_m = (-1.0 * s.getAt(0) / 2.0) + centroid2D[0];
-        y_m = (-1.0 * s.getAt(1) / 2.0) + centroid2D[1];
-        radius = qSqrt(0.25 * (s.getAt(0) * s.getAt(0) + s.getAt(1) * s.getAt(1)) - s.getAt(2));
+        x_m = (-1.0 * s(0) / 2.0) + centroid2D[0];
+        y_m = (-1.0 * s(1) / 2.0) + centroid2D[1];
+        radius = qSqrt(0.25 * (s(0) * s(0) + s(1) * s(1)) - s(2));
+
+        //v = -A1 - A2 * s
+        sum_vv = 0.0;
+        for(int j = 0; j < numPoints; j++){
+            quint32 p = points[j];
+            tx = R[0][0]*this->myStore->getX(p) + R[0][1]*this->myStore->getY(p) + R[0][2]*this->myStore->getZ(p) - centroid2D[0];
+            ty = R[1][0]*this->myStore->getX(p) + R[1][1]*this->myStore->getY(p) + R[1][2]*this->myStore->getZ(p) - centroid2D[1];
 
-        v = -1.0 * A1 - A2 * s;
-        OiVec::dot(sum_vv, v,v);
+            const double v = -1.0 * (tx*tx + ty*ty) - (s(0) * tx + s(1) * ty + s(2));
+            sum_vv += v * v;
+        }
         sum_vv = qSqrt(sum_vv / (numPoints-3.0));
 
         //wenn diese Lösung besser als die bisher beste Lösung ist
@@ -1187,7 +655,7 @@ void PS_CylinderSegment::minimumSolution(const QList<PS_Point_PC *> &points){
  */
 void PS_CylinderSegment::sortOut(PS_CylinderSegment *myCylinder, const PS_InputParameter &param, const int &toleranceFactor){
 
-    QList<PS_Point_PC *> myPoints = myCylinder->getPoints();
+    vector<quint32> myPoints = myCylinder->getPoints();
     myCylinder->removeAllPoints();
     PS_CylinderSegment::checkPointsInCylinder(myCylinder, myPoints, param, toleranceFactor);
 
@@ -1198,14 +666,20 @@ void PS_CylinderSegment::sortOut(PS_CylinderSegment *myCylinder, const PS_InputP
  * \param detectedCylinders
  * \param mergedCylinders
  * \param param
+ * \param statistics
+ * \param compareAllPairs true if all pairs of cylinders shall be compared instead of only those in neighbouring cells of the merge index (same result, used as reference in tests)
  */
-void PS_CylinderSegment::mergeCylinders(const QList<PS_CylinderSegment *> &detectedCylinders, QList<PS_CylinderSegment *> &mergedCylinders, const PS_InputParameter &param){
+void PS_CylinderSegment::mergeCylinders(const QList<PS_CylinderSegment *> &detectedCylinders, QList<PS_CylinderSegment *> &mergedCylinders, const PS_InputParameter &param, PS_MergeStatistics &statistics,
+                                        const bool &compareAllPairs){
+
+    PS_SCOPED_TIMER(eMergeCylinders);
 
     /*float diffAlpha = 0.0, diffBeta = 0.0; //rotation angle differences
     float diffXYZ = 0.0; //distance of the 2D centroid of one cylinder to the other cylinder
     float diffRadius = 0.0; //radius difference*/
 
     float diffRadius = 0.0; //radius difference
+    float axisAngle = 0.0f; //angle between the axes
     double distX01C2 = 0.0, distX02C1 = 0.0; //distance of a main focus of the one cylinder to the other cylinder axis
 
     OiVec distHelper(3);
@@ -1220,6 +694,60 @@ void PS_CylinderSegment::mergeCylinders(const QList<PS_CylinderSegment *> &detec
         mergedCylinders.clear();
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
+    statistics = PS_MergeStatistics();
+    statistics.numShapes = detectedCylinders.size();
+
+    /*
+     * bucket the cylinders by their axis direction and by the foot point of the axis (the point of the axis next to a
+     * reference point), so that only cylinders with a similar axis are compared
+     */
+
+    //the reference point is the mean main focus of all cylinders
+    float reference[3] = {0.0f, 0.0f, 0.0f};
+    for(int i = 0; i < detectedCylinders.size(); ++i){
+        for(int k = 0; k < 3; k++){
+            reference[k] += detectedCylinders.at(i)->getMainFocus()[k] / (float)detectedCylinders.size();
+        }
+    }
+
+    //largest radius, largest distance of a main focus from the reference and largest distance of a main focus from its own axis
+    float maxRadius = param.cylinderParams.maxRadius;
+    float extent = 0.0f, maxFocusOffset = 0.0f;
+    for(int i = 0; i < detectedCylinders.size(); ++i){
+        PS_CylinderSegment *c = detectedCylinders.at(i);
+        float *focus = c->getMainFocus();
+        float n[3], x0[3];
+        c->getIJK(n);
+        c->getX0(x0);
+        const double axisX0[3] = {x0[0], x0[1], x0[2]};
+        const double axisN0[3] = {n[0], n[1], n[2]};
+        maxRadius = qMax(maxRadius, c->getRadius());
+        extent = qMax(extent, (float)qSqrt( (focus[0]-reference[0])*(focus[0]-reference[0])
+                + (focus[1]-reference[1])*(focus[1]-reference[1]) + (focus[2]-reference[2])*(focus[2]-reference[2]) ));
+        maxFocusOffset = qMax(maxFocusOffset, (float)PS_CylinderSegment::getAxisDistance(focus[0], focus[1], focus[2], axisX0, axisN0));
+    }
+
+    /*
+     * two cylinders are compared if their axes enclose less than angleTolerance, so each direction component differs by
+     * less than angleTolerance. The foot points then differ by less than the merge distance of five radii, plus the
+     * distance of the main focus from its own axis, plus the tilt of the axis over the extent of the main foci, so a pair
+     * that satisfies the merge criterion is always found in a neighbour cell. The cells are slightly larger than these
+     * bounds to be robust against rounding errors.
+     */
+    float angleTolerance = 0.0873f;
+    float footCellSize = 1.01f * (5.0f * maxRadius + maxFocusOffset + angleTolerance * extent);
+    float cellSizes[6] = {1.01f * angleTolerance, 1.01f * angleTolerance, 1.01f * angleTolerance, footCellSize, footCellSize, footCellSize};
+    PS_MergeIndex index(compareAllPairs ? 0 : 6, cellSizes);
+    float key[6], flippedKey[6];
+    for(int i = 0; i < detectedCylinders.size(); ++i){
+        PS_CylinderSegment::getMergeKey(detectedCylinders.at(i), reference, key);
+        index.insert(i, key);
+    }
+    vector<int> candidates;
+
     //for each cylinder save its merged state
     QMap<int, bool> mergeMap;
     for(int i = 0; i < detectedCylinders.size(); ++i){
@@ -1236,151 +764,184 @@ void PS_CylinderSegment::mergeCylinders(const QList<PS_CylinderSegment *> &detec
 
         PS_CylinderSegment *c1 = detectedCylinders.at(i);
 
-        //compare all cylinder's params and merge them if they fit together
-        for(int j = i+1; j < detectedCylinders.size(); ++j){
-
-            //if the cylinder at position j was merged before
-            if(mergeMap.value(j) == true){
-                continue;
-            }
-
-            PS_CylinderSegment *c2 = detectedCylinders.at(j);
-
-
-            diffRadius = qAbs(c2->getRadius() - c1->getRadius());
+        //the candidates are compared in the order of their position, so the result equals a comparison of all pairs
+        int lastCandidate = i;
+        bool isMerged = true;
+        while(isMerged){
 
-            float ijk1[3], ijk2[3], *x01, *x02, pc1[3], pc2[3];
-            c2->getIJK(ijk2);
-            c1->getIJK(ijk1);
-            c2->getX0(pc2);
-            c1->getX0(pc1);
-            x01 = c1->getMainFocus();
-            x02 = c2->getMainFocus();
+            isMerged = false;
 
-            ijk1Helper.setAt(0, ijk1[0]);
-            ijk1Helper.setAt(1, ijk1[1]);
-            ijk1Helper.setAt(2, ijk1[2]);
-            ijk2Helper.setAt(0, ijk2[0]);
-            ijk2Helper.setAt(1, ijk2[1]);
-            ijk2Helper.setAt(2, ijk2[2]);
-            x01Helper.setAt(0, x01[0]);
-            x01Helper.setAt(1, x01[1]);
-            x01Helper.setAt(2, x01[2]);
-            x02Helper.setAt(0, x02[0]);
-            x02Helper.setAt(1, x02[1]);
-            x02Helper.setAt(2, x02[2]);
-            pc01Helper.setAt(0, pc1[0]);
-            pc01Helper.setAt(1, pc1[1]);
-            pc01Helper.setAt(2, pc1[2]);
-            pc02Helper.setAt(0, pc2[0]);
-            pc02Helper.setAt(1, pc2[1]);
-            pc02Helper.setAt(2, pc2[2]);
-
-
-
-            OiVec::cross(distHelper, ijk2Helper, x01Helper - pc02Helper);
-            OiVec::dot(distX01C2, distHelper, distHelper);
-            distX01C2 = qSqrt(distX01C2);
-
-            OiVec::cross(distHelper, ijk1Helper, x02Helper - pc01Helper);
-            OiVec::dot(distX02C1, distHelper, distHelper);
-            distX02C1 = qSqrt(distX02C1);
-
-
-
-
-            /*diffAlpha = qAbs(c2->getAlpha() - c1->getAlpha());
-            diffBeta = qAbs(c2->getBeta() - c1->getBeta());
-            diffXYZ = qSqrt( (c2->getXYZ()[0]-c1->getXYZ()[0])*(c2->getXYZ()[0]-c1->getXYZ()[0])
-                    + (c2->getXYZ()[1]-c1->getXYZ()[1])*(c2->getXYZ()[1]-c1->getXYZ()[1]) );
-            diffRadius = qAbs(c2->getRadius() - c1->getRadius());
-
-            if(qAbs(diffAlpha - 2.0*PS_PI) < diffAlpha){ diffAlpha = qAbs(diffAlpha - 2.0*PS_PI); }
-            if(qAbs(diffBeta - 2.0*PS_PI) < diffBeta){ diffBeta = qAbs(diffBeta - 2.0*PS_PI); }*/
-
-
-
-            //if the parameter-differences are under a threshold
-            /*if(diffXYZ < 10.0 && diffRadius < 10.0*param.cylinderParams.maxDistance
-                    && diffAlpha < 0.4 && diffBeta < 0.4){*/
-            /*qDebug() << "diff alpha " << diffAlpha;
-            qDebug() << "diff beta " << diffBeta;
-            qDebug() << "diff radius " << diffRadius;*/
-
-            /*if(diffRadius < 10.0*param.cylinderParams.maxDistance && diffXYZ < 10.0*param.cylinderParams.maxDistance
-                                && diffAlpha < 0.0873 && diffBeta < 0.0873){ //0.4*/
+            //get all cylinders with a similar axis (the axis direction may point in the opposite direction)
+            PS_CylinderSegment::getMergeKey(c1, reference, key);
+            for(int k = 0; k < 6; k++){
+                flippedKey[k] = k < 3 ? -key[k] : key[k];
+            }
+            candidates.clear();
+            index.getCandidates(candidates, key);
+            index.getCandidates(candidates, flippedKey);
 
-            //qDebug() << "diff x01c2 " << distX01C2;
-            //qDebug() << "diff x02c1 " << distX02C1;
-            //qDebug() << "diff radius " << diffRadius;
+            //compare the cylinder's params with all candidates and merge them if they fit together
+            for(unsigned int c = 0; c < candidates.size(); ++c){
 
-            /*if(diffRadius < 3.0*param.cylinderParams.maxDistance &&
-                    distX01C2 < 3.0*param.cylinderParams.maxDistance
-                    && distX02C1 < 3.0*param.cylinderParams.maxDistance){*/
-                //qDebug() << "check";
-            //qDebug() << c1->getRadius() << " " << c2->getRadius() << " " << distX01C2 << " " << distX02C1;
-            if(distX01C2 < 5.0*c2->getRadius() && distX02C1 < 5.0*c1->getRadius()){
+                int j = candidates[c];
 
-                PS_CylinderSegment *mergedCylinder = new PS_CylinderSegment();
-                QList<PS_Point_PC *> mergeList;
-                //mergedCylinder->setIsValid(true);
-                foreach(PS_Point_PC *myPoint, c1->getPoints()){
-                    myPoint->isUsed = false;
-                    mergedCylinder->addPoint(myPoint);
-                    mergeList.append(myPoint);
+                //if the cylinder at position j was considered before or was merged before
+                if(j <= lastCandidate || mergeMap.value(j) == true){
+                    continue;
                 }
-                foreach(PS_Point_PC *myPoint, c2->getPoints()){
-                    myPoint->isUsed = false;
-                    mergedCylinder->addPoint(myPoint);
-                    mergeList.append(myPoint);
-                }
-
-                //set approximate values
-                /*if(c1->getPointCount() > c2->getPointCount()){
-                    mergedCylinder->setApproximation(c1->getAlpha(), c1->getBeta(), c1->getRadius(), c1->getXYZ()[0], c1->getXYZ()[1]);
-                }else{
-                    mergedCylinder->setApproximation(c2->getAlpha(), c2->getBeta(), c2->getRadius(), c2->getXYZ()[0], c2->getXYZ()[1]);
-                }*/
+                lastCandidate = j;
+
+                PS_CylinderSegment *c2 = detectedCylinders.at(j);
+
+                statistics.numComparisons++;
 
-                PS_CylinderSegment *tmp = PS_CylinderSegment::detectCylinder(mergeList, param);
-                mergedCylinder->setApproximation(tmp->getAlpha(), tmp->getBeta(), tmp->getRadius(), tmp->getXYZ()[0], tmp->getXYZ()[1]);
-                delete tmp;
 
-                /*qDebug() << "size both " << mergedCylinder->getPointCount();
-                qDebug() << "c1 size " << c1->getPointCount();
-                qDebug() << "c2 size " << c2->getPointCount();*/
+                diffRadius = qAbs(c2->getRadius() - c1->getRadius());
+
+                float ijk1[3], ijk2[3], *x01, *x02, pc1[3], pc2[3];
+                c2->getIJK(ijk2);
+                c1->getIJK(ijk1);
+                c2->getX0(pc2);
+                c1->getX0(pc1);
+                x01 = c1->getMainFocus();
+                x02 = c2->getMainFocus();
+
+                ijk1Helper.setAt(0, ijk1[0]);
+                ijk1Helper.setAt(1, ijk1[1]);
+                ijk1Helper.setAt(2, ijk1[2]);
+                ijk2Helper.setAt(0, ijk2[0]);
+                ijk2Helper.setAt(1, ijk2[1]);
+                ijk2Helper.setAt(2, ijk2[2]);
+                x01Helper.setAt(0, x01[0]);
+                x01Helper.setAt(1, x01[1]);
+                x01Helper.setAt(2, x01[2]);
+                x02Helper.setAt(0, x02[0]);
+                x02Helper.setAt(1, x02[1]);
+                x02Helper.setAt(2, x02[2]);
+                pc01Helper.setAt(0, pc1[0]);
+                pc01Helper.setAt(1, pc1[1]);
+                pc01Helper.setAt(2, pc1[2]);
+                pc02Helper.setAt(0, pc2[0]);
+                pc02Helper.setAt(1, pc2[1]);
+                pc02Helper.setAt(2, pc2[2]);
+
+
+
+                OiVec::cross(distHelper, ijk2Helper, x01Helper - pc02Helper);
+                OiVec::dot(distX01C2, distHelper, distHelper);
+                distX01C2 = qSqrt(distX01C2);
+
+                OiVec::cross(distHelper, ijk1Helper, x02Helper - pc01Helper);
+                OiVec::dot(distX02C1, distHelper, distHelper);
+                distX02C1 = qSqrt(distX02C1);
+
+
+
+
+                /*diffAlpha = qAbs(c2->getAlpha() - c1->getAlpha());
+                diffBeta = qAbs(c2->getBeta() - c1->getBeta());
+                diffXYZ = qSqrt( (c2->getXYZ()[0]-c1->getXYZ()[0])*(c2->getXYZ()[0]-c1->getXYZ()[0])
+                        + (c2->getXYZ()[1]-c1->getXYZ()[1])*(c2->getXYZ()[1]-c1->getXYZ()[1]) );
+                diffRadius = qAbs(c2->getRadius() - c1->getRadius());
+
+                if(qAbs(diffAlpha - 2.0*PS_PI) < diffAlpha){ diffAlpha = qAbs(diffAlpha - 2.0*PS_PI); }
+                if(qAbs(diffBeta - 2.0*PS_PI) < diffBeta){ diffBeta = qAbs(diffBeta - 2.0*PS_PI); }*/
+
+
+
+                //if the parameter-differences are under a threshold
+                /*if(diffXYZ < 10.0 && diffRadius < 10.0*param.cylinderParams.maxDistance
+                        && diffAlpha < 0.4 && diffBeta < 0.4){*/
+                /*qDebug() << "diff alpha " << diffAlpha;
+                qDebug() << "diff beta " << diffBeta;
+                qDebug() << "diff radius " << diffRadius;*/
+
+                /*if(diffRadius < 10.0*param.cylinderParams.maxDistance && diffXYZ < 10.0*param.cylinderParams.maxDistance
+                                    && diffAlpha < 0.0873 && diffBeta < 0.0873){ //0.4*/
+
+                //qDebug() << "diff x01c2 " << distX01C2;
+                //qDebug() << "diff x02c1 " << distX02C1;
+                //qDebug() << "diff radius " << diffRadius;
+
+                /*if(diffRadius < 3.0*param.cylinderParams.maxDistance &&
+                        distX01C2 < 3.0*param.cylinderParams.maxDistance
+                        && distX02C1 < 3.0*param.cylinderParams.maxDistance){*/
+                    //qDebug() << "check";
+                //qDebug() << c1->getRadius() << " " << c2->getRadius() << " " << distX01C2 << " " << distX02C1;
+
+                //angle between the axes (the axis direction may point in the opposite direction)
+                axisAngle = qAcos(qMin(1.0f, qAbs(ijk1[0]*ijk2[0] + ijk1[1]*ijk2[1] + ijk1[2]*ijk2[2])));
+
+                if(distX01C2 < 5.0*c2->getRadius() && distX02C1 < 5.0*c1->getRadius() && axisAngle < angleTolerance){
+
+                    PS_CylinderSegment *mergedCylinder = new PS_CylinderSegment(c1->getPointStore());
+                    mergedCylinder->setRandomSeed(c1->getRandomGenerator().next());
+                    vector<quint32> mergeList;
+                    //mergedCylinder->setIsValid(true);
+                    c1->setPointsUsed(false);
+                    c2->setPointsUsed(false);
+                    foreach(const quint32 &myPoint, c1->getPoints()){
+                        mergedCylinder->addPoint(myPoint);
+                        mergeList.push_back(myPoint);
+                    }
+                    foreach(const quint32 &myPoint, c2->getPoints()){
+                        mergedCylinder->addPoint(myPoint);
+                        mergeList.push_back(myPoint);
+                    }
+
+                    //set approximate values
+                    /*if(c1->getPointCount() > c2->getPointCount()){
+                        mergedCylinder->setApproximation(c1->getAlpha(), c1->getBeta(), c1->getRadius(), c1->getXYZ()[0], c1->getXYZ()[1]);
+                    }else{
+                        mergedCylinder->setApproximation(c2->getAlpha(), c2->getBeta(), c2->getRadius(), c2->getXYZ()[0], c2->getXYZ()[1]);
+                    }*/
+
+                    PS_CylinderSegment *tmp = PS_CylinderSegment::detectCylinder(c1->getPointStore(), mergeList, param, c1->getRandomGenerator());
+                    mergedCylinder->setApproximation(tmp->getAlpha(), tmp->getBeta(), tmp->getRadius(), tmp->getXYZ()[0], tmp->getXYZ()[1]);
+                    delete tmp;
+
+                    /*qDebug() << "size both " << mergedCylinder->getPointCount();
+                    qDebug() << "c1 size " << c1->getPointCount();
+                    qDebug() << "c2 size " << c2->getPointCount();*/
+
+                    //fit cylinder and sort out points that do not satisfy the distance criterion
+                    //mergedCylinder->fitBySample(param.fitSampleSize * 3);
+                    mergedCylinder->fitBySample(param.fitSampleSize * 10);
+                    PS_CylinderSegment::sortOut(mergedCylinder, param, 3);
+                    //mergedCylinder->fitBySample(param.fitSampleSize);
+
+                    /*qDebug() << "valid " << mergedCylinder->getIsValid();
+                    qDebug() << "sigma " << mergedCylinder->getSigma();
+                    qDebug() << "radius " << mergedCylinder->getRadius();
+                    qDebug() << "size " << mergedCylinder->getPointCount();*/
+
+                    if(mergedCylinder->getIsValid() //&& mergedCylinder->getSigma() <= param.cylinderParams.maxDistance
+                            && mergedCylinder->getRadius() >= param.cylinderParams.minRadius
+                            && mergedCylinder->getRadius() <= param.cylinderParams.maxRadius
+                            && mergedCylinder->getPoints().size() > c1->getPoints().size()
+                            && mergedCylinder->getPoints().size() > c2->getPoints().size()){
 
-                //fit cylinder and sort out points that do not satisfy the distance criterion
-                //mergedCylinder->fitBySample(param.fitSampleSize * 3);
-                mergedCylinder->fitBySample(param.fitSampleSize * 10);
-                PS_CylinderSegment::sortOut(mergedCylinder, param, 3);
-                //mergedCylinder->fitBySample(param.fitSampleSize);
+                        //delete single cylinders
+                        delete c1;
+                        delete c2;
 
-                /*qDebug() << "valid " << mergedCylinder->getIsValid();
-                qDebug() << "sigma " << mergedCylinder->getSigma();
-                qDebug() << "radius " << mergedCylinder->getRadius();
-                qDebug() << "size " << mergedCylinder->getPointCount();*/
+                        //set the planes to be merged
+                        mergeMap.insert(j, true);
+                        statistics.numMerges++;
 
-                if(mergedCylinder->getIsValid() //&& mergedCylinder->getSigma() <= param.cylinderParams.maxDistance
-                        && mergedCylinder->getRadius() >= param.cylinderParams.minRadius
-                        && mergedCylinder->getRadius() <= param.cylinderParams.maxRadius
-                        && mergedCylinder->getPoints().size() > c1->getPoints().size()
-                        && mergedCylinder->getPoints().size() > c2->getPoints().size()){
+                        c1 = mergedCylinder;
 
-                    //delete single cylinders
-                    delete c1;
-                    delete c2;
+                        //the merged cylinder has new parameters, so its candidates have to be queried again
+                        isMerged = true;
+                        break;
 
-                    //set the planes to be merged
-                    mergeMap.insert(j, true);
+                        //qDebug() << "accept";
+
+                    }else{
+                        delete mergedCylinder;
+                        //qDebug() << "reject";
+                    }
 
-                    c1 = mergedCylinder;
-
-                    //qDebug() << "accept";
-
-                }else{
-                    delete mergedCylinder;
-                    //qDebug() << "reject";
                 }
 
             }
@@ -1392,6 +953,26 @@ void PS_CylinderSegment::mergeCylinders(const QList<PS_CylinderSegment *> &detec
 
     }
 
+    statistics.elapsedTime = timer.elapsed();
+
+}
+
+/*!
+ * \brief PS_CylinderSegment::getMergeKey
+ * Computes the key of the cylinder in the merge index (axis direction and the point of the axis next to the reference point)
+ * \param c
+ * \param reference
+ * \param key
+ */
+void PS_CylinderSegment::getMergeKey(const PS_CylinderSegment *c, const float (&reference)[3], float (&key)[6]){
+    float n[3], x0[3];
+    c->getIJK(n);
+    c->getX0(x0);
+    float t = (x0[0]-reference[0])*n[0] + (x0[1]-reference[1])*n[1] + (x0[2]-reference[2])*n[2];
+    for(int k = 0; k < 3; k++){
+        key[k] = n[k];
+        key[3+k] = x0[k] - reference[k] - t*n[k];
+    }
 }
 
 /*!
@@ -1406,7 +987,7 @@ void PS_CylinderSegment::reviewNodes(const QList<PS_CylinderSegment *> &detected
     int numAdded = 0; //number of added points
 
     //list to save all unmerged points of each node
-    QList<PS_Point_PC *> unmergedPoints;
+    vector<quint32> unmergedPoints;
 
     foreach(PS_CylinderSegment *c, detectedCylinders){
 
@@ -1414,11 +995,11 @@ void PS_CylinderSegment::reviewNodes(const QList<PS_CylinderSegment *> &detected
         foreach(PS_Node *n, c->getUsedNodes()){
 
             //try to add points that were not added yet
-            n->getUnmergedPoints(unmergedPoints);
+            n->getUnmergedPoints(unmergedPoints, c->getPointStore());
             numAdded = PS_CylinderSegment::checkPointsInCylinder(c, unmergedPoints, param, 3);
-            QList<PS_Point_PC *> cylinderPoints = c->getPoints();
+            const vector<quint32> &cylinderPoints = c->getPoints();
             for(int i = 0; i < numAdded; ++i){
-                cylinderPoints.at(cylinderPoints.size()-1-i)->isUsed = true;
+                c->getPointStore()->setUsed(cylinderPoints[cylinderPoints.size()-1-i], true);
             }
 
             if(numAdded > 0){
@@ -1453,65 +1034,16 @@ void PS_CylinderSegment::reviewNodes(const QList<PS_CylinderSegment *> &detected
  */
 void PS_CylinderSegment::verifyCylinders(const QList<PS_CylinderSegment *> &detectedCylinders, QList<PS_CylinderSegment *> &verifiedCylinders, const PS_InputParameter &param){
 
-    //initialize variables
-    double centroid[3]; //main focus of sphere points
-    int numPoints;
-    double eVal; //smallest eigen-value
-    double planeSigma; //sigma of a fitted plane
-    OiMat ata(3,3);
-
+    /*
+     * the standard deviation of a plane through the shape points is derived from the running sums of the points,
+     * so no shape points have to be iterated here
+     */
     foreach(PS_CylinderSegment *cylinder, detectedCylinders){
-
-        //crCoord.clear();
-
-        numPoints = cylinder->getPointCount();
-
-        //calc centroid of cylinder points
-        centroid[0] = 0.0;
-        centroid[1] = 0.0;
-        centroid[2] = 0.0;
-        for(unsigned int i = 0; i < numPoints; ++i){
-            PS_Point_PC *p = cylinder->getPoints().at(i);
-            centroid[0] += p->xyz[0];
-            centroid[1] += p->xyz[1];
-            centroid[2] += p->xyz[2];
-        }
-        centroid[0] = centroid[0] / (double)numPoints;
-        centroid[1] = centroid[1] / (double)numPoints;
-        centroid[2] = centroid[2] / (double)numPoints;
-
-        double value = 0.0;
-        for(int i = 0; i < 3; ++i){
-            for(int j = 0; j < 3; ++j){
-                value = 0.0;
-                for(unsigned int k = 0; k < numPoints; ++k){
-                    PS_Point_PC *p = cylinder->getPoints().at(k);
-                    value += (p->xyz[i] - centroid[i]) * (p->xyz[j] - centroid[j]);
-                }
-                ata.setAt(i, j, value);
-            }
-        }
-
-        ata.svd(PS_CylinderSegment::verify_u, PS_CylinderSegment::verify_d, PS_CylinderSegment::verify_v);
-
-        eVal = numeric_limits<double>::max();
-        for(int i = 0; i < 3; ++i){
-            if(PS_CylinderSegment::verify_d.getAt(i) < eVal){
-                eVal = PS_CylinderSegment::verify_d.getAt(i);
-            }
-        }
-
-        planeSigma = qSqrt(eVal / (double)(numPoints - 3.0));
-
-        if( 3.0 * planeSigma > cylinder->getSigma()){//3.0*param.sphereParams.maxDistance ){
-
-            //qDebug() << "sigma plane " << planeSigma;
+        if( 3.0 * cylinder->getPlaneSigma() > cylinder->getSigma()){//3.0*param.sphereParams.maxDistance ){
             verifiedCylinders.append(cylinder);
-
         }else{
             delete cylinder;
         }
-
     }
 
 }
@@ -1523,27 +1055,12 @@ void PS_CylinderSegment::verifyCylinders(const QList<PS_CylinderSegment *> &dete
  */
 void PS_CylinderSegment::getX0(float *x0) const{
 
-    PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-    PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(this->getAlpha()));
-    PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(this->getAlpha()));
-    PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(this->getAlpha()));
-    PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(this->getAlpha()));
-    PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(this->getBeta()));
-    PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(this->getBeta()));
-    PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-    PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(this->getBeta()));
-    PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(this->getBeta()));
-
-    PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
+    double axisX0[3], axisN0[3];
+    PS_CylinderSegment::getAxis(this->getAlpha(), this->getBeta(), this->getXYZ()[0], this->getXYZ()[1], axisX0, axisN0);
 
-    PS_CylinderSegment::x_m_n.setAt(0, this->getXYZ()[0]);
-    PS_CylinderSegment::x_m_n.setAt(1, this->getXYZ()[1]);
-    PS_CylinderSegment::x_m_n.setAt(2, 0.0);
-    OiMat::solve(PS_CylinderSegment::x_m_n, PS_CylinderSegment::Rall, (-1.0) * PS_CylinderSegment::x_m_n);
-
-    x0[0] = PS_CylinderSegment::x_m_n.getAt(0);
-    x0[1] = PS_CylinderSegment::x_m_n.getAt(1);
-    x0[2] = PS_CylinderSegment::x_m_n.getAt(2);
+    x0[0] = axisX0[0];
+    x0[1] = axisX0[1];
+    x0[2] = axisX0[2];
 
 }
 
@@ -1554,29 +1071,59 @@ void PS_CylinderSegment::getX0(float *x0) const{
  */
 void PS_CylinderSegment::getIJK(float *ijk) const{
 
-    PS_CylinderSegment::Ralpha.setAt(0, 0, 1.0);
-    PS_CylinderSegment::Ralpha.setAt(1, 1, qCos(this->getAlpha()));
-    PS_CylinderSegment::Ralpha.setAt(1, 2, -qSin(this->getAlpha()));
-    PS_CylinderSegment::Ralpha.setAt(2, 1, qSin(this->getAlpha()));
-    PS_CylinderSegment::Ralpha.setAt(2, 2, qCos(this->getAlpha()));
-    PS_CylinderSegment::Rbeta.setAt(0, 0, qCos(this->getBeta()));
-    PS_CylinderSegment::Rbeta.setAt(0, 2, qSin(this->getBeta()));
-    PS_CylinderSegment::Rbeta.setAt(1, 1, 1.0);
-    PS_CylinderSegment::Rbeta.setAt(2, 0, -qSin(this->getBeta()));
-    PS_CylinderSegment::Rbeta.setAt(2, 2, qCos(this->getBeta()));
-
-    PS_CylinderSegment::Rall = PS_CylinderSegment::Rbeta * PS_CylinderSegment::Ralpha;
-
-    PS_CylinderSegment::n0.setAt(0, 0.0);
-    PS_CylinderSegment::n0.setAt(1, 0.0);
-    PS_CylinderSegment::n0.setAt(2, 1.0);
-    OiMat::solve(PS_CylinderSegment::n0, PS_CylinderSegment::Rall, PS_CylinderSegment::n0);
-
-    PS_CylinderSegment::n0 = PS_CylinderSegment::n0.normalize();
-
-    ijk[0] = PS_CylinderSegment::n0.getAt(0);
-    ijk[1] = PS_CylinderSegment::n0.getAt(1);
-    ijk[2] = PS_CylinderSegment::n0.getAt(2);
+    double axisX0[3], axisN0[3];
+    PS_CylinderSegment::getAxis(this->getAlpha(), this->getBeta(), this->getXYZ()[0], this->getXYZ()[1], axisX0, axisN0);
+
+    ijk[0] = axisN0[0];
+    ijk[1] = axisN0[1];
+    ijk[2] = axisN0[2];
+
+}
+
+/*!
+ * \brief PS_CylinderSegment::getRotation
+ * Set up the rotation matrix Rbeta * Ralpha that transforms the cylinder axis to the z axis
+ * \param alpha rotation around the x axis
+ * \param beta rotation around the y axis
+ * \param r
+ */
+void PS_CylinderSegment::getRotation(const double &alpha, const double &beta, double (&r)[3][3]){
+
+    const double ca = qCos(alpha), sa = qSin(alpha);
+    const double cb = qCos(beta), sb = qSin(beta);
+
+    r[0][0] = cb;
+    r[0][1] = sb * sa;
+    r[0][2] = sb * ca;
+    r[1][0] = 0.0;
+    r[1][1] = ca;
+    r[1][2] = -sa;
+    r[2][0] = -sb;
+    r[2][1] = cb * sa;
+    r[2][2] = cb * ca;
+
+}
+
+/*!
+ * \brief PS_CylinderSegment::getAxis
+ * Get a point on the cylinder axis and its direction (length 1) in the original coordinate system
+ * \param alpha
+ * \param beta
+ * \param x point on the cylinder axis after rotation
+ * \param y point on the cylinder axis after rotation
+ * \param x0
+ * \param n0
+ */
+void PS_CylinderSegment::getAxis(const double &alpha, const double &beta, const double &x, const double &y, double (&x0)[3], double (&n0)[3]){
+
+    double r[3][3];
+    PS_CylinderSegment::getRotation(alpha, beta, r);
+
+    //the rotation is orthogonal, so its inverse is the transposed matrix
+    for(int i = 0; i < 3; i++){
+        x0[i] = -1.0 * (r[0][i] * x + r[1][i] * y);
+        n0[i] = r[2][i];
+    }
 
 }
 
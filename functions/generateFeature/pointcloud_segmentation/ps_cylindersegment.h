@@ -3,17 +3,22 @@
 
 #include <QList>
 #include <QtMath>
+#include <QElapsedTimer>
 #include <string>
 #include <limits>
 #include <math.h>
 
 #include "oivec.h"
 #include "oimat.h"
+#include "fixedmatrix.h"
 
 #include "ps_pointcloud.h"
 #include "ps_generalmath.h"
-#include "ps_point_pc.h"
+#include "ps_pointstore.h"
 #include "ps_shapesegment.h"
+#include "ps_distancekernels.h"
+#include "ps_ransac.h"
+#include "ps_mergeindex.h"
 
 //! \brief cylinder specific attributes
 struct CylinderState : ShapeState{
@@ -64,7 +69,7 @@ class PS_CylinderSegment : public PS_ShapeSegment
 {
 
 public:
-    PS_CylinderSegment();
+    PS_CylinderSegment(PS_PointStore *store);
     ~PS_CylinderSegment();
 
     bool writeToX3D(const QString &filePath);
@@ -72,7 +77,10 @@ public:
     void fit();
     void fitBySample(int numPoints);
 
-    void minimumSolution(const QList<PS_Point_PC *> &points);
+    void minimumSolution(const vector<quint32> &points);
+    bool isPlausible(const PS_InputParameter &param) const;
+    void prepareInlierCheck();
+    unsigned int checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const;
 
     //! \brief Returns the radius of the cylinder
     inline float getRadius() const{
@@ -99,10 +107,12 @@ public:
 
     void setApproximation(const float &alpha, const float &beta, const float &radius, const float &x, const float &y); //set values by hand
 
-    static PS_CylinderSegment *detectCylinder(const QList<PS_Point_PC*> &points, const PS_InputParameter &param);
-    static int checkPointsInCylinder(PS_CylinderSegment *myCylinder, const QList<PS_Point_PC*> &myPoints, const PS_InputParameter &param, const int &toleranceFactor); //check wether a point is in the given cylinder
+    static PS_CylinderSegment *detectCylinder(PS_PointStore *store, const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator);
+    static int checkPointsInCylinder(PS_CylinderSegment *myCylinder, const vector<quint32> &myPoints, const PS_InputParameter &param, const int &toleranceFactor,
+                                     vector<unsigned char> *inlierMask = NULL); //check wether a point is in the given cylinder
     static void sortOut(PS_CylinderSegment *myCylinder, const PS_InputParameter &param, const int &toleranceFactor);
-    static void mergeCylinders(const QList<PS_CylinderSegment *> &detectedCylinders, QList<PS_CylinderSegment *> &mergedCylinders, const PS_InputParameter &param);
+    static void mergeCylinders(const QList<PS_CylinderSegment *> &detectedCylinders, QList<PS_CylinderSegment *> &mergedCylinders, const PS_InputParameter &param, PS_MergeStatistics &statistics,
+                               const bool &compareAllPairs = false);
     static void reviewNodes(const QList<PS_CylinderSegment *> &detectedCylinders, const PS_InputParameter &param);
     static void verifyCylinders(const QList<PS_CylinderSegment *> &detectedCylinders, QList<PS_CylinderSegment *> &verifiedCylinders, const PS_InputParameter &param);
 
@@ -112,29 +122,26 @@ private:
     double getCorrespondingSin(double a);
     bool compareAngles(double a, double b);
 
-    //static helpers (to not have to instanciate every time)
-    static OiMat Ralpha;
-    static OiMat Rbeta;
-    static OiMat Rall;
-    static OiVec x_m_n;
-    static OiVec n0;
-    static OiVec a;
-    static OiVec b;
-    static OiVec X0; //approximation of unknowns (r, X0, Y0, alpha, beta)
-    static OiVec x; //corrections of unknowns
-    static OiMat H; //used in minimum solution
-    static OiMat u;
-    static OiVec d;
-    static OiMat v;
-
-    //cylinder verification
-    static OiMat verify_u;
-    static OiMat verify_v;
-    static OiVec verify_d;
+    bool adjust(const vector<quint32> &points, double (&unknowns)[5]) const;
+
+    static void getRotation(const double &alpha, const double &beta, double (&r)[3][3]);
+    static void getAxis(const double &alpha, const double &beta, const double &x, const double &y, double (&x0)[3], double (&n0)[3]);
+    static void getMergeKey(const PS_CylinderSegment *c, const float (&reference)[3], float (&key)[6]);
+
+    //! \brief Returns the distance of the point (x, y, z) from the axis through x0 with direction n0 (length 1)
+    static inline double getAxisDistance(const double &x, const double &y, const double &z, const double (&x0)[3], const double (&n0)[3]){
+        const double b[3] = {x - x0[0], y - x0[1], z - x0[2]};
+        const double c[3] = {n0[1] * b[2] - n0[2] * b[1], n0[2] * b[0] - n0[0] * b[2], n0[0] * b[1] - n0[1] * b[0]};
+        return qSqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+    }
 
     //current cylinder state pointer to access special cylinder attributes
     CylinderState *myCylinderState;
 
+    //axis of the cylinder (computed in prepareInlierCheck)
+    float axisX0[3]; //point on the cylinder axis
+    float axisN0[3]; //direction of the cylinder axis (length 1)
+
 };
 
 #endif // PS_CYLINDERSEGMENT_H
@@ -0,0 +1,262 @@
+#include "ps_distancekernels.h"
+
+#include <cmath>
+
+const unsigned int PS_DistanceKernels::blockSize;
+
+/*
+ * thin wrappers around the available vector instructions so that each kernel is only written once
+ */
+#if defined(PS_KERNELS_AVX2)
+
+#define PS_KERNELS_SIMD
+typedef __m256 PS_Vec;
+static const unsigned int PS_LANES = 8;
+static inline PS_Vec psLoad(const float *v){ return _mm256_loadu_ps(v); }
+static inline PS_Vec psSet(const float &v){ return _mm256_set1_ps(v); }
+static inline PS_Vec psAdd(const PS_Vec &a, const PS_Vec &b){ return _mm256_add_ps(a, b); }
+static inline PS_Vec psSub(const PS_Vec &a, const PS_Vec &b){ return _mm256_sub_ps(a, b); }
+static inline PS_Vec psMul(const PS_Vec &a, const PS_Vec &b){ return _mm256_mul_ps(a, b); }
+static inline PS_Vec psSqrt(const PS_Vec &a){ return _mm256_sqrt_ps(a); }
+static inline PS_Vec psAbs(const PS_Vec &a){ return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline int psLessMask(const PS_Vec &a, const PS_Vec &b){ return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+
+#elif defined(PS_KERNELS_SSE2)
+
+#define PS_KERNELS_SIMD
+typedef __m128 PS_Vec;
+static const unsigned int PS_LANES = 4;
+static inline PS_Vec psLoad(const float *v){ return _mm_loadu_ps(v); }
+static inline PS_Vec psSet(const float &v){ return _mm_set1_ps(v); }
+static inline PS_Vec psAdd(const PS_Vec &a, const PS_Vec &b){ return _mm_add_ps(a, b); }
+static inline PS_Vec psSub(const PS_Vec &a, const PS_Vec &b){ return _mm_sub_ps(a, b); }
+static inline PS_Vec psMul(const PS_Vec &a, const PS_Vec &b){ return _mm_mul_ps(a, b); }
+static inline PS_Vec psSqrt(const PS_Vec &a){ return _mm_sqrt_ps(a); }
+static inline PS_Vec psAbs(const PS_Vec &a){ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline int psLessMask(const PS_Vec &a, const PS_Vec &b){ return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+
+#endif
+
+#ifdef PS_KERNELS_SIMD
+/*!
+ * \brief psStoreMask
+ * Writes the comparison bits of one vector to the byte mask and returns the number of set bits
+ */
+static inline unsigned int psStoreMask(const int &bits, unsigned char *mask){
+    unsigned int count = 0;
+    for(unsigned int l = 0; l < PS_LANES; l++){
+        mask[l] = (unsigned char)((bits >> l) & 1);
+        count += mask[l];
+    }
+    return count;
+}
+#endif
+
+/*!
+ * \brief gatherBlock
+ * Copies the coordinates of count indexed points into the contiguous block buffers
+ */
+static inline void gatherBlock(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                               float *bx, float *by, float *bz){
+    for(unsigned int i = 0; i < count; i++){
+        const quint32 p = indices[i];
+        bx[i] = x[p];
+        by[i] = y[p];
+        bz[i] = z[p];
+    }
+}
+
+/*!
+ * \brief PS_DistanceKernels::planeInliers
+ * Check the distance of count contiguous points from the plane ijk * x = d
+ * \param x
+ * \param y
+ * \param z
+ * \param count
+ * \param ijk normal vector of the plane (length 1)
+ * \param d distance of the plane from the origin
+ * \param threshold
+ * \param mask
+ * \return
+ */
+unsigned int PS_DistanceKernels::planeInliers(const float *x, const float *y, const float *z, const unsigned int &count,
+                                              const float ijk[3], const float &d, const float &threshold, unsigned char *mask){
+
+    unsigned int result = 0;
+    unsigned int i = 0;
+
+#ifdef PS_KERNELS_SIMD
+    const PS_Vec vi = psSet(ijk[0]), vj = psSet(ijk[1]), vk = psSet(ijk[2]);
+    const PS_Vec vd = psSet(d), vt = psSet(threshold);
+    for(; i + PS_LANES <= count; i += PS_LANES){
+        PS_Vec distance = psAdd(psAdd(psMul(psLoad(x + i), vi), psMul(psLoad(y + i), vj)), psMul(psLoad(z + i), vk));
+        distance = psSub(distance, vd);
+        result += psStoreMask(psLessMask(psAbs(distance), vt), mask + i);
+    }
+#endif
+
+    for(; i < count; i++){
+        const float distance = x[i]*ijk[0] + y[i]*ijk[1] + z[i]*ijk[2] - d;
+        mask[i] = (unsigned char)(std::fabs(distance) < threshold);
+        result += mask[i];
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_DistanceKernels::sphereInliers
+ * Check the distance of count contiguous points from the sphere surface
+ * \param x
+ * \param y
+ * \param z
+ * \param count
+ * \param center
+ * \param radius
+ * \param threshold
+ * \param mask
+ * \return
+ */
+unsigned int PS_DistanceKernels::sphereInliers(const float *x, const float *y, const float *z, const unsigned int &count,
+                                               const float center[3], const float &radius, const float &threshold, unsigned char *mask){
+
+    unsigned int result = 0;
+    unsigned int i = 0;
+
+#ifdef PS_KERNELS_SIMD
+    const PS_Vec cx = psSet(center[0]), cy = psSet(center[1]), cz = psSet(center[2]);
+    const PS_Vec vr = psSet(radius), vt = psSet(threshold);
+    for(; i + PS_LANES <= count; i += PS_LANES){
+        const PS_Vec dx = psSub(psLoad(x + i), cx);
+        const PS_Vec dy = psSub(psLoad(y + i), cy);
+        const PS_Vec dz = psSub(psLoad(z + i), cz);
+        const PS_Vec distance = psSub(psSqrt(psAdd(psAdd(psMul(dx, dx), psMul(dy, dy)), psMul(dz, dz))), vr);
+        result += psStoreMask(psLessMask(psAbs(distance), vt), mask + i);
+    }
+#endif
+
+    for(; i < count; i++){
+        const float dx = x[i] - center[0];
+        const float dy = y[i] - center[1];
+        const float dz = z[i] - center[2];
+        const float distance = std::sqrt(dx*dx + dy*dy + dz*dz) - radius;
+        mask[i] = (unsigned char)(std::fabs(distance) < threshold);
+        result += mask[i];
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_DistanceKernels::cylinderInliers
+ * Check the distance of count contiguous points from the cylinder surface
+ * \param x
+ * \param y
+ * \param z
+ * \param count
+ * \param x0 point on the cylinder axis
+ * \param n0 direction of the cylinder axis (length 1)
+ * \param radius
+ * \param threshold
+ * \param mask
+ * \return
+ */
+unsigned int PS_DistanceKernels::cylinderInliers(const float *x, const float *y, const float *z, const unsigned int &count,
+                                                 const float x0[3], const float n0[3], const float &radius, const float &threshold, unsigned char *mask){
+
+    unsigned int result = 0;
+    unsigned int i = 0;
+
+#ifdef PS_KERNELS_SIMD
+    const PS_Vec ox = psSet(x0[0]), oy = psSet(x0[1]), oz = psSet(x0[2]);
+    const PS_Vec nx = psSet(n0[0]), ny = psSet(n0[1]), nz = psSet(n0[2]);
+    const PS_Vec vr = psSet(radius), vt = psSet(threshold);
+    for(; i + PS_LANES <= count; i += PS_LANES){
+        const PS_Vec bx = psSub(psLoad(x + i), ox);
+        const PS_Vec by = psSub(psLoad(y + i), oy);
+        const PS_Vec bz = psSub(psLoad(z + i), oz);
+        const PS_Vec cx = psSub(psMul(ny, bz), psMul(nz, by));
+        const PS_Vec cy = psSub(psMul(nz, bx), psMul(nx, bz));
+        const PS_Vec cz = psSub(psMul(nx, by), psMul(ny, bx));
+        const PS_Vec distance = psSub(psSqrt(psAdd(psAdd(psMul(cx, cx), psMul(cy, cy)), psMul(cz, cz))), vr);
+        result += psStoreMask(psLessMask(psAbs(distance), vt), mask + i);
+    }
+#endif
+
+    for(; i < count; i++){
+        const float bx = x[i] - x0[0];
+        const float by = y[i] - x0[1];
+        const float bz = z[i] - x0[2];
+        const float cx = n0[1] * bz - n0[2] * by;
+        const float cy = n0[2] * bx - n0[0] * bz;
+        const float cz = n0[0] * by - n0[1] * bx;
+        const float distance = std::sqrt(cx*cx + cy*cy + cz*cz) - radius;
+        mask[i] = (unsigned char)(std::fabs(distance) < threshold);
+        result += mask[i];
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_DistanceKernels::planeInliers
+ * Check the distance of the indexed points from the plane (the points are gathered into contiguous blocks)
+ */
+unsigned int PS_DistanceKernels::planeInliers(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                                              const float ijk[3], const float &d, const float &threshold, unsigned char *mask){
+
+    float bx[PS_DistanceKernels::blockSize], by[PS_DistanceKernels::blockSize], bz[PS_DistanceKernels::blockSize];
+
+    unsigned int result = 0;
+    for(unsigned int i = 0; i < count; i += PS_DistanceKernels::blockSize){
+        const unsigned int n = qMin(PS_DistanceKernels::blockSize, count - i);
+        gatherBlock(x, y, z, indices + i, n, bx, by, bz);
+        result += PS_DistanceKernels::planeInliers(bx, by, bz, n, ijk, d, threshold, mask + i);
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_DistanceKernels::sphereInliers
+ * Check the distance of the indexed points from the sphere (the points are gathered into contiguous blocks)
+ */
+unsigned int PS_DistanceKernels::sphereInliers(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                                               const float center[3], const float &radius, const float &threshold, unsigned char *mask){
+
+    float bx[PS_DistanceKernels::blockSize], by[PS_DistanceKernels::blockSize], bz[PS_DistanceKernels::blockSize];
+
+    unsigned int result = 0;
+    for(unsigned int i = 0; i < count; i += PS_DistanceKernels::blockSize){
+        const unsigned int n = qMin(PS_DistanceKernels::blockSize, count - i);
+        gatherBlock(x, y, z, indices + i, n, bx, by, bz);
+        result += PS_DistanceKernels::sphereInliers(bx, by, bz, n, center, radius, threshold, mask + i);
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_DistanceKernels::cylinderInliers
+ * Check the distance of the indexed points from the cylinder (the points are gathered into contiguous blocks)
+ */
+unsigned int PS_DistanceKernels::cylinderInliers(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                                                 const float x0[3], const float n0[3], const float &radius, const float &threshold, unsigned char *mask){
+
+    float bx[PS_DistanceKernels::blockSize], by[PS_DistanceKernels::blockSize], bz[PS_DistanceKernels::blockSize];
+
+    unsigned int result = 0;
+    for(unsigned int i = 0; i < count; i += PS_DistanceKernels::blockSize){
+        const unsigned int n = qMin(PS_DistanceKernels::blockSize, count - i);
+        gatherBlock(x, y, z, indices + i, n, bx, by, bz);
+        result += PS_DistanceKernels::cylinderInliers(bx, by, bz, n, x0, n0, radius, threshold, mask + i);
+    }
+
+    return result;
+
+}
@@ -0,0 +1,46 @@
+#ifndef PS_DISTANCEKERNELS_H
+#define PS_DISTANCEKERNELS_H
+
+#include <QtGlobal>
+
+#if defined(__AVX2__)
+#define PS_KERNELS_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PS_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+/*!
+ * \brief The PS_DistanceKernels class
+ * Batch distance checks of points against a plane, a sphere or a cylinder.
+ * Each kernel writes an inlier mask (1 if the absolute orthogonal distance is below the threshold, 0 otherwise)
+ * and returns the number of inliers. The coordinates are processed in contiguous blocks
+ * using AVX2 or SSE2 if available at compile time and scalar code otherwise.
+ */
+class PS_DistanceKernels
+{
+private:
+    PS_DistanceKernels();
+
+public:
+    //! number of points that are gathered into one contiguous block by the indexed kernels
+    static const unsigned int blockSize = 256;
+
+    static unsigned int planeInliers(const float *x, const float *y, const float *z, const unsigned int &count,
+                                     const float ijk[3], const float &d, const float &threshold, unsigned char *mask);
+    static unsigned int sphereInliers(const float *x, const float *y, const float *z, const unsigned int &count,
+                                      const float center[3], const float &radius, const float &threshold, unsigned char *mask);
+    static unsigned int cylinderInliers(const float *x, const float *y, const float *z, const unsigned int &count,
+                                        const float x0[3], const float n0[3], const float &radius, const float &threshold, unsigned char *mask);
+
+    static unsigned int planeInliers(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                                     const float ijk[3], const float &d, const float &threshold, unsigned char *mask);
+    static unsigned int sphereInliers(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                                      const float center[3], const float &radius, const float &threshold, unsigned char *mask);
+    static unsigned int cylinderInliers(const float *x, const float *y, const float *z, const quint32 *indices, const unsigned int &count,
+                                        const float x0[3], const float n0[3], const float &radius, const float &threshold, unsigned char *mask);
+
+};
+
+#endif // PS_DISTANCEKERNELS_H
@@ -0,0 +1,493 @@
+#include "ps_downsampling.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+
+#include "ps_shapesegment.h"
+#include "ps_random.h"
+
+const quint32 PS_Downsampling::chunkSize;
+const quint32 PS_Downsampling::minVoxelPoints;
+
+/*!
+ * \brief PS_DownsamplingTask::run
+ * Processes chunks of points or voxels until all chunks have been taken by a task
+ */
+void PS_DownsamplingTask::run(){
+
+    const quint64 count = (this->type == eComputeKeys) ? this->downsampling->fullPoints->size() : this->downsampling->voxelKeys.size();
+
+    quint64 begin = (quint64)this->nextChunk->fetchAndAddOrdered(1) * PS_Downsampling::chunkSize;
+    while(begin < count){
+        quint32 end = (quint32)qMin(begin + PS_Downsampling::chunkSize, count);
+        switch(this->type){
+        case eComputeKeys:
+            this->downsampling->computeKeys((quint32)begin, end);
+            break;
+        case eReduceVoxels:
+            this->downsampling->reduceVoxels((quint32)begin, end, this->buffer);
+            break;
+        case eAssignPoints:
+            this->downsampling->assignPoints((quint32)begin, end, this->buffer, this->mask);
+            break;
+        }
+        begin = (quint64)this->nextChunk->fetchAndAddOrdered(1) * PS_Downsampling::chunkSize;
+    }
+
+}
+
+PS_Downsampling::PS_Downsampling() : fullPoints(NULL), reducedPoints(NULL), method(eNoDownsampling), samplingRate(1.0f),
+    randomSeed(0), numThreads(1), voxelSize(0.0f), shapes(NULL), thresholds(NULL)
+{
+    for(int k = 0; k < 3; k++){
+        this->origin[k] = 0.0f;
+        this->dimensions[k] = 1;
+    }
+}
+
+PS_Downsampling::~PS_Downsampling()
+{
+    if(this->reducedPoints != NULL){
+        delete this->reducedPoints;
+    }
+}
+
+/*!
+ * \brief PS_Downsampling::reduce
+ * Sorts the points into the voxel grid and builds the reduced cloud (see getReducedPoints)
+ * \param points all points
+ * \param boundingBox
+ * \param param method, voxel size, sampling rate, seed and number of threads
+ * \return false if no downsampling is requested or if the reduced cloud would be empty
+ */
+bool PS_Downsampling::reduce(PS_PointStore *points, const PS_BoundingBox_PC &boundingBox, const PS_InputParameter &param){
+
+    if(param.downsampling == eNoDownsampling || param.voxelSize <= 0.0f || points == NULL || points->size() == 0){
+        return false;
+    }
+
+    this->fullPoints = points;
+    this->method = param.downsampling;
+    this->samplingRate = qBound(0.0f, param.samplingRate, 1.0f);
+    this->randomSeed = param.randomSeed;
+    this->numThreads = (param.numThreads > 0) ? param.numThreads : QThread::idealThreadCount();
+
+    //set up the voxel grid (the voxels are enlarged if the keys would not fit into 63 bits)
+    this->voxelSize = param.voxelSize;
+    bool fits = false;
+    while(!fits){
+        fits = true;
+        for(int k = 0; k < 3; k++){
+            this->origin[k] = boundingBox.min[k];
+            double extent = qMax((double)boundingBox.max[k] - (double)boundingBox.min[k], 0.0);
+            this->dimensions[k] = (quint64)(extent / this->voxelSize) + 1;
+            if(this->dimensions[k] > (Q_UINT64_C(1) << 21)){
+                fits = false;
+            }
+        }
+        if(!fits){
+            this->voxelSize *= 2.0f;
+        }
+    }
+
+    //sort the points by voxel
+    this->sortByVoxel();
+
+    //number of reduced points of each voxel
+    const quint32 numVoxels = this->voxelKeys.size();
+    this->reducedOffsets.resize(numVoxels + 1);
+    quint32 numReduced = 0;
+    for(quint32 v = 0; v < numVoxels; v++){
+        this->reducedOffsets[v] = numReduced;
+        numReduced += (this->method == eRandomDownsampling) ? this->getRandomCount(v) : this->getCentroidCount(v);
+    }
+    this->reducedOffsets[numVoxels] = numReduced;
+
+    if(numReduced == 0){
+        return false;
+    }
+
+    //compute the reduced points of all voxels and copy them into an own store
+    this->reducedX.resize(numReduced);
+    this->reducedY.resize(numReduced);
+    this->reducedZ.resize(numReduced);
+    this->runTasks(PS_DownsamplingTask::eReduceVoxels, numVoxels);
+
+    if(this->reducedPoints != NULL){
+        delete this->reducedPoints;
+    }
+    this->reducedPoints = new PS_PointStore();
+    this->reducedPoints->append(this->reducedX.data(), this->reducedY.data(), this->reducedZ.data(), numReduced);
+    vector<float>().swap(this->reducedX);
+    vector<float>().swap(this->reducedY);
+    vector<float>().swap(this->reducedZ);
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_Downsampling::getReducedParameter
+ * Returns the parameters to detect the shapes in the reduced cloud (the minimum number of points of each shape type
+ * is scaled by the reduction ratio)
+ * \param param
+ * \return
+ */
+PS_InputParameter PS_Downsampling::getReducedParameter(const PS_InputParameter &param) const{
+
+    const double ratio = this->getReductionRatio();
+
+    PS_InputParameter result = param;
+    result.downsampling = eNoDownsampling;
+    result.planeParams.minPoints = qMin(param.planeParams.minPoints, qMax(10u, (unsigned int)(ratio * param.planeParams.minPoints + 0.5)));
+    result.sphereParams.minPoints = qMin(param.sphereParams.minPoints, qMax(10u, (unsigned int)(ratio * param.sphereParams.minPoints + 0.5)));
+    result.cylinderParams.minPoints = qMin(param.cylinderParams.minPoints, qMax(10u, (unsigned int)(ratio * param.cylinderParams.minPoints + 0.5)));
+    return result;
+
+}
+
+/*!
+ * \brief PS_Downsampling::assignPoints
+ * Moves the shapes that were detected in the reduced cloud to the full cloud. All previous shape points are removed and
+ * each point of the full cloud is added to the first shape (in the order of the list) whose inlier check it passes.
+ * Only the shapes that own reduced points in the voxel of a point or in one of the neighbouring voxels are checked.
+ * \param shapes shapes whose points are indices of the reduced cloud
+ * \param thresholds maximum distance of an inlier of each shape (no points are assigned to shapes with a threshold <= 0)
+ */
+void PS_Downsampling::assignPoints(const QList<PS_ShapeSegment *> &shapes, const vector<float> &thresholds){
+
+    if(this->reducedPoints == NULL){
+        return;
+    }
+
+    //shape of each reduced point (the first shape wins if a point belongs to more than one shape)
+    this->reducedLabels.assign(this->reducedPoints->size(), -1);
+    for(int s = 0; s < shapes.size(); s++){
+        const vector<quint32> &points = shapes.at(s)->getPoints();
+        for(unsigned int i = 0; i < points.size(); i++){
+            if(this->reducedLabels[points[i]] < 0){
+                this->reducedLabels[points[i]] = s;
+            }
+        }
+    }
+
+    //move the shapes to the full cloud
+    foreach(PS_ShapeSegment *shape, shapes){
+        shape->setPointStore(this->fullPoints);
+        shape->prepareInlierCheck();
+    }
+
+    //check the points of all voxels concurrently (each task writes the labels of its own voxels)
+    this->shapes = &shapes;
+    this->thresholds = &thresholds;
+    this->labels.assign(this->sortedPoints.size(), -1);
+    this->runTasks(PS_DownsamplingTask::eAssignPoints, this->voxelKeys.size());
+    this->shapes = NULL;
+    this->thresholds = NULL;
+
+    //add the assigned points to their shapes
+    for(quint32 i = 0; i < this->labels.size(); i++){
+        if(this->labels[i] >= 0){
+            shapes.at(this->labels[i])->addPoint(this->sortedPoints[i]);
+        }
+    }
+
+    vector<qint32>().swap(this->labels);
+    vector<qint32>().swap(this->reducedLabels);
+
+}
+
+/*!
+ * \brief PS_Downsampling::runTasks
+ * Processes count points or voxels with numThreads tasks (chunk by chunk)
+ * \param type
+ * \param count
+ */
+void PS_Downsampling::runTasks(const PS_DownsamplingTask::TaskType &type, const quint64 &count){
+
+    QAtomicInt nextChunk(0);
+
+    if(this->numThreads <= 1 || count < 2 * PS_Downsampling::chunkSize){
+        PS_DownsamplingTask(this, &nextChunk, type).run();
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(this->numThreads);
+    for(int t = 0; t < this->numThreads; t++){
+        pool.start(new PS_DownsamplingTask(this, &nextChunk, type));
+    }
+    pool.waitForDone();
+
+}
+
+/*!
+ * \brief PS_Downsampling::sortByVoxel
+ * Computes the voxel key of each point and sorts the point indices by it with a stable LSD radix sort
+ * (digits of radixBits bits, only the bits that are needed for the keys of the grid are sorted)
+ */
+void PS_Downsampling::sortByVoxel(){
+
+    const quint32 numPoints = this->fullPoints->size();
+
+    this->keys.resize(numPoints);
+    this->sortedPoints.resize(numPoints);
+    this->runTasks(PS_DownsamplingTask::eComputeKeys, numPoints);
+
+    int numBits = 0;
+    const quint64 maxKey = this->dimensions[0] * this->dimensions[1] * this->dimensions[2] - 1;
+    while(numBits < 64 && (maxKey >> numBits) != 0){
+        numBits++;
+    }
+
+    const int radixBits = 11;
+    const quint32 numBuckets = 1 << radixBits;
+    vector<quint64> tempKeys(numPoints);
+    vector<quint32> tempPoints(numPoints);
+    vector<quint32> offsets(numBuckets);
+    for(int shift = 0; shift < numBits; shift += radixBits){
+
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for(quint32 i = 0; i < numPoints; i++){
+            offsets[(this->keys[i] >> shift) & (numBuckets - 1)]++;
+        }
+
+        //skip digits that are equal for all points
+        if(offsets[(this->keys[0] >> shift) & (numBuckets - 1)] == numPoints){
+            continue;
+        }
+
+        quint32 sum = 0;
+        for(quint32 b = 0; b < numBuckets; b++){
+            const quint32 count = offsets[b];
+            offsets[b] = sum;
+            sum += count;
+        }
+        for(quint32 i = 0; i < numPoints; i++){
+            const quint32 target = offsets[(this->keys[i] >> shift) & (numBuckets - 1)]++;
+            tempKeys[target] = this->keys[i];
+            tempPoints[target] = this->sortedPoints[i];
+        }
+        this->keys.swap(tempKeys);
+        this->sortedPoints.swap(tempPoints);
+
+    }
+    vector<quint64>().swap(tempKeys);
+    vector<quint32>().swap(tempPoints);
+
+    //ranges of the points of all occupied voxels
+    this->voxelKeys.clear();
+    this->voxelOffsets.clear();
+    for(quint32 i = 0; i < numPoints; i++){
+        if(i == 0 || this->keys[i] != this->keys[i - 1]){
+            this->voxelKeys.push_back(this->keys[i]);
+            this->voxelOffsets.push_back(i);
+        }
+    }
+    this->voxelOffsets.push_back(numPoints);
+    vector<quint64>().swap(this->keys);
+
+}
+
+/*!
+ * \brief PS_Downsampling::computeKeys
+ * Computes the voxel keys of the points in [begin, end)
+ * \param begin
+ * \param end
+ */
+void PS_Downsampling::computeKeys(const quint32 &begin, const quint32 &end){
+
+    const float *xyz[3] = {this->fullPoints->getXArray(), this->fullPoints->getYArray(), this->fullPoints->getZArray()};
+
+    for(quint32 i = begin; i < end; i++){
+        quint64 cell[3];
+        for(int k = 0; k < 3; k++){
+            float f = (xyz[k][i] - this->origin[k]) / this->voxelSize;
+            cell[k] = (f <= 0.0f) ? 0 : qMin((quint64)f, this->dimensions[k] - 1);
+        }
+        this->keys[i] = (cell[2] * this->dimensions[1] + cell[1]) * this->dimensions[0] + cell[0];
+        this->sortedPoints[i] = i;
+    }
+
+}
+
+/*!
+ * \brief PS_Downsampling::reduceVoxels
+ * Computes the centroid or the random subset of the voxels in [begin, end)
+ * \param begin
+ * \param end
+ * \param buffer scratch memory of the calling task
+ */
+void PS_Downsampling::reduceVoxels(const quint32 &begin, const quint32 &end, vector<quint32> &buffer){
+
+    const float *xyz[3] = {this->fullPoints->getXArray(), this->fullPoints->getYArray(), this->fullPoints->getZArray()};
+
+    for(quint32 v = begin; v < end; v++){
+
+        const quint32 first = this->voxelOffsets[v];
+        const quint32 count = this->voxelOffsets[v + 1] - first;
+        quint32 target = this->reducedOffsets[v];
+
+        if(this->method == eVoxelGridDownsampling){
+
+            //voxels with too few points are dropped (see getCentroidCount)
+            if(this->reducedOffsets[v + 1] == target){
+                continue;
+            }
+
+            double centroid[3] = {0.0, 0.0, 0.0};
+            for(quint32 i = first; i < first + count; i++){
+                const quint32 p = this->sortedPoints[i];
+                centroid[0] += xyz[0][p];
+                centroid[1] += xyz[1][p];
+                centroid[2] += xyz[2][p];
+            }
+            this->reducedX[target] = (float)(centroid[0] / count);
+            this->reducedY[target] = (float)(centroid[1] / count);
+            this->reducedZ[target] = (float)(centroid[2] / count);
+
+        }else{
+
+            //draw the points with a partial Fisher-Yates shuffle from the stream of the voxel (see getRandomCount)
+            const quint32 numSelected = this->reducedOffsets[v + 1] - target;
+            PS_Random generator(PS_Random::deriveSeed(this->randomSeed, v));
+            generator.next();
+            buffer.assign(this->sortedPoints.begin() + first, this->sortedPoints.begin() + first + count);
+            for(quint32 i = 0; i < numSelected; i++){
+                const quint32 j = i + (quint32)generator.nextInRange(count - 1 - i);
+                std::swap(buffer[i], buffer[j]);
+                this->reducedX[target] = xyz[0][buffer[i]];
+                this->reducedY[target] = xyz[1][buffer[i]];
+                this->reducedZ[target] = xyz[2][buffer[i]];
+                target++;
+            }
+
+        }
+
+    }
+
+}
+
+/*!
+ * \brief PS_Downsampling::assignPoints
+ * Assigns the points of the voxels in [begin, end) to the shapes of the current assignPoints call
+ * \param begin
+ * \param end
+ * \param candidates scratch memory of the calling task
+ * \param mask scratch memory of the calling task
+ */
+void PS_Downsampling::assignPoints(const quint32 &begin, const quint32 &end, vector<quint32> &candidates, vector<unsigned char> &mask){
+
+    const quint64 sliceSize = this->dimensions[0] * this->dimensions[1];
+
+    for(quint32 v = begin; v < end; v++){
+
+        //collect the shapes that own reduced points in the voxel or in its neighbours
+        const quint64 key = this->voxelKeys[v];
+        const qint64 cell[3] = {(qint64)(key % this->dimensions[0]), (qint64)((key / this->dimensions[0]) % this->dimensions[1]),
+                                (qint64)(key / sliceSize)};
+        candidates.clear();
+        for(qint64 dz = -1; dz <= 1; dz++){
+            for(qint64 dy = -1; dy <= 1; dy++){
+                for(qint64 dx = -1; dx <= 1; dx++){
+
+                    const qint64 neighbour[3] = {cell[0] + dx, cell[1] + dy, cell[2] + dz};
+                    if(neighbour[0] < 0 || neighbour[1] < 0 || neighbour[2] < 0 || neighbour[0] >= (qint64)this->dimensions[0]
+                            || neighbour[1] >= (qint64)this->dimensions[1] || neighbour[2] >= (qint64)this->dimensions[2]){
+                        continue;
+                    }
+
+                    const qint64 w = (dx == 0 && dy == 0 && dz == 0) ? (qint64)v
+                            : this->findVoxel((quint64)neighbour[2] * sliceSize + (quint64)neighbour[1] * this->dimensions[0] + (quint64)neighbour[0]);
+                    if(w < 0){
+                        continue;
+                    }
+
+                    for(quint32 r = this->reducedOffsets[w]; r < this->reducedOffsets[w + 1]; r++){
+                        const qint32 label = this->reducedLabels[r];
+                        if(label >= 0 && std::find(candidates.begin(), candidates.end(), (quint32)label) == candidates.end()){
+                            candidates.push_back((quint32)label);
+                        }
+                    }
+
+                }
+            }
+        }
+
+        if(candidates.empty()){
+            continue;
+        }
+
+        //check the points of the voxel against the candidates in the order of the shapes
+        std::sort(candidates.begin(), candidates.end());
+        const quint32 first = this->voxelOffsets[v];
+        const quint32 count = this->voxelOffsets[v + 1] - first;
+        mask.resize(count);
+        for(unsigned int c = 0; c < candidates.size(); c++){
+            const quint32 label = candidates[c];
+            if(this->thresholds->at(label) <= 0.0f){
+                continue;
+            }
+            this->shapes->at(label)->checkInliers(this->sortedPoints.data() + first, count, this->thresholds->at(label), mask.data());
+            for(quint32 i = 0; i < count; i++){
+                if(mask[i] && this->labels[first + i] < 0){
+                    this->labels[first + i] = (qint32)label;
+                }
+            }
+        }
+
+    }
+
+}
+
+/*!
+ * \brief PS_Downsampling::getCentroidCount
+ * Returns the number of points of a voxel that are kept by the voxel grid downsampling: the centroid of the voxel if it
+ * contains at least minVoxelPoints points, else none. A single point in a voxel is mostly an outlier, but its centroid
+ * would weigh as much as that of a voxel on a surface. Kept, the outliers make up a large part of the reduced cloud and
+ * the region growing breaks the shapes into many small candidates. The points of dropped voxels on a surface are still
+ * assigned to the shapes (see assignPoints).
+ * \param voxel
+ * \return
+ */
+quint32 PS_Downsampling::getCentroidCount(const quint32 &voxel) const{
+    return (this->voxelOffsets[voxel + 1] - this->voxelOffsets[voxel] >= PS_Downsampling::minVoxelPoints) ? 1 : 0;
+}
+
+/*!
+ * \brief PS_Downsampling::getRandomCount
+ * Returns the number of points of a voxel that are kept by the random downsampling. The expected number is
+ * samplingRate times the number of points, the fraction is rounded up or down at random.
+ * \param voxel
+ * \return
+ */
+quint32 PS_Downsampling::getRandomCount(const quint32 &voxel) const{
+
+    const quint32 count = this->voxelOffsets[voxel + 1] - this->voxelOffsets[voxel];
+    const double expected = (double)this->samplingRate * (double)count;
+
+    quint32 result = (quint32)expected;
+    PS_Random generator(PS_Random::deriveSeed(this->randomSeed, voxel));
+    const double u = (double)(generator.next() >> 11) / 9007199254740992.0; //uniform in [0, 1)
+    if(u < expected - (double)result){
+        result++;
+    }
+    return qMin(result, count);
+
+}
+
+/*!
+ * \brief PS_Downsampling::findVoxel
+ * Returns the index of the occupied voxel with the given key or -1 if the voxel is empty
+ * \param key
+ * \return
+ */
+qint64 PS_Downsampling::findVoxel(const quint64 &key) const{
+    vector<quint64>::const_iterator it = std::lower_bound(this->voxelKeys.begin(), this->voxelKeys.end(), key);
+    if(it == this->voxelKeys.end() || *it != key){
+        return -1;
+    }
+    return it - this->voxelKeys.begin();
+}
@@ -0,0 +1,125 @@
+#ifndef PS_DOWNSAMPLING_H
+#define PS_DOWNSAMPLING_H
+
+#include <QList>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <vector>
+
+#include "ps_pointcloud.h"
+#include "ps_pointstore.h"
+
+class PS_ShapeSegment;
+class PS_Downsampling;
+
+using namespace std;
+
+//! computes the voxel keys of the points, reduces the voxels or assigns the points of the voxels to shapes in a worker thread
+class PS_DownsamplingTask : public QRunnable
+{
+public:
+    enum TaskType{
+        eComputeKeys, //voxel key of each point (chunks of points)
+        eReduceVoxels, //centroid or random subset of each voxel (chunks of voxels)
+        eAssignPoints //shape of each point of the full cloud (chunks of voxels)
+    };
+
+    PS_DownsamplingTask(PS_Downsampling *downsampling, QAtomicInt *nextChunk, TaskType type)
+        : downsampling(downsampling), nextChunk(nextChunk), type(type){}
+
+    void run();
+
+private:
+    PS_Downsampling *downsampling;
+    QAtomicInt *nextChunk;
+    TaskType type;
+    vector<quint32> buffer; //scratch memory that is reused for all voxels processed by this task
+    vector<unsigned char> mask;
+};
+
+/*!
+ * \brief The PS_Downsampling class
+ * Optional decimation of a point cloud before the octree is built (see PS_InputParameter::downsampling).
+ * The points are sorted into a voxel grid (LSD radix sort of the voxel keys like in PS_LinearOctree) and each voxel
+ * is replaced either by the centroid of its points or by a random subset of them (stratified by the voxels).
+ * The voxel grid drops voxels with a single point, which are mostly outliers (the random subset drops most of them, too).
+ * The shapes are detected in the reduced cloud. Afterwards assignPoints moves them back to the full cloud: the points
+ * of each voxel are only checked against the shapes that own reduced points in the voxel or in one of its 26 neighbours,
+ * so that all points are assigned in one parallel pass.
+ */
+class PS_Downsampling
+{
+public:
+    PS_Downsampling();
+    ~PS_Downsampling();
+
+    bool reduce(PS_PointStore *points, const PS_BoundingBox_PC &boundingBox, const PS_InputParameter &param);
+    void assignPoints(const QList<PS_ShapeSegment *> &shapes, const vector<float> &thresholds);
+
+    //! \brief Returns the store of the reduced points (owned by this object)
+    inline PS_PointStore *getReducedPoints() const{
+        return this->reducedPoints;
+    }
+
+    //! \brief Returns the store of all points
+    inline PS_PointStore *getFullPoints() const{
+        return this->fullPoints;
+    }
+
+    //! \brief Returns the number of reduced points per point of the full cloud
+    inline double getReductionRatio() const{
+        return this->fullPoints != NULL && this->fullPoints->size() > 0 ?
+                    (double)this->reducedPoints->size() / (double)this->fullPoints->size() : 1.0;
+    }
+
+    //! \brief Returns the number of occupied voxels
+    inline quint32 getVoxelCount() const{
+        return this->voxelKeys.size();
+    }
+
+    PS_InputParameter getReducedParameter(const PS_InputParameter &param) const;
+
+private:
+    void runTasks(const PS_DownsamplingTask::TaskType &type, const quint64 &count);
+    void sortByVoxel();
+
+    void computeKeys(const quint32 &begin, const quint32 &end);
+    void reduceVoxels(const quint32 &begin, const quint32 &end, vector<quint32> &buffer);
+    void assignPoints(const quint32 &begin, const quint32 &end, vector<quint32> &candidates, vector<unsigned char> &mask);
+
+    quint32 getCentroidCount(const quint32 &voxel) const;
+    quint32 getRandomCount(const quint32 &voxel) const;
+    qint64 findVoxel(const quint64 &key) const;
+
+    static const quint32 chunkSize = 4096; //number of points or voxels processed at once by a task
+    static const quint32 minVoxelPoints = 2; //minimum number of points of a voxel that is kept by the voxel grid downsampling
+
+    PS_PointStore *fullPoints; //all points (not owned)
+    PS_PointStore *reducedPoints; //centroids or random subsets of the voxels (stored voxel by voxel)
+
+    PS_DownsamplingMethod method;
+    float samplingRate;
+    quint64 randomSeed;
+    int numThreads;
+
+    float origin[3]; //minimum corner of the voxel grid
+    float voxelSize;
+    quint64 dimensions[3]; //number of voxels along each axis
+
+    vector<quint64> keys; //voxel key of each point (only used while sorting)
+    vector<quint32> sortedPoints; //indices of all points sorted by voxel
+    vector<quint64> voxelKeys; //sorted keys of the occupied voxels
+    vector<quint32> voxelOffsets; //points of voxel v are sortedPoints[voxelOffsets[v]] until sortedPoints[voxelOffsets[v+1]]
+    vector<quint32> reducedOffsets; //reduced points of voxel v are reducedOffsets[v] until reducedOffsets[v+1]
+    vector<float> reducedX, reducedY, reducedZ; //coordinates of the reduced points (only used while reducing)
+
+    const QList<PS_ShapeSegment *> *shapes; //shapes of the current assignPoints call
+    const vector<float> *thresholds; //inlier threshold of each shape
+    vector<qint32> reducedLabels; //shape of each reduced point (-1 if the point is not used)
+    vector<qint32> labels; //shape of each point in the order of sortedPoints (-1 if the point is not assigned)
+
+    friend class PS_DownsamplingTask;
+
+};
+
+#endif // PS_DOWNSAMPLING_H
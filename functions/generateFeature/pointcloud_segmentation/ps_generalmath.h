@@ -2,9 +2,12 @@
 #define PS_GENERALMATH_H
 
 #include <random>
+#include <vector>
 #include <QList>
 #include <QMap>
 
+#include "ps_random.h"
+
 const double PS_PI = 3.14159265358979323846;
 
 using namespace std;
@@ -18,9 +21,9 @@ public:
     static unsigned long long computeBinomialCoefficient(const unsigned int &n, const unsigned int &k);
 
     /*!
-     * Draws numSubsets random subsets from values, each containing subsetLength items
+     * Draws numSubsets random subsets from values, each containing subsetLength items, using the given generator
      */
-    template<class T> static void getRandomSubsets(QMap<int, QList<T> > &result, const unsigned int &numSubsets, const unsigned int &subsetLength, const QList<T> &values){
+    template<class T> static void getRandomSubsets(QMap<int, vector<T> > &result, const unsigned int &numSubsets, const unsigned int &subsetLength, const vector<T> &values, PS_Random &generator){
 
         //count of possible subsets (drawing subsetLength out of values)
         unsigned long long numAvailableSubsets = PS_GeneralMath::computeBinomialCoefficient(values.size(), subsetLength);
@@ -31,7 +34,7 @@ public:
 
             //draw numSubsets subsets
             QList<unsigned long long> subsets;
-            PS_GeneralMath::getRandomSubset(subsets, numSubsets, numAvailableSubsets-1);
+            PS_GeneralMath::getRandomSubset(subsets, numSubsets, numAvailableSubsets-1, generator);
 
             //qDebug() << "r " << subsets.size();
             if(subsets.size() > 0){
@@ -42,7 +45,7 @@ public:
             //dissolve each subset
             unsigned int index = 0;
             foreach(const unsigned long long subset, subsets){
-                QList<T> item;
+                vector<T> item;
                 PS_GeneralMath::dissolveSubset(item, subset, subsetLength, values);
                 //qDebug() << "itemsize " << item.size();
                 result.insert(index, item);
@@ -57,7 +60,7 @@ private:
     /*!
      * Draws one random subset from values containing subsetLength items
      */
-    template<class T> static void getRandomSubset(QList<T> &result, unsigned int subsetLength, const T &maxValue){
+    template<class T> static void getRandomSubset(QList<T> &result, unsigned int subsetLength, const T &maxValue, PS_Random &generator){
 
         T numItems = maxValue + 1;
 
@@ -70,16 +73,11 @@ private:
             return;
         }else{
 
-            std::random_device rd;
-            int seed = rd();
-            std::default_random_engine generator( seed );
-
             if( 2 * subsetLength < numItems ){ //if there are equal or less items to draw than there are available
 
                 for(T i = numItems - subsetLength; i < numItems; ++i){
 
-                    uniform_int_distribution<T> distribution(0, i);
-                    T item = distribution(generator);
+                    T item = generator.nextInRange(i);
 
                     if(result.contains(item)){
                         result.append( i );
@@ -99,8 +97,7 @@ private:
 
                 for(T i = numItems - subsetLength; i < numItems; ++i){
 
-                    uniform_int_distribution<T> distribution(0, i);
-                    T item = distribution(generator);
+                    T item = generator.nextInRange(i);
 
                     if(!result.contains(item)){
                         result.removeOne( i );
@@ -118,7 +115,7 @@ private:
     /*!
      * From all available subsets of values containing subsetLength items this method returns the one at position
      */
-    template<class T> static void dissolveSubset(QList<T> &result, const unsigned long &position, const unsigned int &subsetLength, const QList<T> &values){
+    template<class T> static void dissolveSubset(vector<T> &result, const unsigned long &position, const unsigned int &subsetLength, const vector<T> &values){
 
         //count of possible subsets (drawing subsetLength out of values)
         unsigned long long numAvailableSubsets = 0;
@@ -144,7 +141,7 @@ private:
             if(k > 0){
                 solutionsWithIndex = PS_GeneralMath::computeBinomialCoefficient(n, k);
             }else{
-                result.append(values.at(currentValueIndex + (position-numViewedSubsets)));
+                result.push_back(values.at(currentValueIndex + (position-numViewedSubsets)));
                 return;
             }
 
@@ -167,7 +164,7 @@ private:
             //at that index to the result list. Otherwise continue with the next index
             if(solutionsWithIndex > position){
 
-                result.append(values.at(currentValueIndex));
+                result.push_back(values.at(currentValueIndex));
                 currentValueIndex++;
 
             }else{
@@ -0,0 +1,127 @@
+#include "ps_instrumentation.h"
+
+QAtomicInteger<quint64> PS_Instrumentation::counters[PS_Instrumentation::eNumCounters];
+QAtomicInteger<qint64> PS_Instrumentation::nsecs[PS_Instrumentation::eNumTimers];
+QAtomicInteger<quint64> PS_Instrumentation::calls[PS_Instrumentation::eNumTimers];
+
+/*!
+ * \brief PS_Instrumentation::getSnapshot
+ * Returns the current values of all counters and timers
+ * \return
+ */
+PS_Statistics PS_Instrumentation::getSnapshot(){
+
+    PS_Statistics result;
+    for(int i = 0; i < PS_Instrumentation::eNumCounters; i++){
+        result.counters[i] = PS_Instrumentation::counters[i].load();
+    }
+    for(int i = 0; i < PS_Instrumentation::eNumTimers; i++){
+        result.nsecs[i] = PS_Instrumentation::nsecs[i].load();
+        result.calls[i] = PS_Instrumentation::calls[i].load();
+    }
+    return result;
+
+}
+
+/*!
+ * \brief PS_Instrumentation::getName
+ * \param counter
+ * \return
+ */
+const char *PS_Instrumentation::getName(const Counter &counter){
+
+    switch(counter){
+    case eHypothesesTested:
+        return "hypotheses_tested";
+    case eHypothesesRejected:
+        return "hypotheses_rejected";
+    case ePointsScored:
+        return "points_scored";
+    case eNodesMerged:
+        return "nodes_merged";
+    case eRefits:
+        return "refits";
+    default:
+        return "";
+    }
+
+}
+
+/*!
+ * \brief PS_Instrumentation::getName
+ * \param timer
+ * \return
+ */
+const char *PS_Instrumentation::getName(const Timer &timer){
+
+    switch(timer){
+    case eDetectPlane:
+        return "detectPlane";
+    case eDetectSphere:
+        return "detectSphere";
+    case eDetectCylinder:
+        return "detectCylinder";
+    case eConsiderNeighbourNodes:
+        return "considerNeighbourNodes";
+    case eMergeNode:
+        return "mergeNode";
+    case eMergePlanes:
+        return "mergePlanes";
+    case eMergeSpheres:
+        return "mergeSpheres";
+    case eMergeCylinders:
+        return "mergeCylinders";
+    default:
+        return "";
+    }
+
+}
+
+PS_Statistics::PS_Statistics(){
+    for(int i = 0; i < PS_Instrumentation::eNumCounters; i++){
+        this->counters[i] = 0;
+    }
+    for(int i = 0; i < PS_Instrumentation::eNumTimers; i++){
+        this->nsecs[i] = 0;
+        this->calls[i] = 0;
+    }
+}
+
+/*!
+ * \brief PS_Statistics::operator -
+ * Returns the counts and times between the snapshot other and this snapshot
+ * \param other
+ * \return
+ */
+PS_Statistics PS_Statistics::operator-(const PS_Statistics &other) const{
+
+    PS_Statistics result;
+    for(int i = 0; i < PS_Instrumentation::eNumCounters; i++){
+        result.counters[i] = this->counters[i] - other.counters[i];
+    }
+    for(int i = 0; i < PS_Instrumentation::eNumTimers; i++){
+        result.nsecs[i] = this->nsecs[i] - other.nsecs[i];
+        result.calls[i] = this->calls[i] - other.calls[i];
+    }
+    return result;
+
+}
+
+/*!
+ * \brief PS_Statistics::toString
+ * Returns all counters and timers in one line (e.g. to report them via PS_PointCloud::updateStatus)
+ * \return
+ */
+QString PS_Statistics::toString() const{
+
+    QString result;
+    for(int i = 0; i < PS_Instrumentation::eNumCounters; i++){
+        result.append(QString("%1=%2 ").arg(PS_Instrumentation::getName((PS_Instrumentation::Counter)i)).arg(this->counters[i]));
+    }
+    for(int i = 0; i < PS_Instrumentation::eNumTimers; i++){
+        result.append(QString("%1=%2ms/%3 ").arg(PS_Instrumentation::getName((PS_Instrumentation::Timer)i))
+                      .arg(this->getTime((PS_Instrumentation::Timer)i), 0, 'f', 1).arg(this->calls[i]));
+    }
+    return result.trimmed();
+
+}
@@ -0,0 +1,121 @@
+#ifndef PS_INSTRUMENTATION_H
+#define PS_INSTRUMENTATION_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+
+/*
+ * Counters and scoped timers of the segmentation. They are only compiled in if PS_WITH_INSTRUMENTATION is defined
+ * (e.g. qmake "DEFINES+=PS_WITH_INSTRUMENTATION"), otherwise PS_COUNT and PS_SCOPED_TIMER expand to nothing.
+ */
+#ifdef PS_WITH_INSTRUMENTATION
+#define PS_COUNT(counter, n) PS_Instrumentation::add(PS_Instrumentation::counter, (n))
+#define PS_SCOPED_TIMER(timer) PS_ScopedTimer psScopedTimer(PS_Instrumentation::timer)
+#else
+#define PS_COUNT(counter, n) ((void)0)
+#define PS_SCOPED_TIMER(timer) ((void)0)
+#endif
+
+//! snapshot of all counters and timers (see PS_Instrumentation)
+struct PS_Statistics;
+
+/*!
+ * \brief The PS_Instrumentation class
+ * Process wide counters and accumulated times of the segmentation. The values are updated atomically, so they may be
+ * incremented from the worker threads. Times of functions that run concurrently are summed over all threads.
+ * The values only increase, a run is measured by the difference of two snapshots (see PS_PointCloud::getStatistics).
+ */
+class PS_Instrumentation
+{
+public:
+    enum Counter{
+        eHypothesesTested, //RANSAC hypotheses computed from a minimal sample
+        eHypothesesRejected, //RANSAC hypotheses that were implausible or rejected while scoring
+        ePointsScored, //distance checks of points against RANSAC hypotheses
+        eNodesMerged, //octree nodes whose points were added to a growing shape
+        eRefits, //fits of a shape using all or a sample of its points
+        eNumCounters
+    };
+
+    enum Timer{
+        eDetectPlane,
+        eDetectSphere,
+        eDetectCylinder,
+        eConsiderNeighbourNodes, //region growing of a shape candidate (including mergeNode)
+        eMergeNode,
+        eMergePlanes,
+        eMergeSpheres,
+        eMergeCylinders,
+        eNumTimers
+    };
+
+    //! \brief Returns true if the instrumentation was compiled in
+    static inline bool isEnabled(){
+#ifdef PS_WITH_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //! \brief Adds n to a counter
+    static inline void add(const Counter &counter, const quint64 &n){
+        PS_Instrumentation::counters[counter].fetchAndAddRelaxed(n);
+    }
+
+    //! \brief Adds the given number of nanoseconds to a timer
+    static inline void addTime(const Timer &timer, const qint64 &nsecs){
+        PS_Instrumentation::nsecs[timer].fetchAndAddRelaxed(nsecs);
+        PS_Instrumentation::calls[timer].fetchAndAddRelaxed(1);
+    }
+
+    static PS_Statistics getSnapshot();
+
+    static const char *getName(const Counter &counter);
+    static const char *getName(const Timer &timer);
+
+private:
+    static QAtomicInteger<quint64> counters[eNumCounters];
+    static QAtomicInteger<qint64> nsecs[eNumTimers];
+    static QAtomicInteger<quint64> calls[eNumTimers];
+
+};
+
+struct PS_Statistics{
+    PS_Statistics();
+
+    PS_Statistics operator-(const PS_Statistics &other) const;
+
+    //! \brief Returns the accumulated time of a timer in ms
+    inline double getTime(const PS_Instrumentation::Timer &timer) const{
+        return (double)this->nsecs[timer] / 1000000.0;
+    }
+
+    QString toString() const;
+
+    quint64 counters[PS_Instrumentation::eNumCounters];
+    qint64 nsecs[PS_Instrumentation::eNumTimers]; //accumulated time of each timer in ns
+    quint64 calls[PS_Instrumentation::eNumTimers]; //number of measured calls of each timer
+};
+
+//! adds the time between its construction and destruction to a timer of PS_Instrumentation
+class PS_ScopedTimer
+{
+public:
+    explicit PS_ScopedTimer(const PS_Instrumentation::Timer &timer) : timer(timer){
+        this->elapsed.start();
+    }
+
+    ~PS_ScopedTimer(){
+        PS_Instrumentation::addTime(this->timer, this->elapsed.nsecsElapsed());
+    }
+
+private:
+    PS_Instrumentation::Timer timer;
+    QElapsedTimer elapsed;
+
+};
+
+#endif // PS_INSTRUMENTATION_H
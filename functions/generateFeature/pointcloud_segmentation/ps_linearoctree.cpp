@@ -0,0 +1,486 @@
+#include "ps_linearoctree.h"
+
+#include "ps_pointcloud.h"
+
+const int PS_LinearOctree::maxDepth;
+
+const quint32 PS_LinearOctree::minTaskSize;
+
+PS_LinearOctree::PS_LinearOctree() : PS_Octree()
+{
+    this->codeDepth = 0;
+    this->myCodes = NULL;
+}
+
+PS_LinearOctree::~PS_LinearOctree()
+{
+    this->clear();
+}
+
+/*!
+ * \brief PS_LinearOctree::clear
+ * Delete all nodes of the linear octree (they are owned by the node array, not by their parents)
+ * \return
+ */
+bool PS_LinearOctree::clear(){
+    this->root = NULL;
+    vector<PS_Node>().swap(this->myNodes);
+    return PS_Octree::clear();
+}
+
+/*!
+ * \brief PS_LinearOctree::setUp
+ * Build the linear octree based on the input points
+ * \param points
+ * \param boundingBox
+ * \param minPoints
+ * \param layout previously built layout for the same points and minPoints that is restored instead of sorting the points (optional)
+ * \return
+ */
+bool PS_LinearOctree::setUp(PS_PointStore *points, PS_BoundingBox_PC *boundingBox, unsigned int minPoints, const PS_OctreeLayout *layout){
+
+    if(points == NULL || points->size() == 0){
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    unsigned int numPoints = points->size();
+    int numThreads = this->getNumThreads();
+
+    this->minPoints = minPoints;
+    this->myBoundingBox = boundingBox;
+    this->myPoints = points;
+    this->myChildSizes.clear();
+
+    //only use the layout if it belongs to the same points and parameters
+    bool restored = false;
+    if(layout != NULL && layout->minPoints == minPoints && layout->indices.size() == numPoints){
+        restored = true;
+        for(unsigned int i = 0; i < numPoints && restored; i++){
+            restored = layout->indices[i] < numPoints;
+        }
+        size_t position = 0;
+        restored = restored && this->validateLayout(layout, numPoints, 0, position) && position == layout->childSizes.size();
+    }
+
+    if(restored){
+        this->myIndices = layout->indices;
+        this->myChildSizes = layout->childSizes;
+    }else{
+
+        //sort the points by their Morton code and split the sorted range into the nodes
+        vector<quint64> codes;
+        this->sortByMortonCode(codes, numThreads);
+        this->splitRange(codes.data(), 0, numPoints, 0, false);
+
+    }
+
+
+    //create all nodes in one array
+    this->leafs.clear();
+    this->myNodes.clear();
+    this->myNodes.resize(1 + this->myChildSizes.size());
+    this->myNodeKeys.clear();
+    this->myNodeKeys.reserve(this->myNodes.size());
+    this->myNodeCells.assign(3 * this->myNodes.size(), 0);
+    this->root = &this->myNodes[0];
+    this->setUpRoot(this->root);
+    size_t position = 0;
+    quint32 nextNode = 1;
+    this->linkNode(0, 1, position, nextNode);
+
+    this->buildTime = timer.restart();
+
+    //set the face neighbours of all nodes (each task handles a range of nodes)
+    sort(this->myNodeKeys.begin(), this->myNodeKeys.end());
+    this->runTasks(PS_LinearOctreeTask::eComputeNeighbours, 1, this->myNodes.size(), numThreads);
+    vector< pair<quint64, quint32> >().swap(this->myNodeKeys);
+    vector<quint32>().swap(this->myNodeCells);
+
+    this->neighbourTime = timer.elapsed();
+
+    this->sortLeafs();
+    this->isValid = true;
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_LinearOctree::sortByMortonCode
+ * Computes the Morton code of each point for the first levels that are expected to be subdivided
+ * and sorts the point indices by it (ranges that have to be subdivided further are refined in splitRange)
+ * \param codes receives the sorted codes
+ * \param numThreads number of threads used to compute the codes
+ */
+void PS_LinearOctree::sortByMortonCode(vector<quint64> &codes, const int &numThreads){
+
+    unsigned int numPoints = this->myPoints->size();
+
+    //center of the root node and the offsets of the sub-node centers at each depth
+    PS_Node rootNode;
+    this->myIndices.resize(numPoints);
+    this->setUpRoot(&rootNode);
+    for(int k = 0; k < 3; k++){
+        this->rootCenter[k] = rootNode.position[k];
+        for(int d = 0; d < PS_LinearOctree::maxDepth; d++){
+            this->childOffsets[d][k] = this->getChildOffset(k, d);
+        }
+    }
+
+    //estimate the depth of the octree for uniformly distributed points
+    this->codeDepth = 1;
+    quint64 numCells = 8;
+    while(this->codeDepth < PS_LinearOctree::maxDepth && numCells * qMax(this->minPoints, 1u) < numPoints){
+        this->codeDepth++;
+        numCells *= 8;
+    }
+    this->codeDepth = qMin(this->codeDepth + 2, PS_LinearOctree::maxDepth);
+
+    codes.resize(numPoints);
+    this->myCodes = codes.data();
+    this->runTasks(PS_LinearOctreeTask::eComputeCodes, 0, numPoints, numThreads);
+    this->myCodes = NULL;
+
+    //sort the codes with a stable LSD radix sort (digits of radixBits bits) so that the build is linear in the number of points
+    const int radixBits = 11;
+    const quint32 numBuckets = 1 << radixBits;
+    vector<quint64> tempCodes(numPoints);
+    vector<quint32> tempIndices(numPoints);
+    vector<quint32> offsets(numBuckets);
+    for(int shift = 0; shift < 3 * PS_LinearOctree::maxDepth; shift += radixBits){
+
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for(unsigned int i = 0; i < numPoints; i++){
+            offsets[(codes[i] >> shift) & (numBuckets - 1)]++;
+        }
+
+        //skip digits that are equal for all points
+        if(offsets[(codes[0] >> shift) & (numBuckets - 1)] == numPoints){
+            continue;
+        }
+
+        quint32 sum = 0;
+        for(quint32 b = 0; b < numBuckets; b++){
+            const quint32 count = offsets[b];
+            offsets[b] = sum;
+            sum += count;
+        }
+        for(unsigned int i = 0; i < numPoints; i++){
+            const quint32 target = offsets[(codes[i] >> shift) & (numBuckets - 1)]++;
+            tempCodes[target] = codes[i];
+            tempIndices[target] = this->myIndices[i];
+        }
+        codes.swap(tempCodes);
+        this->myIndices.swap(tempIndices);
+
+    }
+
+}
+
+/*!
+ * \brief PS_LinearOctree::getMortonCode
+ * Returns the Morton code of the point at index for the first depth levels (aligned to maxDepth levels)
+ * \param index
+ * \param depth
+ * \return
+ */
+quint64 PS_LinearOctree::getMortonCode(const quint32 &index, const int &depth) const{
+
+    const float coords[3] = {this->myPoints->getX(index), this->myPoints->getY(index), this->myPoints->getZ(index)};
+    float center[3] = {this->rootCenter[0], this->rootCenter[1], this->rootCenter[2]};
+
+    quint64 code = 0;
+    for(int d = 0; d < depth; d++){
+        int octant = 0;
+        for(int k = 0; k < 3; k++){
+            const bool upper = coords[k] > center[k];
+            octant |= upper << k;
+            center[k] = upper ? center[k] + this->childOffsets[d][k] : center[k] - this->childOffsets[d][k];
+        }
+        code = (code << 3) | octant;
+    }
+
+    return code << (3 * (PS_LinearOctree::maxDepth - depth));
+
+}
+
+/*!
+ * \brief PS_LinearOctree::refineRange
+ * Replaces the codes of the sorted range [begin, end) by the codes of all maxDepth levels and sorts the range again
+ * \param codes
+ * \param begin
+ * \param end
+ */
+void PS_LinearOctree::refineRange(quint64 *codes, const quint32 &begin, const quint32 &end){
+
+    vector< pair<quint64, quint32> > sorted(end - begin);
+    for(quint32 i = begin; i < end; i++){
+        sorted[i - begin] = make_pair(this->getMortonCode(this->myIndices[i], PS_LinearOctree::maxDepth), this->myIndices[i]);
+    }
+
+    sort(sorted.begin(), sorted.end());
+
+    for(quint32 i = begin; i < end; i++){
+        codes[i] = sorted[i - begin].first;
+        this->myIndices[i] = sorted[i - begin].second;
+    }
+
+}
+
+/*!
+ * \brief PS_LinearOctree::splitRange
+ * Recursively splits the sorted range [begin, end) of a node at depth into the ranges of its sub-nodes
+ * \param codes
+ * \param begin
+ * \param end
+ * \param depth
+ * \param refined true if the codes of the range contain all maxDepth levels
+ */
+void PS_LinearOctree::splitRange(quint64 *codes, const quint32 &begin, const quint32 &end, const int &depth, bool refined){
+
+    if(end - begin <= this->minPoints || depth >= PS_LinearOctree::maxDepth){
+        return;
+    }
+
+    //the codes only contain the first codeDepth levels
+    if(!refined && depth >= this->codeDepth){
+        this->refineRange(codes, begin, end);
+        refined = true;
+    }
+
+    //the octant of each point at this depth is given by 3 bits of its code (all codes of the range share the bits above)
+    const int shift = 3 * (PS_LinearOctree::maxDepth - 1 - depth);
+    const quint64 prefix = (codes[begin] >> (shift + 3)) << (shift + 3);
+    quint32 bounds[9];
+    bounds[0] = begin;
+    bounds[8] = end;
+    for(int o = 1; o < 8; o++){
+        bounds[o] = lower_bound(codes + bounds[o-1], codes + end, prefix | ((quint64)o << shift)) - codes;
+    }
+
+    quint32 sizes[8];
+    for(int o = 0; o < 8; o++){
+        sizes[PS_Octree::octantToChild[o]] = bounds[o+1] - bounds[o];
+    }
+    this->myChildSizes.insert(this->myChildSizes.end(), sizes, sizes + 8);
+
+    for(int i = 0; i < 8; i++){
+        const int octant = PS_Octree::childToOctant[i];
+        this->splitRange(codes, bounds[octant], bounds[octant+1], depth + 1, refined);
+    }
+
+}
+
+/*!
+ * \brief PS_LinearOctree::validateLayout
+ * Checks that the child sizes of the layout are consistent with the number of points and the depth limit
+ * \param layout
+ * \param numPoints
+ * \param depth
+ * \param position
+ * \return
+ */
+bool PS_LinearOctree::validateLayout(const PS_OctreeLayout *layout, const quint32 &numPoints, const int &depth, size_t &position) const{
+
+    if(numPoints <= this->minPoints){
+        return true;
+    }
+    if(depth >= PS_LinearOctree::maxDepth || position + 8 > layout->childSizes.size()){
+        return false;
+    }
+
+    quint32 sizes[8];
+    quint64 sum = 0;
+    for(int i = 0; i < 8; i++){
+        sizes[i] = layout->childSizes[position + i];
+        sum += sizes[i];
+    }
+    if(sum != numPoints){
+        return false;
+    }
+    position += 8;
+
+    for(int i = 0; i < 8; i++){
+        if(!this->validateLayout(layout, sizes[i], depth + 1, position)){
+            return false;
+        }
+    }
+    return true;
+
+}
+
+/*!
+ * \brief PS_LinearOctree::linkNode
+ * Sets up the sub-nodes of the node at index from the child sizes and registers the node's locational code
+ * \param index
+ * \param key
+ * \param position next entry of the child sizes
+ * \param nextNode next unused entry of the node array
+ */
+void PS_LinearOctree::linkNode(const quint32 &index, const quint64 &key, size_t &position, quint32 &nextNode){
+
+    PS_Node *node = &this->myNodes[index];
+    this->myNodeKeys.push_back(make_pair(key, index));
+
+    if(node->numPoints <= this->minPoints || node->depth >= PS_LinearOctree::maxDepth){
+        node->isLeaf = true;
+        this->leafs.push_back(node);
+        return;
+    }
+
+    const quint32 firstChild = nextNode;
+    nextNode += 8;
+    for(int i = 0; i < 8; i++){
+        PS_Node *child = &this->myNodes[firstChild + i];
+        node->children[i] = child;
+        child->parent = node;
+        child->depth = node->depth + 1;
+    }
+
+    //assign the contiguous index ranges in octant order
+    quint32 *begin = node->points;
+    for(int o = 0; o < 8; o++){
+        PS_Node *child = node->children[PS_Octree::octantToChild[o]];
+        child->points = begin;
+        child->numPoints = this->myChildSizes[position + PS_Octree::octantToChild[o]];
+        begin += child->numPoints;
+    }
+    position += 8;
+
+    //set center and cell coordinates of each sub-node
+    for(int i = 0; i < 8; i++){
+        const int octant = PS_Octree::childToOctant[i];
+        for(int k = 0; k < 3; k++){
+            node->children[i]->position[k] = this->getChildCenter(node->position[k], k, node->depth, (octant >> k) & 1);
+            this->myNodeCells[3 * (firstChild + i) + k] = 2 * this->myNodeCells[3 * index + k] + ((octant >> k) & 1);
+        }
+    }
+
+    for(int i = 0; i < 8; i++){
+        this->linkNode(firstChild + i, (key << 3) | PS_Octree::childToOctant[i], position, nextNode);
+    }
+
+}
+
+/*!
+ * \brief PS_LinearOctree::runTasks
+ * Processes the range [begin, end) in numThreads parts concurrently
+ * \param type
+ * \param begin
+ * \param end
+ * \param numThreads
+ */
+void PS_LinearOctree::runTasks(const PS_LinearOctreeTask::TaskType &type, const quint32 &begin, const quint32 &end, const int &numThreads){
+
+    if(numThreads <= 1 || end - begin < 2 * PS_LinearOctree::minTaskSize){
+        PS_LinearOctreeTask(this, type, begin, end).run();
+        return;
+    }
+
+    quint32 numTasks = qMin((quint32)(4 * numThreads), (end - begin) / PS_LinearOctree::minTaskSize);
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+    for(quint32 i = 0; i < numTasks; i++){
+        pool.start(new PS_LinearOctreeTask(this, type, begin + (quint64)(end - begin) * i / numTasks,
+                                           begin + (quint64)(end - begin) * (i + 1) / numTasks));
+    }
+    pool.waitForDone();
+
+}
+
+/*!
+ * \brief PS_LinearOctree::computeCodes
+ * Computes the Morton codes of the first codeDepth levels of the points in [begin, end)
+ * \param begin
+ * \param end
+ */
+void PS_LinearOctree::computeCodes(const quint32 &begin, const quint32 &end){
+    for(quint32 i = begin; i < end; i++){
+        this->myCodes[i] = this->getMortonCode(i, this->codeDepth);
+        this->myIndices[i] = i;
+    }
+}
+
+/*!
+ * \brief PS_LinearOctree::computeNeighbours
+ * Sets the six face neighbours of the nodes in [begin, end) (the neighbour at the same depth or the leaf at a lower depth that contains it)
+ * \param begin
+ * \param end
+ */
+void PS_LinearOctree::computeNeighbours(const quint32 &begin, const quint32 &end){
+
+    for(quint32 i = begin; i < end; i++){
+        PS_Node *node = &this->myNodes[i];
+        const qint64 x = this->myNodeCells[3 * i];
+        const qint64 y = this->myNodeCells[3 * i + 1];
+        const qint64 z = this->myNodeCells[3 * i + 2];
+        node->right = this->findNode(x + 1, y, z, node->depth);
+        node->left = this->findNode(x - 1, y, z, node->depth);
+        node->back = this->findNode(x, y + 1, z, node->depth);
+        node->front = this->findNode(x, y - 1, z, node->depth);
+        node->top = this->findNode(x, y, z + 1, node->depth);
+        node->bottom = this->findNode(x, y, z - 1, node->depth);
+    }
+
+}
+
+/*!
+ * \brief PS_LinearOctree::findNode
+ * Returns the node at the cell (x, y, z) of depth or the deepest node at a lower depth that contains the cell
+ * \param x
+ * \param y
+ * \param z
+ * \param depth
+ * \return NULL if the cell lies outside the octree
+ */
+PS_Node *PS_LinearOctree::findNode(const qint64 &x, const qint64 &y, const qint64 &z, const int &depth) const{
+
+    const qint64 numCells = Q_INT64_C(1) << depth;
+    if(x < 0 || y < 0 || z < 0 || x >= numCells || y >= numCells || z >= numCells){
+        return NULL;
+    }
+
+    for(int d = depth; d >= 0; d--){
+        const int shift = depth - d;
+        const quint64 key = PS_LinearOctree::getKey(x >> shift, y >> shift, z >> shift, d);
+        vector< pair<quint64, quint32> >::const_iterator it = lower_bound(this->myNodeKeys.begin(), this->myNodeKeys.end(),
+                                                                         make_pair(key, (quint32)0));
+        if(it != this->myNodeKeys.end() && it->first == key){
+            return const_cast<PS_Node *>(&this->myNodes[it->second]);
+        }
+    }
+    return NULL;
+
+}
+
+/*!
+ * \brief PS_LinearOctree::getKey
+ * Returns the locational code of the cell (x, y, z) at depth (interleaved coordinate bits behind a leading 1 bit)
+ * \param x
+ * \param y
+ * \param z
+ * \param depth
+ * \return
+ */
+quint64 PS_LinearOctree::getKey(const quint32 &x, const quint32 &y, const quint32 &z, const int &depth){
+    quint64 key = 1;
+    for(int d = depth - 1; d >= 0; d--){
+        key = (key << 3) | (((z >> d) & 1) << 2) | (((y >> d) & 1) << 1) | ((x >> d) & 1);
+    }
+    return key;
+}
+
+/*!
+ * \brief PS_LinearOctreeTask::run
+ * Computes the Morton codes of a range of points or the neighbours of a range of nodes
+ */
+void PS_LinearOctreeTask::run(){
+    if(this->type == PS_LinearOctreeTask::eComputeCodes){
+        this->octree->computeCodes(this->begin, this->end);
+    }else{
+        this->octree->computeNeighbours(this->begin, this->end);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef PS_LINEAROCTREE_H
+#define PS_LINEAROCTREE_H
+
+#include <vector>
+#include <algorithm>
+
+#include "ps_octree.h"
+
+using namespace std;
+
+class PS_LinearOctree;
+
+//! computes the Morton codes of a range of points or the neighbours of a range of nodes in a worker thread
+class PS_LinearOctreeTask : public QRunnable
+{
+public:
+    enum TaskType{
+        eComputeCodes,
+        eComputeNeighbours
+    };
+
+    PS_LinearOctreeTask(PS_LinearOctree *octree, TaskType type, quint32 begin, quint32 end)
+        : octree(octree), type(type), begin(begin), end(end){}
+
+    void run();
+
+private:
+    PS_LinearOctree *octree;
+    TaskType type;
+    quint32 begin, end;
+};
+
+/*!
+ * \brief The PS_LinearOctree class
+ * Octree whose points are sorted by their Morton code, so that each node references a contiguous range of the sorted indices.
+ * All nodes are stored in one flat array and the face neighbours are found by arithmetic on the locational codes of the nodes
+ * instead of walking the tree. The Morton codes are computed with the same node centers as PS_Octree, so both octrees yield
+ * the same leafs and neighbour relations (the linear octree is limited to maxDepth levels).
+ */
+class PS_LinearOctree : public PS_Octree
+{
+public:
+    PS_LinearOctree();
+    ~PS_LinearOctree();
+
+    bool clear();
+    bool setUp(PS_PointStore *points, PS_BoundingBox_PC *boundingBox, unsigned int minPoints, const PS_OctreeLayout *layout = NULL);
+
+private:
+    static const int maxDepth = 21; //maximum depth so that the Morton code of a point fits into 63 bits
+    static const quint32 minTaskSize = 4096; //minimum number of points or nodes processed by one task
+
+    float rootCenter[3]; //center of the root node
+    double childOffsets[maxDepth][3]; //distances between the centers of the nodes at each depth and the centers of their sub-nodes
+    int codeDepth; //number of levels contained in the initially computed Morton codes
+    quint64 *myCodes; //Morton codes that are computed by the tasks
+
+    vector<PS_Node> myNodes; //all nodes (the sub-nodes of a node are stored consecutively)
+
+    vector< pair<quint64, quint32> > myNodeKeys; //sorted locational codes of all nodes (Morton code with a leading 1 bit) and the index of the node
+    vector<quint32> myNodeCells; //cell coordinates of all nodes at their depth (3 per node)
+
+    void sortByMortonCode(vector<quint64> &codes, const int &numThreads);
+    void runTasks(const PS_LinearOctreeTask::TaskType &type, const quint32 &begin, const quint32 &end, const int &numThreads);
+    void computeCodes(const quint32 &begin, const quint32 &end);
+    quint64 getMortonCode(const quint32 &index, const int &depth) const;
+    void refineRange(quint64 *codes, const quint32 &begin, const quint32 &end);
+    void splitRange(quint64 *codes, const quint32 &begin, const quint32 &end, const int &depth, bool refined);
+    bool validateLayout(const PS_OctreeLayout *layout, const quint32 &numPoints, const int &depth, size_t &position) const;
+
+    void linkNode(const quint32 &index, const quint64 &key, size_t &position, quint32 &nextNode);
+    void computeNeighbours(const quint32 &begin, const quint32 &end);
+    PS_Node *findNode(const qint64 &x, const qint64 &y, const qint64 &z, const int &depth) const;
+
+    static quint64 getKey(const quint32 &x, const quint32 &y, const quint32 &z, const int &depth);
+
+    friend class PS_LinearOctreeTask;
+
+};
+
+#endif // PS_LINEAROCTREE_H
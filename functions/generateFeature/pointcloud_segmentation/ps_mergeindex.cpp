@@ -0,0 +1,87 @@
+#include "ps_mergeindex.h"
+
+#include <cmath>
+#include <algorithm>
+
+/*!
+ * \brief PS_MergeIndex::PS_MergeIndex
+ * \param dimensions number of parameters of a key
+ * \param cellSizes size of a grid cell in each dimension
+ */
+PS_MergeIndex::PS_MergeIndex(const unsigned int &dimensions, const float *cellSizes) : dimensions(dimensions)
+{
+    for(unsigned int i = 0; i < dimensions; i++){
+        this->cellSizes.push_back(cellSizes[i] > 0.0f ? cellSizes[i] : 1.0f);
+    }
+}
+
+/*!
+ * \brief PS_MergeIndex::insert
+ * Adds the shape with the given id to the cell of key
+ * \param id
+ * \param key
+ */
+void PS_MergeIndex::insert(const int &id, const float *key){
+    vector<qint32> cell;
+    this->getCell(cell, key);
+    this->cells[cell].push_back(id);
+}
+
+/*!
+ * \brief PS_MergeIndex::getCandidates
+ * Appends the ids of all shapes in the cell of key and in the cells up to range cells away from it (sorted and without duplicates).
+ * An index without dimensions has a single cell, so all shapes are candidates of each other.
+ * \param candidates
+ * \param key
+ * \param range
+ */
+void PS_MergeIndex::getCandidates(vector<int> &candidates, const float *key, const int &range) const{
+
+    vector<qint32> center;
+    this->getCell(center, key);
+
+    //run through all (2 * range + 1)^dimensions neighbour cells
+    vector<qint32> cell(this->dimensions);
+    vector<int> offset(this->dimensions, -range);
+    bool finished = false;
+    while(!finished){
+
+        for(unsigned int i = 0; i < this->dimensions; i++){
+            cell[i] = center[i] + offset[i];
+        }
+
+        map<vector<qint32>, vector<int> >::const_iterator it = this->cells.find(cell);
+        if(it != this->cells.end()){
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+        }
+
+        //next offset
+        finished = true;
+        for(unsigned int i = 0; i < this->dimensions; i++){
+            if(offset[i] < range){
+                offset[i]++;
+                finished = false;
+                break;
+            }
+            offset[i] = -range;
+        }
+
+    }
+
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+}
+
+/*!
+ * \brief PS_MergeIndex::getCell
+ * Computes the grid cell of key
+ * \param cell
+ * \param key
+ */
+void PS_MergeIndex::getCell(vector<qint32> &cell, const float *key) const{
+    cell.resize(this->dimensions);
+    for(unsigned int i = 0; i < this->dimensions; i++){
+        cell[i] = (qint32)std::floor(key[i] / this->cellSizes[i]);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef PS_MERGEINDEX_H
+#define PS_MERGEINDEX_H
+
+#include <QtGlobal>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+//! statistics of a merge step
+struct PS_MergeStatistics{
+    PS_MergeStatistics() : numShapes(0), numComparisons(0), numMerges(0), elapsedTime(0){}
+
+    //! \brief Returns the number of pairs that would have been compared without the index
+    inline quint64 getNumPossibleComparisons() const{
+        return (quint64)this->numShapes * (this->numShapes > 0 ? this->numShapes - 1 : 0) / 2;
+    }
+
+    unsigned int numShapes; //number of shapes before the merge
+    quint64 numComparisons; //number of shape pairs whose parameters were compared
+    unsigned int numMerges; //number of accepted merges
+    qint64 elapsedTime; //duration of the merge step in milliseconds
+};
+
+/*!
+ * \brief The PS_MergeIndex class
+ * Grid over shape parameters (e.g. normal direction and offset of planes) that is used to only compare
+ * shapes with similar parameters in the merge step. Each shape is inserted with a key of its parameters.
+ * The candidates of a key are all shapes in the same or in a directly neighbouring cell (or within a given range of cells).
+ */
+class PS_MergeIndex
+{
+public:
+    PS_MergeIndex(const unsigned int &dimensions, const float *cellSizes);
+
+    void insert(const int &id, const float *key);
+    void getCandidates(vector<int> &candidates, const float *key, const int &range = 1) const;
+
+private:
+    void getCell(vector<qint32> &cell, const float *key) const;
+
+    unsigned int dimensions;
+    vector<float> cellSizes;
+
+    map<vector<qint32>, vector<int> > cells; //ids of the shapes in each occupied cell
+
+};
+
+#endif // PS_MERGEINDEX_H
@@ -11,6 +11,10 @@ PS_Node::PS_Node()
 
     this->parent = NULL;
 
+    this->points = NULL;
+    this->numPoints = 0;
+    this->leafIndex = PS_PointStore::noLeaf;
+
     this->back = NULL;
     this->front = NULL;
     this->bottom = NULL;
@@ -52,7 +56,7 @@ void PS_Node::setWasConsideredInMerge(const bool &state){
         if(this->parent != NULL && !this->parent->getWasConsideredInMerge()){
             bool parentState = true;
             for(unsigned int i = 0; i < 8; i++){
-                if(this->parent->children[i]->points.size() > 0 && !this->parent->children[i]->getWasConsideredInMerge()){
+                if(this->parent->children[i]->numPoints > 0 && !this->parent->children[i]->getWasConsideredInMerge()){
                     parentState = false;
                     break;
                 }
@@ -93,28 +97,25 @@ void PS_Node::setWasConsideredAsSeed(const bool &state){
  * Returns a list of all points that are not used for another shape
  * \param result
  */
-void PS_Node::getUnusedPoints(QList<PS_Point_PC *> &result) const{
+void PS_Node::getUnusedPoints(vector<quint32> &result, const PS_PointStore *store) const{
     if(result.size() != 0){
         result.clear();
     }
-    for(int i = 0; i < this->points.size(); i++){
-        PS_Point_PC *p = this->points.at(i);
-        if(!p->isUsed){
-            result.append(p);
-        }
-    }
+    this->appendUnusedPoints(result, store);
 }
 
 /*!
  * \brief PS_Node::getUnusedPointsCount
- * Returns the number of points that are not used for another shape
+ * Returns the number of points that are not used for another shape (in O(1) if this leaf is registered in the store)
  * \return
  */
-unsigned long PS_Node::getUnusedPointsCount() const{
+unsigned long PS_Node::getUnusedPointsCount(const PS_PointStore *store) const{
+    if(this->leafIndex != PS_PointStore::noLeaf && store->hasLeafs()){
+        return store->getUnusedCount(this->leafIndex);
+    }
     unsigned long result = 0;
-    for(unsigned long i = 0; i < this->points.size(); i++){
-        PS_Point_PC *p = this->points.at(i);
-        if(!p->isUsed){
+    for(quint32 i = 0; i < this->numPoints; i++){
+        if(!store->isUsed(this->points[i])){
             result++;
         }
     }
@@ -126,11 +127,11 @@ unsigned long PS_Node::getUnusedPointsCount() const{
  * Returns a list of all points that are not used for another shape and that have not been considered in merging step
  * \param result
  */
-void PS_Node::getUnmergedPoints(QList<PS_Point_PC *> &result) const{
+void PS_Node::getUnmergedPoints(vector<quint32> &result, const PS_PointStore *store) const{
     if(result.size() != 0){
         result.clear();
     }
-    this->getUnmergedChildPoints(result);
+    this->getUnmergedChildPoints(result, store);
 }
 
 /*!
@@ -138,7 +139,7 @@ void PS_Node::getUnmergedPoints(QList<PS_Point_PC *> &result) const{
  * Returns the unused points of the children of a node
  * \param unmergedPoints
  */
-void PS_Node::getUnmergedChildPoints(QList<PS_Point_PC *> &unmergedPoints) const{
+void PS_Node::getUnmergedChildPoints(vector<quint32> &unmergedPoints, const PS_PointStore *store) const{
 
     //if already considered in merge no points are added
     if(this->consideredInMerge){
@@ -147,14 +148,38 @@ void PS_Node::getUnmergedChildPoints(QList<PS_Point_PC *> &unmergedPoints) const
 
     //if this is a leaf node add the unused points
     if(this->isLeaf){
-        foreach(PS_Point_PC *p, this->points){
-            if(!p->isUsed){
-                unmergedPoints.append(p);
-            }
-        }
+        this->appendUnusedPoints(unmergedPoints, store);
     }else{
         for(int i = 0; i < 8; i++){
-            this->children[i]->getUnmergedChildPoints(unmergedPoints);
+            this->children[i]->getUnmergedChildPoints(unmergedPoints, store);
+        }
+    }
+
+}
+
+/*!
+ * \brief PS_Node::appendUnusedPoints
+ * Appends the unused points of this node to result. If the leaf is registered in the store, leafs whose points are
+ * all used are skipped and leafs whose points are all unused are appended at once without checking each point.
+ * The points are copied: RANSAC and the inlier kernels take one contiguous index list, so there are no views over the unused points.
+ * \param result
+ */
+void PS_Node::appendUnusedPoints(vector<quint32> &result, const PS_PointStore *store) const{
+
+    if(this->leafIndex != PS_PointStore::noLeaf && store->hasLeafs()){
+        quint32 numUnused = store->getUnusedCount(this->leafIndex);
+        if(numUnused == 0){
+            return;
+        }
+        if(numUnused == this->numPoints){
+            result.insert(result.end(), this->points, this->points + this->numPoints);
+            return;
+        }
+    }
+
+    for(quint32 i = 0; i < this->numPoints; i++){
+        if(!store->isUsed(this->points[i])){
+            result.push_back(this->points[i]);
         }
     }
 
@@ -2,8 +2,11 @@
 #define PS_NODE_H
 
 #include <QList>
+#include <vector>
 
-#include "ps_point_pc.h"
+#include "ps_pointstore.h"
+
+using namespace std;
 
 class PS_Node
 {
@@ -22,10 +25,10 @@ public:
     }
     void setWasConsideredAsSeed(const bool &state);
 
-    void getUnusedPoints(QList<PS_Point_PC *> &result) const;
-    unsigned long getUnusedPointsCount() const;
+    void getUnusedPoints(vector<quint32> &result, const PS_PointStore *store) const;
+    unsigned long getUnusedPointsCount(const PS_PointStore *store) const;
 
-    void getUnmergedPoints(QList<PS_Point_PC *> &result) const;
+    void getUnmergedPoints(vector<quint32> &result, const PS_PointStore *store) const;
 
     int depth; //depth of the level at which this node lies
     float position[3]; //position of node's center
@@ -38,13 +41,16 @@ public:
     //neighbours of this node at level equal or greater than this node's level
     PS_Node *top, *bottom, *left, *right, *front, *back;
 
-    QList<PS_Point_PC*> points; //vector with references to points in the pointcloud
+    quint32 *points; //begin of this node's index range within the octree's permutation of the point store
+    quint32 numPoints; //number of points within this node
+    quint32 leafIndex; //index of this leaf in the point store's unused counts (PS_PointStore::noLeaf if not registered)
 
 private:
     bool consideredAsSeed; //is set to true as soon as this node has been considered as a seed region
     bool consideredInMerge; //is set to true as soon as this node or all its subnodes were considered in merging step
 
-    void getUnmergedChildPoints(QList<PS_Point_PC *> &unmergedPoints) const;
+    void getUnmergedChildPoints(vector<quint32> &unmergedPoints, const PS_PointStore *store) const;
+    void appendUnusedPoints(vector<quint32> &result, const PS_PointStore *store) const;
 };
 
 #endif // PS_NODE_H
@@ -2,10 +2,24 @@
 
 #include "ps_pointcloud.h"
 
+const int PS_Octree::octantToChild[8] = {0, 3, 1, 2, 4, 7, 5, 6};
+const int PS_Octree::childToOctant[8] = {0, 2, 3, 1, 4, 6, 7, 5};
+const int PS_Octree::parallelDepth;
+
 PS_Octree::PS_Octree()
 {
     this->isValid = false;
     this->root = NULL;
+    this->myLayout = NULL;
+    this->layoutPosition = 0;
+    this->numThreads = 0;
+    this->buildTime = 0;
+    this->neighbourTime = 0;
+}
+
+PS_Octree::~PS_Octree()
+{
+    this->clear();
 }
 
 /*!
@@ -14,45 +28,83 @@ PS_Octree::PS_Octree()
  * \param points
  * \param boundingBox
  * \param minPoints
+ * \param layout previously built layout for the same points and minPoints that is restored instead of partitioning the points (optional)
  * \return
  */
-bool PS_Octree::setUp(vector<PS_Point_PC *> *points, PS_BoundingBox_PC *boundingBox, unsigned int minPoints){
+bool PS_Octree::setUp(PS_PointStore *points, PS_BoundingBox_PC *boundingBox, unsigned int minPoints, const PS_OctreeLayout *layout){
     if(points != NULL && points->size() > 0){
 
-        clock_t c1 = clock();
+        QElapsedTimer timer;
+        timer.start();
 
         unsigned int numPoints = points->size();
+        int numThreads = this->getNumThreads();
 
         this->minPoints = minPoints;
         this->myBoundingBox = boundingBox;
         this->myPoints = points;
 
-        //create root node and set its points
-        this->root = new PS_Node();
-        for(unsigned int i = 0; i < numPoints; i++){
-            this->root->points.push_back(points->at(i));
+        //only use the layout if it belongs to the same points and parameters
+        this->myLayout = NULL;
+        this->layoutPosition = 0;
+        if(layout != NULL && layout->minPoints == minPoints && layout->indices.size() == numPoints){
+            this->myLayout = layout;
+            for(unsigned int i = 0; i < numPoints; i++){
+                if(layout->indices[i] >= numPoints){
+                    this->myLayout = NULL;
+                    break;
+                }
+            }
         }
-        this->root->position[0] = this->myBoundingBox->min[0] + (this->myBoundingBox->max[0]
-                - this->myBoundingBox->min[0]) * 0.5;
-        this->root->position[1] = this->myBoundingBox->min[1] + (this->myBoundingBox->max[1]
-                - this->myBoundingBox->min[1]) * 0.5;
-        this->root->position[2] = this->myBoundingBox->min[2] + (this->myBoundingBox->max[2]
-                - this->myBoundingBox->min[2]) * 0.5;
-        this->dx = this->myBoundingBox->max[0] - this->myBoundingBox->min[0];
-        this->dy = this->myBoundingBox->max[1] - this->myBoundingBox->min[1];
-        this->dz = this->myBoundingBox->max[2] - this->myBoundingBox->min[2];
 
-        //build Octree and set inner neighbours for each node
-        this->computeNode(this->root);
+        //create root node and let it reference all points of the store
+        if(this->myLayout != NULL){
+            this->myIndices = this->myLayout->indices;
+        }else{
+            this->myIndices.resize(numPoints);
+            for(unsigned int i = 0; i < numPoints; i++){
+                this->myIndices[i] = i;
+            }
+        }
+        this->myChildSizes.clear();
+        this->leafs.clear();
+        PS_Octree::deleteNode(this->root);
+        this->root = new PS_Node();
+        this->setUpRoot(this->root);
+
+        //build the upper levels of the Octree and set inner neighbours for each node
+        //(the subtrees below parallelDepth are built concurrently unless a layout is restored, which has to be read in order)
+        vector<PS_OctreeSubtree> subtrees;
+        bool parallel = (numThreads > 1 && this->myLayout == NULL);
+        this->computeNode(this->root, this->leafs, this->myChildSizes, parallel ? &subtrees : NULL);
+        this->myLayout = NULL;
+        if(subtrees.size() > 0){
+            QThreadPool pool;
+            pool.setMaxThreadCount(numThreads);
+            for(unsigned int i = 0; i < subtrees.size(); i++){
+                pool.start(new PS_OctreeTask(this, &subtrees[i], PS_OctreeTask::eBuildSubtree));
+            }
+            pool.waitForDone();
+            this->mergeSubtrees(subtrees);
+        }
 
-        cout << "octree fertig " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
-        c1 = clock();
+        this->buildTime = timer.restart();
 
-        //traverse Octree and set the outer neighbours for each node
-        this->computeOuterNeighbours(this->root);
+        //traverse Octree and set the outer neighbours for each node (subtrees below parallelDepth concurrently)
+        subtrees.clear();
+        this->computeOuterNeighbours(this->root, (numThreads > 1) ? &subtrees : NULL);
+        if(subtrees.size() > 0){
+            QThreadPool pool;
+            pool.setMaxThreadCount(numThreads);
+            for(unsigned int i = 0; i < subtrees.size(); i++){
+                pool.start(new PS_OctreeTask(this, &subtrees[i], PS_OctreeTask::eComputeOuterNeighbours));
+            }
+            pool.waitForDone();
+        }
 
-        cout << "outer neighbours fertig " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+        this->neighbourTime = timer.elapsed();
 
+        this->sortLeafs();
         this->isValid = true;
 
         return true;
@@ -60,6 +112,65 @@ bool PS_Octree::setUp(vector<PS_Point_PC *> *points, PS_BoundingBox_PC *bounding
     return false;
 }
 
+/*!
+ * \brief PS_Octree::setUpRoot
+ * Lets the root node reference all points and places it in the center of the bounding box
+ * \param node
+ */
+void PS_Octree::setUpRoot(PS_Node *node){
+    node->points = this->myIndices.data();
+    node->numPoints = this->myIndices.size();
+    node->position[0] = this->myBoundingBox->min[0] + (this->myBoundingBox->max[0]
+            - this->myBoundingBox->min[0]) * 0.5;
+    node->position[1] = this->myBoundingBox->min[1] + (this->myBoundingBox->max[1]
+            - this->myBoundingBox->min[1]) * 0.5;
+    node->position[2] = this->myBoundingBox->min[2] + (this->myBoundingBox->max[2]
+            - this->myBoundingBox->min[2]) * 0.5;
+    this->dx = this->myBoundingBox->max[0] - this->myBoundingBox->min[0];
+    this->dy = this->myBoundingBox->max[1] - this->myBoundingBox->min[1];
+    this->dz = this->myBoundingBox->max[2] - this->myBoundingBox->min[2];
+}
+
+/*!
+ * \brief PS_Octree::getNumThreads
+ * Returns the number of threads used to build the octree
+ * \return
+ */
+int PS_Octree::getNumThreads() const{
+    if(this->numThreads <= 0){
+        return QThread::idealThreadCount();
+    }
+    return this->numThreads;
+}
+
+/*!
+ * \brief PS_Octree::mergeSubtrees
+ * Inserts the leafs and child sizes of the concurrently built subtrees at their positions in preorder
+ * \param subtrees
+ */
+void PS_Octree::mergeSubtrees(const vector<PS_OctreeSubtree> &subtrees){
+
+    QList<PS_Node *> leafs;
+    vector<quint32> childSizes;
+    int leafPosition = 0;
+    size_t sizePosition = 0;
+    for(unsigned int i = 0; i < subtrees.size(); i++){
+        const PS_OctreeSubtree &subtree = subtrees[i];
+        leafs.append(this->leafs.mid(leafPosition, subtree.leafPosition - leafPosition));
+        leafs.append(subtree.leafs);
+        leafPosition = subtree.leafPosition;
+        childSizes.insert(childSizes.end(), this->myChildSizes.begin() + sizePosition, this->myChildSizes.begin() + subtree.sizePosition);
+        childSizes.insert(childSizes.end(), subtree.childSizes.begin(), subtree.childSizes.end());
+        sizePosition = subtree.sizePosition;
+    }
+    leafs.append(this->leafs.mid(leafPosition));
+    childSizes.insert(childSizes.end(), this->myChildSizes.begin() + sizePosition, this->myChildSizes.end());
+
+    this->leafs = leafs;
+    this->myChildSizes.swap(childSizes);
+
+}
+
 /*!
  * \brief Octree::getIsValid
  * Returns true if Octree was set up successfully
@@ -71,13 +182,33 @@ bool PS_Octree::getIsValid(){
 
 /*!
  * \brief Octree::getLeafs
+ * Returns the leafs sorted from containing many points to containing less points (see sortLeafs)
  * \return
  */
 QList<PS_Node *> *PS_Octree::getLeafs(){
-    sort(this->leafs.begin(), this->leafs.end(), NodeSorter());
     return &this->leafs;
 }
 
+/*!
+ * \brief PS_Octree::sortLeafs
+ * Sorts the leafs once after the octree was built. The sort is stable, so leafs of the same size keep their preorder
+ * and the seed order of the segmentation only depends on the octree (not on how often the leafs are requested).
+ */
+void PS_Octree::sortLeafs(){
+    stable_sort(this->leafs.begin(), this->leafs.end(), NodeSorter());
+}
+
+/*!
+ * \brief PS_Octree::getLayout
+ * Returns the layout of the octree that can be used to restore it for the same points
+ * \param layout
+ */
+void PS_Octree::getLayout(PS_OctreeLayout &layout) const{
+    layout.minPoints = this->minPoints;
+    layout.indices = this->myIndices;
+    layout.childSizes = this->myChildSizes;
+}
+
 /*!
  * \brief Octree::getRoot
  * \return
@@ -102,22 +233,55 @@ void PS_Octree::setNodesUnmerged(PS_Node *n){
 
 /*!
  * \brief Octree::clear
- * Clear the Octree
+ * Delete all nodes of the Octree
  * \return
  */
 bool PS_Octree::clear(){
 
-    return false;
+    PS_Octree::deleteNode(this->root);
+    this->root = NULL;
+    this->leafs.clear();
+    vector<quint32>().swap(this->myIndices);
+    vector<quint32>().swap(this->myChildSizes);
+    this->isValid = false;
+
+    return true;
+}
+
+/*!
+ * \brief PS_Octree::deleteNode
+ * Delete a node and all of its sub-nodes
+ * \param node
+ */
+void PS_Octree::deleteNode(PS_Node *node){
+    if(node == NULL){
+        return;
+    }
+    if(!node->isLeaf){
+        for(int i = 0; i < 8; i++){
+            PS_Octree::deleteNode(node->children[i]);
+        }
+    }
+    delete node;
 }
 
 /*!
  * \brief Octree::computeNode
  * Compute a node and its children recurively
  * \param node
+ * \param leafs receives the leafs in preorder
+ * \param childSizes receives the child sizes of the subdivided nodes in preorder
+ * \param subtrees if not NULL the nodes at parallelDepth are not subdivided but added to the subtrees that are built concurrently
  */
-void PS_Octree::computeNode(PS_Node *node){
+void PS_Octree::computeNode(PS_Node *node, QList<PS_Node *> &leafs, vector<quint32> &childSizes, vector<PS_OctreeSubtree> *subtrees){
     //if this node has to be subdivided into 8 child-nodes
-    if(node->points.size() > this->minPoints){
+    if(node->numPoints > this->minPoints){
+
+        //defer the subtree so that it can be built concurrently
+        if(subtrees != NULL && node->depth == PS_Octree::parallelDepth){
+            subtrees->push_back(PS_OctreeSubtree(node, leafs.size(), childSizes.size()));
+            return;
+        }
 
         //set up sub-nodes
         for(int i = 0; i < 8; i++){
@@ -157,82 +321,133 @@ void PS_Octree::computeNode(PS_Node *node){
         node->children[7]->back = node->children[6];
         node->children[7]->left = node->children[4];
 
-        //categorize node's points and add them to the corresponding sub-node
+        //categorize node's points by reordering its index range in place so that each sub-node gets a contiguous part of it
         float mx, my, mz;
         mx = node->position[0];
         my = node->position[1];
         mz = node->position[2];
-        foreach(PS_Point_PC *myPoint, node->points){
-            if(myPoint != NULL){
-                if(myPoint->xyz[0] <= mx && myPoint->xyz[1] <= my && myPoint->xyz[2] <= mz){
-                    node->children[0]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] <= mx && myPoint->xyz[1] > my && myPoint->xyz[2] <= mz){
-                    node->children[1]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] > mx && myPoint->xyz[1] > my && myPoint->xyz[2] <= mz){
-                    node->children[2]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] > mx && myPoint->xyz[1] <= my && myPoint->xyz[2] <= mz){
-                    node->children[3]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] <= mx && myPoint->xyz[1] <= my && myPoint->xyz[2] > mz){
-                    node->children[4]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] <= mx && myPoint->xyz[1] > my && myPoint->xyz[2] > mz){
-                    node->children[5]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] > mx && myPoint->xyz[1] > my && myPoint->xyz[2] > mz){
-                    node->children[6]->points.push_back(myPoint);
-                }else if(myPoint->xyz[0] > mx && myPoint->xyz[1] <= my && myPoint->xyz[2] > mz){
-                    node->children[7]->points.push_back(myPoint);
-                }
-            }
+        quint32 sizes[8];
+        if(!this->restoreChildSizes(node, sizes)){
+            quint32 *begin = node->points;
+            quint32 *end = node->points + node->numPoints;
+            quint32 *zSplit = this->partition(begin, end, 2, mz);
+            quint32 *ySplitLow = this->partition(begin, zSplit, 1, my);
+            quint32 *ySplitHigh = this->partition(zSplit, end, 1, my);
+            quint32 *xSplit[4];
+            xSplit[0] = this->partition(begin, ySplitLow, 0, mx);
+            xSplit[1] = this->partition(ySplitLow, zSplit, 0, mx);
+            xSplit[2] = this->partition(zSplit, ySplitHigh, 0, mx);
+            xSplit[3] = this->partition(ySplitHigh, end, 0, mx);
+
+            sizes[0] = xSplit[0] - begin; //x <= mx, y <= my, z <= mz
+            sizes[1] = xSplit[1] - ySplitLow; //x <= mx, y > my, z <= mz
+            sizes[2] = zSplit - xSplit[1]; //x > mx, y > my, z <= mz
+            sizes[3] = ySplitLow - xSplit[0]; //x > mx, y <= my, z <= mz
+            sizes[4] = xSplit[2] - zSplit; //x <= mx, y <= my, z > mz
+            sizes[5] = xSplit[3] - ySplitHigh; //x <= mx, y > my, z > mz
+            sizes[6] = end - xSplit[3]; //x > mx, y > my, z > mz
+            sizes[7] = ySplitHigh - xSplit[2]; //x > mx, y <= my, z > mz
+        }
+        childSizes.insert(childSizes.end(), sizes, sizes + 8);
+
+        //assign the contiguous index ranges to the sub-nodes (in the order they were partitioned = octant order)
+        quint32 *begin = node->points;
+        for(int i = 0; i < 8; i++){
+            PS_Node *child = node->children[PS_Octree::octantToChild[i]];
+            child->points = begin;
+            child->numPoints = sizes[PS_Octree::octantToChild[i]];
+            begin += child->numPoints;
         }
 
         //set center for each sub-node
-        int idx = 2;
-        for(int i = 0; i < node->depth+1; i++){
-            idx = idx * 2;
+        for(int i = 0; i < 8; i++){
+            const int octant = PS_Octree::childToOctant[i];
+            for(int k = 0; k < 3; k++){
+                node->children[i]->position[k] = this->getChildCenter(node->position[k], k, node->depth, (octant >> k) & 1);
+            }
         }
-        node->children[0]->position[0] = mx - (this->dx / idx);
-        node->children[0]->position[1] = my - (this->dy / idx);
-        node->children[0]->position[2] = mz - (this->dz / idx);
-        node->children[1]->position[0] = mx - (this->dx / idx);
-        node->children[1]->position[1] = my + (this->dy / idx);
-        node->children[1]->position[2] = mz - (this->dz / idx);
-        node->children[2]->position[0] = mx + (this->dx / idx);
-        node->children[2]->position[1] = my + (this->dy / idx);
-        node->children[2]->position[2] = mz - (this->dz / idx);
-        node->children[3]->position[0] = mx + (this->dx / idx);
-        node->children[3]->position[1] = my - (this->dy / idx);
-        node->children[3]->position[2] = mz - (this->dz / idx);
-        node->children[4]->position[0] = mx - (this->dx / idx);
-        node->children[4]->position[1] = my - (this->dy / idx);
-        node->children[4]->position[2] = mz + (this->dz / idx);
-        node->children[5]->position[0] = mx - (this->dx / idx);
-        node->children[5]->position[1] = my + (this->dy / idx);
-        node->children[5]->position[2] = mz + (this->dz / idx);
-        node->children[6]->position[0] = mx + (this->dx / idx);
-        node->children[6]->position[1] = my + (this->dy / idx);
-        node->children[6]->position[2] = mz + (this->dz / idx);
-        node->children[7]->position[0] = mx + (this->dx / idx);
-        node->children[7]->position[1] = my - (this->dy / idx);
-        node->children[7]->position[2] = mz + (this->dz / idx);
 
         //call computeNode for each sub-node
         for(int i = 0; i < 8; i++){
-            this->computeNode(node->children[i]);
+            this->computeNode(node->children[i], leafs, childSizes, subtrees);
         }
 
         return;
     }
     node->isLeaf = true;
-    this->leafs.push_back(node);
+    leafs.push_back(node);
     return;
 }
 
+/*!
+ * \brief PS_Octree::restoreChildSizes
+ * Reads the sizes of the sub-nodes of node from the restored layout
+ * \param node
+ * \param sizes
+ * \return false if no layout is restored or the layout does not match the node
+ */
+bool PS_Octree::restoreChildSizes(const PS_Node *node, quint32 sizes[8]){
+
+    if(this->myLayout == NULL || this->layoutPosition + 8 > this->myLayout->childSizes.size()){
+        this->myLayout = NULL;
+        return false;
+    }
+
+    quint64 numPoints = 0;
+    for(int i = 0; i < 8; i++){
+        sizes[i] = this->myLayout->childSizes[this->layoutPosition + i];
+        numPoints += sizes[i];
+    }
+    if(numPoints != node->numPoints){
+        this->myLayout = NULL;
+        return false;
+    }
+
+    this->layoutPosition += 8;
+    return true;
+
+}
+
+/*!
+ * \brief PS_Octree::partition
+ * Reorders the point indices in [begin, end) so that all points whose coordinate dim is less or equal splitValue
+ * come first. Returns the first index of the points whose coordinate is greater than splitValue
+ * \param begin
+ * \param end
+ * \param dim
+ * \param splitValue
+ * \return
+ */
+quint32 *PS_Octree::partition(quint32 *begin, quint32 *end, const int &dim, const float &splitValue){
+    const float *coords = (dim == 0) ? this->myPoints->getXArray()
+                                     : ((dim == 1) ? this->myPoints->getYArray() : this->myPoints->getZArray());
+    while(begin < end){
+        if(coords[*begin] <= splitValue){
+            begin++;
+        }else{
+            end--;
+            quint32 temp = *begin;
+            *begin = *end;
+            *end = temp;
+        }
+    }
+    return begin;
+}
+
 /*!
  * \brief Octree::computeOuterNeighbours
  * \param node
+ * \param subtrees if not NULL the nodes at parallelDepth are not traversed but added to the subtrees that are processed concurrently
  */
-void PS_Octree::computeOuterNeighbours(PS_Node *node){
+void PS_Octree::computeOuterNeighbours(PS_Node *node, vector<PS_OctreeSubtree> *subtrees){
     if(!node->isLeaf){
 
+        //the neighbours of the node are known at this point, so its subtree can be processed independently
+        if(subtrees != NULL && node->depth == PS_Octree::parallelDepth){
+            subtrees->push_back(PS_OctreeSubtree(node));
+            return;
+        }
+
         if(node->bottom != NULL){
             if(node->bottom->isLeaf){
                 node->children[0]->bottom = node->bottom;
@@ -319,9 +534,21 @@ void PS_Octree::computeOuterNeighbours(PS_Node *node){
 
         //compute outer neighbours for each sub-node's sub-nodes
         for(int i = 0; i < 8; i++){
-            this->computeOuterNeighbours(node->children[i]);
+            this->computeOuterNeighbours(node->children[i], subtrees);
         }
 
     }
     return;
 }
+
+/*!
+ * \brief PS_OctreeTask::run
+ * Builds the subtree or computes the outer neighbours of its nodes
+ */
+void PS_OctreeTask::run(){
+    if(this->type == PS_OctreeTask::eBuildSubtree){
+        this->octree->computeNode(this->subtree->root, this->subtree->leafs, this->subtree->childSizes, NULL);
+    }else{
+        this->octree->computeOuterNeighbours(this->subtree->root, NULL);
+    }
+}
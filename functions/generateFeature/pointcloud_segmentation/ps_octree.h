@@ -2,10 +2,15 @@
 #define PS_OCTREE_H
 
 #include <QList>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
 #include <vector>
+#include <algorithm>
 
 #include "ps_node.h"
-#include "ps_point_pc.h"
+#include "ps_pointstore.h"
 
 struct PS_BoundingBox_PC;
 
@@ -13,7 +18,7 @@ struct NodeSorter
 {
     inline bool operator() (const PS_Node* node1, const PS_Node* node2)
     {
-        int v1 = node1->points.size(), v2 = node2->points.size();
+        int v1 = node1->numPoints, v2 = node2->numPoints;
         if(node1->depth - node2->depth > 0){
             for(int i = 0; i < node1->depth - node2->depth; i++){
                 v1 = v1 * 8;
@@ -30,33 +35,128 @@ struct NodeSorter
 
 using namespace std;
 
+//! everything that is needed to restore an octree without partitioning the points again
+struct PS_OctreeLayout{
+    PS_OctreeLayout() : minPoints(0){}
+
+    unsigned int minPoints; //maximum number of points of a leaf node
+    vector<quint32> indices; //permutation of the point indices (see PS_Octree::myIndices)
+    vector<quint32> childSizes; //number of points of the 8 sub-nodes of each subdivided node (in the order the nodes were subdivided)
+};
+
+//! a subtree below PS_Octree::parallelDepth that is processed by its own task
+struct PS_OctreeSubtree{
+    PS_OctreeSubtree(PS_Node *root = NULL, int leafPosition = 0, size_t sizePosition = 0)
+        : root(root), leafPosition(leafPosition), sizePosition(sizePosition){}
+
+    PS_Node *root; //root node of the subtree
+    int leafPosition; //position of the subtree's leafs within the leafs of the upper levels
+    size_t sizePosition; //position of the subtree's child sizes within the child sizes of the upper levels
+    QList<PS_Node *> leafs; //leafs of the subtree in preorder
+    vector<quint32> childSizes; //child sizes of the subtree in preorder
+};
+
 class PS_Octree
 {
 public:
     PS_Octree();
+    virtual ~PS_Octree();
 
-    bool setUp(vector<PS_Point_PC*> *points, PS_BoundingBox_PC *boundingBox, unsigned int minPoints);
-    bool clear();
+    virtual bool setUp(PS_PointStore *points, PS_BoundingBox_PC *boundingBox, unsigned int minPoints, const PS_OctreeLayout *layout = NULL);
+    virtual bool clear();
     bool getIsValid();
 
     QList<PS_Node *> *getLeafs();
+    void getLayout(PS_OctreeLayout &layout) const;
+
+    //! \brief Sets the number of threads used to build the octree (0 = all available cores, 1 = serial)
+    inline void setNumThreads(const int &numThreads){
+        this->numThreads = numThreads;
+    }
+
+    //! \brief Returns the time in ms that was needed to build the nodes
+    inline qint64 getBuildTime() const{
+        return this->buildTime;
+    }
+
+    //! \brief Returns the time in ms that was needed to compute the neighbours of the nodes
+    inline qint64 getNeighbourTime() const{
+        return this->neighbourTime;
+    }
     PS_Node *getRoot();
 
     void setNodesUnmerged(PS_Node *n); //set all nodes to not have been considered during merging
 
-private:
+protected:
     PS_Node *root;
     QList<PS_Node*> leafs;
 
     bool isValid; //true if octree was set up successfully
 
+    int numThreads; //number of threads used to build the octree
+    qint64 buildTime, neighbourTime; //duration of the build phases in ms
+
     unsigned int minPoints;
     PS_BoundingBox_PC *myBoundingBox;
     double dx, dy, dz;
-    vector<PS_Point_PC*> *myPoints;
+    PS_PointStore *myPoints;
+    vector<quint32> myIndices; //permutation of the point indices so that the points of each node lie in a contiguous range
+    vector<quint32> myChildSizes; //sizes of the sub-nodes of each subdivided node
+
+    const PS_OctreeLayout *myLayout; //layout that is restored (NULL if the octree is built from scratch)
+    size_t layoutPosition; //next entry of the restored child sizes
+
+    static const int parallelDepth = 2; //depth of the nodes whose subtrees are built concurrently
 
-    void computeNode(PS_Node *node);
-    void computeOuterNeighbours(PS_Node *node);
+    static const int octantToChild[8]; //index of the sub-node of each octant (bit 0: x > center, bit 1: y > center, bit 2: z > center)
+    static const int childToOctant[8]; //octant of each sub-node
+
+    //! \brief Returns the distance between the center of a node at depth and the centers of its sub-nodes in dimension dim
+    inline double getChildOffset(const int &dim, const int &depth) const{
+        const double extent = (dim == 0) ? this->dx : ((dim == 1) ? this->dy : this->dz);
+        int idx = 2;
+        for(int i = 0; i < depth+1; i++){
+            idx = idx * 2;
+        }
+        return extent / idx;
+    }
+
+    //! \brief Returns the center coordinate dim of a sub-node of a node at depth (upper = true if the sub-node lies above the center)
+    inline float getChildCenter(const float &center, const int &dim, const int &depth, const bool &upper) const{
+        return upper ? center + this->getChildOffset(dim, depth) : center - this->getChildOffset(dim, depth);
+    }
+
+    void setUpRoot(PS_Node *node);
+    static void deleteNode(PS_Node *node);
+    void sortLeafs();
+    int getNumThreads() const;
+    void computeNode(PS_Node *node, QList<PS_Node *> &leafs, vector<quint32> &childSizes, vector<PS_OctreeSubtree> *subtrees);
+    void mergeSubtrees(const vector<PS_OctreeSubtree> &subtrees);
+    bool restoreChildSizes(const PS_Node *node, quint32 sizes[8]);
+    quint32 *partition(quint32 *begin, quint32 *end, const int &dim, const float &splitValue);
+    void computeOuterNeighbours(PS_Node *node, vector<PS_OctreeSubtree> *subtrees);
+
+    friend class PS_OctreeTask;
+};
+
+//! builds or links a subtree of an octree in a worker thread
+class PS_OctreeTask : public QRunnable
+{
+public:
+    enum TaskType{
+        eBuildSubtree,
+        eComputeOuterNeighbours
+    };
+
+    PS_OctreeTask(PS_Octree *octree, PS_OctreeSubtree *subtree, TaskType type)
+        : octree(octree), subtree(subtree), type(type){}
+
+    void run();
+
+private:
+    PS_Octree *octree;
+    PS_OctreeSubtree *subtree;
+    TaskType type;
 };
 
 #endif // PS_OCTREE_H
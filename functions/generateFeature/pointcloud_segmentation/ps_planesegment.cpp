@@ -1,13 +1,8 @@
 #include "ps_planesegment.h"
 
-OiMat PS_PlaneSegment::u = OiMat(3,3);
-OiMat PS_PlaneSegment::v = OiMat(3,3);
-OiVec PS_PlaneSegment::d = OiVec(3);
-OiVec PS_PlaneSegment::n0;
-OiMat PS_PlaneSegment::ata(3,3);
-//OiVec PS_PlaneSegment::xyz = OiVec(3);
+#include "ps_instrumentation.h"
 
-PS_PlaneSegment::PS_PlaneSegment(){
+PS_PlaneSegment::PS_PlaneSegment(PS_PointStore *store) : PS_ShapeSegment(store){
 
     //create plane states and make sure that myPlaneState points to the same object as myState
     this->myPlaneState = new PlaneState();
@@ -39,65 +34,42 @@ bool PS_PlaneSegment::writeToX3D(const QString &filePath){
  * \param param
  * \return
  */
-PS_PlaneSegment *PS_PlaneSegment::detectPlane(const QList<PS_Point_PC*> &points, const PS_InputParameter &param){
+PS_PlaneSegment *PS_PlaneSegment::detectPlane(PS_PointStore *store, const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator){
 
-    PS_PlaneSegment *result = new PS_PlaneSegment();
+    PS_SCOPED_TIMER(eDetectPlane);
+
+    PS_PlaneSegment *result = new PS_PlaneSegment(store);
 
-    int numTrials = 0; //number of necessary trials
     int k = 3; //number of points in a required minimal set to define a plane
-    float p = 1.0f - param.outlierPercentage; //probability of drawing a plane-point from the set of points
-    float s = 0.99f; //required probability of detecting the plane in numTrials trials
 
-    float phk = p;
-    for(int i = 0; i < k-1; i++){
-        phk = phk * p;
+    //search the plane with the most inliers (at least 4 points and stop if the plane contains mostly all points of the voxel)
+    PS_PlaneSegment hypothesis(store);
+    PS_Ransac ransac(points, param, generator);
+    if(ransac.run(&hypothesis, result, k, param.planeParams.maxDistance, k+1, k)){
+        PS_PlaneSegment::checkPointsInPlane(result, points, param, 1);
     }
 
-    //calculate the number of necessary trials
-    numTrials = (int)ceil(qLn(1.0f - s) / qLn(1.0f - phk));
-
-    //get numTrials random samples of k points
-    QMap<int, QList<PS_Point_PC*> > randomSamples;
-    PS_GeneralMath::getRandomSubsets(randomSamples, numTrials, k, points);
-
-    for(int i = 0; i < numTrials; ++i){
-
-        //create plane from k points
-        PS_PlaneSegment *possibleSolution = new PS_PlaneSegment();
-        possibleSolution->minimumSolution(randomSamples.value(i));
-
-        if(!possibleSolution->getIsValid()){
-            continue;
-        }
-
-        //if at least 4 points are within the plane...
-        if(PS_PlaneSegment::checkPointsInPlane(possibleSolution, points, param, 1) >= k+1){
-
-            //...and the solution is better then the best one found before
-            if(possibleSolution->getPoints().size() > result->getPoints().size()){
-
-                //delete the old "best" plane
-                if(result != NULL){
-                    delete result;
-                }
-
-                //set the new plane as result
-                result = possibleSolution;
-
-                //if the plane contains mostly all points of the voxel then break the search because no better plane can be found
-                if(result->getPoints().size() >= points.size()-3){
-                    break;
-                }
-            }
-
-        }
-
-    }
+    //seed the generator of the detected shape to be able to fit it by sample reproducibly
+    result->setRandomSeed(generator.next());
 
     return result;
 
 }
 
+/*!
+ * \brief PS_PlaneSegment::checkInliers
+ * Check which of the given points lie in a small band around the plane
+ * \param points
+ * \param count
+ * \param threshold
+ * \param mask
+ * \return
+ */
+unsigned int PS_PlaneSegment::checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const{
+    return PS_DistanceKernels::planeInliers(this->myStore->getXArray(), this->myStore->getYArray(), this->myStore->getZArray(),
+                                            points, count, this->myPlaneState->n0, this->myPlaneState->d, threshold, mask);
+}
+
 /*!
  * \brief PS_PlaneSegment::checkPointsInPlane
  * Check each given point if it lies in a small band around the plane
@@ -105,9 +77,11 @@ PS_PlaneSegment *PS_PlaneSegment::detectPlane(const QList<PS_Point_PC*> &points,
  * \param myPoints
  * \param param
  * \param toleranceFactor
+ * \param inlierMask scratch memory for the inlier mask, e.g. of a PS_ShapeTask (optional, a temporary mask is used if NULL)
  * \return
  */
-int PS_PlaneSegment::checkPointsInPlane(PS_PlaneSegment *myPlane, const QList<PS_Point_PC*> &myPoints, const PS_InputParameter &param, const int &toleranceFactor){
+int PS_PlaneSegment::checkPointsInPlane(PS_PlaneSegment *myPlane, const vector<quint32> &myPoints, const PS_InputParameter &param, const int &toleranceFactor,
+                                        vector<unsigned char> *inlierMask){
 
     int result = 0; //number of points that were added to the plane (that lie in a small band around the plane)
 
@@ -115,25 +89,20 @@ int PS_PlaneSegment::checkPointsInPlane(PS_PlaneSegment *myPlane, const QList<PS
 
         float distanceThreshold = (float)toleranceFactor * param.planeParams.maxDistance;
 
-        //iterate through all points to check wether they lie in a small band around the plane
-        for(int i = 0; i < myPoints.size(); ++i){
-
-            PS_Point_PC *p = myPoints.at(i);
+        const PS_PointStore *store = myPlane->getPointStore();
 
-            //if the point is not used for another shape
-            if(!p->isUsed){
-
-                //distance of the point p from the plane
-                float distance = p->xyz[0]*myPlane->getIJK()[0] + p->xyz[1]*myPlane->getIJK()[1] + p->xyz[2]*myPlane->getIJK()[2] - myPlane->getDistance();
-
-                //add the point to the plane if the distance is lower than a threshold
-                if(qAbs(distance) < distanceThreshold){
-                    myPlane->addPoint(p);
-                    result++;
-                }
+        //check the distance of all points from the plane in one batch
+        vector<unsigned char> localMask;
+        vector<unsigned char> &mask = (inlierMask != NULL) ? *inlierMask : localMask;
+        mask.resize(myPoints.size());
+        myPlane->checkInliers(myPoints.data(), myPoints.size(), distanceThreshold, mask.data());
 
+        //add all inliers that are not used for another shape to the plane
+        for(unsigned int i = 0; i < myPoints.size(); ++i){
+            if(mask[i] && !store->isUsed(myPoints[i])){
+                myPlane->addPoint(myPoints[i]);
+                result++;
             }
-
         }
 
     }
@@ -148,7 +117,9 @@ int PS_PlaneSegment::checkPointsInPlane(PS_PlaneSegment *myPlane, const QList<PS
  */
 void PS_PlaneSegment::fit(){
 
-    if(this->myState->myPoints.size() < 4){
+    PS_COUNT(eRefits, 1);
+
+    if(this->myPoints.size() < 4){
         this->myState->isValid = false;
         return;
     }
@@ -161,89 +132,32 @@ void PS_PlaneSegment::fit(){
     centroid[1] = 0.0;
     centroid[2] = 0.0;
     for(int i = 0; i < numPoints; ++i){
-        PS_Point_PC *p = this->getPoints().at(i);
-        centroid[0] += p->xyz[0];
-        centroid[1] += p->xyz[1];
-        centroid[2] += p->xyz[2];
+        quint32 p = this->myPoints[i];
+        centroid[0] += this->myStore->getX(p);
+        centroid[1] += this->myStore->getY(p);
+        centroid[2] += this->myStore->getZ(p);
     }
     centroid[0] = centroid[0] / (double)numPoints;
     centroid[1] = centroid[1] / (double)numPoints;
     centroid[2] = centroid[2] / (double)numPoints;
 
-    //centroid reduced coordinates
-    /*vector<OiVec> crCoord;
-    for(int i = 0; i < numPoints; ++i){
-        PS_Point_PC *p = this->getPoints().at(i);
-        PS_PlaneSegment::xyz.setAt(0, p->xyz[0] - centroid[0]);
-        PS_PlaneSegment::xyz.setAt(1, p->xyz[1] - centroid[1]);
-        PS_PlaneSegment::xyz.setAt(2, p->xyz[2] - centroid[2]);
-        crCoord.push_back( PS_PlaneSegment::xyz );
-    }*/
-
-    //set up A matrix
-    /*OiMat a(crCoord.size(), 3);
-    for(int i = 0; i < crCoord.size(); i++){
-        a.setAt(i, 0, crCoord.at(i).getAt(0));
-        a.setAt(i, 1, crCoord.at(i).getAt(1));
-        a.setAt(i, 2, crCoord.at(i).getAt(2));
-    }
-
-    //principal component analysis
-    OiMat ata = a.t() * a;*/
-
-    double value = 0.0;
-    for(int i = 0; i < 3; ++i){
-        for(int j = 0; j < 3; ++j){
-            value = 0.0;
-            for(int k = 0; k < numPoints; ++k){
-                PS_Point_PC *p = this->getPoints().at(k);
-                value += (p->xyz[i] - centroid[i]) * (p->xyz[j] - centroid[j]);
+    //principal component analysis: covariance matrix of the centroid reduced coordinates
+    const float *xyz[3] = {this->myStore->getXArray(), this->myStore->getYArray(), this->myStore->getZArray()};
+    fixed::Mat<3, 3> ata;
+    for(int k = 0; k < numPoints; ++k){
+        quint32 p = this->myPoints[k];
+        const double cr[3] = {xyz[0][p] - centroid[0], xyz[1][p] - centroid[1], xyz[2][p] - centroid[2]};
+        for(int i = 0; i < 3; ++i){
+            for(int j = i; j < 3; ++j){
+                ata(i, j) += cr[i] * cr[j];
             }
-            PS_PlaneSegment::ata.setAt(i, j, value);
         }
     }
+    ata(1, 0) = ata(0, 1);
+    ata(2, 0) = ata(0, 2);
+    ata(2, 1) = ata(1, 2);
 
-    PS_PlaneSegment::ata.svd(PS_PlaneSegment::u, PS_PlaneSegment::d, PS_PlaneSegment::v);
-
-    //get eigenvector which is n vector
-    int eigenIndex = -1;
-    double eVal = 0.0;
-    for(int i = 0; i < PS_PlaneSegment::d.getSize(); ++i){
-        if(PS_PlaneSegment::d.getAt(i) < eVal || i == 0){
-            eVal = PS_PlaneSegment::d.getAt(i);
-            eigenIndex = i;
-        }
-    }
-    if(eigenIndex > -1){
-
-        PS_PlaneSegment::u.getCol(PS_PlaneSegment::n0, eigenIndex);
-        double sumXN = 0.0;
-        double sumYN = 0.0;
-        double sumZN = 0.0;
-        for(int i = 0; i < numPoints; ++i){
-            PS_Point_PC *p = this->getPoints().at(i);
-            sumXN += p->xyz[0] * PS_PlaneSegment::n0.getAt(0);
-            sumXN += p->xyz[1] * PS_PlaneSegment::n0.getAt(1);
-            sumXN += p->xyz[2] * PS_PlaneSegment::n0.getAt(2);
-        }
-        double d = (sumXN + sumYN + sumZN) / (double)numPoints;
-        n0 = n0.normalize();
-
-        //set result
-        this->myPlaneState->n0[0] = PS_PlaneSegment::n0.getAt(0);
-        this->myPlaneState->n0[1] = PS_PlaneSegment::n0.getAt(1);
-        this->myPlaneState->n0[2] = PS_PlaneSegment::n0.getAt(2);
-        this->myPlaneState->d = d;
-        this->myState->sigma = qSqrt(eVal / ((double)numPoints - 3.0));
-        this->myState->mainFocus[0] = centroid[0];
-        this->myState->mainFocus[1] = centroid[1];
-        this->myState->mainFocus[2] = centroid[2];
-        this->myState->isValid = true;
-
-    }else{
-        this->myState->isValid = false;
-        return;
-    }
+    this->setFromCovariance(centroid, ata, numPoints);
 
 }
 
@@ -254,8 +168,10 @@ void PS_PlaneSegment::fit(){
  */
 void PS_PlaneSegment::fitBySample(int numPoints){
 
+    PS_COUNT(eRefits, 1);
+
     //number of points on the plane
-    const int planePoints = this->myState->myPoints.size();
+    const int planePoints = this->myPoints.size();
 
     if(planePoints < 4 || numPoints < 4){
         this->myState->isValid = false;
@@ -265,13 +181,13 @@ void PS_PlaneSegment::fitBySample(int numPoints){
     if(numPoints > planePoints){
         numPoints = planePoints;
     }
-    QList<int> mySet;
-    for(int i = 0; i < numPoints; ++i){
-        mySet.append(i);
+    QMap<int, vector<quint32> > randomSampleMap;
+    PS_GeneralMath::getRandomSubsets(randomSampleMap, 1, numPoints, this->myPoints, this->myRandom);
+    if(randomSampleMap.isEmpty()){
+        this->myState->isValid = false;
+        return;
     }
-    QMap<int, QList<int> > randomSampleMap;
-    PS_GeneralMath::getRandomSubsets(randomSampleMap, 1, numPoints, mySet);
-    QList<int> &randomSample = randomSampleMap.first();
+    vector<quint32> &randomSample = randomSampleMap.first();
 
     if(randomSample.size() == 0){
         this->myState->isValid = false;
@@ -284,113 +200,87 @@ void PS_PlaneSegment::fitBySample(int numPoints){
     centroid[1] = 0.0;
     centroid[2] = 0.0;
     for(int i = 0; i < numPoints; ++i){
-        PS_Point_PC *p = this->myState->myPoints.at(randomSample.at(i));
-        centroid[0] += p->xyz[0];
-        centroid[1] += p->xyz[1];
-        centroid[2] += p->xyz[2];
+        quint32 p = randomSample[i];
+        centroid[0] += this->myStore->getX(p);
+        centroid[1] += this->myStore->getY(p);
+        centroid[2] += this->myStore->getZ(p);
     }
     centroid[0] = centroid[0] / (double)numPoints;
     centroid[1] = centroid[1] / (double)numPoints;
     centroid[2] = centroid[2] / (double)numPoints;
 
-    //centroid reduced coordinates
-    /*QList<OiVec> crCoord;
-    for(int i = 0; i < numPoints; ++i){
-        PS_Point_PC *p = this->myState->myPoints.at(randomSample.at(i));
-        PS_PlaneSegment::xyz.setAt(0, p->xyz[0] - centroid[0]);
-        PS_PlaneSegment::xyz.setAt(1, p->xyz[1] - centroid[1]);
-        PS_PlaneSegment::xyz.setAt(2, p->xyz[2] - centroid[2]);
-        crCoord.append( PS_PlaneSegment::xyz );
-    }*/
-
-    //set up A matrix
-    /*OiMat a(numPoints, 3);
-    for(int i = 0; i < crCoord.size(); ++i){
-        a.setAt(i, 0, crCoord.at(i).getAt(0));
-        a.setAt(i, 1, crCoord.at(i).getAt(1));
-        a.setAt(i, 2, crCoord.at(i).getAt(2));
-    }
-
-    //principal component analysis
-    OiMat ata = a.t() * a;*/
-
-    /*double value = 0.0;
-    for(int i = 0; i < 3; ++i){
-        for(int j = 0; j < 3; ++j){
-            value = 0.0;
-            for(unsigned int k = 0; k < numPoints; ++k){
-                value += crCoord.at(k).getAt(i) * crCoord.at(k).getAt(j);
-            }
-            PS_PlaneSegment::ata.setAt(i, j, value);
-        }
-    }*/
-
-    double value = 0.0;
-    for(int i = 0; i < 3; ++i){
-        for(int j = 0; j < 3; ++j){
-            value = 0.0;
-            for(int k = 0; k < numPoints; ++k){
-                PS_Point_PC *p = this->getPoints().at(k);
-                value += (p->xyz[i] - centroid[i]) * (p->xyz[j] - centroid[j]);
+    //principal component analysis: covariance matrix of the centroid reduced sample coordinates
+    const float *xyz[3] = {this->myStore->getXArray(), this->myStore->getYArray(), this->myStore->getZArray()};
+    fixed::Mat<3, 3> ata;
+    for(int k = 0; k < numPoints; ++k){
+        quint32 p = randomSample[k];
+        const double cr[3] = {xyz[0][p] - centroid[0], xyz[1][p] - centroid[1], xyz[2][p] - centroid[2]};
+        for(int i = 0; i < 3; ++i){
+            for(int j = i; j < 3; ++j){
+                ata(i, j) += cr[i] * cr[j];
             }
-            PS_PlaneSegment::ata.setAt(i, j, value);
         }
     }
+    ata(1, 0) = ata(0, 1);
+    ata(2, 0) = ata(0, 2);
+    ata(2, 1) = ata(1, 2);
 
-    PS_PlaneSegment::ata.svd(PS_PlaneSegment::u, PS_PlaneSegment::d, PS_PlaneSegment::v);
+    this->setFromCovariance(centroid, ata, numPoints);
 
-    //get eigenvector which is n vector
-    int eigenIndex = -1;
-    float eVal = 0.0;
-    for(int i = 0; i < PS_PlaneSegment::d.getSize(); i++){
-        if(PS_PlaneSegment::d.getAt(i) < eVal || i == 0){
-            eVal = PS_PlaneSegment::d.getAt(i);
-            eigenIndex = i;
-        }
-    }
-    if(eigenIndex > -1){
-
-        PS_PlaneSegment::u.getCol(PS_PlaneSegment::n0, eigenIndex);
-        double sumXN = 0.0, sumYN = 0.0, sumZN = 0.0;
-        for(int i = 0; i < numPoints; ++i){
-            PS_Point_PC *p = this->getPoints().at(randomSample.at(i));
-            sumXN += p->xyz[0] * PS_PlaneSegment::n0.getAt(0);
-            sumXN += p->xyz[1] * PS_PlaneSegment::n0.getAt(1);
-            sumXN += p->xyz[2] * PS_PlaneSegment::n0.getAt(2);
-        }
-        double d = (sumXN + sumYN + sumZN) / (double)numPoints;
-        //n0 = n0.normalize();
-
-        double sumVV = 0.0;
-        double x = 0.0, y = 0.0, z = 0.0;
-        for(int i = 0; i < planePoints; ++i){
+}
 
-            x = this->myState->myPoints.at(i)->xyz[0];
-            y = this->myState->myPoints.at(i)->xyz[1];
-            z = this->myState->myPoints.at(i)->xyz[2];
+/*!
+ * \brief PS_PlaneSegment::fitByMoments
+ * Fit the plane using the running sums of all points (O(1), used to refit the plane during region growing)
+ */
+void PS_PlaneSegment::fitByMoments(){
 
-            sumVV += (x*PS_PlaneSegment::n0.getAt(0) + y*PS_PlaneSegment::n0.getAt(1) + z*PS_PlaneSegment::n0.getAt(2) - d)
-                    * (x*PS_PlaneSegment::n0.getAt(0) + y*PS_PlaneSegment::n0.getAt(1) + z*PS_PlaneSegment::n0.getAt(2) - d);
+    PS_COUNT(eRefits, 1);
 
-        }
+    const PointMoments &moments = this->myMoments;
 
-        //set result
-        this->myPlaneState->n0[0] = PS_PlaneSegment::n0.getAt(0);
-        this->myPlaneState->n0[1] = PS_PlaneSegment::n0.getAt(1);
-        this->myPlaneState->n0[2] = PS_PlaneSegment::n0.getAt(2);
-        this->myPlaneState->d = d;
-        //this->myState->sigma = qSqrt(sumVV / ((double)planePoints - 3.0));
-        this->myState->sigma = qSqrt(eVal / ((double)numPoints - 3.0));
-        this->myState->mainFocus[0] = centroid[0];
-        this->myState->mainFocus[1] = centroid[1];
-        this->myState->mainFocus[2] = centroid[2];
-        this->myState->isValid = true;
-
-    }else{
+    if(moments.getCount() < 4){
         this->myState->isValid = false;
         return;
     }
 
+    double centroid[3];
+    moments.getCentroid(centroid);
+
+    this->setFromCovariance(centroid, moments.getScatterMatrix(), moments.getCount());
+
+}
+
+/*!
+ * \brief PS_PlaneSegment::setFromCovariance
+ * Set the plane from the centroid and the covariance matrix of its points (principal component analysis)
+ * \param centroid
+ * \param ata covariance matrix of the centroid reduced coordinates
+ * \param numPoints
+ */
+void PS_PlaneSegment::setFromCovariance(const double (&centroid)[3], const fixed::Mat<3, 3> &ata, const int &numPoints){
+
+    //the eigenvector of the smallest eigenvalue is the normal vector
+    fixed::Vec<3> eigenValues;
+    fixed::Mat<3, 3> eigenVectors;
+    fixed::eigenSymmetric(ata, eigenValues, eigenVectors);
+    const double eVal = qMax(eigenValues(2), 0.0);
+    const double n0[3] = {eigenVectors(0, 2), eigenVectors(1, 2), eigenVectors(2, 2)};
+
+    //the plane contains the centroid
+    double d = centroid[0] * n0[0] + centroid[1] * n0[1] + centroid[2] * n0[2];
+
+    //set result
+    this->myPlaneState->n0[0] = n0[0];
+    this->myPlaneState->n0[1] = n0[1];
+    this->myPlaneState->n0[2] = n0[2];
+    this->myPlaneState->d = d;
+    this->myState->sigma = qSqrt(eVal / ((double)numPoints - 3.0));
+    this->myState->mainFocus[0] = centroid[0];
+    this->myState->mainFocus[1] = centroid[1];
+    this->myState->mainFocus[2] = centroid[2];
+    this->myState->isValid = true;
+
 }
 
 /*!
@@ -398,7 +288,7 @@ void PS_PlaneSegment::fitBySample(int numPoints){
  * Calculate plane parameters from 3 points A, B and C
  * \param points
  */
-void PS_PlaneSegment::minimumSolution(const QList<PS_Point_PC *> &points){
+void PS_PlaneSegment::minimumSolution(const vector<quint32> &points){
 
     if(points.size() != 3){
         this->myState->isValid = false;
@@ -406,12 +296,15 @@ void PS_PlaneSegment::minimumSolution(const QList<PS_Point_PC *> &points){
     }
 
     //calculate vectors AB and AC
+    float a[3] = {this->myStore->getX(points[0]), this->myStore->getY(points[0]), this->myStore->getZ(points[0])};
     float ab[3];
     float ac[3];
-    for(int j = 0; j < 3; j++){
-        ab[j] = points.at(0)->xyz[j] - points.at(1)->xyz[j];
-        ac[j] = points.at(0)->xyz[j] - points.at(2)->xyz[j];
-    }
+    ab[0] = a[0] - this->myStore->getX(points[1]);
+    ab[1] = a[1] - this->myStore->getY(points[1]);
+    ab[2] = a[2] - this->myStore->getZ(points[1]);
+    ac[0] = a[0] - this->myStore->getX(points[2]);
+    ac[1] = a[1] - this->myStore->getY(points[2]);
+    ac[2] = a[2] - this->myStore->getZ(points[2]);
 
     //by cross product calculate normal vector of the plane
     float n[3];
@@ -426,9 +319,9 @@ void PS_PlaneSegment::minimumSolution(const QList<PS_Point_PC *> &points){
     n[2] = n[2] / laenge_n;
 
     //smallest distance d of the plane from the origin
-    float d = points.at(0)->xyz[0] * n[0]
-            + points.at(0)->xyz[1] * n[1]
-            + points.at(0)->xyz[2] * n[2];
+    float d = a[0] * n[0]
+            + a[1] * n[1]
+            + a[2] * n[2];
 
     //set the plane's attributes to the calculated values
     this->myPlaneState->d = d;
@@ -448,7 +341,7 @@ void PS_PlaneSegment::minimumSolution(const QList<PS_Point_PC *> &points){
  */
 void PS_PlaneSegment::sortOut(PS_PlaneSegment *myPlane, const PS_InputParameter &param, const int &toleranceFactor){
 
-    QList<PS_Point_PC *> myPoints = myPlane->getPoints();
+    vector<quint32> myPoints = myPlane->getPoints();
     myPlane->removeAllPoints();
     PS_PlaneSegment::checkPointsInPlane(myPlane, myPoints, param, toleranceFactor);
 
@@ -460,17 +353,67 @@ void PS_PlaneSegment::sortOut(PS_PlaneSegment *myPlane, const PS_InputParameter
  * \param detectedPlanes
  * \param mergedPlanes
  * \param param
+ * \param statistics
+ * \param compareAllPairs true if all pairs of planes shall be compared instead of only those in neighbouring cells of the merge index (same result, used as reference in tests)
  */
-void PS_PlaneSegment::mergePlanes(const QList<PS_PlaneSegment *> &detectedPlanes, QList<PS_PlaneSegment *> &mergedPlanes, const PS_InputParameter &param){
+void PS_PlaneSegment::mergePlanes(const QList<PS_PlaneSegment *> &detectedPlanes, QList<PS_PlaneSegment *> &mergedPlanes, const PS_InputParameter &param, PS_MergeStatistics &statistics,
+                                  const bool &compareAllPairs){
+
+    PS_SCOPED_TIMER(eMergePlanes);
+
+    QElapsedTimer timer;
+    timer.start();
 
-    float nAngle = 0.0f; //angle between the normal vectors of the two planes
     float dCP1P2 = 0.0f; //distance of centroid of plane 1 to plane 2
     float dCP2P1 = 0.0f; //distance of centroid of plane 2 to plane 1
+    float nAngle = 0.0f; //angle between the normal vectors
 
     if(mergedPlanes.size() != 0){
         mergedPlanes.clear();
     }
 
+    statistics = PS_MergeStatistics();
+    statistics.numShapes = detectedPlanes.size();
+
+    /*
+     * bucket the planes by their normal vector and their offset, so that only planes with similar parameters are compared
+     */
+
+    //the offset of each plane is computed relative to the mean main focus to keep it small
+    float reference[3] = {0.0f, 0.0f, 0.0f};
+    for(int i = 0; i < detectedPlanes.size(); ++i){
+        for(int k = 0; k < 3; k++){
+            reference[k] += detectedPlanes.at(i)->getMainFocus()[k] / (float)detectedPlanes.size();
+        }
+    }
+
+    //largest distance of a main focus from the reference and largest distance of a main focus from its own plane
+    float extent = 0.0f, maxFocusOffset = 0.0f;
+    for(int i = 0; i < detectedPlanes.size(); ++i){
+        PS_PlaneSegment *p = detectedPlanes.at(i);
+        float *focus = p->getMainFocus();
+        extent = qMax(extent, (float)qSqrt( (focus[0]-reference[0])*(focus[0]-reference[0])
+                + (focus[1]-reference[1])*(focus[1]-reference[1]) + (focus[2]-reference[2])*(focus[2]-reference[2]) ));
+        maxFocusOffset = qMax(maxFocusOffset, qAbs(focus[0]*p->getIJK()[0] + focus[1]*p->getIJK()[1] + focus[2]*p->getIJK()[2] - p->getDistance()));
+    }
+
+    /*
+     * two planes are compared if their normal vectors enclose less than angleTolerance, so each normal component differs
+     * by less than angleTolerance. The offsets then differ by less than the distance tolerance plus the tilt of the
+     * normal vector over the extent of the main foci, so a pair that satisfies the merge criterion is always found in
+     * a neighbour cell. The cells are slightly larger than these bounds to be robust against rounding errors.
+     */
+    float angleTolerance = 0.0873f;
+    float cellSizes[4] = {1.01f * angleTolerance, 1.01f * angleTolerance, 1.01f * angleTolerance,
+                          1.01f * (10.0f*param.planeParams.maxDistance + maxFocusOffset + angleTolerance*extent)};
+    PS_MergeIndex index(compareAllPairs ? 0 : 4, cellSizes);
+    float key[4], flippedKey[4];
+    for(int i = 0; i < detectedPlanes.size(); ++i){
+        PS_PlaneSegment::getMergeKey(detectedPlanes.at(i), reference, key);
+        index.insert(i, key);
+    }
+    vector<int> candidates;
+
     //for each plane save its merged state
     QMap<int, bool> mergeMap;
     for(int i = 0; i < detectedPlanes.size(); ++i){
@@ -488,80 +431,103 @@ void PS_PlaneSegment::mergePlanes(const QList<PS_PlaneSegment *> &detectedPlanes
 
         PS_PlaneSegment *p1 = detectedPlanes.at(i); //get the first plane
 
-        //compare all plane's params and merge them if they fit together
-        for(int j = i+1; j < detectedPlanes.size(); ++j){
-
-            //if the plane at position j was merged before
-            if(mergeMap.value(j) == true){
-                continue;
-            }
+        //the candidates are compared in the order of their position, so the result equals a comparison of all pairs
+        int lastCandidate = i;
+        bool isMerged = true;
+        while(isMerged){
 
-            PS_PlaneSegment *p2 = detectedPlanes.at(j); //get the second plane
+            isMerged = false;
 
-            //calculate the angle between the normal vectors of plane 1 and 2
-            nAngle = qAcos( p1->getIJK()[0] * p2->getIJK()[0]
-                    + p1->getIJK()[1] * p2->getIJK()[1]
-                    + p1->getIJK()[2] * p2->getIJK()[2] );
-            nAngle = qAbs( fmod(nAngle, PS_PI) );
-            if(qAbs(nAngle - PS_PI) < nAngle){ nAngle = qAbs(nAngle - PS_PI); }
+            //get all planes with a similar normal vector and offset (the normal vector may point in the opposite direction)
+            PS_PlaneSegment::getMergeKey(p1, reference, key);
+            for(int k = 0; k < 4; k++){
+                flippedKey[k] = -key[k];
+            }
+            candidates.clear();
+            index.getCandidates(candidates, key);
+            index.getCandidates(candidates, flippedKey);
 
-            dCP2P1 = p2->getMainFocus()[0]*p1->getIJK()[0] + p2->getMainFocus()[1]*p1->getIJK()[1] + p2->getMainFocus()[2]*p1->getIJK()[2] - p1->getDistance();
-            dCP1P2 = p1->getMainFocus()[0]*p2->getIJK()[0] + p1->getMainFocus()[1]*p2->getIJK()[1] + p1->getMainFocus()[2]*p2->getIJK()[2] - p2->getDistance();
+            //compare the plane's params with all candidates and merge them if they fit together
+            for(unsigned int c = 0; c < candidates.size(); ++c){
 
-            //if the parameter-differences are under a threshold
-            if(dCP2P1 < 10.0*param.planeParams.maxDistance && dCP1P2 < 10.0*param.planeParams.maxDistance){
-                    //&& nAngle < 0.0873){
+                int j = candidates[c];
 
-                PS_PlaneSegment *mergedPlane = new PS_PlaneSegment();
-                mergedPlane->setIsValid(true);
-                foreach(PS_Point_PC *myPoint, p1->getPoints()){
-                    myPoint->isUsed = false;
-                    mergedPlane->addPoint(myPoint);
-                }
-                foreach(PS_Point_PC *myPoint, p2->getPoints()){
-                    myPoint->isUsed = false;
-                    mergedPlane->addPoint(myPoint);
+                //if the plane at position j was considered before or was merged before
+                if(j <= lastCandidate || mergeMap.value(j) == true){
+                    continue;
                 }
+                lastCandidate = j;
+
+                PS_PlaneSegment *p2 = detectedPlanes.at(j); //get the second plane
+
+                statistics.numComparisons++;
+
+                dCP2P1 = qAbs(p2->getMainFocus()[0]*p1->getIJK()[0] + p2->getMainFocus()[1]*p1->getIJK()[1] + p2->getMainFocus()[2]*p1->getIJK()[2] - p1->getDistance());
+                dCP1P2 = qAbs(p1->getMainFocus()[0]*p2->getIJK()[0] + p1->getMainFocus()[1]*p2->getIJK()[1] + p1->getMainFocus()[2]*p2->getIJK()[2] - p2->getDistance());
+
+                //angle between the normal vectors (the normal vector may point in the opposite direction)
+                nAngle = qAcos(qMin(1.0f, qAbs(p1->getIJK()[0]*p2->getIJK()[0] + p1->getIJK()[1]*p2->getIJK()[1] + p1->getIJK()[2]*p2->getIJK()[2])));
+
+                //if the parameter-differences are under a threshold
+                if(dCP2P1 < 10.0*param.planeParams.maxDistance && dCP1P2 < 10.0*param.planeParams.maxDistance
+                        && nAngle < angleTolerance){
+
+                    PS_PlaneSegment *mergedPlane = new PS_PlaneSegment(p1->getPointStore());
+                    mergedPlane->setRandomSeed(p1->getRandomGenerator().next());
+                    mergedPlane->setIsValid(true);
+                    p1->setPointsUsed(false);
+                    p2->setPointsUsed(false);
+                    foreach(const quint32 &myPoint, p1->getPoints()){
+                        mergedPlane->addPoint(myPoint);
+                    }
+                    foreach(const quint32 &myPoint, p2->getPoints()){
+                        mergedPlane->addPoint(myPoint);
+                    }
+
+                    //fit plane and sort out points that do not satisfy the distance criterion
+                    //mergedPlane->fitBySample(param.fitSampleSize * 10);
+                    //mergedPlane->fitBySample(param.fitSampleSize * 10);
+                    mergedPlane->fit();
+                    PS_PlaneSegment::sortOut(mergedPlane, param, 3);
+                    //mergedPlane->fitBySample(param.fitSampleSize);
+
+                    //qDebug() << "p1 " << p1->getPointCount();
+                    //qDebug()<< "p2" << p2->getPointCount();
+                    //qDebug() << "merged " << mergedPlane->getPointCount();
+
+                    //if the merged plane's standard deviation is ok
+                    if(mergedPlane->getIsValid() //&& mergedPlane->getSigma() <= param.planeParams.maxDistance
+                            && mergedPlane->getPointCount() > p1->getPointCount()
+                            && mergedPlane->getPointCount() > p2->getPointCount()){
+
+                        //qDebug() << "deleted: " << p1->getPointCount()+p2->getPointCount()-mergedPlane->getPointCount();
+
+                        //delete single planes
+                        delete p1;
+                        delete p2;
+
+                        //set the planes to be merged
+                        mergeMap.insert(j, true);
+                        statistics.numMerges++;
+
+                        p1 = mergedPlane;
+
+                        //the merged plane has new parameters, so its candidates have to be queried again
+                        isMerged = true;
+                        break;
+
+                    }else{
+                        //qDebug() << "reject";
+                        /*qDebug() << mergedPlane->getIsValid();
+                        qDebug() << mergedPlane->getSigma();
+                        qDebug() << mergedPlane->getPointCount();*/
+                        delete mergedPlane;
+                    }
 
-                //fit plane and sort out points that do not satisfy the distance criterion
-                //mergedPlane->fitBySample(param.fitSampleSize * 10);
-                //mergedPlane->fitBySample(param.fitSampleSize * 10);
-                mergedPlane->fit();
-                PS_PlaneSegment::sortOut(mergedPlane, param, 3);
-                //mergedPlane->fitBySample(param.fitSampleSize);
-
-                //qDebug() << "p1 " << p1->getPointCount();
-                //qDebug()<< "p2" << p2->getPointCount();
-                //qDebug() << "merged " << mergedPlane->getPointCount();
-
-                //if the merged plane's standard deviation is ok
-                if(mergedPlane->getIsValid() //&& mergedPlane->getSigma() <= param.planeParams.maxDistance
-                        && mergedPlane->getPointCount() > p1->getPointCount()
-                        && mergedPlane->getPointCount() > p2->getPointCount()){
-
-                    //qDebug() << "deleted: " << p1->getPointCount()+p2->getPointCount()-mergedPlane->getPointCount();
-
-                    //delete single planes
-                    delete p1;
-                    delete p2;
-
-                    //set the planes to be merged
-                    mergeMap.insert(j, true);
-
-                    p1 = mergedPlane;
-
-                }else{
-                    //qDebug() << "reject";
-                    /*qDebug() << mergedPlane->getIsValid();
-                    qDebug() << mergedPlane->getSigma();
-                    qDebug() << mergedPlane->getPointCount();*/
-                    delete mergedPlane;
                 }
 
             }
 
-            //qDebug() << "angle: " << nAngle;
-
         }
 
         //add the plane to result list
@@ -569,6 +535,22 @@ void PS_PlaneSegment::mergePlanes(const QList<PS_PlaneSegment *> &detectedPlanes
 
     }
 
+    statistics.elapsedTime = timer.elapsed();
+
+}
+
+/*!
+ * \brief PS_PlaneSegment::getMergeKey
+ * Computes the key of the plane in the merge index (normal vector and offset relative to the reference point)
+ * \param p
+ * \param reference
+ * \param key
+ */
+void PS_PlaneSegment::getMergeKey(const PS_PlaneSegment *p, const float (&reference)[3], float (&key)[4]){
+    key[0] = p->getIJK()[0];
+    key[1] = p->getIJK()[1];
+    key[2] = p->getIJK()[2];
+    key[3] = p->getDistance() - (p->getIJK()[0]*reference[0] + p->getIJK()[1]*reference[1] + p->getIJK()[2]*reference[2]);
 }
 
 /*!
@@ -582,7 +564,7 @@ void PS_PlaneSegment::reviewNodes(const QList<PS_PlaneSegment *> &detectedPlanes
     int numAdded = 0; //number of added points
 
     //list to save all unmerged points of each node
-    QList<PS_Point_PC *> unmergedPoints;
+    vector<quint32> unmergedPoints;
 
     foreach(PS_PlaneSegment *p, detectedPlanes){
 
@@ -590,11 +572,11 @@ void PS_PlaneSegment::reviewNodes(const QList<PS_PlaneSegment *> &detectedPlanes
         foreach(PS_Node *n, p->getUsedNodes()){
 
             //try to add points that were not added yet
-            n->getUnmergedPoints(unmergedPoints);
+            n->getUnmergedPoints(unmergedPoints, p->getPointStore());
             numAdded = PS_PlaneSegment::checkPointsInPlane(p, unmergedPoints, param, 3);
-            QList<PS_Point_PC *> planePoints = p->getPoints();
+            const vector<quint32> &planePoints = p->getPoints();
             for(int i = 0; i < numAdded; ++i){
-                planePoints.at(planePoints.size()-1-i)->isUsed = true;
+                p->getPointStore()->setUsed(planePoints[planePoints.size()-1-i], true);
             }
 
             if(numAdded > 0){
@@ -3,15 +3,20 @@
 
 #include <QList>
 #include <QtMath>
+#include <QElapsedTimer>
 #include <math.h>
 
 #include "oivec.h"
 #include "oimat.h"
+#include "fixedmatrix.h"
 
 #include "ps_pointcloud.h"
 #include "ps_generalmath.h"
-#include "ps_point_pc.h"
+#include "ps_pointstore.h"
 #include "ps_shapesegment.h"
+#include "ps_distancekernels.h"
+#include "ps_ransac.h"
+#include "ps_mergeindex.h"
 
 //! \brief plane specific attributes
 struct PlaneState : ShapeState{
@@ -56,15 +61,17 @@ struct PlaneState : ShapeState{
 class PS_PlaneSegment : public PS_ShapeSegment
 {
 public:
-    PS_PlaneSegment();
+    PS_PlaneSegment(PS_PointStore *store);
     ~PS_PlaneSegment();
 
     bool writeToX3D(const QString &filePath);
 
     void fit();
     void fitBySample(int numPoints);
+    void fitByMoments();
 
-    void minimumSolution(const QList<PS_Point_PC *> &points);
+    void minimumSolution(const vector<quint32> &points);
+    unsigned int checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const;
 
     //! \brief Returns the smallest normal distance of the plane from the origin
     inline float getDistance() const{
@@ -76,21 +83,19 @@ public:
         return this->myPlaneState->n0;
     }
 
-    static PS_PlaneSegment *detectPlane(const QList<PS_Point_PC*> &points, const PS_InputParameter &param);
-    static int checkPointsInPlane(PS_PlaneSegment *myPlane, const QList<PS_Point_PC*> &myPoints, const PS_InputParameter &param, const int &toleranceFactor); //check wether a point is in the given plane
+    static PS_PlaneSegment *detectPlane(PS_PointStore *store, const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator);
+    static int checkPointsInPlane(PS_PlaneSegment *myPlane, const vector<quint32> &myPoints, const PS_InputParameter &param, const int &toleranceFactor,
+                                  vector<unsigned char> *inlierMask = NULL); //check wether a point is in the given plane
     static void sortOut(PS_PlaneSegment *myPlane, const PS_InputParameter &param, const int &toleranceFactor);
-    static void mergePlanes(const QList<PS_PlaneSegment *> &detectedPlanes, QList<PS_PlaneSegment *> &mergedPlanes, const PS_InputParameter &param);
+    static void mergePlanes(const QList<PS_PlaneSegment *> &detectedPlanes, QList<PS_PlaneSegment *> &mergedPlanes, const PS_InputParameter &param, PS_MergeStatistics &statistics,
+                            const bool &compareAllPairs = false);
     static void reviewNodes(const QList<PS_PlaneSegment *> &detectedPlanes, const PS_InputParameter &param);
 
 private:
 
-    //fitting helpers (static to not have to instanciate every time)
-    static OiMat u;
-    static OiMat v;
-    static OiVec d;
-    static OiVec n0;
-    static OiMat ata;
-    //static OiVec xyz;
+    void setFromCovariance(const double (&centroid)[3], const fixed::Mat<3, 3> &ata, const int &numPoints);
+
+    static void getMergeKey(const PS_PlaneSegment *p, const float (&reference)[3], float (&key)[4]);
 
     //current plane state pointer to access special plane attributes
     PlaneState *myPlaneState;
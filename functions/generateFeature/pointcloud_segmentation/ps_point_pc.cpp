@@ -1,5 +0,0 @@
-#include "ps_point_pc.h"
-
-PS_Point_PC::PS_Point_PC() : isUsed(false)//, isMerged(false)
-{
-}
@@ -3,12 +3,15 @@
 #include "ps_planesegment.h"
 #include "ps_spheresegment.h"
 #include "ps_cylindersegment.h"
+#include "ps_pointcloudloader.h"
+#include "ps_pointcloudcache.h"
+#include "ps_downsampling.h"
 
 QList<PS_Node*> PS_PointCloud::mergedNodes;
 
 PS_PointCloud::PS_PointCloud(QObject *parent) : QObject(parent)
 {
-    this->myPoints = new vector<PS_Point_PC*>;
+    this->myPoints = new PS_PointStore();
     this->num_points = 0;
 
     this->myBoundingBox.min[0] = numeric_limits<float>::max();
@@ -19,98 +22,84 @@ PS_PointCloud::PS_PointCloud(QObject *parent) : QObject(parent)
     this->myBoundingBox.max[2] = -numeric_limits<float>::max();
 
     this->myOctree = NULL;
-
-    this->c1 = clock();
+    this->myDownsampling = NULL;
+    this->useCache = false;
+    this->canceled = NULL;
+    this->writeOutput = true;
 }
 
 PS_PointCloud::PS_PointCloud(const PS_PointCloud &copy){
     this->myPoints = copy.myPoints;
     this->myBoundingBox = copy.myBoundingBox;
     this->myOctree = copy.myOctree;
+    this->myDownsampling = copy.myDownsampling;
     this->num_points = copy.num_points;
     this->detectedPlanes = copy.detectedPlanes;
     this->detectedSpheres = copy.detectedSpheres;
     this->detectedCylinders = copy.detectedCylinders;
+    this->filePath = copy.filePath;
+    this->useCache = copy.useCache;
+    this->cachedLayout = copy.cachedLayout;
+    this->canceled = copy.canceled;
+    this->writeOutput = copy.writeOutput;
 }
 
 PS_PointCloud &PS_PointCloud::operator=(const PS_PointCloud &copy){
     this->myPoints = copy.myPoints;
     this->myBoundingBox = copy.myBoundingBox;
     this->myOctree = copy.myOctree;
+    this->myDownsampling = copy.myDownsampling;
     this->num_points = copy.num_points;
     this->detectedPlanes = copy.detectedPlanes;
     this->detectedSpheres = copy.detectedSpheres;
     this->detectedCylinders = copy.detectedCylinders;
+    this->filePath = copy.filePath;
+    this->useCache = copy.useCache;
+    this->cachedLayout = copy.cachedLayout;
+    this->canceled = copy.canceled;
+    this->writeOutput = copy.writeOutput;
     return *this;
 }
 
 /*!
  * \brief PointCloud::loadPointCloud
- * Load a point cloud from PTS
+ * Load a point cloud from PTS or XYZ (see PS_PointCloudLoader)
  * \param fileName
+ * \param useCache true if the points and the octree should be read from (and written to) a binary cache file next to the point cloud
  */
-bool PS_PointCloud::loadPointCloud(QString fileName){
-
+bool PS_PointCloud::loadPointCloud(QString fileName, bool useCache){
 
-    QFile file(fileName);
-
-    if(!file.open(QIODevice::ReadOnly)) {
-        return false;
-    }
+    QElapsedTimer loadTimer;
+    loadTimer.start();
 
     try{
 
-        this->filePath = file.fileName();
-
-        QTextStream in(&file);
-
-        while(!in.atEnd()) {
+        this->filePath = fileName;
 
-            QString line = in.readLine();
+        //the cache can only represent the file if the point cloud does not contain other points
+        quint32 numPoints = this->myPoints->size();
+        this->useCache = useCache && numPoints == 0;
+        this->cachedLayout = PS_OctreeLayout();
 
-            QStringList fields = line.split(' ');
-
-            if(fields.length() >= 3){
-
-                //create a new point and add it to the point cloud
-                PS_Point_PC *myPoint = new PS_Point_PC();
-                myPoint->xyz[0] = fields.at(0).toFloat();
-                myPoint->xyz[1] = fields.at(1).toFloat();
-                myPoint->xyz[2] = fields.at(2).toFloat();
-                this->myPoints->push_back(myPoint);
-                this->num_points++;
-
-                //update bounding box
-                if(myPoint->xyz[0] < this->myBoundingBox.min[0]){
-                    this->myBoundingBox.min[0] = myPoint->xyz[0];
-                }
-                if(myPoint->xyz[0] > this->myBoundingBox.max[0]){
-                    this->myBoundingBox.max[0] = myPoint->xyz[0];
-                }
-                if(myPoint->xyz[1] < this->myBoundingBox.min[1]){
-                    this->myBoundingBox.min[1] = myPoint->xyz[1];
-                }
-                if(myPoint->xyz[1] > this->myBoundingBox.max[1]){
-                    this->myBoundingBox.max[1] = myPoint->xyz[1];
-                }
-                if(myPoint->xyz[2] < this->myBoundingBox.min[2]){
-                    this->myBoundingBox.min[2] = myPoint->xyz[2];
-                }
-                if(myPoint->xyz[2] > this->myBoundingBox.max[2]){
-                    this->myBoundingBox.max[2] = myPoint->xyz[2];
-                }
+        //read the points from the cache or parse the file concurrently and append all points to the point store
+        if(this->useCache && PS_PointCloudCache::read(fileName, this->myPoints, this->myBoundingBox, &this->cachedLayout, true)){
+            emit this->updateStatus("Point cloud read from cache " + PS_PointCloudCache::getCacheFileName(fileName), 0);
+        }else{
+            if(!PS_PointCloudLoader::load(fileName, this->myPoints, this->myBoundingBox)){
+                return false;
+            }
+            if(this->useCache){
+                PS_PointCloudCache::write(fileName, this->myPoints, this->myBoundingBox);
             }
-
         }
+        this->num_points += this->myPoints->size() - numPoints;
+
     }catch(exception &e){
-        file.close();
         qDebug() << e.what();
         return false;
     }
 
-    file.close();
-
-    cout << "einlesen fertig " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+    this->stageTimes.load = loadTimer.elapsed();
 
     return true;
 }
@@ -120,14 +109,14 @@ bool PS_PointCloud::loadPointCloud(QString fileName){
  * Manually set a previously loaded point cloud
  * \param myPoints
  * \param bbox
- * \param numPoints
  * \return
  */
-bool PS_PointCloud::setCloud(vector<PS_Point_PC *> *myPoints, PS_BoundingBox_PC bbox, unsigned long numPoints){
+bool PS_PointCloud::setCloud(PS_PointStore *myPoints, PS_BoundingBox_PC bbox){
 
     this->myPoints = myPoints;
     this->myBoundingBox = bbox;
-    this->num_points = numPoints;
+    this->num_points = myPoints->size();
+    this->useCache = false;
     return true;
 
 }
@@ -138,12 +127,64 @@ bool PS_PointCloud::setCloud(vector<PS_Point_PC *> *myPoints, PS_BoundingBox_PC
  */
 bool PS_PointCloud::setUpOctree(PS_InputParameter param)
 {
-    c1 = clock();
+    QElapsedTimer octreeTimer;
+    octreeTimer.start();
+
+    //build the octree over a reduced cloud (the points of the full cloud are assigned to the shapes at the end of detectShapes)
+    if(this->myDownsampling != NULL){
+        this->myPoints = this->myDownsampling->getFullPoints();
+        delete this->myDownsampling;
+        this->myDownsampling = NULL;
+    }
+    if(param.downsampling != eNoDownsampling){
+        PS_Downsampling *downsampling = new PS_Downsampling();
+        if(downsampling->reduce(this->myPoints, this->myBoundingBox, param)){
+            this->myDownsampling = downsampling;
+            this->myPoints = downsampling->getReducedPoints();
+            emit this->updateStatus(QString("Point cloud reduced from %1 to %2 points (%3 voxels) in %4 ms")
+                                    .arg(downsampling->getFullPoints()->size()).arg(this->myPoints->size())
+                                    .arg(downsampling->getVoxelCount()).arg(octreeTimer.elapsed()), 0);
+        }else{
+            delete downsampling;
+        }
+    }
 
-    this->myOctree = new PS_Octree();
-    this->myOctree->setUp(this->myPoints, &this->myBoundingBox, param.leafSize);
+    //restore the octree from the cache if it was built with the same leaf size (the cache holds the layout of the full cloud)
+    const PS_OctreeLayout *layout = NULL;
+    if(this->useCache && this->myDownsampling == NULL && this->cachedLayout.minPoints == param.leafSize){
+        layout = &this->cachedLayout;
+    }
+
+    if(param.linearOctree){
+        this->myOctree = new PS_LinearOctree();
+    }else{
+        this->myOctree = new PS_Octree();
+    }
+    this->myOctree->setNumThreads(param.numThreads);
+    this->myOctree->setUp(this->myPoints, &this->myBoundingBox, param.leafSize, layout);
+    QList<PS_Node *> *leafs = this->myOctree->getLeafs();
+    emit this->updateStatus(QString("Octree built in %1 ms (%2 leafs)").arg(this->myOctree->getBuildTime())
+                            .arg(leafs->size()), 0);
+    emit this->updateStatus(QString("Octree neighbours computed in %1 ms").arg(this->myOctree->getNeighbourTime()), 0);
+
+    //register the leafs in the point store to count their unused points while shapes claim points
+    vector<quint32> pointLeafs(this->myPoints->size(), PS_PointStore::noLeaf);
+    for(int i = 0; i < leafs->size(); i++){
+        PS_Node *n = leafs->at(i);
+        n->leafIndex = i;
+        for(quint32 k = 0; k < n->numPoints; k++){
+            pointLeafs[n->points[k]] = i;
+        }
+    }
+    this->myPoints->setLeafs(pointLeafs, leafs->size());
+
+    this->stageTimes.octree = octreeTimer.elapsed();
 
-    cout << "octree komplett fertig " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+    //update the cache with the layout of the new octree
+    if(this->useCache && this->myDownsampling == NULL && layout == NULL){
+        this->myOctree->getLayout(this->cachedLayout);
+        PS_PointCloudCache::write(this->filePath, this->myPoints, this->myBoundingBox, &this->cachedLayout);
+    }
     return true;
 }
 
@@ -158,10 +199,21 @@ bool PS_PointCloud::detectShapes(PS_InputParameter param){
 
         emit this->updateStatus("Octree successfully created", 1);
 
-        c1 = clock();
+        //counters and timers of this run are the difference to the values before the detection (see PS_Instrumentation)
+        PS_Statistics startStatistics = PS_Instrumentation::getSnapshot();
+
+        //shapes are detected in the reduced cloud with a scaled minimum number of points (see PS_Downsampling)
+        const PS_InputParameter fullParam = param;
+        if(this->myDownsampling != NULL){
+            param = this->myDownsampling->getReducedParameter(fullParam);
+        }
+        this->stageTimes.assign = 0;
+
+        //nodes of a previously segmented octree may still be listed
+        PS_PointCloud::mergedNodes.clear();
 
         //get leaf nodes from Octree (= nodes that are not subdevided into smaller nodes)
-        //the nodes are sorted from containing many points to containing less points
+        //the nodes are sorted from containing many points to containing less points (once, when the octree was built)
         QList<PS_Node *> *leafs = this->myOctree->getLeafs();
 
         /*float r = 0.0;
@@ -206,529 +258,565 @@ bool PS_PointCloud::detectShapes(PS_InputParameter param){
 
         int numPointLeafs = 0;
         for(int i = 0; i < leafs->size(); i++){
-            if(leafs->at(i)->points.size() > 0){
+            if(leafs->at(i)->numPoints > 0){
                 numPointLeafs++;
             }
         }
 
-        cout << "Start Geometrieerkennung: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
-
-        bool resetUnmerged = false; //if true all nodes are set as unmerged (eg after a plane detection before spheres)
-
         unsigned long numUsedPoints = 0; //number of already used points
 
-        clock_t test = clock();
-
-        //list to save all unused points of each node
-        QList<PS_Point_PC *> unusedPoints;
-
         //list to save all unmerged points of each node
-        QList<PS_Point_PC *> unmergedPoints;
-
-        //iterate through all leaf nodes starting with the one with the most points
-        for(int i = 0; i < leafs->size(); i++){
-
-            /*std::random_device rd;
-            int seed = rd();
-            std::default_random_engine generator( seed );
-            uniform_int_distribution<int> distribution(0, 255);
-
-                if(leafs->at(i)->points.size() > 0){
-                    r = distribution(generator);
-                    g = distribution(generator);
-                    b = distribution(generator);
+        vector<quint32> unmergedPoints;
 
-                    for(int j = 0; j < leafs->at(i)->points.size(); j++){
-                        if(!leafs->at(i)->points.at(j)->isUsed){
-                            streama << QString::number(leafs->at(i)->points.at(j)->xyz[0])
-                                    << " " << QString::number(leafs->at(i)->points.at(j)->xyz[1])
-                                    << " " << QString::number(leafs->at(i)->points.at(j)->xyz[2])
-                                    << " " << r << " " << g << " " << b
-                                    << endl;
-                            //leafs->at(i)->points.at(j)->isUsed = true;
-                        }
-                    }
-
-                }*/
-
-            //qDebug() << i;
-            //cout << "start: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+        //number of threads used to detect the shape candidates of the seed leafs
+        int numThreads = param.numThreads;
+        if(numThreads <= 0){
+            numThreads = QThread::idealThreadCount();
+        }
 
-            //leafs with 10 or less points are not considered, so break here because the list is ordered
-            if(leafs->at(i)->points.size() <= 10){
-                //break;
-                continue;
+        //shape candidates of the next seed leafs (detected concurrently if more than one thread is used)
+        vector<PS_SeedCandidates> candidates;
+        unsigned int batchSize = (numThreads > 1) ? 4 * numThreads : 1;
+
+        //the detection stops early if it is canceled or if the time budget is exceeded (see isStopRequested)
+        QElapsedTimer timer;
+        timer.start();
+        bool stopped = false;
+
+        //number of points in the leafs that were already considered as seed (used to report the progress)
+        unsigned long numConsumedPoints = 0;
+        int numConsumedLeafs = 0;
+
+        int i = 0;
+        bool enoughPoints = true;
+        while(i < leafs->size() && enoughPoints && !stopped){
+
+            //collect the next seed leafs (leafs with 10 or less points are not considered)
+            candidates.clear();
+            for(; i < leafs->size() && candidates.size() < batchSize; i++){
+                if(leafs->at(i)->numPoints > 10){
+                    PS_SeedCandidates seedCandidates;
+                    seedCandidates.seed = leafs->at(i);
+                    seedCandidates.leafIndex = i;
+                    candidates.push_back(seedCandidates);
+                }
             }
 
-            //check wether there are still enough points unused to be able to find a geometry
-            if( (!param.planeParams.detectPlanes || this->myPoints->size() - numUsedPoints < param.planeParams.minPoints)
-                    && (!param.sphereParams.detectSpheres || this->myPoints->size() - numUsedPoints < param.sphereParams.minPoints)
-                    && (!param.cylinderParams.detectCylinders || this->myPoints->size() - numUsedPoints < param.cylinderParams.minPoints)){
-                break;
+            //detect shape candidates in all collected seed leafs concurrently
+            if(numThreads > 1 && candidates.size() > 1){
+                QAtomicInt nextCandidate(0);
+                QThreadPool pool;
+                pool.setMaxThreadCount(numThreads);
+                for(int t = 0; t < numThreads; t++){
+                    pool.start(new PS_SeedDetectionTask(this, &candidates, &nextCandidate, param));
+                }
+                pool.waitForDone();
             }
 
-            resetUnmerged = false;
-
-            //get the current node to be considered and set it as considered in merge
-            PS_Node *n = leafs->at(i);
-            n->setWasConsideredAsSeed(true);
-            n->setWasConsideredInMerge(true);
-
-            //add node to list of merged nodes
-            PS_PointCloud::mergedNodes.append(n);
-
-
-
-
-
-
-
-            //nodes that contain more than 10 unused points are considered
-            if(n->getUnusedPointsCount() > 10){
-
-                /*
-                 * foreach node try to detect a plane, a sphere and a cylinder
-                 * and chose the one that best fits (sigma-value)
-                 */
-
-                //create shape variables here and set them to NULL
-                PS_PlaneSegment *p = NULL;
-                PS_SphereSegment *s = NULL;
-                PS_CylinderSegment *c = NULL;
-
-                //get a list of unsused points of node n
-                n->getUnusedPoints(unusedPoints);
+            /*
+             * claim points and grow regions in the order of the leafs, so that the result does not depend on
+             * the number of threads: candidates are only used if no points of their seed leaf were claimed in between
+             */
+            for(unsigned int k = 0; k < candidates.size(); k++){
 
-                /*
-                 * detect plane if requested by user
-                 */
-                if(param.planeParams.detectPlanes){
+                PS_SeedCandidates &seedCandidates = candidates[k];
 
-                    bool planeValid = false;
-
-                    //cout << "vor min: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
-
-                    //try to detect a plane in the leaf-node n
-                    p = PS_PlaneSegment::detectPlane(unusedPoints, param);
-
-                    //cout << "minSol: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
-
-                    //if a plane was found in the given leaf node
-                    if(p->getIsValid()){
-
-                        //fit the plane by sample
-                        p->fitBySample(param.fitSampleSize);
-
-                        if(p->getIsValid()){
-
-                            //start region growing by considering the neighbour nodes
-                            this->considerNeighbourNodes(n, param, p, unmergedPoints);
-
-                            //cout << "test considered: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
-
-                            resetUnmerged = true;
-
-                            //qDebug() << "point count: " << p->getPointCount();
-
-                            PS_PlaneSegment::sortOut(p, param, 3);
-
-                            //if the plane is valid and contains enough points
-                            if(p->getIsValid() && p->getPointCount() >= param.planeParams.minPoints){
-
-
-
-                                //finally fit the plane to be able to merge planes later
-                                p->fitBySample(param.fitSampleSize * 10);
-
-                                if(p->getIsValid()){
+                //check wether there are still enough points unused to be able to find a geometry
+                if( (!param.planeParams.detectPlanes || this->myPoints->size() - numUsedPoints < param.planeParams.minPoints)
+                        && (!param.sphereParams.detectSpheres || this->myPoints->size() - numUsedPoints < param.sphereParams.minPoints)
+                        && (!param.cylinderParams.detectCylinders || this->myPoints->size() - numUsedPoints < param.cylinderParams.minPoints)){
+                    enoughPoints = false;
+                }
 
-                                    //sort out points that do not satisfy the distance criterion
-                                    //PS_PlaneSegment::sortOut(p, param);
+                if(!stopped && this->isStopRequested(param, timer)){
+                    stopped = true;
+                }
 
-                                    //if there are still enough points after sorting out
-                                    //if(p->getPointCount() >= param.planeParams.minPoints){
-                                        planeValid = true;
-                                    //}
+                if(!enoughPoints || stopped){
+                    seedCandidates.deleteShapes();
+                    continue;
+                }
 
-                                }
+                //get the current node to be considered and set it as considered in merge
+                PS_Node *n = seedCandidates.seed;
+                n->setWasConsideredAsSeed(true);
+                n->setWasConsideredInMerge(true);
 
-                            }
+                //add node to list of merged nodes
+                PS_PointCloud::mergedNodes.append(n);
 
-                        }
+                //nodes that contain more than 10 unused points are considered (the unused points of the leafs are counted by the store)
+                unsigned long numUnusedPoints = n->getUnusedPointsCount(this->myPoints);
+                if(numUnusedPoints > 10){
 
+                    //(re)detect the candidates if they were not detected before or if points of the seed leaf were claimed meanwhile
+                    if(!seedCandidates.isDetected || seedCandidates.numUnusedPoints != numUnusedPoints){
+                        seedCandidates.deleteShapes();
+                        this->detectSeedCandidates(seedCandidates, param);
                     }
 
-                    //cout << "test fertig: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
-
-                    //delete plane if it is not valid
-                    if(!planeValid){
-                        delete p;
-                        p = NULL;
-                    }
+                    this->growSeedCandidates(seedCandidates, param, unmergedPoints, numUsedPoints);
 
+                }else{
+                    //continue with the next node when the current node does not contain more than 10 points
+                    seedCandidates.deleteShapes();
                 }
 
-                /*
-                 * detect sphere if requested by user
-                 */
-                if(param.sphereParams.detectSpheres){
+                //report the fraction of points whose leafs were considered as seed so far
+                for(; numConsumedLeafs <= seedCandidates.leafIndex; numConsumedLeafs++){
+                    numConsumedPoints += leafs->at(numConsumedLeafs)->numPoints;
+                }
+                double fraction = (this->myPoints->size() > 0) ? (double)numConsumedPoints / (double)this->myPoints->size() : 1.0;
+                emit this->updateProgress(fraction);
+                emit this->updateStatus(QString("%1 of %2 leaf nodes considered (%3 of %4 points used)").arg(seedCandidates.leafIndex + 1)
+                                        .arg(leafs->size()).arg(numUsedPoints).arg(this->myPoints->size()), 1 + (int)(59.0 * fraction));
 
-                    if(resetUnmerged){
+            }
 
-                        //reset all nodes to not have been considered in merge
-                        for(int j = 0; j < PS_PointCloud::mergedNodes.size(); j++){
-                            PS_PointCloud::mergedNodes.at(j)->setWasConsideredInMerge(false);
-                        }
-                        PS_PointCloud::mergedNodes.clear();
+        }
 
-                        //get the current node to be considered and set it as considered in merge
-                        n->setWasConsideredInMerge(true);
+        if(stopped){
+            emit this->updateStatus(QString("Detection stopped after %1 ms, starting with review of the %2 shapes found so far...").arg(timer.elapsed())
+                                    .arg(this->detectedPlanes.size() + this->detectedSpheres.size() + this->detectedCylinders.size()), 60);
+        }else{
+            emit this->updateProgress(1.0);
+            emit this->updateStatus("All leafs considered, starting with review...", 60);
+        }
 
-                        //add node to list of merged nodes
-                        PS_PointCloud::mergedNodes.append(n);
+        //fileOctree.close();
 
-                        resetUnmerged = false;
-                    }
+        //time of each post-processing stage (reported via updateStatus)
+        this->stageTimes.detect = timer.elapsed();
+        QElapsedTimer stageTimer;
+        stageTimer.start();
+
+        /*
+         * the streamed shapes are final: review, merge, verify and the final sort out would change or drop shapes that the
+         * receivers of planeAccepted, sphereAccepted and cylinderAccepted have already taken over
+         */
+        if(param.streamShapes){
+            this->stageTimes.review = 0;
+            this->stageTimes.merge = 0;
+            this->stageTimes.verify = 0;
+            this->stageTimes.sortOut = 0;
+            this->stageTimes.finalFit = 0;
+            if(this->myDownsampling != NULL){
+                this->assignFullCloud(fullParam);
+                this->stageTimes.assign = stageTimer.restart();
+            }
+            emit this->updateStatus("Shapes streamed, review, merge, verify and final fit are skipped", 98);
+        }else{
+            this->postProcessShapes(param, fullParam, numThreads);
+        }
 
-                    bool sphereValid = false;
+        this->statistics = PS_Instrumentation::getSnapshot() - startStatistics;
+        if(PS_Instrumentation::isEnabled()){
+            emit this->updateStatus(QString("Statistics: %1").arg(this->statistics.toString()), 98);
+        }
 
-                    //try to detect a sphere in the leaf-node n
-                    s = PS_SphereSegment::detectSphere(unusedPoints, param);
+        PS_PointCloud::mergedNodes.clear();
 
-                    //print sphere
-                    /*QFile fileS( QString("D:/UNI/Master/Semester_04/Masterarbeit/pointcloudSegmentation/result/minSphere%1.pts").arg(i) );
-                    if ( fileS.open(QIODevice::ReadWrite | QIODevice::Truncate) ){
+        emit this->updateStatus(QString("%1 planes, %2 spheres and %3 cylinders found").arg(this->detectedPlanes.size())
+                                .arg(this->detectedSpheres.size()).arg(this->detectedCylinders.size()), 98);
 
-                        float r = 0.0;
-                        float g = 0.0;
-                        float b = 0.0;
-                        QTextStream streama( &fileS );
+        if(!this->writeOutput){
+            emit this->updateStatus("Segmentation done", 99);
+            return true;
+        }
 
-                        std::random_device rd;
-                        int seed = rd();
-                        std::default_random_engine generator( seed );
-                        uniform_int_distribution<int> distribution(0, 255);
+        QString path = qApp->applicationDirPath().append("/result");
+        QDir dir(path);
+        if (!dir.exists()) {
+            dir.mkpath(path);
+        }
 
-                        for(int k = 0; k < s->getPoints().size(); k++){
-                            r = distribution(generator);
-                            g = distribution(generator);
-                            b = distribution(generator);
-                            streama << QString::number(s->getPoints().at(k)->xyz[0])
-                                    << " " << QString::number(s->getPoints().at(k)->xyz[1])
-                                    << " " << QString::number(s->getPoints().at(k)->xyz[2])
-                                    << " " << r << " " << g << " " << b
-                                    << endl;
-                        }
-                        fileS.close();
+        emit this->updateStatus(QString("Segmentation done, writing output files to %1").arg(path), 99);
 
-                    }*/
+        double processingTime = (this->stageTimes.getSegmentationTime() - this->stageTimes.octree) / 1000.0;
 
-                    //if a sphere was found in the given leaf node
-                    if(s->getIsValid() && s->getRadius() <= param.sphereParams.maxRadius
-                            && s->getRadius() >= param.sphereParams.minRadius){
+        this->printOutput(path, processingTime, fullParam);
 
-                        //fit the sphere by sample
-                        s->fitBySample(param.fitSampleSize);
+        //TODO in plugin show result modal dialog
 
-                        if(s->getIsValid()){
+        return true;
 
-                            //start region growing by considering the neighbour nodes
-                            this->considerNeighbourNodes(n, param, s, unmergedPoints);
+    }
+    return false;
+}
 
-                            resetUnmerged = true;
+const QList<PS_PlaneSegment *> &PS_PointCloud::getDetectedPlanes(){
+    return this->detectedPlanes;
+}
 
-                            PS_SphereSegment::sortOut(s, param, 3);
+const QList<PS_SphereSegment *> &PS_PointCloud::getDetectedSpheres(){
+    return this->detectedSpheres;
+}
 
-                            //if the sphere is valid and contains enough points
-                            if(s->getIsValid() && s->getPoints().size() >= param.sphereParams.minPoints
-                                    && s->getRadius() <= param.sphereParams.maxRadius
-                                    && s->getRadius() >= param.sphereParams.minRadius){
+const QList<PS_CylinderSegment *> &PS_PointCloud::getDetectedCylinders(){
+    return this->detectedCylinders;
+}
 
-                                //finally fit the sphere to be able to merge spheres later
-                                s->fitBySample(param.fitSampleSize * 10);
+/*!
+ * \brief PS_PointCloud::getStageTimes
+ * Returns the wall time of each stage of the last segmentation
+ * \return
+ */
+const PS_StageTimes &PS_PointCloud::getStageTimes() const{
+    return this->stageTimes;
+}
 
-                                if(s->getIsValid() && s->getRadius() <= param.sphereParams.maxRadius
-                                        && s->getRadius() >= param.sphereParams.minRadius){
+/*!
+ * \brief PS_PointCloud::getStatistics
+ * Returns the counters (RANSAC hypotheses, scored points, merged nodes, refits) and the accumulated times of the
+ * detection and merge functions of the last segmentation. All values are 0 if PS_WITH_INSTRUMENTATION is not defined.
+ * \return
+ */
+const PS_Statistics &PS_PointCloud::getStatistics() const{
+    return this->statistics;
+}
 
-                                    //sort out points that do not satisfy the distance criterion
-                                    //PS_SphereSegment::sortOut(s, param);
+/*!
+ * \brief PS_PointCloud::setCancelFlag
+ * Set a flag that is polled during shape detection. As soon as it is set to a value != 0 (from any thread)
+ * no further seed leafs are considered and the shapes found so far are reviewed, merged and fit as usual (unless they are streamed).
+ * \param canceled
+ */
+void PS_PointCloud::setCancelFlag(const QAtomicInt *canceled){
+    this->canceled = canceled;
+}
 
-                                    //cout << "test considered 3: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+/*!
+ * \brief PS_PointCloud::setWriteOutput
+ * Set wether detectShapes writes the result files (protocol and shapes) to the result directory of the application
+ * \param writeOutput
+ */
+void PS_PointCloud::setWriteOutput(const bool &writeOutput){
+    this->writeOutput = writeOutput;
+}
 
+/*!
+ * \brief PS_PointCloud::deleteOctree
+ * Deletes the octree and the reduced cloud (they are shared by all copies of the point cloud).
+ * The nodes referenced by the detected shapes become invalid.
+ */
+void PS_PointCloud::deleteOctree(){
+    this->myPoints->clearLeafs();
+    delete this->myOctree;
+    this->myOctree = NULL;
+    if(this->myDownsampling != NULL){
+        this->myPoints = this->myDownsampling->getFullPoints();
+        delete this->myDownsampling;
+        this->myDownsampling = NULL;
+    }
+}
 
-                                    //if there are still enough points after sorting out
-                                    //if(s->getPoints().size() >= param.sphereParams.minPoints){
-                                        sphereValid = true;
-                                    //}
+/*!
+ * \brief PS_SeedCandidates::deleteShapes
+ * Delete all shape candidates that were not accepted
+ */
+void PS_SeedCandidates::deleteShapes(){
+    if(this->plane != NULL){
+        delete this->plane;
+        this->plane = NULL;
+    }
+    if(this->sphere != NULL){
+        delete this->sphere;
+        this->sphere = NULL;
+    }
+    if(this->cylinder != NULL){
+        delete this->cylinder;
+        this->cylinder = NULL;
+    }
+    this->isDetected = false;
+}
 
-                                }
+/*!
+ * \brief PS_SeedDetectionTask::run
+ * Detect the shape candidates of seed leafs until all seed leafs of the batch are processed
+ */
+void PS_SeedDetectionTask::run(){
+    int index = this->nextCandidate->fetchAndAddOrdered(1);
+    while(index < (int)this->candidates->size()){
+        PS_SeedCandidates &seedCandidates = this->candidates->at(index);
+        seedCandidates.numUnusedPoints = seedCandidates.seed->getUnusedPointsCount(this->cloud->myPoints);
+        if(seedCandidates.numUnusedPoints > 10){
+            this->cloud->detectSeedCandidates(seedCandidates, this->param);
+        }
+        index = this->nextCandidate->fetchAndAddOrdered(1);
+    }
+}
 
-                            }
+/*!
+ * \brief PS_ShapeTask::run
+ * Processes detected shapes until all shapes have been taken by a task
+ */
+void PS_ShapeTask::run(){
+    int numShapes = this->cloud->getShapeCount();
+    int index = this->nextShape->fetchAndAddOrdered(1);
+    while(index < numShapes){
+        this->cloud->processShape(index, this->type, this->param, this->buffer, this->inlierMask);
+        index = this->nextShape->fetchAndAddOrdered(1);
+    }
+}
 
-                        }
+/*!
+ * \brief PS_PointCloud::detectSeedCandidates
+ * Detect a plane, a sphere and a cylinder candidate in the unused points of a seed leaf.
+ * This only reads the point cloud and thus may be called for several seed leafs concurrently.
+ * \param seedCandidates
+ * \param param
+ */
+void PS_PointCloud::detectSeedCandidates(PS_SeedCandidates &seedCandidates, const PS_InputParameter &param) const{
 
-                    }
+    //get a list of unsused points of the seed node
+    vector<quint32> unusedPoints;
+    seedCandidates.seed->getUnusedPoints(unusedPoints, this->myPoints);
+    seedCandidates.numUnusedPoints = unusedPoints.size();
 
-                    //delete sphere if it is not valid
-                    if(!sphereValid){
-                        delete s;
-                        s = NULL;
-                    }
+    //each seed leaf draws its random samples from an own stream to be independent of the detection order
+    PS_Random generator(PS_Random::deriveSeed(param.randomSeed, seedCandidates.leafIndex));
 
-                }
+    /*
+     * detect plane if requested by user
+     */
+    if(param.planeParams.detectPlanes){
 
-                /*
-                 * detect cylinder if requested by user
-                 */
-                if(param.cylinderParams.detectCylinders){
+        //try to detect a plane in the leaf-node n
+        PS_PlaneSegment *p = PS_PlaneSegment::detectPlane(this->myPoints, unusedPoints, param, generator);
 
-                    if(resetUnmerged){
+        //if a plane was found in the given leaf node fit the plane by sample
+        if(p->getIsValid()){
+            p->fitBySample(param.fitSampleSize);
+        }
 
-                        //reset all nodes to not have been considered in merge
-                        for(int j = 0; j < PS_PointCloud::mergedNodes.size(); j++){
-                            PS_PointCloud::mergedNodes.at(j)->setWasConsideredInMerge(false);
-                        }
-                        PS_PointCloud::mergedNodes.clear();
+        if(p->getIsValid()){
+            seedCandidates.plane = p;
+        }else{
+            delete p;
+        }
 
-                        //get the current node to be considered and set it as considered in merge
-                        n->setWasConsideredInMerge(true);
+    }
 
-                        //add node to list of merged nodes
-                        PS_PointCloud::mergedNodes.append(n);
+    /*
+     * detect sphere if requested by user
+     */
+    if(param.sphereParams.detectSpheres){
 
-                        resetUnmerged = false;
-                    }
+        //try to detect a sphere in the leaf-node n
+        PS_SphereSegment *s = PS_SphereSegment::detectSphere(this->myPoints, unusedPoints, param, generator);
 
-                    bool cylinderValid = false;
+        //if a sphere was found in the given leaf node fit the sphere by sample
+        bool sphereValid = false;
+        if(s->getIsValid() && s->getRadius() <= param.sphereParams.maxRadius
+                && s->getRadius() >= param.sphereParams.minRadius){
+            s->fitBySample(param.fitSampleSize);
+            sphereValid = s->getIsValid();
+        }
 
-                    //try to detect a cylinder in the leaf-node n
-                    c = PS_CylinderSegment::detectCylinder(unusedPoints, param);
+        if(sphereValid){
+            seedCandidates.sphere = s;
+        }else{
+            delete s;
+        }
 
-                    //if a cylinder was found in the given leaf node
-                    if(c->getIsValid() && c->getRadius() <= param.cylinderParams.maxRadius
-                            && c->getRadius() >= param.cylinderParams.minRadius){
+    }
 
-                        //fit the cylinder by sample
-                        c->fitBySample(param.fitSampleSize);
+    /*
+     * detect cylinder if requested by user
+     */
+    if(param.cylinderParams.detectCylinders){
 
-                        if(c->getIsValid()){
+        //try to detect a cylinder in the leaf-node n
+        PS_CylinderSegment *c = PS_CylinderSegment::detectCylinder(this->myPoints, unusedPoints, param, generator);
 
-                            //start region growing by considering the neighbour nodes
-                            this->considerNeighbourNodes(n, param, c, unmergedPoints);
+        //if a cylinder was found in the given leaf node fit the cylinder by sample
+        bool cylinderValid = false;
+        if(c->getIsValid() && c->getRadius() <= param.cylinderParams.maxRadius
+                && c->getRadius() >= param.cylinderParams.minRadius){
+            c->fitBySample(param.fitSampleSize);
+            cylinderValid = c->getIsValid();
+        }
 
-                            PS_CylinderSegment::sortOut(c, param, 3);
+        if(cylinderValid){
+            seedCandidates.cylinder = c;
+        }else{
+            delete c;
+        }
 
-                            //if the cylinder is valid and contains enough points
-                            if(c->getIsValid() && c->getPoints().size() >= param.cylinderParams.minPoints
-                                    && c->getRadius() <= param.cylinderParams.maxRadius
-                                    && c->getRadius() >= param.cylinderParams.minRadius){
+    }
 
-                                //finally fit the cylinder to be able to merge cylinders later
-                                c->fitBySample(param.fitSampleSize * 10);
+    seedCandidates.isDetected = true;
 
-                                if(c->getIsValid() && c->getRadius() <= param.cylinderParams.maxRadius
-                                        && c->getRadius() >= param.cylinderParams.minRadius){
+}
 
-                                    //sort out points that do not satisfy the distance criterion
-                                    //PS_CylinderSegment::sortOut(c, param);
+/*!
+ * \brief PS_PointCloud::growSeedCandidates
+ * Grow the shape candidates of a seed leaf into its neighbour nodes and accept the best one
+ * \param seedCandidates
+ * \param param
+ * \param unmergedPoints
+ * \param numUsedPoints
+ */
+void PS_PointCloud::growSeedCandidates(PS_SeedCandidates &seedCandidates, const PS_InputParameter &param, vector<quint32> &unmergedPoints, unsigned long &numUsedPoints){
 
-                                    //if there are still enough points after sorting out
-                                    //if(c->getPoints().size() >= param.cylinderParams.minPoints){
-                                        cylinderValid = true;
-                                    //}
+    PS_Node *n = seedCandidates.seed;
 
-                                }
+    PS_PlaneSegment *p = seedCandidates.plane;
+    PS_SphereSegment *s = seedCandidates.sphere;
+    PS_CylinderSegment *c = seedCandidates.cylinder;
 
-                            }
+    //the candidates are either accepted or deleted in here
+    seedCandidates.plane = NULL;
+    seedCandidates.sphere = NULL;
+    seedCandidates.cylinder = NULL;
 
-                        }
+    bool resetUnmerged = false; //if true all nodes are set as unmerged (eg after a plane detection before spheres)
 
-                    }
+    if(p != NULL){
 
-                    //delete cylinder if it is not valid
-                    if(!cylinderValid){
-                        delete c;
-                        c = NULL;
-                    }
+        bool planeValid = false;
 
-                }
+        //start region growing by considering the neighbour nodes (timed here, because considerNeighbourNodes is recursive)
+        {
+            PS_SCOPED_TIMER(eConsiderNeighbourNodes);
+            this->considerNeighbourNodes(n, param, p, unmergedPoints);
+        }
 
-                this->acceptShapeCandidates(p, s, c, numUsedPoints, param);
+        resetUnmerged = true;
 
-                //reset all nodes to not have been considered in merge
-                for(int j = 0; j < PS_PointCloud::mergedNodes.size(); j++){
-                    PS_PointCloud::mergedNodes.at(j)->setWasConsideredInMerge(false);
-                }
-                PS_PointCloud::mergedNodes.clear();
+        PS_PlaneSegment::sortOut(p, param, 3);
 
-                emit this->updateStatus(QString("%1 of %2 leaf nodes considered").arg(i).arg(this->myOctree->getLeafs()->size()), 1 + 59 * (i / this->myOctree->getLeafs()->size()));
+        //if the plane is valid and contains enough points
+        if(p->getIsValid() && p->getPointCount() >= param.planeParams.minPoints){
 
-                //cout << "test continue: " << (clock() - test)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+            //finally fit the plane to be able to merge planes later
+            p->fitBySample(param.fitSampleSize * 10);
 
-            }else{
-                //continue with the next node when the current node does not contain more than 10 points
-                continue;
+            if(p->getIsValid()){
+                planeValid = true;
             }
 
         }
 
-        emit this->updateStatus("All leafs considered, starting with review...", 60);
-
-        //fileOctree.close();
+        //delete plane if it is not valid
+        if(!planeValid){
+            delete p;
+            p = NULL;
+        }
 
-        cout << "Ende Geometrieerkennung: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+    }
 
-        //review used nodes for all detected shapes and probably add further points which were overlooked
-        PS_PlaneSegment::reviewNodes(this->detectedPlanes, param);
-        PS_SphereSegment::reviewNodes(this->detectedSpheres, param);
-        PS_CylinderSegment::reviewNodes(this->detectedCylinders, param);
+    if(s != NULL){
 
-        emit this->updateStatus("Review completed, starting with merge...", 67);
+        if(resetUnmerged){
+            this->resetMergedNodes(n);
+            resetUnmerged = false;
+        }
 
-        qDebug() << "spheres " << this->detectedSpheres.size();
+        bool sphereValid = false;
 
-        cout << "Ende Review: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+        //start region growing by considering the neighbour nodes (timed here, because considerNeighbourNodes is recursive)
+        {
+            PS_SCOPED_TIMER(eConsiderNeighbourNodes);
+            this->considerNeighbourNodes(n, param, s, unmergedPoints);
+        }
 
-        //merge planes, spheres and cylinders which were detected as 2 different shapes, but are in fact the same
-        QList<PS_SphereSegment *> mergedSpheres;
-        PS_SphereSegment::mergeSpheres(this->detectedSpheres, mergedSpheres, param);
-        this->detectedSpheres = mergedSpheres;
+        resetUnmerged = true;
 
-        qDebug() << "vor " << this->detectedCylinders.size();
-        QList<PS_CylinderSegment *> mergedCylinders;
-        PS_CylinderSegment::mergeCylinders(this->detectedCylinders, mergedCylinders, param);
-        this->detectedCylinders = mergedCylinders;
-        qDebug() << "nach " << this->detectedCylinders.size();
+        PS_SphereSegment::sortOut(s, param, 3);
 
-        QList<PS_PlaneSegment *> mergedPlanes;
-        PS_PlaneSegment::mergePlanes(this->detectedPlanes, mergedPlanes, param);
-        this->detectedPlanes = mergedPlanes;
+        //if the sphere is valid and contains enough points
+        if(s->getIsValid() && s->getPoints().size() >= param.sphereParams.minPoints
+                && s->getRadius() <= param.sphereParams.maxRadius
+                && s->getRadius() >= param.sphereParams.minRadius){
 
-        emit this->updateStatus("Merge completed, starting to verify...", 80);
+            //finally fit the sphere to be able to merge spheres later
+            s->fitBySample(param.fitSampleSize * 10);
 
-        cout << "Ende Merge: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+            if(s->getIsValid() && s->getRadius() <= param.sphereParams.maxRadius
+                    && s->getRadius() >= param.sphereParams.minRadius){
+                sphereValid = true;
+            }
 
-        qDebug() << "spheres vor verify " << this->detectedSpheres.size();
+        }
 
-        //verify spheres and cylinders (sort out ones whose points almost lie in a plane
-        QList<PS_SphereSegment *> verifiedSpheres;
-        PS_SphereSegment::verifySpheres(this->detectedSpheres, verifiedSpheres, param);
-        this->detectedSpheres = verifiedSpheres;
+        //delete sphere if it is not valid
+        if(!sphereValid){
+            delete s;
+            s = NULL;
+        }
 
-        QList<PS_CylinderSegment *> verifiedCylinders;
-        PS_CylinderSegment::verifyCylinders(this->detectedCylinders, verifiedCylinders, param);
-        this->detectedCylinders = verifiedCylinders;
+    }
 
-        emit this->updateStatus("Verify completed, starting with final sort out and fit...", 90);
+    if(c != NULL){
 
-        qDebug() << "spheres nach verify " << this->detectedSpheres.size();
+        if(resetUnmerged){
+            this->resetMergedNodes(n);
+            resetUnmerged = false;
+        }
 
-        cout << "Ende Verify: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+        bool cylinderValid = false;
 
-        //final sort out
-        QList<PS_SphereSegment *> finalSpheres;
-        foreach(PS_SphereSegment *s, this->detectedSpheres){
-            s->fitBySample(param.fitSampleSize * 10);
-            foreach(PS_Point_PC *poi, s->getPoints()){
-                poi->isUsed = false;
-            }
-            PS_SphereSegment::sortOut(s, param, 3);
-            if(s->getPointCount() >= param.sphereParams.minPoints){
-                finalSpheres.append(s);
-            }
+        //start region growing by considering the neighbour nodes (timed here, because considerNeighbourNodes is recursive)
+        {
+            PS_SCOPED_TIMER(eConsiderNeighbourNodes);
+            this->considerNeighbourNodes(n, param, c, unmergedPoints);
         }
-        this->detectedSpheres = finalSpheres;
 
-        QList<PS_PlaneSegment *> finalPlanes;
-        foreach(PS_PlaneSegment *p, this->detectedPlanes){
-            //p->fitBySample(param.fitSampleSize * 10);
-            p->fit();
-            foreach(PS_Point_PC *poi, p->getPoints()){
-                poi->isUsed = false;
-            }
-            PS_PlaneSegment::sortOut(p, param, 3);
-            if(p->getPointCount() >= param.planeParams.minPoints){
-                finalPlanes.append(p);
-            }
-        }
-        this->detectedPlanes = finalPlanes;
+        PS_CylinderSegment::sortOut(c, param, 3);
 
-        QList<PS_CylinderSegment *> finalCylinders;
-        foreach(PS_CylinderSegment *c, this->detectedCylinders){
-            c->fitBySample(param.fitSampleSize * 10);
-            foreach(PS_Point_PC *poi, c->getPoints()){
-                poi->isUsed = false;
-            }
-            PS_CylinderSegment::sortOut(c, param, 3);
-            if(c->getPointCount() >= param.cylinderParams.minPoints){
-                finalCylinders.append(c);
-            }
-        }
-        this->detectedCylinders = finalCylinders;
+        //if the cylinder is valid and contains enough points
+        if(c->getIsValid() && c->getPoints().size() >= param.cylinderParams.minPoints
+                && c->getRadius() <= param.cylinderParams.maxRadius
+                && c->getRadius() >= param.cylinderParams.minRadius){
 
-        cout << "Ende final sort out: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+            //finally fit the cylinder to be able to merge cylinders later
+            c->fitBySample(param.fitSampleSize * 10);
 
-        //finally fit the detected shapes using all points that are associated to a shape
-        if(param.finalFit){
-            foreach(PS_SphereSegment *s, this->detectedSpheres){
-                s->fit();
+            if(c->getIsValid() && c->getRadius() <= param.cylinderParams.maxRadius
+                    && c->getRadius() >= param.cylinderParams.minRadius){
+                cylinderValid = true;
             }
-            for(int i = 0; i < this->detectedPlanes.size(); ++i){
-                this->detectedPlanes.at(i)->fit();
-            }
-            for(int i = 0; i < this->detectedCylinders.size(); ++i){
-                this->detectedCylinders.at(i)->fit();
-            }
-        }else{
-            for(int i = 0; i < this->detectedSpheres.size(); ++i){
-                this->detectedSpheres.at(i)->fitBySample(param.fitSampleSize);
-            }
-            for(int i = 0; i < this->detectedPlanes.size(); ++i){
-                this->detectedPlanes.at(i)->fitBySample(param.fitSampleSize);
-            }
-            for(int i = 0; i < this->detectedCylinders.size(); ++i){
-                this->detectedCylinders.at(i)->fitBySample(param.fitSampleSize);
-            }
-        }
 
-        QString path = qApp->applicationDirPath().append("/result");
-        qDebug() << path;
-        QDir dir(path);
-        if (!dir.exists()) {
-            dir.mkpath(path);
         }
 
-        emit this->updateStatus(QString("Segmentation done, writing output files to %1").arg(path), 99);
-
-        double processingTime = (clock() - c1)/(double)CLOCKS_PER_SEC;
+        //delete cylinder if it is not valid
+        if(!cylinderValid){
+            delete c;
+            c = NULL;
+        }
 
-        cout << "Ende All: " << (clock() - c1)/(double)CLOCKS_PER_SEC << " seconds." << endl;
+    }
 
-        //print result overview to console
-        qDebug() << this->detectedPlanes.size() << " planes found";
-        qDebug() << this->detectedSpheres.size() << " spheres found";
-        qDebug() << this->detectedCylinders.size() << " cylinders found";
+    this->acceptShapeCandidates(p, s, c, numUsedPoints, param);
 
-        this->printOutput(path, processingTime, param);
+    //reset all nodes to not have been considered in merge
+    for(int j = 0; j < PS_PointCloud::mergedNodes.size(); j++){
+        PS_PointCloud::mergedNodes.at(j)->setWasConsideredInMerge(false);
+    }
+    PS_PointCloud::mergedNodes.clear();
 
-        //TODO in plugin show result modal dialog
+}
 
-        return true;
+/*!
+ * \brief PS_PointCloud::resetMergedNodes
+ * Reset all nodes to not have been considered in merge except the seed node
+ * \param seed
+ */
+void PS_PointCloud::resetMergedNodes(PS_Node *seed){
 
+    //reset all nodes to not have been considered in merge
+    for(int j = 0; j < PS_PointCloud::mergedNodes.size(); j++){
+        PS_PointCloud::mergedNodes.at(j)->setWasConsideredInMerge(false);
     }
-    return false;
-}
+    PS_PointCloud::mergedNodes.clear();
 
-const QList<PS_PlaneSegment *> &PS_PointCloud::getDetectedPlanes(){
-    return this->detectedPlanes;
-}
+    //get the current node to be considered and set it as considered in merge
+    seed->setWasConsideredInMerge(true);
 
-const QList<PS_SphereSegment *> &PS_PointCloud::getDetectedSpheres(){
-    return this->detectedSpheres;
-}
+    //add node to list of merged nodes
+    PS_PointCloud::mergedNodes.append(seed);
 
-const QList<PS_CylinderSegment *> &PS_PointCloud::getDetectedCylinders(){
-    return this->detectedCylinders;
 }
 
 /*!
@@ -739,7 +827,7 @@ const QList<PS_CylinderSegment *> &PS_PointCloud::getDetectedCylinders(){
  * \param p
  * \param unmergedPoints
  */
-void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, QList<PS_Point_PC *> &unmergedPoints){
+void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, vector<quint32> &unmergedPoints){
 
     if(p->getIsValid()){
 
@@ -793,8 +881,8 @@ void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &
         //if there are nodes to be extended
         if(nodesToGrow.size() > 0){
 
-            //refit the plane before considering further neighbours
-            p->fitBySample(param.fitSampleSize);
+            //refit the plane from the running sums of its points before considering further neighbours
+            p->fitByMoments();
 
             if(!p->getIsValid()){
                 return;
@@ -827,7 +915,7 @@ void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &
  * \param s
  * \param unmergedPoints
  */
-void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, QList<PS_Point_PC *> &unmergedPoints){
+void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, vector<quint32> &unmergedPoints){
 
     if(s->getIsValid()){
 
@@ -881,8 +969,8 @@ void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &
         //if there are nodes to be extended
         if(nodesToGrow.size() > 0){
 
-            //refit the sphere before considering further neighbours
-            s->fitBySample(param.fitSampleSize);
+            //refit the sphere from the running sums of its points before considering further neighbours
+            s->fitByMoments();
 
             if(!s->getIsValid()){
                 return;
@@ -914,7 +1002,7 @@ void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &
  * \param c
  * \param unmergedPoints
  */
-void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, QList<PS_Point_PC *> &unmergedPoints){
+void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, vector<quint32> &unmergedPoints){
 
     if(c->getIsValid()){
 
@@ -1003,7 +1091,9 @@ void PS_PointCloud::considerNeighbourNodes(PS_Node *n, const PS_InputParameter &
  * \param unmergedPoints
  * \return
  */
-bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, QList<PS_Point_PC *> &unmergedPoints){
+bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, vector<quint32> &unmergedPoints){
+
+    PS_SCOPED_TIMER(eMergeNode);
 
     //number of points the plane currently contains
     unsigned int numPoints = p->getPoints().size();
@@ -1012,7 +1102,7 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Pla
     p->saveCurrentState();
 
     //try to add further points of node n
-    n->getUnmergedPoints(unmergedPoints);
+    n->getUnmergedPoints(unmergedPoints, this->myPoints);
     PS_PlaneSegment::checkPointsInPlane(p, unmergedPoints, param, 3);
 
     //set node as considered in merge and add it to list of merged nodes
@@ -1022,6 +1112,7 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Pla
     //if at minimum 4 points have been found in the node consider its neighbours
     if(p->getPointCount() - numPoints >= 4){
 
+        PS_COUNT(eNodesMerged, 1);
         return true;
 
     }else{
@@ -1042,7 +1133,9 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Pla
  * \param unmergedPoints
  * \return
  */
-bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, QList<PS_Point_PC *> &unmergedPoints){
+bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, vector<quint32> &unmergedPoints){
+
+    PS_SCOPED_TIMER(eMergeNode);
 
     //number of points the sphere currently contains
     unsigned int numPoints = s->getPoints().size();
@@ -1051,7 +1144,7 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Sph
     s->saveCurrentState();
 
     //try to add further points of node n
-    n->getUnmergedPoints(unmergedPoints);
+    n->getUnmergedPoints(unmergedPoints, this->myPoints);
     PS_SphereSegment::checkPointsInSphere(s, unmergedPoints, param, 3);
 
     //set node as considered in merge and add it to list of merged nodes
@@ -1061,6 +1154,7 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Sph
     //if at minimum 5 points have been found in the node consider its neighbours
     if(s->getPointCount() - numPoints >= 5){
 
+        PS_COUNT(eNodesMerged, 1);
         return true;
 
     }else{
@@ -1081,7 +1175,9 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Sph
  * \param unmergedPoints
  * \return
  */
-bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, QList<PS_Point_PC *> &unmergedPoints){
+bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, vector<quint32> &unmergedPoints){
+
+    PS_SCOPED_TIMER(eMergeNode);
 
     //number of points the cylinder currently contains
     unsigned int numPoints = c->getPoints().size();
@@ -1090,7 +1186,7 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Cyl
     c->saveCurrentState();
 
     //try to add further points of node n
-    n->getUnmergedPoints(unmergedPoints);
+    n->getUnmergedPoints(unmergedPoints, this->myPoints);
     PS_CylinderSegment::checkPointsInCylinder(c, unmergedPoints, param, 3);
 
     //set node as considered in merge and add it to list of merged nodes
@@ -1100,6 +1196,7 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Cyl
     //if at minimum 6 points have been found in the node consider its neighbours
     if(c->getPointCount() - numPoints >= 6){
 
+        PS_COUNT(eNodesMerged, 1);
         return true;
 
     }else{
@@ -1111,6 +1208,192 @@ bool PS_PointCloud::mergeNode(PS_Node *n, const PS_InputParameter &param, PS_Cyl
 
 }
 
+/*!
+ * \brief PS_PointCloud::postProcessShapes
+ * Review, merge, verify, sort out and finally fit the detected shapes
+ * \param param parameters of the cloud the shapes were detected in
+ * \param fullParam parameters of the full cloud (differ from param if the shapes were detected in a reduced cloud)
+ * \param numThreads
+ */
+void PS_PointCloud::postProcessShapes(const PS_InputParameter &param, const PS_InputParameter &fullParam, const int &numThreads){
+
+    //time of each post-processing stage (reported via updateStatus)
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
+    /*
+     * review used nodes for all detected shapes and probably add further points which were overlooked
+     * (serial, because the shapes claim the unused points in the order of detection)
+     */
+    PS_PlaneSegment::reviewNodes(this->detectedPlanes, param);
+    PS_SphereSegment::reviewNodes(this->detectedSpheres, param);
+    PS_CylinderSegment::reviewNodes(this->detectedCylinders, param);
+
+    this->stageTimes.review = stageTimer.restart();
+    emit this->updateStatus(QString("Review completed in %1 ms, starting with merge...").arg(this->stageTimes.review), 67);
+
+    //merge planes, spheres and cylinders which were detected as 2 different shapes, but are in fact the same
+    PS_MergeStatistics sphereStatistics, cylinderStatistics, planeStatistics;
+
+    QList<PS_SphereSegment *> mergedSpheres;
+    PS_SphereSegment::mergeSpheres(this->detectedSpheres, mergedSpheres, param, sphereStatistics);
+    this->detectedSpheres = mergedSpheres;
+
+    QList<PS_CylinderSegment *> mergedCylinders;
+    PS_CylinderSegment::mergeCylinders(this->detectedCylinders, mergedCylinders, param, cylinderStatistics);
+    this->detectedCylinders = mergedCylinders;
+
+    QList<PS_PlaneSegment *> mergedPlanes;
+    PS_PlaneSegment::mergePlanes(this->detectedPlanes, mergedPlanes, param, planeStatistics);
+    this->detectedPlanes = mergedPlanes;
+
+    emit this->updateStatus(QString("Merged %1 of %2 spheres, %3 of %4 cylinders and %5 of %6 planes").arg(sphereStatistics.numMerges).arg(sphereStatistics.numShapes)
+                            .arg(cylinderStatistics.numMerges).arg(cylinderStatistics.numShapes).arg(planeStatistics.numMerges).arg(planeStatistics.numShapes), 79);
+    emit this->updateStatus(QString("Compared %1 of %2 possible shape pairs in %3 ms")
+                            .arg(sphereStatistics.numComparisons + cylinderStatistics.numComparisons + planeStatistics.numComparisons)
+                            .arg(sphereStatistics.getNumPossibleComparisons() + cylinderStatistics.getNumPossibleComparisons() + planeStatistics.getNumPossibleComparisons())
+                            .arg(sphereStatistics.elapsedTime + cylinderStatistics.elapsedTime + planeStatistics.elapsedTime), 79);
+
+    this->stageTimes.merge = stageTimer.restart();
+    emit this->updateStatus(QString("Merge completed in %1 ms, starting to verify...").arg(this->stageTimes.merge), 80);
+
+    //verify spheres and cylinders (sort out ones whose points almost lie in a plane
+    QList<PS_SphereSegment *> verifiedSpheres;
+    PS_SphereSegment::verifySpheres(this->detectedSpheres, verifiedSpheres, param);
+    this->detectedSpheres = verifiedSpheres;
+
+    QList<PS_CylinderSegment *> verifiedCylinders;
+    PS_CylinderSegment::verifyCylinders(this->detectedCylinders, verifiedCylinders, param);
+    this->detectedCylinders = verifiedCylinders;
+
+    this->stageTimes.verify = stageTimer.restart();
+    emit this->updateStatus(QString("Verify completed in %1 ms, starting with final sort out and fit...").arg(this->stageTimes.verify), 90);
+
+    /*
+     * final sort out: release the points of all shapes first (the used state of the points is not changed concurrently),
+     * then refit and sort out all shapes in parallel and finally drop the ones with too few points in the order of detection
+     */
+    foreach(PS_PlaneSegment *p, this->detectedPlanes){
+        p->setPointsUsed(false);
+    }
+    foreach(PS_SphereSegment *s, this->detectedSpheres){
+        s->setPointsUsed(false);
+    }
+    foreach(PS_CylinderSegment *c, this->detectedCylinders){
+        c->setPointsUsed(false);
+    }
+    this->processShapes(PS_ShapeTask::eSortOut, param, numThreads);
+
+    QList<PS_SphereSegment *> finalSpheres;
+    foreach(PS_SphereSegment *s, this->detectedSpheres){
+        if(s->getPointCount() >= param.sphereParams.minPoints){
+            finalSpheres.append(s);
+        }
+    }
+    this->detectedSpheres = finalSpheres;
+
+    QList<PS_PlaneSegment *> finalPlanes;
+    foreach(PS_PlaneSegment *p, this->detectedPlanes){
+        if(p->getPointCount() >= param.planeParams.minPoints){
+            finalPlanes.append(p);
+        }
+    }
+    this->detectedPlanes = finalPlanes;
+
+    QList<PS_CylinderSegment *> finalCylinders;
+    foreach(PS_CylinderSegment *c, this->detectedCylinders){
+        if(c->getPointCount() >= param.cylinderParams.minPoints){
+            finalCylinders.append(c);
+        }
+    }
+    this->detectedCylinders = finalCylinders;
+
+    this->stageTimes.sortOut = stageTimer.restart();
+    emit this->updateStatus(QString("Final sort out completed in %1 ms, starting with final fit...").arg(this->stageTimes.sortOut), 95);
+
+    //assign the points of the full cloud to the shapes that were detected in the reduced cloud
+    if(this->myDownsampling != NULL){
+        this->assignFullCloud(fullParam);
+        this->stageTimes.assign = stageTimer.restart();
+        emit this->updateStatus(QString("Points of the full cloud assigned in %1 ms, starting with final fit...").arg(this->stageTimes.assign), 96);
+    }
+
+    //finally fit the detected shapes using all points that are associated to a shape
+    if(param.finalFit){
+        this->processShapes(PS_ShapeTask::eFinalFit, fullParam, numThreads);
+    }else{
+        this->processShapes(PS_ShapeTask::eSampleFit, fullParam, numThreads);
+    }
+
+    this->stageTimes.finalFit = stageTimer.elapsed();
+    emit this->updateStatus(QString("Final fit completed in %1 ms").arg(this->stageTimes.finalFit), 98);
+
+}
+
+/*!
+ * \brief PS_PointCloud::assignFullCloud
+ * Moves the shapes that were detected in the reduced cloud to the full cloud (see PS_Downsampling::assignPoints)
+ * and drops the shapes that contain too few points of the full cloud
+ * \param param parameters of the full cloud
+ */
+void PS_PointCloud::assignFullCloud(const PS_InputParameter &param){
+
+    //the points are checked with the same tolerance as in the final sort out (invalid shapes get no points)
+    QList<PS_ShapeSegment *> shapes;
+    vector<float> thresholds;
+    foreach(PS_PlaneSegment *p, this->detectedPlanes){
+        shapes.append(p);
+        thresholds.push_back(p->getIsValid() ? 3.0f * param.planeParams.maxDistance : 0.0f);
+    }
+    foreach(PS_SphereSegment *s, this->detectedSpheres){
+        shapes.append(s);
+        thresholds.push_back(s->getIsValid() ? 3.0f * param.sphereParams.maxDistance : 0.0f);
+    }
+    foreach(PS_CylinderSegment *c, this->detectedCylinders){
+        shapes.append(c);
+        thresholds.push_back(c->getIsValid() ? 3.0f * param.cylinderParams.maxDistance : 0.0f);
+    }
+
+    this->myDownsampling->assignPoints(shapes, thresholds);
+    this->myPoints = this->myDownsampling->getFullPoints();
+
+    //streamed shapes were already handed over, so they are kept even if they contain too few points of the full cloud
+    if(param.streamShapes){
+        return;
+    }
+
+    QList<PS_PlaneSegment *> assignedPlanes;
+    foreach(PS_PlaneSegment *p, this->detectedPlanes){
+        if(p->getPointCount() >= param.planeParams.minPoints){
+            assignedPlanes.append(p);
+        }else{
+            delete p;
+        }
+    }
+    this->detectedPlanes = assignedPlanes;
+
+    QList<PS_SphereSegment *> assignedSpheres;
+    foreach(PS_SphereSegment *s, this->detectedSpheres){
+        if(s->getPointCount() >= param.sphereParams.minPoints){
+            assignedSpheres.append(s);
+        }else{
+            delete s;
+        }
+    }
+    this->detectedSpheres = assignedSpheres;
+
+    QList<PS_CylinderSegment *> assignedCylinders;
+    foreach(PS_CylinderSegment *c, this->detectedCylinders){
+        if(c->getPointCount() >= param.cylinderParams.minPoints){
+            assignedCylinders.append(c);
+        }else{
+            delete c;
+        }
+    }
+    this->detectedCylinders = assignedCylinders;
+
+}
+
 /*!
  * \brief PS_PointCloud::acceptShapeCandidates
  * Accept or reject shape candidates that were detected in one leaf voxel
@@ -1126,11 +1409,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
     if( p != NULL && (s == NULL || s->getSigma() > p->getSigma()) && (c == NULL || c->getSigma() > 3.0*p->getSigma() ) ){
 
         //accept plane and set its points as used
-        this->detectedPlanes.append(p);
-        foreach(PS_Point_PC *poi, p->getPoints()){
-            poi->isUsed = true;
-        }
-        numUsedPoints += p->getPoints().size();
+        this->acceptPlane(p, numUsedPoints);
 
         //refit sphere with still unused points or delete
         if(s != NULL){
@@ -1158,11 +1437,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
         if(s != NULL && (c == NULL || c->getSigma() > s->getSigma())){
 
             //accept sphere and set its points as used
-            this->detectedSpheres.append(s);
-            foreach(PS_Point_PC *poi, s->getPoints()){
-                poi->isUsed = true;
-            }
-            numUsedPoints += s->getPoints().size();
+            this->acceptSphere(s, numUsedPoints);
 
             //refit cylinder with still unused points or delete
             if(c != NULL){
@@ -1172,11 +1447,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
                     c->fitBySample(param.fitSampleSize);
 
                     //accept cylinder and set its points as used
-                    this->detectedCylinders.append(c);
-                    foreach(PS_Point_PC *poi, c->getPoints()){
-                        poi->isUsed = true;
-                    }
-                    numUsedPoints += c->getPoints().size();
+                    this->acceptCylinder(c, numUsedPoints);
 
                 }else{
                     delete c;
@@ -1187,11 +1458,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
         }else if(c != NULL && (s == NULL || s->getSigma() >= c->getSigma())){
 
             //accept cylinder and set its points as used
-            this->detectedCylinders.append(c);
-            foreach(PS_Point_PC *poi, c->getPoints()){
-                poi->isUsed = true;
-            }
-            numUsedPoints += c->getPoints().size();
+            this->acceptCylinder(c, numUsedPoints);
 
             //refit sphere with still unused points or delete
             if(s != NULL){
@@ -1201,11 +1468,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
                     s->fitBySample(param.fitSampleSize);
 
                     //accept sphere and set its points as used
-                    this->detectedSpheres.append(s);
-                    foreach(PS_Point_PC *poi, s->getPoints()){
-                        poi->isUsed = true;
-                    }
-                    numUsedPoints += s->getPoints().size();
+                    this->acceptSphere(s, numUsedPoints);
 
                 }else{
                     delete s;
@@ -1218,11 +1481,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
     }else if( s != NULL && (p == NULL || p->getSigma() >= s->getSigma()) && (c == NULL || c->getSigma() > s->getSigma() ) ){
 
         //accept sphere and set its points as used
-        this->detectedSpheres.append(s);
-        foreach(PS_Point_PC *poi, s->getPoints()){
-            poi->isUsed = true;
-        }
-        numUsedPoints += s->getPoints().size();
+        this->acceptSphere(s, numUsedPoints);
 
         //refit plane with still unused points or delete
         if(p != NULL){
@@ -1249,11 +1508,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
         if(p != NULL && (c == NULL || c->getSigma() > p->getSigma())){
 
             //accept plane and set its points as used
-            this->detectedPlanes.append(p);
-            foreach(PS_Point_PC *poi, p->getPoints()){
-                poi->isUsed = true;
-            }
-            numUsedPoints += p->getPoints().size();
+            this->acceptPlane(p, numUsedPoints);
 
             //refit cylinder with still unused points or delete
             if(c != NULL){
@@ -1263,11 +1518,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
                     c->fitBySample(param.fitSampleSize);
 
                     //accept cylinder and set its points as used
-                    this->detectedCylinders.append(c);
-                    foreach(PS_Point_PC *poi, c->getPoints()){
-                        poi->isUsed = true;
-                    }
-                    numUsedPoints += c->getPoints().size();
+                    this->acceptCylinder(c, numUsedPoints);
 
                 }else{
                     delete c;
@@ -1278,11 +1529,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
         }else if(c != NULL && (p == NULL || p->getSigma() >= c->getSigma())){
 
             //accept cylinder and set its points as used
-            this->detectedCylinders.append(c);
-            foreach(PS_Point_PC *poi, c->getPoints()){
-                poi->isUsed = true;
-            }
-            numUsedPoints += c->getPoints().size();
+            this->acceptCylinder(c, numUsedPoints);
 
             //refit plane with still unused points or delete
             if(p != NULL){
@@ -1292,11 +1539,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
                     p->fitBySample(param.fitSampleSize);
 
                     //accept plane and set its points as used
-                    this->detectedPlanes.append(p);
-                    foreach(PS_Point_PC *poi, p->getPoints()){
-                        poi->isUsed = true;
-                    }
-                    numUsedPoints += p->getPoints().size();
+                    this->acceptPlane(p, numUsedPoints);
 
                 }else{
                     delete p;
@@ -1309,11 +1552,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
     }else if( c != NULL && (p == NULL || p->getSigma() >= c->getSigma()) && (s == NULL || s->getSigma() >= c->getSigma() ) ){
 
         //accept cylinder and set its points as used
-        this->detectedCylinders.append(c);
-        foreach(PS_Point_PC *poi, c->getPoints()){
-            poi->isUsed = true;
-        }
-        numUsedPoints += c->getPoints().size();
+        this->acceptCylinder(c, numUsedPoints);
 
         //refit plane with still unused points or delete
         if(p != NULL){
@@ -1340,11 +1579,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
         if(p != NULL && (s == NULL || s->getSigma() > p->getSigma())){
 
             //accept plane and set its points as used
-            this->detectedPlanes.append(p);
-            foreach(PS_Point_PC *poi, p->getPoints()){
-                poi->isUsed = true;
-            }
-            numUsedPoints += p->getPoints().size();
+            this->acceptPlane(p, numUsedPoints);
 
             //refit sphere with still unused points or delete
             if(s != NULL){
@@ -1354,11 +1589,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
                     s->fitBySample(param.fitSampleSize);
 
                     //accept sphere and set its points as used
-                    this->detectedSpheres.append(s);
-                    foreach(PS_Point_PC *poi, s->getPoints()){
-                        poi->isUsed = true;
-                    }
-                    numUsedPoints += s->getPoints().size();
+                    this->acceptSphere(s, numUsedPoints);
 
                 }else{
                     delete s;
@@ -1369,11 +1600,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
         }else if(s != NULL && (p == NULL || p->getSigma() >= s->getSigma())){
 
             //accept sphere and set its points as used
-            this->detectedSpheres.append(s);
-            foreach(PS_Point_PC *poi, s->getPoints()){
-                poi->isUsed = true;
-            }
-            numUsedPoints += s->getPoints().size();
+            this->acceptSphere(s, numUsedPoints);
 
             //refit plane with still unused points or delete
             if(p != NULL){
@@ -1383,11 +1610,7 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
                     p->fitBySample(param.fitSampleSize);
 
                     //accept plane and set its points as used
-                    this->detectedPlanes.append(p);
-                    foreach(PS_Point_PC *poi, p->getPoints()){
-                        poi->isUsed = true;
-                    }
-                    numUsedPoints += p->getPoints().size();
+                    this->acceptPlane(p, numUsedPoints);
 
                 }else{
                     delete p;
@@ -1401,6 +1624,161 @@ void PS_PointCloud::acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *
 
 }
 
+/*!
+ * \brief PS_PointCloud::acceptPlane
+ * Accept a plane, set its points as used and report it (see planeAccepted)
+ * \param p
+ * \param numUsedPoints
+ */
+void PS_PointCloud::acceptPlane(PS_PlaneSegment *p, unsigned long &numUsedPoints){
+    this->detectedPlanes.append(p);
+    p->setPointsUsed(true);
+    numUsedPoints += p->getPoints().size();
+    emit this->planeAccepted(p);
+}
+
+/*!
+ * \brief PS_PointCloud::acceptSphere
+ * Accept a sphere, set its points as used and report it (see sphereAccepted)
+ * \param s
+ * \param numUsedPoints
+ */
+void PS_PointCloud::acceptSphere(PS_SphereSegment *s, unsigned long &numUsedPoints){
+    this->detectedSpheres.append(s);
+    s->setPointsUsed(true);
+    numUsedPoints += s->getPoints().size();
+    emit this->sphereAccepted(s);
+}
+
+/*!
+ * \brief PS_PointCloud::acceptCylinder
+ * Accept a cylinder, set its points as used and report it (see cylinderAccepted)
+ * \param c
+ * \param numUsedPoints
+ */
+void PS_PointCloud::acceptCylinder(PS_CylinderSegment *c, unsigned long &numUsedPoints){
+    this->detectedCylinders.append(c);
+    c->setPointsUsed(true);
+    numUsedPoints += c->getPoints().size();
+    emit this->cylinderAccepted(c);
+}
+
+/*!
+ * \brief PS_PointCloud::isStopRequested
+ * Check wether the detection of further shapes shall be stopped (canceled or time budget exceeded)
+ * \param param
+ * \param timer timer that was started at the beginning of the detection
+ * \return
+ */
+bool PS_PointCloud::isStopRequested(const PS_InputParameter &param, const QElapsedTimer &timer) const{
+    if(this->canceled != NULL && this->canceled->loadAcquire() != 0){
+        return true;
+    }
+    return param.timeBudget > 0.0 && timer.elapsed() > (qint64)(param.timeBudget * 1000.0);
+}
+
+/*!
+ * \brief PS_PointCloud::processShapes
+ * Applies a post-processing step to all detected shapes. The shapes are independent at this stage and each shape draws
+ * its random samples from its own generator, so they are processed concurrently without changing the result.
+ * \param type
+ * \param param
+ * \param numThreads
+ */
+void PS_PointCloud::processShapes(const PS_ShapeTask::TaskType &type, const PS_InputParameter &param, const int &numThreads){
+
+    int numShapes = this->getShapeCount();
+
+    if(numThreads > 1 && numShapes > 1){
+        QAtomicInt nextShape(0);
+        QThreadPool pool;
+        pool.setMaxThreadCount(numThreads);
+        for(int t = 0; t < qMin(numThreads, numShapes); t++){
+            pool.start(new PS_ShapeTask(this, &nextShape, type, param));
+        }
+        pool.waitForDone();
+        return;
+    }
+
+    vector<quint32> buffer;
+    vector<unsigned char> inlierMask;
+    for(int i = 0; i < numShapes; i++){
+        this->processShape(i, type, param, buffer, inlierMask);
+    }
+
+}
+
+/*!
+ * \brief PS_PointCloud::processShape
+ * Applies a post-processing step to the detected shape with the given index (planes, then spheres, then cylinders).
+ * This only changes the shape itself and reads the used state of the points, so it may be called for several shapes concurrently.
+ * \param index
+ * \param type
+ * \param param
+ * \param buffer scratch memory of the calling task
+ * \param inlierMask scratch memory of the calling task for the inlier checks
+ */
+void PS_PointCloud::processShape(const int &index, const PS_ShapeTask::TaskType &type, const PS_InputParameter &param, vector<quint32> &buffer,
+                                 vector<unsigned char> &inlierMask){
+
+    PS_PlaneSegment *p = NULL;
+    PS_SphereSegment *s = NULL;
+    PS_CylinderSegment *c = NULL;
+    PS_ShapeSegment *shape = NULL;
+
+    int i = index;
+    if(i < this->detectedPlanes.size()){
+        p = this->detectedPlanes.at(i);
+        shape = p;
+    }else if((i -= this->detectedPlanes.size()) < this->detectedSpheres.size()){
+        s = this->detectedSpheres.at(i);
+        shape = s;
+    }else{
+        c = this->detectedCylinders.at(i - this->detectedSpheres.size());
+        shape = c;
+    }
+
+    switch(type){
+    case PS_ShapeTask::eSortOut:
+
+        //refit the shape and only keep the points near its surface (like sortOut, but with the scratch memory of the task)
+        if(p != NULL){
+            //p->fitBySample(param.fitSampleSize * 10);
+            p->fit();
+        }else{
+            shape->fitBySample(param.fitSampleSize * 10);
+        }
+        buffer.assign(shape->getPoints().begin(), shape->getPoints().end());
+        shape->removeAllPoints();
+        if(p != NULL){
+            PS_PlaneSegment::checkPointsInPlane(p, buffer, param, 3, &inlierMask);
+        }else if(s != NULL){
+            PS_SphereSegment::checkPointsInSphere(s, buffer, param, 3, &inlierMask);
+        }else{
+            PS_CylinderSegment::checkPointsInCylinder(c, buffer, param, 3, &inlierMask);
+        }
+        break;
+
+    case PS_ShapeTask::eFinalFit:
+        shape->fit();
+        break;
+
+    case PS_ShapeTask::eSampleFit:
+        shape->fitBySample(param.fitSampleSize);
+        break;
+    }
+
+}
+
+/*!
+ * \brief PS_PointCloud::getShapeCount
+ * Returns the number of detected planes, spheres and cylinders
+ * \return
+ */
+int PS_PointCloud::getShapeCount() const{
+    return this->detectedPlanes.size() + this->detectedSpheres.size() + this->detectedCylinders.size();
+}
+
 /*!
  * \brief PS_PointCloud::printOutput
  * Print output files with results of the segmentation
@@ -11,9 +11,13 @@
 #include <iostream>
 #include <limits>
 #include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
 #include <QObject>
 #include <vector>
 #include <QDateTime>
+#include <QElapsedTimer>
 
 #include <string>
 #include <sstream>
@@ -21,11 +25,14 @@
 #include <ctime>
 
 #include "ps_octree.h"
-#include "ps_point_pc.h"
+#include "ps_linearoctree.h"
+#include "ps_pointstore.h"
+#include "ps_instrumentation.h"
 
 class PS_PlaneSegment;
 class PS_SphereSegment;
 class PS_CylinderSegment;
+class PS_Downsampling;
 
 struct PS_BoundingBox_PC{
     float min[3];
@@ -57,12 +64,27 @@ struct CylinderParameter{
     float maxRadius; //maximum radius of detected spheres
 };
 
+//! decimation of the points before the octree is built (see PS_Downsampling)
+enum PS_DownsamplingMethod{
+    eNoDownsampling,
+    eVoxelGridDownsampling, //one point (the centroid) per voxel with at least two points
+    eRandomDownsampling //random subset of samplingRate of the points of each voxel
+};
+
 //! input parameter for pointcloud segmentation
 struct PS_InputParameter{
     unsigned int leafSize; //maximum number of points in one leaf-voxel
     float outlierPercentage; //estimated percentage of outlier points in a leaf voxel (between 0.0 and 1.0)
     float fitSampleSize; //percentage of points of a shape used to fit it by sample
     bool finalFit; //true if all detected shapes shall be fit at the end using all points
+    quint64 randomSeed; //seed of the random sampling (runs with the same seed and input yield the same shapes)
+    int numThreads; //number of threads used to build the octree and to detect shape candidates (0 = all available cores, 1 = serial)
+    bool linearOctree; //true if the octree shall be built as linear octree (see PS_LinearOctree)
+    double timeBudget; //maximum time in seconds spent on detecting shapes, the shapes found until then are kept (0 = unlimited)
+    bool streamShapes; //true if each shape shall be reported as soon as it is accepted, the shapes are not post-processed then (see PS_PointCloud::planeAccepted)
+    PS_DownsamplingMethod downsampling; //detect the shapes in a reduced cloud and assign the points of the full cloud afterwards
+    float voxelSize; //edge length of the voxels used to reduce the cloud (<= 0 = no downsampling)
+    float samplingRate; //fraction of the points of each voxel that is kept by the random downsampling (between 0.0 and 1.0)
     PlaneParameter planeParams; //special plane parameter
     SphereParameter sphereParams; //special sphere parameter
     CylinderParameter cylinderParams; //special cylinder parameter
@@ -70,6 +92,84 @@ struct PS_InputParameter{
 
 using namespace std;
 
+//! wall time in ms of each stage of the last segmentation (see PS_PointCloud::getStageTimes)
+struct PS_StageTimes{
+    PS_StageTimes() : load(0), octree(0), detect(0), review(0), merge(0), verify(0), sortOut(0), finalFit(0), assign(0){}
+
+    //! \brief Returns the time of all stages after loading the points
+    inline qint64 getSegmentationTime() const{
+        return this->octree + this->detect + this->review + this->merge + this->verify + this->sortOut + this->assign + this->finalFit;
+    }
+
+    qint64 load; //reading the points (from the file or the cache)
+    qint64 octree; //downsampling, building the octree and registering its leafs
+    qint64 detect; //detecting and growing shapes from the seed leafs
+    qint64 review; //adding overlooked points of the used nodes
+    qint64 merge; //merging shapes that were detected twice
+    qint64 verify; //sorting out spheres and cylinders whose points lie in a plane
+    qint64 sortOut; //final refit and sort out of all shapes
+    qint64 finalFit; //final fit of all shapes
+    qint64 assign; //assigning the points of the full cloud to the shapes detected in the reduced cloud (see PS_Downsampling)
+};
+
+//! shape candidates that were detected in the unused points of a seed leaf
+struct PS_SeedCandidates{
+    PS_SeedCandidates() : seed(NULL), leafIndex(0), isDetected(false), numUnusedPoints(0),
+        plane(NULL), sphere(NULL), cylinder(NULL){}
+
+    void deleteShapes();
+
+    PS_Node *seed; //the seed leaf
+    int leafIndex; //index of the seed leaf in the list of leafs
+    bool isDetected; //true if the candidates have been detected
+    unsigned long numUnusedPoints; //number of unused points of the seed leaf at detection time
+    PS_PlaneSegment *plane;
+    PS_SphereSegment *sphere;
+    PS_CylinderSegment *cylinder;
+};
+
+class PS_PointCloud;
+
+//! detects the shape candidates of a batch of seed leafs in a worker thread
+class PS_SeedDetectionTask : public QRunnable
+{
+public:
+    PS_SeedDetectionTask(const PS_PointCloud *cloud, vector<PS_SeedCandidates> *candidates, QAtomicInt *nextCandidate, const PS_InputParameter &param)
+        : cloud(cloud), candidates(candidates), nextCandidate(nextCandidate), param(param){}
+
+    void run();
+
+private:
+    const PS_PointCloud *cloud;
+    vector<PS_SeedCandidates> *candidates;
+    QAtomicInt *nextCandidate;
+    PS_InputParameter param;
+};
+
+//! applies one post-processing step to the detected shapes in a worker thread (each shape is processed on its own)
+class PS_ShapeTask : public QRunnable
+{
+public:
+    enum TaskType{
+        eSortOut, //refit the shape and keep only the points near its surface
+        eFinalFit, //fit the shape using all of its points
+        eSampleFit //fit the shape using a random sample of its points
+    };
+
+    PS_ShapeTask(PS_PointCloud *cloud, QAtomicInt *nextShape, TaskType type, const PS_InputParameter &param)
+        : cloud(cloud), nextShape(nextShape), type(type), param(param){}
+
+    void run();
+
+private:
+    PS_PointCloud *cloud;
+    QAtomicInt *nextShape;
+    TaskType type;
+    PS_InputParameter param;
+    vector<quint32> buffer; //scratch memory that is reused for all shapes processed by this task
+    vector<unsigned char> inlierMask; //scratch memory for the inlier checks of the shapes processed by this task
+};
+
 class PS_PointCloud : public QObject
 {
 
@@ -79,8 +179,8 @@ public:
     PS_PointCloud (const PS_PointCloud &copy);
     PS_PointCloud &operator=(const PS_PointCloud &copy);
 
-    bool loadPointCloud(QString fileName);
-    bool setCloud(vector<PS_Point_PC *> *myPoints, PS_BoundingBox_PC bbox, unsigned long numPoints);
+    bool loadPointCloud(QString fileName, bool useCache = false);
+    bool setCloud(PS_PointStore *myPoints, PS_BoundingBox_PC bbox);
     bool setUpOctree(PS_InputParameter param);
     bool detectShapes(PS_InputParameter param);
 
@@ -88,32 +188,62 @@ public:
     const QList<PS_SphereSegment *> &getDetectedSpheres();
     const QList<PS_CylinderSegment *> &getDetectedCylinders();
 
+    const PS_StageTimes &getStageTimes() const;
+    const PS_Statistics &getStatistics() const;
+
+    void setCancelFlag(const QAtomicInt *canceled);
+    void setWriteOutput(const bool &writeOutput);
+    void deleteOctree();
+
 signals:
     void parseLine(QString line);
     void updateStatus(QString msg, int status);
+    void updateProgress(double fraction);
+
+    //emitted as soon as a shape is accepted during region growing (review, merge, verify and final fit are skipped if streamShapes is set)
+    void planeAccepted(PS_PlaneSegment *p);
+    void sphereAccepted(PS_SphereSegment *s);
+    void cylinderAccepted(PS_CylinderSegment *c);
 
 private:
-    clock_t c1;
-    vector<PS_Point_PC *> *myPoints;
+    PS_PointStore *myPoints;
 
     PS_BoundingBox_PC myBoundingBox;
     unsigned long num_points;
 
     PS_Octree *myOctree;
+    PS_Downsampling *myDownsampling; //voxel grid of the full cloud if the shapes are detected in a reduced cloud (else NULL)
 
     QList<PS_PlaneSegment *> detectedPlanes;
     QList<PS_SphereSegment *> detectedSpheres;
     QList<PS_CylinderSegment *> detectedCylinders;
 
-    void considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, QList<PS_Point_PC *> &unmergedPoints);
-    void considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, QList<PS_Point_PC *> &unmergedPoints);
-    void considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, QList<PS_Point_PC *> &unmergedPoints);
+    void considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, vector<quint32> &unmergedPoints);
+    void considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, vector<quint32> &unmergedPoints);
+    void considerNeighbourNodes(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, vector<quint32> &unmergedPoints);
 
-    bool mergeNode(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, QList<PS_Point_PC *> &unmergedPoints);
-    bool mergeNode(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, QList<PS_Point_PC *> &unmergedPoints);
-    bool mergeNode(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, QList<PS_Point_PC *> &unmergedPoints);
+    bool mergeNode(PS_Node *n, const PS_InputParameter &param, PS_PlaneSegment *p, vector<quint32> &unmergedPoints);
+    bool mergeNode(PS_Node *n, const PS_InputParameter &param, PS_SphereSegment *s, vector<quint32> &unmergedPoints);
+    bool mergeNode(PS_Node *n, const PS_InputParameter &param, PS_CylinderSegment *c, vector<quint32> &unmergedPoints);
+
+    void detectSeedCandidates(PS_SeedCandidates &seedCandidates, const PS_InputParameter &param) const;
+    void growSeedCandidates(PS_SeedCandidates &seedCandidates, const PS_InputParameter &param, vector<quint32> &unmergedPoints, unsigned long &numUsedPoints);
+    void resetMergedNodes(PS_Node *seed);
+
+    void postProcessShapes(const PS_InputParameter &param, const PS_InputParameter &fullParam, const int &numThreads);
+    void assignFullCloud(const PS_InputParameter &param);
 
     void acceptShapeCandidates(PS_PlaneSegment *p, PS_SphereSegment *s, PS_CylinderSegment *c, unsigned long &numUsedPoints, const PS_InputParameter &param);
+    void acceptPlane(PS_PlaneSegment *p, unsigned long &numUsedPoints);
+    void acceptSphere(PS_SphereSegment *s, unsigned long &numUsedPoints);
+    void acceptCylinder(PS_CylinderSegment *c, unsigned long &numUsedPoints);
+
+    bool isStopRequested(const PS_InputParameter &param, const QElapsedTimer &timer) const;
+
+    void processShapes(const PS_ShapeTask::TaskType &type, const PS_InputParameter &param, const int &numThreads);
+    void processShape(const int &index, const PS_ShapeTask::TaskType &type, const PS_InputParameter &param, vector<quint32> &buffer,
+                      vector<unsigned char> &inlierMask);
+    int getShapeCount() const;
 
     void printOutput(QString filePath, double processingTime, PS_InputParameter param);
 
@@ -121,6 +251,19 @@ private:
 
     QString filePath;
 
+    bool useCache; //true if the points and the octree layout are cached in a binary file next to filePath
+    PS_OctreeLayout cachedLayout; //octree layout read from or written to the cache
+
+    bool writeOutput; //true if the result files shall be written at the end of detectShapes
+
+    PS_StageTimes stageTimes; //wall time of each stage of the last segmentation
+    PS_Statistics statistics; //counters and timers of the last call of detectShapes (only filled if PS_WITH_INSTRUMENTATION is defined)
+
+    const QAtomicInt *canceled; //set to a value != 0 from any thread to stop the detection of further shapes (may be NULL)
+
+    friend class PS_SeedDetectionTask;
+    friend class PS_ShapeTask;
+
 };
 
 #endif // PS_POINTCLOUD_H
@@ -0,0 +1,168 @@
+#include "ps_pointcloudcache.h"
+
+#include <cstring>
+#include <QSharedPointer>
+
+#include "ps_pointcloud.h"
+
+const quint32 PS_PointCloudCache::version;
+
+//! identifies cache files
+static const char PS_CACHE_MAGIC[8] = {'P', 'S', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+/*!
+ * \brief PS_PointCloudCache::getCacheFileName
+ * Returns the name of the cache file that belongs to the source file
+ * \param sourceFile
+ * \return
+ */
+QString PS_PointCloudCache::getCacheFileName(const QString &sourceFile){
+    return sourceFile + ".pscache";
+}
+
+/*!
+ * \brief PS_PointCloudCache::read
+ * Appends the cached points of the source file to the store and extends the bounding box
+ * \param sourceFile
+ * \param store
+ * \param bbox
+ * \param layout receives the cached octree layout (optional, minPoints is 0 if no layout is cached)
+ * \param mapPoints true if an empty store shall view the mapped coordinates instead of copying them (the mapping is held by the store)
+ * \return false if there is no valid cache for the source file
+ */
+bool PS_PointCloudCache::read(const QString &sourceFile, PS_PointStore *store, PS_BoundingBox_PC &bbox, PS_OctreeLayout *layout,
+                              const bool &mapPoints){
+
+    //the file is closed and unmapped as soon as the last reference is released
+    QSharedPointer<QFile> file(new QFile(PS_PointCloudCache::getCacheFileName(sourceFile)));
+    if(!file->open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    qint64 size = file->size();
+    if(size < (qint64)sizeof(PS_PointCloudCacheHeader)){
+        return false;
+    }
+
+    const uchar *data = file->map(0, size);
+    if(data == NULL){
+        return false;
+    }
+
+    //check that the cache belongs to the current version of the source file
+    PS_PointCloudCacheHeader header;
+    memcpy(&header, data, sizeof(PS_PointCloudCacheHeader));
+    qint64 sourceSize, sourceModified;
+    PS_PointCloudCache::getSourceInfo(sourceFile, sourceSize, sourceModified);
+    quint64 expectedSize = sizeof(PS_PointCloudCacheHeader) + header.numPoints * 3 * sizeof(float);
+    if(header.minPoints > 0){
+        expectedSize += (header.numPoints + header.numChildSizes) * sizeof(quint32);
+    }
+    if(memcmp(header.magic, PS_CACHE_MAGIC, sizeof(PS_CACHE_MAGIC)) != 0
+            || header.version != PS_PointCloudCache::version
+            || header.sourceSize != sourceSize || header.sourceModified != sourceModified
+            || header.numPoints > 0xFFFFFFFF || expectedSize != (quint64)size){
+        return false;
+    }
+
+    //view or copy the coordinates
+    const float *x = (const float *)(data + sizeof(PS_PointCloudCacheHeader));
+    const float *y = x + header.numPoints;
+    const float *z = y + header.numPoints;
+    if(mapPoints && store->size() == 0){
+        store->setView(x, y, z, header.numPoints, file);
+    }else{
+        store->reserve(store->size() + header.numPoints);
+        store->append(x, y, z, header.numPoints);
+    }
+    for(int k = 0; k < 3; k++){
+        bbox.min[k] = qMin(bbox.min[k], header.min[k]);
+        bbox.max[k] = qMax(bbox.max[k], header.max[k]);
+    }
+
+    //copy the octree layout
+    if(layout != NULL){
+        layout->minPoints = header.minPoints;
+        layout->indices.clear();
+        layout->childSizes.clear();
+        if(header.minPoints > 0){
+            const quint32 *indices = (const quint32 *)(z + header.numPoints);
+            const quint32 *childSizes = indices + header.numPoints;
+            layout->indices.assign(indices, indices + header.numPoints);
+            layout->childSizes.assign(childSizes, childSizes + header.numChildSizes);
+        }
+    }
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_PointCloudCache::write
+ * Writes the points of the store (and optionally the octree layout) to the cache file of the source file
+ * \param sourceFile
+ * \param store
+ * \param bbox
+ * \param layout
+ * \return
+ */
+bool PS_PointCloudCache::write(const QString &sourceFile, const PS_PointStore *store, const PS_BoundingBox_PC &bbox, const PS_OctreeLayout *layout){
+
+    //only cache layouts that belong to the points of the store
+    if(layout != NULL && (layout->minPoints == 0 || layout->indices.size() != store->size())){
+        layout = NULL;
+    }
+
+    PS_PointCloudCacheHeader header;
+    memset(&header, 0, sizeof(PS_PointCloudCacheHeader));
+    memcpy(header.magic, PS_CACHE_MAGIC, sizeof(PS_CACHE_MAGIC));
+    header.version = PS_PointCloudCache::version;
+    header.minPoints = (layout != NULL) ? layout->minPoints : 0;
+    PS_PointCloudCache::getSourceInfo(sourceFile, header.sourceSize, header.sourceModified);
+    header.numPoints = store->size();
+    header.numChildSizes = (layout != NULL) ? layout->childSizes.size() : 0;
+    for(int k = 0; k < 3; k++){
+        header.min[k] = bbox.min[k];
+        header.max[k] = bbox.max[k];
+    }
+
+    QFile file(PS_PointCloudCache::getCacheFileName(sourceFile));
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+
+    qint64 numBytes = header.numPoints * sizeof(float);
+    bool success = file.write((const char *)&header, sizeof(PS_PointCloudCacheHeader)) == sizeof(PS_PointCloudCacheHeader)
+            && file.write((const char *)store->getXArray(), numBytes) == numBytes
+            && file.write((const char *)store->getYArray(), numBytes) == numBytes
+            && file.write((const char *)store->getZArray(), numBytes) == numBytes;
+    if(success && layout != NULL){
+        qint64 numIndexBytes = layout->indices.size() * sizeof(quint32);
+        qint64 numSizeBytes = layout->childSizes.size() * sizeof(quint32);
+        success = file.write((const char *)layout->indices.data(), numIndexBytes) == numIndexBytes
+                && file.write((const char *)layout->childSizes.data(), numSizeBytes) == numSizeBytes;
+    }
+
+    file.close();
+
+    //do not leave incomplete cache files behind
+    if(!success){
+        file.remove();
+    }
+
+    return success;
+
+}
+
+/*!
+ * \brief PS_PointCloudCache::getSourceInfo
+ * Returns the size and the last modification time of the source file that are used to invalidate the cache
+ * \param sourceFile
+ * \param size
+ * \param modified
+ */
+void PS_PointCloudCache::getSourceInfo(const QString &sourceFile, qint64 &size, qint64 &modified){
+    QFileInfo info(sourceFile);
+    size = info.size();
+    modified = info.lastModified().toMSecsSinceEpoch();
+}
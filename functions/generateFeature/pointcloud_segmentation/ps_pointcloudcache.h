@@ -0,0 +1,57 @@
+#ifndef PS_POINTCLOUDCACHE_H
+#define PS_POINTCLOUDCACHE_H
+
+#include <QString>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <vector>
+
+#include "ps_pointstore.h"
+#include "ps_octree.h"
+
+struct PS_BoundingBox_PC;
+
+using namespace std;
+
+//! header at the beginning of each cache file (followed by the x, y and z arrays, the octree indices and the octree child sizes)
+struct PS_PointCloudCacheHeader{
+    char magic[8]; //"PSCACHE" to identify cache files
+    quint32 version; //version of the file format
+    quint32 minPoints; //minPoints of the cached octree layout (0 if no layout is cached)
+    qint64 sourceSize; //size of the source file in bytes
+    qint64 sourceModified; //last modification of the source file (msecs since epoch)
+    quint64 numPoints; //number of points
+    quint64 numChildSizes; //number of octree child sizes
+    float min[3]; //bounding box of the points
+    float max[3];
+};
+
+/*!
+ * \brief The PS_PointCloudCache class
+ * Binary sidecar cache of an ASCII point cloud file (<file>.pscache). The cache holds the raw coordinates,
+ * the bounding box and optionally the layout of the octree, so that repeated segmentations of the same file
+ * neither have to parse the file nor build the octree again. The cache is read via a memory mapping
+ * and is invalid as soon as the size or the modification time of the source file changes. An empty store may keep
+ * the mapping and view the cached coordinates directly instead of copying them (see PS_PointStore::setView).
+ */
+class PS_PointCloudCache
+{
+private:
+    PS_PointCloudCache();
+
+public:
+    static const quint32 version = 1;
+
+    static QString getCacheFileName(const QString &sourceFile);
+
+    static bool read(const QString &sourceFile, PS_PointStore *store, PS_BoundingBox_PC &bbox, PS_OctreeLayout *layout = NULL,
+                     const bool &mapPoints = false);
+    static bool write(const QString &sourceFile, const PS_PointStore *store, const PS_BoundingBox_PC &bbox, const PS_OctreeLayout *layout = NULL);
+
+private:
+    static void getSourceInfo(const QString &sourceFile, qint64 &size, qint64 &modified);
+
+};
+
+#endif // PS_POINTCLOUDCACHE_H
@@ -0,0 +1,357 @@
+#include "ps_pointcloudloader.h"
+
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+#include "ps_pointcloud.h"
+
+//! exactly representable powers of ten
+static const double PS_POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+//! \brief Returns true if c separates two values in a line
+static inline bool isSeparator(const char &c){
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+/*!
+ * \brief PS_PointCloudLoader::load
+ * Loads all points of the file into the store and extends the bounding box
+ * \param fileName
+ * \param store
+ * \param bbox
+ * \param numThreads number of threads used to parse the file (0 = all available cores)
+ * \return
+ */
+bool PS_PointCloudLoader::load(const QString &fileName, PS_PointStore *store, PS_BoundingBox_PC &bbox, int numThreads){
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    //nothing to load
+    qint64 size = file.size();
+    if(size == 0){
+        file.close();
+        return true;
+    }
+
+    const char *data = (const char *)file.map(0, size);
+    if(data == NULL){
+        file.close();
+        return false;
+    }
+
+    //parse all lines of the file
+    vector<PS_LoaderChunk> chunks;
+    PS_PointCloudLoader::parseBuffer(data, data + size, chunks, numThreads);
+
+    file.unmap((uchar *)data);
+    file.close();
+
+    //copy the points to the store in file order and reduce the bounding boxes of all chunks
+    qint64 numChunks = chunks.size();
+    quint32 numPoints = store->size();
+    for(qint64 i = 0; i < numChunks; i++){
+        numPoints += chunks[i].x.size();
+    }
+    store->reserve(numPoints);
+    for(qint64 i = 0; i < numChunks; i++){
+        PS_LoaderChunk &chunk = chunks[i];
+        store->append(chunk.x.data(), chunk.y.data(), chunk.z.data(), chunk.x.size());
+        if(chunk.x.size() > 0){
+            for(int k = 0; k < 3; k++){
+                bbox.min[k] = qMin(bbox.min[k], chunk.min[k]);
+                bbox.max[k] = qMax(bbox.max[k], chunk.max[k]);
+            }
+        }
+        vector<float>().swap(chunk.x);
+        vector<float>().swap(chunk.y);
+        vector<float>().swap(chunk.z);
+    }
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_PointCloudLoader::parseBuffer
+ * Splits the buffer into line aligned chunks (several chunks per thread to balance the load) and parses them concurrently
+ * \param begin
+ * \param end
+ * \param chunks receives the parsed chunks in buffer order
+ * \param numThreads number of threads used to parse the buffer (0 = all available cores)
+ */
+void PS_PointCloudLoader::parseBuffer(const char *begin, const char *end, vector<PS_LoaderChunk> &chunks, int numThreads){
+
+    if(numThreads <= 0){
+        numThreads = QThread::idealThreadCount();
+    }
+
+    const char *data = begin;
+    const qint64 size = end - begin;
+    const qint64 minChunkSize = 1 << 20;
+    qint64 numChunks = qMax((qint64)1, qMin((qint64)numThreads * 4, size / minChunkSize));
+    chunks.clear();
+    chunks.resize(numChunks);
+    for(qint64 i = 0; i < numChunks; i++){
+        const char *chunkEnd = (i == numChunks - 1) ? end : data + (size * (i + 1)) / numChunks;
+        if(chunkEnd < begin){
+            chunkEnd = begin;
+        }
+        if(chunkEnd < end){
+            const char *lineEnd = (const char *)memchr(chunkEnd, '\n', end - chunkEnd);
+            chunkEnd = (lineEnd == NULL) ? end : lineEnd + 1;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    if(numThreads > 1 && numChunks > 1){
+        QThreadPool pool;
+        pool.setMaxThreadCount(numThreads);
+        for(qint64 i = 0; i < numChunks; i++){
+            pool.start(new PS_LoaderTask(&chunks[i]));
+        }
+        pool.waitForDone();
+    }else{
+        for(qint64 i = 0; i < numChunks; i++){
+            PS_PointCloudLoader::parseChunk(chunks[i]);
+        }
+    }
+
+}
+
+/*!
+ * \brief PS_PointCloudLoader::parseChunk
+ * Parses the first 3 numbers of each line of the chunk as the coordinates of a point
+ * \param chunk
+ */
+void PS_PointCloudLoader::parseChunk(PS_LoaderChunk &chunk){
+
+    for(int k = 0; k < 3; k++){
+        chunk.min[k] = numeric_limits<float>::max();
+        chunk.max[k] = -numeric_limits<float>::max();
+    }
+
+    //estimate the number of points from a typical line length
+    size_t estimate = (chunk.end - chunk.begin) / 24;
+    chunk.x.reserve(estimate);
+    chunk.y.reserve(estimate);
+    chunk.z.reserve(estimate);
+
+    const char *c = chunk.begin;
+    while(c < chunk.end){
+
+        const char *lineEnd = (const char *)memchr(c, '\n', chunk.end - c);
+        if(lineEnd == NULL){
+            lineEnd = chunk.end;
+        }
+
+        //parse the first 3 values of the line
+        float xyz[3];
+        int numValues = 0;
+        while(numValues < 3){
+            while(c < lineEnd && isSeparator(*c)){
+                c++;
+            }
+            if(c >= lineEnd || !PS_PointCloudLoader::parseFloat(c, lineEnd, xyz[numValues])){
+                break;
+            }
+            numValues++;
+        }
+
+        //skip lines that do not start with 3 numbers (e.g. the PTS header containing the number of points)
+        if(numValues == 3){
+            chunk.x.push_back(xyz[0]);
+            chunk.y.push_back(xyz[1]);
+            chunk.z.push_back(xyz[2]);
+            for(int k = 0; k < 3; k++){
+                chunk.min[k] = qMin(chunk.min[k], xyz[k]);
+                chunk.max[k] = qMax(chunk.max[k], xyz[k]);
+            }
+        }
+
+        c = lineEnd + 1;
+
+    }
+
+}
+
+/*!
+ * \brief PS_PointCloudLoader::parseFloat
+ * Locale independent parser for decimal numbers (e.g. -12.345e-2). On success c points behind the number.
+ * \param c
+ * \param end
+ * \param value
+ * \return false if there is no number at c or the number is not followed by a separator
+ */
+bool PS_PointCloudLoader::parseFloat(const char *&c, const char *end, float &value){
+
+    bool negative = false;
+    if(c < end && (*c == '-' || *c == '+')){
+        negative = (*c == '-');
+        c++;
+    }
+
+    quint64 mantissa = 0; //first 19 significant digits
+    int numDigits = 0; //number of significant digits in mantissa
+    int exponent = 0;
+    bool hasDigits = false;
+
+    //integer part
+    while(c < end && *c >= '0' && *c <= '9'){
+        if(numDigits < 19){
+            mantissa = mantissa * 10 + (*c - '0');
+            if(mantissa != 0){
+                numDigits++;
+            }
+        }else{
+            exponent++;
+        }
+        hasDigits = true;
+        c++;
+    }
+
+    //fractional part
+    if(c < end && *c == '.'){
+        c++;
+        while(c < end && *c >= '0' && *c <= '9'){
+            if(numDigits < 19){
+                mantissa = mantissa * 10 + (*c - '0');
+                if(mantissa != 0){
+                    numDigits++;
+                }
+                exponent--;
+            }
+            hasDigits = true;
+            c++;
+        }
+    }
+
+    if(!hasDigits){
+        return false;
+    }
+
+    //exponent
+    if(c < end && (*c == 'e' || *c == 'E')){
+        c++;
+        bool negativeExponent = false;
+        if(c < end && (*c == '-' || *c == '+')){
+            negativeExponent = (*c == '-');
+            c++;
+        }
+        int e = 0;
+        bool hasExponentDigits = false;
+        while(c < end && *c >= '0' && *c <= '9'){
+            if(e < 10000){
+                e = e * 10 + (*c - '0');
+            }
+            hasExponentDigits = true;
+            c++;
+        }
+        if(!hasExponentDigits){
+            return false;
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    //the number has to be followed by a separator or the end of the line
+    if(c < end && !isSeparator(*c)){
+        return false;
+    }
+
+    double result = (double)mantissa;
+    if(mantissa != 0){
+        if(exponent < 0){
+            result = (exponent >= -22) ? result / PS_POW10[-exponent] : result * std::pow(10.0, exponent);
+        }else if(exponent > 0){
+            result = (exponent <= 22) ? result * PS_POW10[exponent] : result * std::pow(10.0, exponent);
+        }
+    }
+
+    value = (float)(negative ? -result : result);
+    return true;
+
+}
+
+PS_PointCloudReader::PS_PointCloudReader(const QString &fileName, const qint64 &windowSize, const int &numThreads)
+    : file(fileName), size(0), position(0), windowSize(windowSize), numThreads(numThreads)
+{
+}
+
+/*!
+ * \brief PS_PointCloudReader::open
+ * Opens the file and starts reading at its beginning
+ * \return
+ */
+bool PS_PointCloudReader::open(){
+    if(!this->file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+    this->size = this->file.size();
+    this->position = 0;
+    return true;
+}
+
+/*!
+ * \brief PS_PointCloudReader::rewind
+ * Starts reading at the beginning of the file again
+ */
+void PS_PointCloudReader::rewind(){
+    this->position = 0;
+}
+
+/*!
+ * \brief PS_PointCloudReader::readNext
+ * Maps the next window of the file, parses all complete lines in it and unmaps it again
+ * \param chunks receives the parsed points of the window
+ * \return false if the end of the file was reached or the window cannot be mapped
+ */
+bool PS_PointCloudReader::readNext(vector<PS_LoaderChunk> &chunks){
+
+    if(this->position >= this->size){
+        return false;
+    }
+
+    qint64 length = qMin(this->windowSize, this->size - this->position);
+    const char *data = (const char *)this->file.map(this->position, length);
+    if(data == NULL){
+        return false;
+    }
+
+    //only parse complete lines (a line that is longer than the window is parsed as it is)
+    const char *end = data + length;
+    if(this->position + length < this->size){
+        const char *lineEnd = end;
+        while(lineEnd > data && *(lineEnd - 1) != '\n'){
+            lineEnd--;
+        }
+        if(lineEnd > data){
+            end = lineEnd;
+        }
+    }
+
+    PS_PointCloudLoader::parseBuffer(data, end, chunks, this->numThreads);
+
+    //the parsed coordinates are copies, so the window is not needed any longer
+    for(unsigned int i = 0; i < chunks.size(); i++){
+        chunks[i].begin = NULL;
+        chunks[i].end = NULL;
+    }
+    this->position += end - data;
+    this->file.unmap((uchar *)data);
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_PointCloudReader::close
+ */
+void PS_PointCloudReader::close(){
+    this->file.close();
+}
@@ -0,0 +1,95 @@
+#ifndef PS_POINTCLOUDLOADER_H
+#define PS_POINTCLOUDLOADER_H
+
+#include <QString>
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <vector>
+
+#include "ps_pointstore.h"
+
+struct PS_BoundingBox_PC;
+
+using namespace std;
+
+//! a line aligned part of a point cloud file and the points parsed from it
+struct PS_LoaderChunk{
+    const char *begin;
+    const char *end;
+
+    vector<float> x, y, z; //parsed coordinates
+    float min[3]; //bounding box of the parsed points
+    float max[3];
+};
+
+/*!
+ * \brief The PS_PointCloudLoader class
+ * Loads ASCII point clouds (PTS, XYZ) into a point store. The file is memory mapped and split into line aligned chunks
+ * that are parsed concurrently with a locale independent number parser. Lines with less than 3 numbers (e.g. the PTS header)
+ * are skipped, additional columns (intensity, RGB) are ignored and both LF and CRLF line endings are supported.
+ */
+class PS_PointCloudLoader
+{
+private:
+    PS_PointCloudLoader();
+
+public:
+    static bool load(const QString &fileName, PS_PointStore *store, PS_BoundingBox_PC &bbox, int numThreads = 0);
+
+    static void parseBuffer(const char *begin, const char *end, vector<PS_LoaderChunk> &chunks, int numThreads = 0);
+    static void parseChunk(PS_LoaderChunk &chunk);
+    static bool parseFloat(const char *&c, const char *end, float &value);
+
+};
+
+/*!
+ * \brief The PS_PointCloudReader class
+ * Reads an ASCII point cloud window by window, so that files that do not fit into memory can be processed.
+ * Only one window of the file is mapped at once and each call of readNext returns the points of the next window.
+ */
+class PS_PointCloudReader
+{
+public:
+    PS_PointCloudReader(const QString &fileName, const qint64 &windowSize = 64 << 20, const int &numThreads = 0);
+
+    bool open();
+    void rewind();
+    bool readNext(vector<PS_LoaderChunk> &chunks);
+    void close();
+
+    //! \brief Returns the number of bytes of the file that were read
+    inline qint64 getPosition() const{
+        return this->position;
+    }
+
+    //! \brief Returns the size of the file in bytes
+    inline qint64 getSize() const{
+        return this->size;
+    }
+
+private:
+    QFile file;
+    qint64 size;
+    qint64 position; //offset of the next window
+    qint64 windowSize; //number of bytes that are mapped at once
+    int numThreads; //number of threads used to parse a window
+
+};
+
+//! parses one chunk of a point cloud file in a worker thread
+class PS_LoaderTask : public QRunnable
+{
+public:
+    PS_LoaderTask(PS_LoaderChunk *chunk) : chunk(chunk){}
+
+    void run(){
+        PS_PointCloudLoader::parseChunk(*this->chunk);
+    }
+
+private:
+    PS_LoaderChunk *chunk;
+};
+
+#endif // PS_POINTCLOUDLOADER_H
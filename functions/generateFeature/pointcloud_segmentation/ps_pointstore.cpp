@@ -0,0 +1,210 @@
+#include "ps_pointstore.h"
+
+const quint32 PS_PointStore::noLeaf;
+
+PS_PointStore::PS_PointStore() : px(NULL), py(NULL), pz(NULL), numPoints(0), view(false)
+{
+}
+
+/*!
+ * \brief PS_PointStore::setView
+ * Replaces all points by a non-owning view over the given coordinate arrays, so that the coordinates are not copied.
+ * The arrays have to stay valid as long as the store uses them, owner (if given) is held until then.
+ * All points are set to not be used.
+ * \param x
+ * \param y
+ * \param z
+ * \param numPoints
+ * \param owner object that owns the arrays (e.g. the mapped file)
+ */
+void PS_PointStore::setView(const float *x, const float *y, const float *z, const quint32 &numPoints, const QSharedPointer<QObject> &owner){
+
+    this->clear();
+
+    this->px = x;
+    this->py = y;
+    this->pz = z;
+    this->numPoints = numPoints;
+    this->view = true;
+    this->viewOwner = owner;
+
+    this->used.assign((numPoints + 63) / 64, 0);
+
+}
+
+/*!
+ * \brief PS_PointStore::reserve
+ * Reserve memory for numPoints points
+ * \param numPoints
+ */
+void PS_PointStore::reserve(const quint32 &numPoints){
+    if(this->view){
+        return;
+    }
+    this->x.reserve(numPoints);
+    this->y.reserve(numPoints);
+    this->z.reserve(numPoints);
+    this->used.reserve((numPoints + 63) / 64);
+}
+
+/*!
+ * \brief PS_PointStore::clear
+ * Removes all points from the store
+ */
+void PS_PointStore::clear(){
+    this->x.clear();
+    this->y.clear();
+    this->z.clear();
+    this->used.clear();
+    this->clearLeafs();
+    this->view = false;
+    this->viewOwner.clear();
+    this->updatePointers();
+}
+
+/*!
+ * \brief PS_PointStore::append
+ * Adds a new unused point to the store and returns its index
+ * \param x
+ * \param y
+ * \param z
+ * \return
+ */
+quint32 PS_PointStore::append(const float &x, const float &y, const float &z){
+
+    this->detachView();
+
+    quint32 index = this->size();
+
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->z.push_back(z);
+    this->updatePointers();
+
+    if((index & 63) == 0){
+        this->used.push_back(0);
+    }
+    if(!this->pointLeafs.empty()){
+        this->pointLeafs.push_back(PS_PointStore::noLeaf);
+    }
+
+    return index;
+
+}
+
+/*!
+ * \brief PS_PointStore::append
+ * Adds count new unused points to the store
+ * \param x
+ * \param y
+ * \param z
+ * \param count
+ */
+void PS_PointStore::append(const float *x, const float *y, const float *z, const quint32 &count){
+
+    this->detachView();
+
+    this->x.insert(this->x.end(), x, x + count);
+    this->y.insert(this->y.end(), y, y + count);
+    this->z.insert(this->z.end(), z, z + count);
+    this->updatePointers();
+
+    this->used.resize((this->x.size() + 63) / 64, 0);
+    if(!this->pointLeafs.empty()){
+        this->pointLeafs.resize(this->x.size(), PS_PointStore::noLeaf);
+    }
+
+}
+
+/*!
+ * \brief PS_PointStore::resetUsed
+ * Sets all points to not be used
+ */
+void PS_PointStore::resetUsed(){
+    for(unsigned int i = 0; i < this->used.size(); i++){
+        this->used[i] = 0;
+    }
+    this->unusedCounts.assign(this->unusedCounts.size(), 0);
+    for(quint32 i = 0; i < this->pointLeafs.size(); i++){
+        if(this->pointLeafs[i] != PS_PointStore::noLeaf){
+            this->unusedCounts[this->pointLeafs[i]]++;
+        }
+    }
+}
+
+/*!
+ * \brief PS_PointStore::getUsedCount
+ * Returns the number of points that are used for a shape
+ * \return
+ */
+quint32 PS_PointStore::getUsedCount() const{
+    quint32 result = 0;
+    for(unsigned int i = 0; i < this->used.size(); i++){
+        quint64 word = this->used[i];
+        while(word != 0){
+            word &= word - 1;
+            result++;
+        }
+    }
+    return result;
+}
+
+/*!
+ * \brief PS_PointStore::setLeafs
+ * Registers the leafs of an octree, so that the number of unused points of each leaf is kept up to date.
+ * The leaf indices are taken over from pointLeafs (one entry per point, noLeaf for points that are in no leaf).
+ * \param pointLeafs
+ * \param numLeafs
+ */
+void PS_PointStore::setLeafs(vector<quint32> &pointLeafs, const quint32 &numLeafs){
+
+    this->pointLeafs.swap(pointLeafs);
+    this->pointLeafs.resize(this->numPoints, PS_PointStore::noLeaf);
+    this->unusedCounts.assign(numLeafs, 0);
+
+    for(quint32 i = 0; i < this->numPoints; i++){
+        if(this->pointLeafs[i] != PS_PointStore::noLeaf && !this->isUsed(i)){
+            this->unusedCounts[this->pointLeafs[i]]++;
+        }
+    }
+
+}
+
+/*!
+ * \brief PS_PointStore::clearLeafs
+ * Stops counting the unused points of the leafs (e.g. because the octree is deleted)
+ */
+void PS_PointStore::clearLeafs(){
+    vector<quint32>().swap(this->pointLeafs);
+    this->unusedCounts.clear();
+}
+
+/*!
+ * \brief PS_PointStore::detachView
+ * Copies the viewed coordinates into the store before points are appended
+ */
+void PS_PointStore::detachView(){
+
+    if(!this->view){
+        return;
+    }
+
+    this->x.assign(this->px, this->px + this->numPoints);
+    this->y.assign(this->py, this->py + this->numPoints);
+    this->z.assign(this->pz, this->pz + this->numPoints);
+    this->view = false;
+    this->viewOwner.clear();
+    this->updatePointers();
+
+}
+
+/*!
+ * \brief PS_PointStore::updatePointers
+ * Lets the accessed coordinates point to the owned arrays again (after they were reallocated)
+ */
+void PS_PointStore::updatePointers(){
+    this->px = this->x.data();
+    this->py = this->y.data();
+    this->pz = this->z.data();
+    this->numPoints = (quint32)this->x.size();
+}
@@ -0,0 +1,134 @@
+#ifndef PS_POINTSTORE_H
+#define PS_POINTSTORE_H
+
+#include <QtGlobal>
+#include <QObject>
+#include <QSharedPointer>
+#include <vector>
+
+using namespace std;
+
+/*!
+ * \brief The PS_PointStore class
+ * Contiguous storage of all points of a point cloud. The coordinates are held in separate x, y and z arrays
+ * and the used state of each point is held in a packed bitset. Nodes and shapes only reference points by their
+ * 32 bit index within this store.
+ * If the leafs of an octree are registered (see setLeafs) the store also keeps the number of unused points of each leaf
+ * up to date whenever the used state of a point changes, so that the unused points of a leaf can be counted in O(1).
+ * Instead of holding its own copy of the coordinates the store may also be a non-owning view over x, y and z arrays
+ * that live elsewhere, e.g. in a memory mapped cache file (see setView). Only the used bitset is allocated then.
+ */
+class PS_PointStore
+{
+public:
+    PS_PointStore();
+
+    void setView(const float *x, const float *y, const float *z, const quint32 &numPoints,
+                 const QSharedPointer<QObject> &owner = QSharedPointer<QObject>());
+
+    //! \brief Returns true if the coordinates are not owned by the store (see setView)
+    inline bool isView() const{
+        return this->view;
+    }
+
+    void reserve(const quint32 &numPoints);
+    void clear();
+
+    quint32 append(const float &x, const float &y, const float &z);
+    void append(const float *x, const float *y, const float *z, const quint32 &count);
+
+    //! \brief Returns the number of points in the store
+    inline quint32 size() const{
+        return this->numPoints;
+    }
+
+    //! \brief Returns the x coordinate of the point at index
+    inline float getX(const quint32 &index) const{
+        return this->px[index];
+    }
+
+    //! \brief Returns the y coordinate of the point at index
+    inline float getY(const quint32 &index) const{
+        return this->py[index];
+    }
+
+    //! \brief Returns the z coordinate of the point at index
+    inline float getZ(const quint32 &index) const{
+        return this->pz[index];
+    }
+
+    //! \brief Returns the contiguous array of x coordinates
+    inline const float *getXArray() const{
+        return this->px;
+    }
+
+    //! \brief Returns the contiguous array of y coordinates
+    inline const float *getYArray() const{
+        return this->py;
+    }
+
+    //! \brief Returns the contiguous array of z coordinates
+    inline const float *getZArray() const{
+        return this->pz;
+    }
+
+    //! \brief Returns true if the point at index is used for a finally detected shape
+    inline bool isUsed(const quint32 &index) const{
+        return (this->used[index >> 6] >> (index & 63)) & 1;
+    }
+
+    //! \brief Sets the used state of the point at index
+    inline void setUsed(const quint32 &index, const bool &state){
+        quint64 &word = this->used[index >> 6];
+        const quint64 bit = Q_UINT64_C(1) << (index & 63);
+        if(((word & bit) != 0) == state){
+            return;
+        }
+        if(state){
+            word |= bit;
+        }else{
+            word &= ~bit;
+        }
+        if(!this->pointLeafs.empty() && this->pointLeafs[index] != PS_PointStore::noLeaf){
+            if(state){
+                this->unusedCounts[this->pointLeafs[index]]--;
+            }else{
+                this->unusedCounts[this->pointLeafs[index]]++;
+            }
+        }
+    }
+
+    void resetUsed();
+    quint32 getUsedCount() const;
+
+    void setLeafs(vector<quint32> &pointLeafs, const quint32 &numLeafs);
+    void clearLeafs();
+
+    //! \brief Returns true if the unused points of the leafs are counted (see setLeafs)
+    inline bool hasLeafs() const{
+        return !this->pointLeafs.empty();
+    }
+
+    //! \brief Returns the number of unused points of the leaf with the given index
+    inline quint32 getUnusedCount(const quint32 &leaf) const{
+        return this->unusedCounts[leaf];
+    }
+
+    static const quint32 noLeaf = 0xFFFFFFFF; //leaf index of points that are not registered
+
+private:
+    void detachView();
+    void updatePointers();
+
+    vector<float> x, y, z; //coordinates of all points (empty if the store is a view)
+    const float *px, *py, *pz; //coordinates that are accessed (either the data of x, y and z or the viewed arrays)
+    quint32 numPoints;
+    bool view; //true if px, py and pz point to arrays that are not owned by the store
+    QSharedPointer<QObject> viewOwner; //keeps the viewed arrays alive (optional)
+    vector<quint64> used; //one bit per point that is set as soon as the point is used for a shape
+    vector<quint32> pointLeafs; //leaf of each point (empty if no leafs are registered)
+    vector<quint32> unusedCounts; //number of unused points of each registered leaf
+
+};
+
+#endif // PS_POINTSTORE_H
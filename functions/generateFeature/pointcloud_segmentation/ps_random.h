@@ -0,0 +1,76 @@
+#ifndef PS_RANDOM_H
+#define PS_RANDOM_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief The PS_Random class
+ * Fast seedable pseudo random number generator (xoshiro256**).
+ * Each seed leaf and each shape uses its own generator so that the segmentation
+ * results only depend on the random seed and not on the number of threads.
+ */
+class PS_Random
+{
+
+public:
+    PS_Random(quint64 seed = 0){
+        this->setSeed(seed);
+    }
+
+    //! \brief Reinitializes the state of the generator from the given seed
+    inline void setSeed(quint64 seed){
+        for(int i = 0; i < 4; i++){
+            this->state[i] = PS_Random::splitMix(seed);
+        }
+    }
+
+    //! \brief Returns the next 64 bit random number
+    inline quint64 next(){
+        const quint64 result = PS_Random::rotl(this->state[1] * 5, 7) * 9;
+        const quint64 t = this->state[1] << 17;
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+        this->state[2] ^= t;
+        this->state[3] = PS_Random::rotl(this->state[3], 45);
+        return result;
+    }
+
+    //! \brief Returns a uniformly distributed random number in the range [0, maxValue]
+    inline quint64 nextInRange(quint64 maxValue){
+        if(maxValue == Q_UINT64_C(0xFFFFFFFFFFFFFFFF)){
+            return this->next();
+        }
+        const quint64 bound = maxValue + 1;
+        const quint64 threshold = (0 - bound) % bound; //reject the lowest values to avoid a modulo bias
+        quint64 r = this->next();
+        while(r < threshold){
+            r = this->next();
+        }
+        return r % bound;
+    }
+
+    //! \brief Derives the seed of an independent stream (e.g. of a seed leaf) from a base seed
+    static inline quint64 deriveSeed(quint64 seed, quint64 stream){
+        quint64 x = seed ^ (stream * Q_UINT64_C(0xD1B54A32D192ED03));
+        return PS_Random::splitMix(x);
+    }
+
+private:
+    quint64 state[4];
+
+    static inline quint64 rotl(const quint64 x, int k){
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static inline quint64 splitMix(quint64 &x){
+        quint64 z = (x += Q_UINT64_C(0x9E3779B97F4A7C15));
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+        return z ^ (z >> 31);
+    }
+
+};
+
+#endif // PS_RANDOM_H
@@ -0,0 +1,249 @@
+#include "ps_ransac.h"
+
+#include <cmath>
+
+#include "ps_shapesegment.h"
+#include "ps_instrumentation.h"
+
+const unsigned int PS_Ransac::scoreBlockSize;
+const unsigned int PS_Ransac::maxTrials;
+const double PS_Ransac::confidence = 0.99;
+const double PS_Ransac::sprtDecisionThreshold = 6.9; //ln(1000): a good hypothesis is rejected with a probability of about 0.1%
+
+/*!
+ * \brief PS_Ransac::PS_Ransac
+ * \param points points in which a shape shall be detected
+ * \param param
+ * \param generator generator used to draw the minimal samples
+ */
+PS_Ransac::PS_Ransac(const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator)
+    : param(param), generator(generator), order(points), bestInliers(0), numTrials(0), numRejected(0), numScoredPoints(0), requiredTrials(0),
+      epsilon(0.0), delta(0.0), badInliers(0.0), badScored(0.0){
+
+    //shuffle the points once, so that every block of points that is scored is a random subset
+    for(unsigned int i = this->order.size(); i > 1; i--){
+        quint32 j = (quint32)this->generator.nextInRange(i - 1);
+        quint32 tmp = this->order[i - 1];
+        this->order[i - 1] = this->order[j];
+        this->order[j] = tmp;
+    }
+
+    this->sample.reserve(16);
+
+}
+
+/*!
+ * \brief PS_Ransac::run
+ * Searches the hypothesis with the most inliers. The parameters of the best hypothesis are copied to best.
+ * \param hypothesis shape that is reused to evaluate each minimal sample
+ * \param best shape that receives the state of the best hypothesis
+ * \param sampleSize number of points in a minimal sample
+ * \param threshold maximum distance of an inlier
+ * \param minInliers minimum number of inliers of a valid hypothesis
+ * \param exitMargin the search is stopped as soon as a hypothesis contains all but exitMargin points
+ * \return true if a valid hypothesis was found
+ */
+bool PS_Ransac::run(PS_ShapeSegment *hypothesis, PS_ShapeSegment *best, const unsigned int &sampleSize, const float &threshold,
+                    const unsigned int &minInliers, const unsigned int &exitMargin){
+
+    this->bestInliers = 0;
+    this->numTrials = 0;
+    this->numRejected = 0;
+    this->numScoredPoints = 0;
+    this->epsilon = 0.0;
+    this->delta = 0.01;
+    this->badInliers = 0.0;
+    this->badScored = 0.0;
+
+    const unsigned int numPoints = this->order.size();
+    if(sampleSize == 0 || numPoints < sampleSize){
+        return false;
+    }
+
+    //initial number of trials from the estimated percentage of outliers
+    this->requiredTrials = PS_Ransac::getRequiredTrials(1.0 - this->param.outlierPercentage, sampleSize);
+
+    //it makes no sense to draw more samples than there are different minimal samples
+    unsigned long long numSubsets = PS_GeneralMath::computeBinomialCoefficient(numPoints, sampleSize);
+    if(numSubsets > 0 && numSubsets < this->requiredTrials){
+        this->requiredTrials = (unsigned int)numSubsets;
+    }
+
+    bool found = false;
+    while(this->numTrials < this->requiredTrials){
+
+        this->numTrials++;
+
+        //compute a hypothesis from a random minimal sample
+        this->drawSample(sampleSize);
+        hypothesis->minimumSolution(this->sample);
+        if(!hypothesis->isPlausible(this->param)){
+            this->numRejected++;
+            continue;
+        }
+        hypothesis->prepareInlierCheck();
+
+        //score the hypothesis (returns false if it was rejected early)
+        unsigned int numInliers = 0;
+        if(!this->scoreHypothesis(hypothesis, threshold, minInliers, numInliers)){
+            continue;
+        }
+
+        //keep the hypothesis if it is better than the best one found before
+        if(numInliers >= minInliers && numInliers > this->bestInliers){
+
+            best->copyState(*hypothesis);
+            this->bestInliers = numInliers;
+            found = true;
+
+            //adapt the number of trials to the inlier ratio of the best hypothesis
+            this->epsilon = (double)numInliers / (double)numPoints;
+            this->requiredTrials = qMin(this->requiredTrials, PS_Ransac::getRequiredTrials(this->epsilon, sampleSize));
+
+            //if the hypothesis contains mostly all points no better one can be found
+            if(this->bestInliers + exitMargin >= numPoints){
+                break;
+            }
+
+        }else{
+            this->rejectHypothesis(numInliers, numPoints);
+        }
+
+    }
+
+    PS_COUNT(eHypothesesTested, this->numTrials);
+    PS_COUNT(eHypothesesRejected, this->numRejected);
+    PS_COUNT(ePointsScored, this->numScoredPoints);
+
+    return found;
+
+}
+
+/*!
+ * \brief PS_Ransac::drawSample
+ * Draws sampleSize different random points
+ * \param sampleSize
+ */
+void PS_Ransac::drawSample(const unsigned int &sampleSize){
+
+    const quint64 maxIndex = this->order.size() - 1;
+
+    this->sample.resize(sampleSize);
+    for(unsigned int i = 0; i < sampleSize; i++){
+
+        bool isDuplicate = true;
+        while(isDuplicate){
+            this->sample[i] = this->order[this->generator.nextInRange(maxIndex)];
+            isDuplicate = false;
+            for(unsigned int j = 0; j < i; j++){
+                if(this->sample[j] == this->sample[i]){
+                    isDuplicate = true;
+                    break;
+                }
+            }
+        }
+
+    }
+
+}
+
+/*!
+ * \brief PS_Ransac::scoreHypothesis
+ * Counts the inliers of a hypothesis block by block. After each block the hypothesis is rejected if it cannot
+ * become better than the best one anymore or if the SPRT decides that it is a bad hypothesis.
+ * \param hypothesis
+ * \param threshold
+ * \param minInliers
+ * \param numInliers
+ * \return false if the hypothesis was rejected
+ */
+bool PS_Ransac::scoreHypothesis(const PS_ShapeSegment *hypothesis, const float &threshold, const unsigned int &minInliers, unsigned int &numInliers){
+
+    const unsigned int numPoints = this->order.size();
+
+    //a hypothesis has to reach this number of inliers to be kept
+    const unsigned int requiredInliers = qMax(this->bestInliers + 1, minInliers);
+
+    //the SPRT is only used once a good hypothesis is known
+    const bool useSprt = this->epsilon > this->delta;
+    double logInlier = 0.0, logOutlier = 0.0, logLambda = 0.0;
+    if(useSprt){
+        logInlier = std::log(this->delta / this->epsilon);
+        logOutlier = std::log((1.0 - this->delta) / (1.0 - this->epsilon));
+    }
+
+    numInliers = 0;
+    unsigned int numScored = 0;
+    while(numScored < numPoints){
+
+        const unsigned int n = qMin(PS_Ransac::scoreBlockSize, numPoints - numScored);
+        const unsigned int blockInliers = hypothesis->checkInliers(this->order.data() + numScored, n, threshold, this->mask);
+        numInliers += blockInliers;
+        numScored += n;
+        this->numScoredPoints += n;
+
+        //the hypothesis cannot reach the required number of inliers anymore
+        if(numInliers + (numPoints - numScored) < requiredInliers){
+            this->rejectHypothesis(numInliers, numScored);
+            return false;
+        }
+
+        //likelihood ratio of the hypothesis being bad vs. being good
+        if(useSprt && numScored < numPoints){
+            logLambda += blockInliers * logInlier + (n - blockInliers) * logOutlier;
+            if(logLambda > PS_Ransac::sprtDecisionThreshold){
+                this->rejectHypothesis(numInliers, numScored);
+                return false;
+            }
+        }
+
+    }
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_Ransac::rejectHypothesis
+ * Update the estimated inlier ratio of bad hypotheses
+ * \param numInliers
+ * \param numScored
+ */
+void PS_Ransac::rejectHypothesis(const unsigned int &numInliers, const unsigned int &numScored){
+
+    this->numRejected++;
+
+    this->badInliers += numInliers;
+    this->badScored += numScored;
+
+    if(this->badScored > 0.0){
+        this->delta = qBound(0.001, this->badInliers / this->badScored, 0.999);
+    }
+
+}
+
+/*!
+ * \brief PS_Ransac::getRequiredTrials
+ * Number of trials that are necessary to draw at least one outlier free sample with the required confidence
+ * \param inlierRatio
+ * \param sampleSize
+ * \return
+ */
+unsigned int PS_Ransac::getRequiredTrials(const double &inlierRatio, const unsigned int &sampleSize){
+
+    const double phk = std::pow(inlierRatio, (double)sampleSize);
+
+    if(phk >= 1.0){
+        return 1;
+    }else if(phk <= 0.0){
+        return PS_Ransac::maxTrials;
+    }
+
+    const double trials = std::ceil(std::log(1.0 - PS_Ransac::confidence) / std::log(1.0 - phk));
+    if(trials >= (double)PS_Ransac::maxTrials){
+        return PS_Ransac::maxTrials;
+    }
+
+    return qMax((unsigned int)trials, 1u);
+
+}
@@ -0,0 +1,82 @@
+#ifndef PS_RANSAC_H
+#define PS_RANSAC_H
+
+#include <vector>
+#include <QtGlobal>
+
+#include "ps_distancekernels.h"
+#include "ps_random.h"
+
+class PS_ShapeSegment;
+struct PS_InputParameter;
+
+using namespace std;
+
+/*!
+ * \brief The PS_Ransac class
+ * RANSAC engine that is shared by the plane, sphere and cylinder detection.
+ * Minimal samples are drawn lazily, the number of trials is adapted to the best inlier ratio found so far
+ * and each hypothesis is scored block by block with a sequential probability ratio test (SPRT),
+ * so that bad hypotheses are rejected after only a small subset of the points was checked.
+ * One hypothesis shape is reused for all trials, so no memory is allocated per hypothesis.
+ */
+class PS_Ransac
+{
+public:
+    PS_Ransac(const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator);
+
+    bool run(PS_ShapeSegment *hypothesis, PS_ShapeSegment *best, const unsigned int &sampleSize, const float &threshold,
+             const unsigned int &minInliers, const unsigned int &exitMargin);
+
+    //! \brief Returns the number of inliers of the best hypothesis
+    inline unsigned int getBestInlierCount() const{
+        return this->bestInliers;
+    }
+
+    //! \brief Returns the number of hypotheses that were evaluated in the last run
+    inline unsigned int getNumTrials() const{
+        return this->numTrials;
+    }
+
+    //! \brief Returns the number of hypotheses that were rejected in the last run
+    inline unsigned int getNumRejected() const{
+        return this->numRejected;
+    }
+
+    //! \brief Returns the number of point distances that were checked in the last run
+    inline quint64 getNumScoredPoints() const{
+        return this->numScoredPoints;
+    }
+
+private:
+    void drawSample(const unsigned int &sampleSize);
+    bool scoreHypothesis(const PS_ShapeSegment *hypothesis, const float &threshold, const unsigned int &minInliers, unsigned int &numInliers);
+    void rejectHypothesis(const unsigned int &numInliers, const unsigned int &numScored);
+
+    static unsigned int getRequiredTrials(const double &inlierRatio, const unsigned int &sampleSize);
+
+    static const unsigned int scoreBlockSize = 64; //number of points that are scored before the SPRT decision is updated
+    static const double confidence; //required probability of drawing at least one outlier free sample
+    static const double sprtDecisionThreshold; //logarithm of Wald's decision threshold A
+    static const unsigned int maxTrials = 1000000; //upper bound of the number of trials
+
+    const PS_InputParameter &param;
+    PS_Random &generator;
+
+    vector<quint32> order; //points in random order, so that each block is a random subset
+    vector<quint32> sample; //current minimal sample
+    unsigned char mask[scoreBlockSize]; //inlier mask of the current block
+
+    unsigned int bestInliers;
+    unsigned int numTrials;
+    unsigned int numRejected;
+    quint64 numScoredPoints;
+    unsigned int requiredTrials;
+
+    double epsilon; //inlier ratio of a good hypothesis (best one so far)
+    double delta; //inlier ratio of a bad hypothesis (estimated from rejected ones)
+    double badInliers, badScored; //statistics of rejected hypotheses to estimate delta
+
+};
+
+#endif // PS_RANSAC_H
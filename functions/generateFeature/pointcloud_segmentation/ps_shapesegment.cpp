@@ -1,11 +1,13 @@
 #include "ps_shapesegment.h"
 
-PS_ShapeSegment::PS_ShapeSegment()
+PS_ShapeSegment::PS_ShapeSegment(PS_PointStore *store) : myStore(store), myState(NULL), myOldState(NULL)
 {
 }
 
 PS_ShapeSegment::~PS_ShapeSegment()
 {
+    delete this->myState;
+    delete this->myOldState;
 }
 
 /*!
@@ -20,10 +22,11 @@ bool PS_ShapeSegment::writeToObj(const QString &filePath){
     if ( file.open(QIODevice::ReadWrite | QIODevice::Truncate) ){
 
         QTextStream streama( &file );
-        for(int i = 0; i < this->getPoints().size(); i++){
-            streama << "v " << QString::number(this->getPoints().at(i)->xyz[0])
-                    << " " << QString::number(this->getPoints().at(i)->xyz[1])
-                    << " " << QString::number(this->getPoints().at(i)->xyz[2]) << endl;
+        for(unsigned int i = 0; i < this->myPoints.size(); i++){
+            quint32 p = this->myPoints[i];
+            streama << "v " << QString::number(this->myStore->getX(p))
+                    << " " << QString::number(this->myStore->getY(p))
+                    << " " << QString::number(this->myStore->getZ(p)) << endl;
         }
 
         qDebug() << "writing finished";
@@ -59,10 +62,11 @@ bool PS_ShapeSegment::writeToPts(const QString &filePath){
     if ( file.open(QIODevice::ReadWrite | QIODevice::Truncate) ){
 
         QTextStream streama( &file );
-        for(int i = 0; i < this->getPoints().size(); i++){
-            streama << QString::number(this->getPoints().at(i)->xyz[0])
-                    << " " << QString::number(this->getPoints().at(i)->xyz[1])
-                    << " " << QString::number(this->getPoints().at(i)->xyz[2])
+        for(unsigned int i = 0; i < this->myPoints.size(); i++){
+            quint32 p = this->myPoints[i];
+            streama << QString::number(this->myStore->getX(p))
+                    << " " << QString::number(this->myStore->getY(p))
+                    << " " << QString::number(this->myStore->getZ(p))
                     << " " << r << " " << g << " " << b << endl;
         }
         return true;
@@ -78,8 +82,9 @@ bool PS_ShapeSegment::writeToPts(const QString &filePath){
  * Adds a point to the shape
  * \param p
  */
-void PS_ShapeSegment::addPoint(PS_Point_PC *p){
-    this->myState->myPoints.append(p);
+void PS_ShapeSegment::addPoint(const quint32 &p){
+    this->myPoints.push_back(p);
+    this->myMoments.add(this->myStore->getX(p), this->myStore->getY(p), this->myStore->getZ(p));
 }
 
 /*!
@@ -88,7 +93,9 @@ void PS_ShapeSegment::addPoint(PS_Point_PC *p){
  * \param index
  */
 void PS_ShapeSegment::removePoint(const int &index){
-    this->myState->myPoints.removeAt(index);
+    quint32 p = this->myPoints[index];
+    this->myMoments.remove(this->myStore->getX(p), this->myStore->getY(p), this->myStore->getZ(p));
+    this->myPoints.erase(this->myPoints.begin() + index);
 }
 
 /*!
@@ -96,13 +103,17 @@ void PS_ShapeSegment::removePoint(const int &index){
  * Remove all points which are already used by another shape
  */
 void PS_ShapeSegment::removeUsedPoints(){
-    QList<PS_Point_PC *> unusedPoints;
-    foreach(PS_Point_PC *p, this->myState->myPoints){
-        if(!p->isUsed){
-            unusedPoints.append(p);
+    unsigned int numUnused = 0;
+    for(unsigned int i = 0; i < this->myPoints.size(); i++){
+        quint32 p = this->myPoints[i];
+        if(!this->myStore->isUsed(p)){
+            this->myPoints[numUnused] = p;
+            numUnused++;
+        }else{
+            this->myMoments.remove(this->myStore->getX(p), this->myStore->getY(p), this->myStore->getZ(p));
         }
     }
-    this->myState->myPoints = unusedPoints;
+    this->myPoints.resize(numUnused);
 }
 
 /*!
@@ -110,16 +121,43 @@ void PS_ShapeSegment::removeUsedPoints(){
  * Removes all points from the shape
  */
 void PS_ShapeSegment::removeAllPoints(){
-    this->myState->myPoints.clear();
+    this->myPoints.clear();
+    this->myMoments.clear();
+}
+
+/*!
+ * \brief PS_ShapeSegment::setPointStore
+ * Moves the shape to another point store (e.g. from the reduced to the full cloud, see PS_Downsampling).
+ * The shape parameters are kept, but all points are removed, because their indices refer to the old store.
+ * \param store
+ */
+void PS_ShapeSegment::setPointStore(PS_PointStore *store){
+    this->removeAllPoints();
+    this->myOldMoments.clear();
+    this->myStore = store;
+}
+
+/*!
+ * \brief PS_ShapeSegment::setPointsUsed
+ * Sets the used state of all shape points in the point store
+ * \param state
+ */
+void PS_ShapeSegment::setPointsUsed(const bool &state){
+    for(unsigned int i = 0; i < this->myPoints.size(); i++){
+        this->myStore->setUsed(this->myPoints[i], state);
+    }
 }
 
 /*!
  * \brief ShapeSegment::saveCurrentState
- * Saves the current shape-state to be able to fall back to that state later
+ * Saves the current shape-state to be able to fall back to that state later.
+ * Between saving and falling back points are only appended so only the point count and the running sums are saved.
  */
 void PS_ShapeSegment::saveCurrentState(){
     if(this->myOldState != NULL){
+        this->myState->numPoints = this->myPoints.size();
         *this->myOldState = *this->myState;
+        this->myOldMoments = this->myMoments;
     }
 }
 
@@ -130,6 +168,10 @@ void PS_ShapeSegment::saveCurrentState(){
 void PS_ShapeSegment::fallBack(){
     if(this->myOldState != NULL){
         *this->myState = *this->myOldState;
+        if(this->myState->numPoints < this->myPoints.size()){
+            this->myPoints.resize(this->myState->numPoints);
+            this->myMoments = this->myOldMoments;
+        }
     }
 }
 
@@ -149,3 +191,59 @@ void PS_ShapeSegment::setIsValid(const bool &isValid){
 void PS_ShapeSegment::addUsedNode(PS_Node *n){
     this->usedNodes.append(n);
 }
+
+/*!
+ * \brief PS_ShapeSegment::getPlaneSigma
+ * Returns the standard deviation of a plane through the shape points (computed in O(1) from the running sums of the points)
+ * \return
+ */
+double PS_ShapeSegment::getPlaneSigma() const{
+
+    if(this->myMoments.getCount() <= 3){
+        return 0.0;
+    }
+
+    fixed::Vec<3> eigenValues;
+    fixed::Mat<3, 3> eigenVectors;
+    fixed::eigenSymmetric(this->myMoments.getScatterMatrix(), eigenValues, eigenVectors);
+
+    return qSqrt(qMax(eigenValues(2), 0.0) / (double)(this->myMoments.getCount() - 3.0));
+
+}
+
+/*!
+ * \brief PS_ShapeSegment::setRandomSeed
+ * Reinitializes the generator that is used to draw random samples of the shape points
+ * \param seed
+ */
+void PS_ShapeSegment::setRandomSeed(const quint64 &seed){
+    this->myRandom.setSeed(seed);
+}
+
+/*!
+ * \brief PS_ShapeSegment::isPlausible
+ * Returns true if the shape is valid and satisfies the user defined restrictions (used to reject RANSAC hypotheses)
+ * \param param
+ * \return
+ */
+bool PS_ShapeSegment::isPlausible(const PS_InputParameter &param) const{
+    Q_UNUSED(param);
+    return this->myState->isValid;
+}
+
+/*!
+ * \brief PS_ShapeSegment::prepareInlierCheck
+ * Precompute all values needed by checkInliers after the shape parameters have changed
+ */
+void PS_ShapeSegment::prepareInlierCheck(){
+}
+
+/*!
+ * \brief PS_ShapeSegment::copyState
+ * Copies the shape parameters of other (but not its points)
+ * \param other
+ */
+void PS_ShapeSegment::copyState(const PS_ShapeSegment &other){
+    *this->myState = *other.myState;
+    this->prepareInlierCheck();
+}
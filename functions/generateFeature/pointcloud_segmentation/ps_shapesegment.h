@@ -7,11 +7,14 @@
 
 #include "oivec.h"
 #include "oimat.h"
+#include "fixedmatrix.h"
 
 #include "ps_pointcloud.h"
 #include "ps_generalmath.h"
-#include "ps_point_pc.h"
+#include "ps_random.h"
+#include "ps_pointstore.h"
 #include "ps_node.h"
+#include "pointmoments.h"
 
 struct ShapeState{
 
@@ -21,11 +24,14 @@ struct ShapeState{
         this->mainFocus[0] = 0.0;
         this->mainFocus[1] = 0.0;
         this->mainFocus[2] = 0.0;
+        this->numPoints = 0;
     }
 
+    virtual ~ShapeState(){}
+
     virtual ShapeState& operator=(const ShapeState &copy){
         this->isValid = copy.isValid;
-        this->myPoints = copy.myPoints;
+        this->numPoints = copy.numPoints;
         this->sigma = copy.sigma;
         this->mainFocus[0] = copy.mainFocus[0];
         this->mainFocus[1] = copy.mainFocus[1];
@@ -36,7 +42,7 @@ struct ShapeState{
     bool isValid;
     float sigma; //variance factor
     float mainFocus[3]; //main focus of the points on the shape surface
-    QList<PS_Point_PC *> myPoints; //points that define the shape
+    unsigned int numPoints; //number of shape points at the time the state was saved
 
 };
 
@@ -44,32 +50,52 @@ class PS_ShapeSegment
 {
 
 public:
-    PS_ShapeSegment();
+    PS_ShapeSegment(PS_PointStore *store);
     virtual ~PS_ShapeSegment();
 
     virtual void fit() = 0;
     virtual void fitBySample(int numPoints) = 0;
 
-    virtual void minimumSolution(const QList<PS_Point_PC *> &points) = 0;
+    virtual void minimumSolution(const vector<quint32> &points) = 0;
+
+    //RANSAC interface
+    virtual bool isPlausible(const PS_InputParameter &param) const;
+    virtual void prepareInlierCheck();
+    virtual unsigned int checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const = 0;
+    void copyState(const PS_ShapeSegment &other);
 
     virtual bool writeToObj(const QString &filePath);
     virtual bool writeToPts(const QString &filePath);
     virtual bool writeToX3D(const QString &filePath) = 0;
 
-    //! \brief Returns all points of the shape
-    inline const QList<PS_Point_PC *> &getPoints(){
-        return this->myState->myPoints;
+    //! \brief Returns the indices of all points of the shape
+    inline const vector<quint32> &getPoints(){
+        return this->myPoints;
     }
 
     //! \brief Returns the number of shape points
     inline const unsigned int getPointCount(){
-        return this->myState->myPoints.size();
+        return this->myPoints.size();
+    }
+
+    //! \brief Returns the running sums of the shape points
+    inline const PointMoments &getMoments() const{
+        return this->myMoments;
+    }
+
+    //! \brief Returns the store that holds the coordinates of the shape points
+    inline PS_PointStore *getPointStore() const{
+        return this->myStore;
     }
 
-    void addPoint(PS_Point_PC *p);
+    void addPoint(const quint32 &p);
     void removePoint(const int &index);
     void removeUsedPoints();
     void removeAllPoints();
+    void setPointStore(PS_PointStore *store);
+    void setPointsUsed(const bool &state);
+
+    double getPlaneSigma() const;
 
     void saveCurrentState();
     void fallBack();
@@ -96,12 +122,25 @@ public:
     }
     void addUsedNode(PS_Node *n);
 
+    //! \brief Returns the generator used to draw random samples of the shape points
+    inline PS_Random &getRandomGenerator(){
+        return this->myRandom;
+    }
+    void setRandomSeed(const quint64 &seed);
+
 protected:
+    PS_PointStore *myStore; //store that holds the coordinates and the used state of all points
+    vector<quint32> myPoints; //indices of the points that define the shape
+    PointMoments myMoments; //running sums of the shape points (kept up to date when points are added or removed)
+    PointMoments myOldMoments; //running sums at the time the state was saved
+
     ShapeState *myState; //current state of the plane
     ShapeState *myOldState; //old parameters of the plane to be able to reset the current solution to the last one
 
     QList<PS_Node *> usedNodes; //nodes from which points were used for this shape
 
+    PS_Random myRandom; //generator used to draw random samples (seeded per shape to get reproducible results)
+
 };
 
 #endif // PS_SHAPESEGMENT_H
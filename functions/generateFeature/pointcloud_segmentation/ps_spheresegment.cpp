@@ -1,22 +1,8 @@
 #include "ps_spheresegment.h"
 
-//CombinationWatcher Sphere::myCombinations;
-OiMat PS_SphereSegment::min_A(4,4);
-OiMat PS_SphereSegment::min_AReplaced(4,4);
-OiVec PS_SphereSegment::min_C(4);
-OiVec PS_SphereSegment::min_X(4);
+#include "ps_instrumentation.h"
 
-OiMat PS_SphereSegment::fitting_N(4,4);
-OiVec PS_SphereSegment::fitting_n(4);
-OiMat PS_SphereSegment::fitting_Q(4,4);
-OiVec PS_SphereSegment::fitting_a(4);
-OiVec PS_SphereSegment::fitting_x(3);
-
-OiMat PS_SphereSegment::verify_u(3,3);
-OiMat PS_SphereSegment::verify_v(3,3);
-OiVec PS_SphereSegment::verify_d(3);
-
-PS_SphereSegment::PS_SphereSegment() : PS_ShapeSegment(){
+PS_SphereSegment::PS_SphereSegment(PS_PointStore *store) : PS_ShapeSegment(store){
 
     //create sphere states and make sure that mySphereState points to the same object as myState
     this->mySphereState = new SphereState();
@@ -85,76 +71,56 @@ bool PS_SphereSegment::writeToX3D(const QString &filePath){
  * \param param
  * \return
  */
-PS_SphereSegment *PS_SphereSegment::detectSphere(const QList<PS_Point_PC*> &points, const PS_InputParameter &param){
+PS_SphereSegment *PS_SphereSegment::detectSphere(PS_PointStore *store, const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator){
+
+    PS_SCOPED_TIMER(eDetectSphere);
 
     //TODO tolerance factor hier überdenken, da sonst grade bei kugeln mit vielen Ausreißern
     //schlechte und falsche Sachen detektiert werden, die mehr Punkte als
     //das rictige enthalten
     //Stattdessen nach der Minimumsuche und fit nochmal checkpointsinShape um Punkte ggf. dazu zu holen
 
-    PS_SphereSegment *result = new PS_SphereSegment();
+    PS_SphereSegment *result = new PS_SphereSegment(store);
 
-    //qDebug() << "sample size: " << points.size();
-
-    int numTrials = 0; //number of necessary trials
     int k = 4; //number of points in a required minimal set to define a sphere
-    float p = 1.0f - param.outlierPercentage; //probability of drawing a sphere-point from the set of points
-    float s = 0.99f; //required probability of detecting the sphere in numTrials trials
 
-    float phk = p;
-    for(int i = 0; i < k-1; i++){
-        phk = phk * p;
+    //search the sphere with the most inliers (at least k+1 points and stop if the sphere contains mostly all points of the voxel)
+    PS_SphereSegment hypothesis(store);
+    PS_Ransac ransac(points, param, generator);
+    if(ransac.run(&hypothesis, result, k, param.sphereParams.maxDistance, k+1, k)){
+        PS_SphereSegment::checkPointsInSphere(result, points, param, 1);
     }
 
-    //calculate the number of necessary trials
-    numTrials = (int)ceil(qLn(1.0f - s) / qLn(1.0f - phk));
-
-    //qDebug() << "Anzahl Durchgänge: " << numTrials;
-
-    //get numTrials random samples
-    QMap<int, QList<PS_Point_PC*> > randomSamples;
-    PS_GeneralMath::getRandomSubsets(randomSamples, numTrials, k, points);
-
-    for(int i = 0; i < numTrials; i++){
-
-        //qDebug() << "sample number " << i;
-
-        //create sphere out of the four points A, B, C and D
-        PS_SphereSegment *possibleSolution = new PS_SphereSegment();
-        possibleSolution->minimumSolution(randomSamples.value(i));
-
-        //if the radius is too large/low or there is no solution then break and consider the next random sample
-        if(!possibleSolution->getIsValid() || possibleSolution->getRadius() > param.sphereParams.maxRadius
-                || possibleSolution->getRadius() < param.sphereParams.minRadius){
-            continue;
-        }
-
-        //if at least k+1 points are within the sphere...
-        if(PS_SphereSegment::checkPointsInSphere(possibleSolution, points, param, 1) >= k+1){
-
-            //...and the solution is better then the best one found before
-            if(possibleSolution->getPoints().size() > result->getPoints().size()){
-
-                //delete the old "best" sphere
-                if(result != NULL){
-                    delete result;
-                }
-
-                //set the new sphere as result
-                result = possibleSolution;
+    //seed the generator of the detected shape to be able to fit it by sample reproducibly
+    result->setRandomSeed(generator.next());
 
-                //if the sphere contains mostly all points of the voxel then break the search
-                if(result->myState->myPoints.size() >= points.size()-4){
-                    break;
-                }
-            }
-
-        }
+    return result;
 
-    }
+}
 
-    return result;
+/*!
+ * \brief PS_SphereSegment::isPlausible
+ * Returns true if the sphere is valid and its radius is within the user defined range
+ * \param param
+ * \return
+ */
+bool PS_SphereSegment::isPlausible(const PS_InputParameter &param) const{
+    return this->myState->isValid && this->getRadius() <= param.sphereParams.maxRadius
+            && this->getRadius() >= param.sphereParams.minRadius;
+}
 
+/*!
+ * \brief PS_SphereSegment::checkInliers
+ * Check which of the given points lie in a small band around the sphere surface
+ * \param points
+ * \param count
+ * \param threshold
+ * \param mask
+ * \return
+ */
+unsigned int PS_SphereSegment::checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const{
+    return PS_DistanceKernels::sphereInliers(this->myStore->getXArray(), this->myStore->getYArray(), this->myStore->getZArray(),
+                                             points, count, this->mySphereState->xyz, this->mySphereState->radius, threshold, mask);
 }
 
 /*!
@@ -165,44 +131,30 @@ PS_SphereSegment *PS_SphereSegment::detectSphere(const QList<PS_Point_PC*> &poin
  * \param myPoints
  * \param param
  * \param toleranceFactor
+ * \param inlierMask scratch memory for the inlier mask, e.g. of a PS_ShapeTask (optional, a temporary mask is used if NULL)
  * \return
  */
-int PS_SphereSegment::checkPointsInSphere(PS_SphereSegment *mySphere, const QList<PS_Point_PC*> &myPoints, const PS_InputParameter &param, const int &toleranceFactor){
+int PS_SphereSegment::checkPointsInSphere(PS_SphereSegment *mySphere, const vector<quint32> &myPoints, const PS_InputParameter &param, const int &toleranceFactor,
+                                          vector<unsigned char> *inlierMask){
 
     int result = 0; //number of points that were added to the sphere
 
     if(mySphere->getIsValid()){
 
-        //iterate through all points to check wether they lie in a small band around the sphere surface
-        for(int i = 0; i < myPoints.size(); i++){
-
-            PS_Point_PC *p = myPoints.at(i);
-
-            //if the point is not used for another shape
-            if(!p->isUsed){
-
-                float diffVec[3]; //difference vector between point and sphere center
-                diffVec[0] = p->xyz[0] - mySphere->getXYZ()[0];
-                diffVec[1] = p->xyz[1] - mySphere->getXYZ()[1];
-                diffVec[2] = p->xyz[2] - mySphere->getXYZ()[2];
-
-                float radiusActual = 0.0f; //length of the difference vector
-
-                radiusActual = qSqrt( diffVec[0]*diffVec[0] + diffVec[1]*diffVec[1] + diffVec[2]*diffVec[2] );
+        const PS_PointStore *store = mySphere->getPointStore();
 
-                float distance = 0.0f;
-
-                distance = radiusActual - mySphere->getRadius(); //distance error
-
-                //add the point to the sphere if the distance is lower than a threshold
-                float absDist = qAbs(distance);
-                if(absDist < (((float)toleranceFactor) * param.sphereParams.maxDistance)){
-                    mySphere->addPoint(p);
-                    result++;
-                }
+        //check the distance of all points from the sphere surface in one batch
+        vector<unsigned char> localMask;
+        vector<unsigned char> &mask = (inlierMask != NULL) ? *inlierMask : localMask;
+        mask.resize(myPoints.size());
+        mySphere->checkInliers(myPoints.data(), myPoints.size(), ((float)toleranceFactor) * param.sphereParams.maxDistance, mask.data());
 
+        //add all inliers that are not used for another shape to the sphere
+        for(unsigned int i = 0; i < myPoints.size(); i++){
+            if(mask[i] && !store->isUsed(myPoints[i])){
+                mySphere->addPoint(myPoints[i]);
+                result++;
             }
-
         }
 
     }
@@ -217,9 +169,9 @@ int PS_SphereSegment::checkPointsInSphere(PS_SphereSegment *mySphere, const QLis
  */
 void PS_SphereSegment::fit(){
 
-    //clock_t test = clock();
+    PS_COUNT(eRefits, 1);
 
-    if(this->myState->myPoints.size() < 5){
+    if(this->myPoints.size() < 5){
         this->myState->isValid = false;
         return;
     }
@@ -239,9 +191,9 @@ void PS_SphereSegment::fit(){
 
     //calc centroid of all sphere points
     for(int i = 0; i < this->getPoints().size(); ++i){
-        centroid[0] += this->myState->myPoints.at(i)->xyz[0];
-        centroid[1] += this->myState->myPoints.at(i)->xyz[1];
-        centroid[2] += this->myState->myPoints.at(i)->xyz[2];
+        centroid[0] += this->myStore->getX(this->myPoints[i]);
+        centroid[1] += this->myStore->getY(this->myPoints[i]);
+        centroid[2] += this->myStore->getZ(this->myPoints[i]);
     }
     centroid[0] = centroid[0] / (double)numPoints;
     centroid[1] = centroid[1] / (double)numPoints;
@@ -253,43 +205,36 @@ void PS_SphereSegment::fit(){
     zm = this->getXYZ()[2];
     r = this->getRadius();
 
-    OiVec xd(4);
-
-    OiVec verb(numPoints*3);
-    //OiVec vd(numPoints*3);
+    /*
+     * Gauss-Helmert model: BBT is diagonal, so the normal equations
+     *  | BBT  A | | k |   | -w |
+     *  | AT   0 | | x | = |  0 |
+     * are reduced to the 4x4 system (AT * BBT^-1 * A) * x = -AT * BBT^-1 * w and k is computed point by point
+     */
+    vector<double> verb(numPoints*3, 0.0); //corrections of the observations
+    vector<double> b(numPoints*3); //derivations with respect to the observations
+    vector<double> bbt(numPoints);
+    vector<double> w(numPoints);
+    fixed::Mat<4, 4> n;
+    fixed::Vec<4> rhs, xd;
 
     double a1 = 0.0, a2 = 0.0, a3 = 0.0;
-    //OiMat A(numPoints, 4);
-    //OiMat AT(4, numPoints);
-
-    //OiMat BBT(numPoints, numPoints);
-
-    //OiMat B(numPoints, numPoints*3);
-    OiVec w(numPoints+4);
-    OiMat N(numPoints+4, numPoints+4);
-
-    //OiMat Q(numPoints+4, numPoints+4);
-
-
-    OiVec res(numPoints+4);
-    //OiVec k(numPoints);
-
-
-    //qDebug() << "vor iteration " << (clock() - test)/(double)CLOCKS_PER_SEC;
 
     double stop = 0.0;
     do{
 
-        //vector<double> bbt_diag;
+        n = fixed::Mat<4, 4>();
+        rhs = fixed::Vec<4>();
+
         for(int i = 0; i < numPoints; ++i){
 
-            x = this->getPoints().at(i)->xyz[0];
-            y = this->getPoints().at(i)->xyz[1];
-            z = this->getPoints().at(i)->xyz[2];
+            x = this->myStore->getX(this->myPoints[i]);
+            y = this->myStore->getY(this->myPoints[i]);
+            z = this->myStore->getZ(this->myPoints[i]);
 
-            vx = verb.getAt(i*3);
-            vy = verb.getAt(i*3+1);
-            vz = verb.getAt(i*3+2);
+            vx = verb[i*3];
+            vy = verb[i*3+1];
+            vz = verb[i*3+2];
 
             double r0 = qSqrt( (x + vx - xm) * (x + vx - xm)
                                + (y + vy - ym) * (y + vy - ym)
@@ -299,146 +244,76 @@ void PS_SphereSegment::fit(){
             a2 = (y + vy - ym) / r0;
             a3 = (z + vz - zm) / r0;
 
-            //A.setAt(i, 0, -1.0 * a1);
-            //A.setAt(i, 1, -1.0 * a2);
-            //A.setAt(i, 2, -1.0 * a3);
-            //A.setAt(i, 3, -1.0);
-
-            //AT.setAt(0, i, -1.0 * a1);
-            //AT.setAt(1, i, -1.0 * a2);
-            //AT.setAt(2, i, -1.0 * a3);
-            //AT.setAt(3, i, -1.0);
-
-            //B.setAt(i, i*3, (x + verb.getAt(i*3) - xm) / r0);
-            //B.setAt(i, i*3+1, (y + verb.getAt(i*3+1) - ym) / r0);
-            //B.setAt(i, i*3+2, (z + verb.getAt(i*3+2) - zm) / r0);
-
-            //bbt_diag.push_back(a1*a1 + a2*a2 + a3*a3);
+            b[i*3] = a1;
+            b[i*3+1] = a2;
+            b[i*3+2] = a3;
+            bbt[i] = a1*a1 + a2*a2 + a3*a3;
+            w[i] = r0 - r;
 
-            //A
-            N.setAt(i, 0+numPoints, -1.0 * a1);
-            N.setAt(i, 1+numPoints, -1.0 * a2);
-            N.setAt(i, 2+numPoints, -1.0 * a3);
-            N.setAt(i, 3+numPoints, -1.0);
-
-            //AT
-            N.setAt(0+numPoints, i, -1.0 * a1);
-            N.setAt(1+numPoints, i, -1.0 * a2);
-            N.setAt(2+numPoints, i, -1.0 * a3);
-            N.setAt(3+numPoints, i, -1.0);
-
-            //BBT
-            N.setAt(i, i, a1*a1 + a2*a2 + a3*a3);
+            if(!(bbt[i] > 0.0)){
+                this->myState->isValid = false;
+                return;
+            }
 
-            w.setAt(i, r0 - r);
+            //row i of A divided by BBT(i,i)
+            const double a[4] = {-1.0 * a1, -1.0 * a2, -1.0 * a3, -1.0};
+            for(int j = 0; j < 4; ++j){
+                const double aj = a[j] / bbt[i];
+                rhs(j) -= aj * w[i];
+                for(int l = j; l < 4; ++l){
+                    n(j, l) += aj * a[l];
+                }
+            }
 
         }
-        //BBT.diag(bbt_diag);
-
-        //qDebug() << "vor N " << (clock() - test)/(double)CLOCKS_PER_SEC;
-
-        /*for(unsigned int i = 0; i < BBT.getRowCount(); ++i){
-            for(unsigned int j = 0; j < BBT.getColCount(); j++){
-                N.setAt(i,j, BBT.getAt(i,j));
-            }
-        }*/
-        /*for(int i = 0; i < numPoints; ++i){
-            for(int j = 0; j < 4; j++){
-                N.setAt(i, j+numPoints, A.getAt(i,j));
-            }
-        }*/
-        /*for(int i = 0; i < 4; ++i){
-            for(int j = 0; j < numPoints; ++j){
-                N.setAt(i+numPoints, j, A.getAt(j,i));
+        for(int j = 1; j < 4; ++j){
+            for(int l = 0; l < j; ++l){
+                n(j, l) = n(l, j);
             }
-        }*/
-
-        //qDebug() << "vor solve " << (clock() - test)/(double)CLOCKS_PER_SEC;
+        }
 
-        try{
-            if(!OiMat::solve(res, N, -1.0*w)){
-                this->myState->isValid = false;
-                return;
-            }
-            //Q = N.inv();
-            //res = -1.0 * Q * w;
-        }catch(exception &e){
-            qDebug() << e.what();
+        if(!fixed::solvePositiveDefinite(n, rhs, xd)){
             this->myState->isValid = false;
             return;
         }
 
-        //qDebug() << "nach solve " << (clock() - test)/(double)CLOCKS_PER_SEC;
-
-        /*for(int i = 0; i < numPoints; ++i){
-            k.setAt(i, res.getAt(i));
-        }*/
-        for(int i = 0; i < 4; ++i){
-            xd.setAt(i, res.getAt(i+numPoints));
-        }
-
+        //k = BBT^-1 * (-w - A * x) and v = BT * k
         for(int i = 0; i < numPoints; ++i){
-
-            x = this->getPoints().at(i)->xyz[0];
-            y = this->getPoints().at(i)->xyz[1];
-            z = this->getPoints().at(i)->xyz[2];
-
-            vx = verb.getAt(i*3);
-            vy = verb.getAt(i*3+1);
-            vz = verb.getAt(i*3+2);
-
-            double r0 = qSqrt( (x + vx - xm) * (x + vx - xm)
-                               + (y + vy - ym) * (y + vy - ym)
-                               + (z + vz - zm) * (z + vz - zm) );
-
-            a1 = (x + vx - xm) / r0;
-            a2 = (y + vy - ym) / r0;
-            a3 = (z + vz - zm) / r0;
-
-            verb.setAt(i*3, vx + res.getAt(i) * a1);
-            verb.setAt(i*3+1, vy + res.getAt(i) * a2);
-            verb.setAt(i*3+2, vz + res.getAt(i) * a3);
-
+            const double k = (-1.0 * w[i] + b[i*3] * xd(0) + b[i*3+1] * xd(1) + b[i*3+2] * xd(2) + xd(3)) / bbt[i];
+            verb[i*3] += k * b[i*3];
+            verb[i*3+1] += k * b[i*3+1];
+            verb[i*3+2] += k * b[i*3+2];
         }
 
-        //vd = B.t() * k;
-
-        //Unbekannte und Beobachtungen verbessern
-        //verb = verb + vd;
-        xm += xd.getAt(0);
-        ym += xd.getAt(1);
-        zm += xd.getAt(2);
-        r += xd.getAt(3);
+        //Unbekannte verbessern
+        xm += xd(0);
+        ym += xd(1);
+        zm += xd(2);
+        r += xd(3);
 
         numIterations++;
 
-        OiVec::dot(stop, xd, xd);
-
-        //qDebug() << "next it " << (clock() - test)/(double)CLOCKS_PER_SEC;
+        stop = xd(0)*xd(0) + xd(1)*xd(1) + xd(2)*xd(2) + xd(3)*xd(3);
 
     }while( (stop > 0.000001) && (numIterations < 100) );
 
-    //qDebug() << numIterations;
-
     if(numIterations >= 100){
         this->myState->isValid = false;
         return;
     }
 
     double sumVV = 0.0;
-    for(int i = 0; i < this->myState->myPoints.size(); ++i){
+    for(unsigned int i = 0; i < this->myPoints.size(); ++i){
 
-        x = this->myState->myPoints.at(i)->xyz[0];
-        y = this->myState->myPoints.at(i)->xyz[1];
-        z = this->myState->myPoints.at(i)->xyz[2];
+        x = this->myStore->getX(this->myPoints[i]);
+        y = this->myStore->getY(this->myPoints[i]);
+        z = this->myStore->getZ(this->myPoints[i]);
 
         sumVV += (r - qSqrt( (xm-x)*(xm-x) + (ym-y)*(ym-y) + (zm-z)*(zm-z) ))
                 * (r - qSqrt( (xm-x)*(xm-x) + (ym-y)*(ym-y) + (zm-z)*(zm-z) ));
 
     }
 
-    //qDebug() << "fertig " << (clock() - test)/(double)CLOCKS_PER_SEC;
-
     this->mySphereState->radius = r;
     this->mySphereState->xyz[0] = xm;
     this->mySphereState->xyz[1] = ym;
@@ -458,9 +333,11 @@ void PS_SphereSegment::fit(){
  */
 void PS_SphereSegment::fitBySample(int numPoints){
 
+    PS_COUNT(eRefits, 1);
+
     //qDebug() << "fit sample";
 
-    if(this->myState->myPoints.size() < 5 || numPoints < 5){
+    if(this->myPoints.size() < 5 || numPoints < 5){
         this->myState->isValid = false;
         return;
     }
@@ -487,13 +364,13 @@ void PS_SphereSegment::fitBySample(int numPoints){
     if(numPoints > this->getPoints().size()){
         numPoints = this->getPoints().size();
     }
-    QMap<int, QList<PS_Point_PC*> > randomSampleMap;
-    PS_GeneralMath::getRandomSubsets(randomSampleMap, 1, numPoints, this->myState->myPoints);
+    QMap<int, vector<quint32> > randomSampleMap;
+    PS_GeneralMath::getRandomSubsets(randomSampleMap, 1, numPoints, this->myPoints, this->myRandom);
     if(randomSampleMap.isEmpty()){
         this->myState->isValid = false;
         return;
     }
-    QList<PS_Point_PC*> &randomSample = randomSampleMap.first();
+    vector<quint32> &randomSample = randomSampleMap.first();
 
     if(randomSample.size() == 0){
         this->myState->isValid = false;
@@ -517,9 +394,9 @@ void PS_SphereSegment::fitBySample(int numPoints){
 
     //calc centroid of all sphere points
     for(int i = 0; i < this->getPoints().size(); i++){
-        centroidAll[0] += this->myState->myPoints.at(i)->xyz[0];
-        centroidAll[1] += this->myState->myPoints.at(i)->xyz[1];
-        centroidAll[2] += this->myState->myPoints.at(i)->xyz[2];
+        centroidAll[0] += this->myStore->getX(this->myPoints[i]);
+        centroidAll[1] += this->myStore->getY(this->myPoints[i]);
+        centroidAll[2] += this->myStore->getZ(this->myPoints[i]);
     }
     centroidAll[0] = centroidAll[0] / (double)this->getPoints().size();
     centroidAll[1] = centroidAll[1] / (double)this->getPoints().size();
@@ -532,9 +409,9 @@ void PS_SphereSegment::fitBySample(int numPoints){
 
     //calc centroid of numPoints points
     for(int i = 0; i < numPoints; i++){
-        centroid[0] += randomSample.at(i)->xyz[0];
-        centroid[1] += randomSample.at(i)->xyz[1];
-        centroid[2] += randomSample.at(i)->xyz[2];
+        centroid[0] += this->myStore->getX(randomSample[i]);
+        centroid[1] += this->myStore->getY(randomSample[i]);
+        centroid[2] += this->myStore->getZ(randomSample[i]);
     }
     centroid[0] = centroid[0] / (double)numPoints;
     centroid[1] = centroid[1] / (double)numPoints;
@@ -543,78 +420,47 @@ void PS_SphereSegment::fitBySample(int numPoints){
     //qDebug() << "vor fit";
 
     //fit the sphere with Drixler
-    for(int i = 0; i < 4; i++){
-        PS_SphereSegment::fitting_n.setAt(i, 0.0);
+    fixed::Mat<4, 4> n;
+    fixed::Vec<4> rhs;
+    for(int i = 0; i < numPoints; i++){
+
+        x = this->myStore->getX(randomSample[i]) - centroid[0];
+        y = this->myStore->getY(randomSample[i]) - centroid[1];
+        z = this->myStore->getZ(randomSample[i]) - centroid[2];
+
+        const double row[4] = {x, y, z, 1.0};
+        const double xyz2 = x*x + y*y + z*z;
         for(int j = 0; j < 4; j++){
-            PS_SphereSegment::fitting_N.setAt(i, j, 0.0);
+            rhs(j) -= row[j] * xyz2;
+            for(int l = j; l < 4; l++){
+                n(j, l) += row[j] * row[l];
+            }
         }
-    }
-    //qDebug() << "vor loop";
-    for(unsigned int i = 0; i < numPoints; i++){
-
-        x = randomSample.at(i)->xyz[0] - centroid[0];
-        y = randomSample.at(i)->xyz[1] - centroid[1];
-        z = randomSample.at(i)->xyz[2] - centroid[2];
-
-        double xx = x*x;
-        double yy = y*y;
-        double zz = z*z;
-        double xy = x*y;
-        double xz = x*z;
-        double yz = y*z;
-        double xyz2 = x*x + y*y + z*z;
-
-        PS_SphereSegment::fitting_N.setAt(0,0, PS_SphereSegment::fitting_N.getAt(0,0) + xx);
-        PS_SphereSegment::fitting_N.setAt(0,1, PS_SphereSegment::fitting_N.getAt(0,1) + xy);
-        PS_SphereSegment::fitting_N.setAt(0,2, PS_SphereSegment::fitting_N.getAt(0,2) + xz);
-        PS_SphereSegment::fitting_N.setAt(0,3, PS_SphereSegment::fitting_N.getAt(0,3) + x);
-        PS_SphereSegment::fitting_N.setAt(1,0, PS_SphereSegment::fitting_N.getAt(1,0) + xy);
-        PS_SphereSegment::fitting_N.setAt(1,1, PS_SphereSegment::fitting_N.getAt(1,1) + yy);
-        PS_SphereSegment::fitting_N.setAt(1,2, PS_SphereSegment::fitting_N.getAt(1,2) + yz);
-        PS_SphereSegment::fitting_N.setAt(1,3, PS_SphereSegment::fitting_N.getAt(1,3) + y);
-        PS_SphereSegment::fitting_N.setAt(2,0, PS_SphereSegment::fitting_N.getAt(2,0) + xz);
-        PS_SphereSegment::fitting_N.setAt(2,1, PS_SphereSegment::fitting_N.getAt(2,1) + yz);
-        PS_SphereSegment::fitting_N.setAt(2,2, PS_SphereSegment::fitting_N.getAt(2,2) + zz);
-        PS_SphereSegment::fitting_N.setAt(2,3, PS_SphereSegment::fitting_N.getAt(2,3) + z);
-        PS_SphereSegment::fitting_N.setAt(3,0, PS_SphereSegment::fitting_N.getAt(3,0) + x);
-        PS_SphereSegment::fitting_N.setAt(3,1, PS_SphereSegment::fitting_N.getAt(3,1) + y);
-        PS_SphereSegment::fitting_N.setAt(3,2, PS_SphereSegment::fitting_N.getAt(3,2) + z);
-        PS_SphereSegment::fitting_N.setAt(3,3, PS_SphereSegment::fitting_N.getAt(3,3) + 1.0);
-
-        PS_SphereSegment::fitting_n.setAt(0, PS_SphereSegment::fitting_n.getAt(0) + x*xyz2);
-        PS_SphereSegment::fitting_n.setAt(1, PS_SphereSegment::fitting_n.getAt(1) + y*xyz2);
-        PS_SphereSegment::fitting_n.setAt(2, PS_SphereSegment::fitting_n.getAt(2) + z*xyz2);
-        PS_SphereSegment::fitting_n.setAt(3, PS_SphereSegment::fitting_n.getAt(3) + xyz2);
 
     }
-
-    //qDebug() << "vor solve";
-
-    OiVec a(4);
-    try{
-        if(!OiMat::solve(a, PS_SphereSegment::fitting_N, -1.0*PS_SphereSegment::fitting_n)){
-            this->myState->isValid = false;
-            return;
+    for(int j = 1; j < 4; j++){
+        for(int l = 0; l < j; l++){
+            n(j, l) = n(l, j);
         }
-        //PS_SphereSegment::fitting_Q = PS_SphereSegment::fitting_N.inv();
-        //a = -1.0 * PS_SphereSegment::fitting_Q * PS_SphereSegment::fitting_n;
-    }catch(exception &e){
-        qDebug() << e.what();
+    }
+
+    fixed::Vec<4> a;
+    if(!fixed::solvePositiveDefinite(n, rhs, a)){
         this->myState->isValid = false;
         return;
     }
 
-    r = qSqrt( qAbs( 0.25 * (a.getAt(0)*a.getAt(0) + a.getAt(1)*a.getAt(1) + a.getAt(2)*a.getAt(2)) - a.getAt(3) ) );
-    xm = -0.5 * a.getAt(0) + centroid[0];
-    ym = -0.5 * a.getAt(1) + centroid[1];
-    zm = -0.5 * a.getAt(2) + centroid[2];
+    r = qSqrt( qAbs( 0.25 * (a(0)*a(0) + a(1)*a(1) + a(2)*a(2)) - a(3) ) );
+    xm = -0.5 * a(0) + centroid[0];
+    ym = -0.5 * a(1) + centroid[1];
+    zm = -0.5 * a(2) + centroid[2];
 
     double sumVV = 0.0;
     /*for(int i = 0; i < this->myState->myPoints.size(); i++){
 
-        x = this->myState->myPoints.at(i)->xyz[0];
-        y = this->myState->myPoints.at(i)->xyz[1];
-        z = this->myState->myPoints.at(i)->xyz[2];
+        x = this->myStore->getX(this->myPoints[i]);
+        y = this->myStore->getY(this->myPoints[i]);
+        z = this->myStore->getZ(this->myPoints[i]);
 
         sumVV += (r - qSqrt( (xm-x)*(xm-x) + (ym-y)*(ym-y) + (zm-z)*(zm-z) ))
                 * (r - qSqrt( (xm-x)*(xm-x) + (ym-y)*(ym-y) + (zm-z)*(zm-z) ));
@@ -625,9 +471,9 @@ void PS_SphereSegment::fitBySample(int numPoints){
 
     for(int i = 0; i < numPoints; i++){
 
-        x = randomSample.at(i)->xyz[0];
-        y = randomSample.at(i)->xyz[1];
-        z = randomSample.at(i)->xyz[2];
+        x = this->myStore->getX(randomSample[i]);
+        y = this->myStore->getY(randomSample[i]);
+        z = this->myStore->getZ(randomSample[i]);
 
         sumVV += (r - qSqrt( (xm-x)*(xm-x) + (ym-y)*(ym-y) + (zm-z)*(zm-z) ))
                 * (r - qSqrt( (xm-x)*(xm-x) + (ym-y)*(ym-y) + (zm-z)*(zm-z) ));
@@ -650,45 +496,92 @@ void PS_SphereSegment::fitBySample(int numPoints){
 
 }
 
+/*!
+ * \brief PS_SphereSegment::fitByMoments
+ * Fit the sphere algebraically (Drixler) using the running sums of all points (O(1), used to refit the sphere during region growing).
+ * Sigma is derived from the algebraic residuals e = |x - xm|^2 - r^2 which are approximately 2 * r * d for a point at distance d.
+ */
+void PS_SphereSegment::fitByMoments(){
+
+    PS_COUNT(eRefits, 1);
+
+    const PointMoments &moments = this->myMoments;
+
+    if(moments.getCount() < 5){
+        this->myState->isValid = false;
+        return;
+    }
+
+    //normal equations of x^2 + y^2 + z^2 + a0*x + a1*y + a2*z + a3 = 0 (coordinates reduced by the reference of the moments)
+    fixed::Mat<4, 4> n;
+    fixed::Vec<4> c, a;
+    moments.getSphereNormalEquations(n, c);
+
+    if(!fixed::solvePositiveDefinite(n, c * -1.0, a)){
+        this->myState->isValid = false;
+        return;
+    }
+
+    double r = qSqrt( qAbs( 0.25 * (a(0)*a(0) + a(1)*a(1) + a(2)*a(2)) - a(3) ) );
+
+    //sum of the squared algebraic residuals
+    const double sumEE = qMax(moments.getSphereResidualSum(a), 0.0);
+
+    double centroid[3];
+    moments.getCentroid(centroid);
+
+    //set results
+    this->mySphereState->radius = r;
+    this->mySphereState->xyz[0] = -0.5 * a(0) + moments.getReference(0);
+    this->mySphereState->xyz[1] = -0.5 * a(1) + moments.getReference(1);
+    this->mySphereState->xyz[2] = -0.5 * a(2) + moments.getReference(2);
+    this->myState->mainFocus[0] = centroid[0];
+    this->myState->mainFocus[1] = centroid[1];
+    this->myState->mainFocus[2] = centroid[2];
+    this->myState->sigma = r > 0.0 ? qSqrt( sumEE / (4.0 * r * r) / ((double)moments.getCount() - 4.0) ) : 0.0;
+    this->myState->isValid = true;
+
+}
+
 /*!
  * \brief PS_SphereSegment::minimumSolution
  * Calculate sphere from 4 points
  * \param points
  */
-void PS_SphereSegment::minimumSolution(const QList<PS_Point_PC *> &points){
+void PS_SphereSegment::minimumSolution(const vector<quint32> &points){
 
     if(points.size() != 4){
         this->myState->isValid = false;
         return;
     }
 
+    //x^2 + y^2 + z^2 - 2*x*xm - 2*y*ym - 2*z*zm + (xm^2 + ym^2 + zm^2 - r^2) = 0
+    fixed::Mat<4, 4> a;
+    fixed::Vec<4> c, x;
     for(int i = 0; i < 4; i++){
-        PS_SphereSegment::min_A.setAt(i, 0, -2.0 * points.at(i)->xyz[0]);
-        PS_SphereSegment::min_A.setAt(i, 1, -2.0 * points.at(i)->xyz[1]);
-        PS_SphereSegment::min_A.setAt(i, 2, -2.0 * points.at(i)->xyz[2]);
-        PS_SphereSegment::min_A.setAt(i, 3, 1.0);
-
-        PS_SphereSegment::min_C.setAt(i, -1.0*points.at(i)->xyz[0]*points.at(i)->xyz[0]
-                - points.at(i)->xyz[1]*points.at(i)->xyz[1]
-                - points.at(i)->xyz[2]*points.at(i)->xyz[2]);
+        const double px = this->myStore->getX(points[i]);
+        const double py = this->myStore->getY(points[i]);
+        const double pz = this->myStore->getZ(points[i]);
+
+        a(i, 0) = -2.0 * px;
+        a(i, 1) = -2.0 * py;
+        a(i, 2) = -2.0 * pz;
+        a(i, 3) = 1.0;
+
+        c(i) = -1.0 * px * px - py * py - pz * pz;
     }
 
-    double detA = PS_SphereSegment::min_A.det();
-    for(int i = 0; i < 4; i++){
-        PS_SphereSegment::min_AReplaced = PS_SphereSegment::min_A;
-        PS_SphereSegment::min_AReplaced.setCol(i, PS_SphereSegment::min_C);
-        double detAr = PS_SphereSegment::min_AReplaced.det();
-        PS_SphereSegment::min_X.setAt(i, detAr / detA);
+    //the four points are coplanar
+    if(!fixed::solve(a, c, x)){
+        this->myState->isValid = false;
+        return;
     }
 
     //set the sphere's attributes to the calculated values
-    this->mySphereState->radius = qSqrt( PS_SphereSegment::min_X.getAt(0)*PS_SphereSegment::min_X.getAt(0)
-                                         + PS_SphereSegment::min_X.getAt(1)*PS_SphereSegment::min_X.getAt(1)
-                                         + PS_SphereSegment::min_X.getAt(2)*PS_SphereSegment::min_X.getAt(2)
-                                         - PS_SphereSegment::min_X.getAt(3) );
-    this->mySphereState->xyz[0] = PS_SphereSegment::min_X.getAt(0);
-    this->mySphereState->xyz[1] = PS_SphereSegment::min_X.getAt(1);
-    this->mySphereState->xyz[2] = PS_SphereSegment::min_X.getAt(2);
+    this->mySphereState->radius = qSqrt( x(0)*x(0) + x(1)*x(1) + x(2)*x(2) - x(3) );
+    this->mySphereState->xyz[0] = x(0);
+    this->mySphereState->xyz[1] = x(1);
+    this->mySphereState->xyz[2] = x(2);
     this->myState->isValid = true;
 
 }
@@ -702,7 +595,7 @@ void PS_SphereSegment::minimumSolution(const QList<PS_Point_PC *> &points){
  */
 void PS_SphereSegment::sortOut(PS_SphereSegment *mySphere, const PS_InputParameter &param, const int &toleranceFactor){
 
-    QList<PS_Point_PC *> myPoints = mySphere->getPoints();
+    vector<quint32> myPoints = mySphere->getPoints();
     mySphere->removeAllPoints();
     PS_SphereSegment::checkPointsInSphere(mySphere, myPoints, param, toleranceFactor);
 
@@ -714,10 +607,16 @@ void PS_SphereSegment::sortOut(PS_SphereSegment *mySphere, const PS_InputParamet
  * \param detectedSpheres
  * \param mergedSpheres
  * \param param
+ * \param statistics
+ * \param compareAllPairs true if all pairs of spheres shall be compared instead of only those in neighbouring cells of the merge index (same result, used as reference in tests)
  */
-void PS_SphereSegment::mergeSpheres(const QList<PS_SphereSegment *> &detectedSpheres, QList<PS_SphereSegment *> &mergedSpheres, const PS_InputParameter &param){
+void PS_SphereSegment::mergeSpheres(const QList<PS_SphereSegment *> &detectedSpheres, QList<PS_SphereSegment *> &mergedSpheres, const PS_InputParameter &param, PS_MergeStatistics &statistics,
+                                    const bool &compareAllPairs){
 
-    //qDebug() << "in merge";
+    PS_SCOPED_TIMER(eMergeSpheres);
+
+    QElapsedTimer timer;
+    timer.start();
 
     //distance of main focus of the points on one sphere to the centroid of the other sphere
     float dCentroid2FocusS1 = 0.0, dCentroid2FocusS2 = 0.0;
@@ -726,6 +625,28 @@ void PS_SphereSegment::mergeSpheres(const QList<PS_SphereSegment *> &detectedSph
         mergedSpheres.clear();
     }
 
+    statistics = PS_MergeStatistics();
+    statistics.numShapes = detectedSpheres.size();
+
+    /*
+     * bucket the spheres by their center: two spheres are merged if the main focus of one sphere is within two radii
+     * of the other center. The main focus of a sphere is near its own center, so the centers of such a pair are at most
+     * two radii plus that offset apart. The cells are slightly larger than this bound to be robust against rounding errors.
+     */
+    float maxRadius = param.sphereParams.maxRadius;
+    float maxFocusOffset = 0.0f; //largest distance of a main focus from the center of its sphere
+    for(int i = 0; i < detectedSpheres.size(); ++i){
+        maxRadius = qMax(maxRadius, detectedSpheres.at(i)->getRadius());
+        maxFocusOffset = qMax(maxFocusOffset, PS_SphereSegment::getFocusOffset(detectedSpheres.at(i)));
+    }
+    float cellSize = 1.01f * (2.0f * maxRadius + maxFocusOffset);
+    float cellSizes[3] = {cellSize, cellSize, cellSize};
+    PS_MergeIndex index(compareAllPairs ? 0 : 3, cellSizes);
+    for(int i = 0; i < detectedSpheres.size(); ++i){
+        index.insert(i, detectedSpheres.at(i)->getXYZ());
+    }
+    vector<int> candidates;
+
     //for each sphere save its merged state
     QMap<int, bool> mergeMap;
     for(int i = 0; i < detectedSpheres.size(); ++i){
@@ -745,77 +666,100 @@ void PS_SphereSegment::mergeSpheres(const QList<PS_SphereSegment *> &detectedSph
 
         PS_SphereSegment *s1 = detectedSpheres.at(i); //get the first sphere
 
-        //qDebug() << "vor inner loop";
+        //the candidates are compared in the order of their position, so the result equals a comparison of all pairs
+        int lastCandidate = i;
+        bool isMerged = true;
+        while(isMerged){
 
-        //compare all sphere's params and merge them if they fit together
-        for(int j = i+1; j < detectedSpheres.size(); ++j){
+            isMerged = false;
 
-            //if the sphere at position j was merged before
-            if(mergeMap.value(j) == true){
-                continue;
-            }
+            //get all spheres with a nearby center (a merged sphere may have a main focus farther from its center)
+            int range = (int)qCeil(1.01f * (2.0f * maxRadius + PS_SphereSegment::getFocusOffset(s1)) / cellSize);
+            candidates.clear();
+            index.getCandidates(candidates, s1->getXYZ(), qMax(range, 1));
 
-            PS_SphereSegment *s2 = detectedSpheres.at(j); //get the second sphere
+            //compare the sphere's params with all candidates and merge them if they fit together
+            for(unsigned int c = 0; c < candidates.size(); ++c){
 
-            dCentroid2FocusS1 = qSqrt( (s2->getXYZ()[0] - s1->getMainFocus()[0]) * (s2->getXYZ()[0] - s1->getMainFocus()[0])
-                    + (s2->getXYZ()[1] - s1->getMainFocus()[1]) * (s2->getXYZ()[1] - s1->getMainFocus()[1])
-                    + (s2->getXYZ()[2] - s1->getMainFocus()[2]) * (s2->getXYZ()[2] - s1->getMainFocus()[2]) );
-            dCentroid2FocusS2 = qSqrt( (s1->getXYZ()[0] - s2->getMainFocus()[0]) * (s1->getXYZ()[0] - s2->getMainFocus()[0])
-                    + (s1->getXYZ()[1] - s2->getMainFocus()[1]) * (s1->getXYZ()[1] - s2->getMainFocus()[1])
-                    + (s1->getXYZ()[2] - s2->getMainFocus()[2]) * (s1->getXYZ()[2] - s2->getMainFocus()[2]) );
+                int j = candidates[c];
 
-            //qDebug() << "vor condition";
+                //if the sphere at position j was considered before or was merged before
+                if(j <= lastCandidate || mergeMap.value(j) == true){
+                    continue;
+                }
+                lastCandidate = j;
 
-            //if the main focus of the points on one sphere is inside the other sphere
-            if(dCentroid2FocusS1 <= 2.0*s2->getRadius() || dCentroid2FocusS2 <= 2.0*s1->getRadius()){
+                PS_SphereSegment *s2 = detectedSpheres.at(j); //get the second sphere
 
-                PS_SphereSegment *mergedSphere = new PS_SphereSegment();
-                mergedSphere->setIsValid(true);
-                foreach(PS_Point_PC *myPoint, s1->getPoints()){
-                    myPoint->isUsed = false;
-                    mergedSphere->addPoint(myPoint);
-                }
-                foreach(PS_Point_PC *myPoint, s2->getPoints()){
-                    myPoint->isUsed = false;
-                    mergedSphere->addPoint(myPoint);
-                }
+                statistics.numComparisons++;
 
-                if(dCentroid2FocusS1 < s2->getRadius()){
-                    mergedSphere->setApproximation(s2->getRadius(), s2->getXYZ()[0], s2->getXYZ()[1], s2->getXYZ()[2]);
-                }else{
-                    mergedSphere->setApproximation(s1->getRadius(), s1->getXYZ()[0], s1->getXYZ()[1], s1->getXYZ()[2]);
-                }
+                dCentroid2FocusS1 = qSqrt( (s2->getXYZ()[0] - s1->getMainFocus()[0]) * (s2->getXYZ()[0] - s1->getMainFocus()[0])
+                        + (s2->getXYZ()[1] - s1->getMainFocus()[1]) * (s2->getXYZ()[1] - s1->getMainFocus()[1])
+                        + (s2->getXYZ()[2] - s1->getMainFocus()[2]) * (s2->getXYZ()[2] - s1->getMainFocus()[2]) );
+                dCentroid2FocusS2 = qSqrt( (s1->getXYZ()[0] - s2->getMainFocus()[0]) * (s1->getXYZ()[0] - s2->getMainFocus()[0])
+                        + (s1->getXYZ()[1] - s2->getMainFocus()[1]) * (s1->getXYZ()[1] - s2->getMainFocus()[1])
+                        + (s1->getXYZ()[2] - s2->getMainFocus()[2]) * (s1->getXYZ()[2] - s2->getMainFocus()[2]) );
+
+                //qDebug() << "vor condition";
+
+                //if the main focus of the points on one sphere is inside the other sphere
+                if(dCentroid2FocusS1 <= 2.0*s2->getRadius() || dCentroid2FocusS2 <= 2.0*s1->getRadius()){
 
-                //qDebug() << "vor merge fit";
+                    PS_SphereSegment *mergedSphere = new PS_SphereSegment(s1->getPointStore());
+                    mergedSphere->setRandomSeed(s1->getRandomGenerator().next());
+                    mergedSphere->setIsValid(true);
+                    s1->setPointsUsed(false);
+                    s2->setPointsUsed(false);
+                    foreach(const quint32 &myPoint, s1->getPoints()){
+                        mergedSphere->addPoint(myPoint);
+                    }
+                    foreach(const quint32 &myPoint, s2->getPoints()){
+                        mergedSphere->addPoint(myPoint);
+                    }
 
-                //fit sphere and sort out points that do not satisfy the distance criterion
-                mergedSphere->fitBySample(param.fitSampleSize * 10);
+                    if(dCentroid2FocusS1 < s2->getRadius()){
+                        mergedSphere->setApproximation(s2->getRadius(), s2->getXYZ()[0], s2->getXYZ()[1], s2->getXYZ()[2]);
+                    }else{
+                        mergedSphere->setApproximation(s1->getRadius(), s1->getXYZ()[0], s1->getXYZ()[1], s1->getXYZ()[2]);
+                    }
 
-                //qDebug() << "nach merge fit";
+                    //qDebug() << "vor merge fit";
 
-                PS_SphereSegment::sortOut(mergedSphere, param, 3);
-                //mergedSphere->fitBySample(param.fitSampleSize);
+                    //fit sphere and sort out points that do not satisfy the distance criterion
+                    mergedSphere->fitBySample(param.fitSampleSize * 10);
 
-                //qDebug() << "vor final desision";
+                    //qDebug() << "nach merge fit";
 
-                //if the merged sphere's standard deviation is ok
-                if(mergedSphere->getIsValid() && mergedSphere->getSigma() <= param.sphereParams.maxDistance
-                        && mergedSphere->getRadius() <= param.sphereParams.maxRadius
-                        && mergedSphere->getRadius() >= param.sphereParams.minRadius
-                        && mergedSphere->getPoints().size() > s1->getPoints().size()
-                        && mergedSphere->getPoints().size() > s2->getPoints().size()){
+                    PS_SphereSegment::sortOut(mergedSphere, param, 3);
+                    //mergedSphere->fitBySample(param.fitSampleSize);
 
-                    //delete single spheres
-                    delete s1;
-                    delete s2;
+                    //qDebug() << "vor final desision";
 
-                    //set the sphere to be merged
-                    mergeMap.insert(j, true);
+                    //if the merged sphere's standard deviation is ok
+                    if(mergedSphere->getIsValid() && mergedSphere->getSigma() <= param.sphereParams.maxDistance
+                            && mergedSphere->getRadius() <= param.sphereParams.maxRadius
+                            && mergedSphere->getRadius() >= param.sphereParams.minRadius
+                            && mergedSphere->getPoints().size() > s1->getPoints().size()
+                            && mergedSphere->getPoints().size() > s2->getPoints().size()){
 
-                    s1 = mergedSphere;
+                        //delete single spheres
+                        delete s1;
+                        delete s2;
+
+                        //set the sphere to be merged
+                        mergeMap.insert(j, true);
+                        statistics.numMerges++;
+
+                        s1 = mergedSphere;
+
+                        //the merged sphere has new parameters, so its candidates have to be queried again
+                        isMerged = true;
+                        break;
+
+                    }else{
+                        delete mergedSphere;
+                    }
 
-                }else{
-                    delete mergedSphere;
                 }
 
             }
@@ -827,6 +771,20 @@ void PS_SphereSegment::mergeSpheres(const QList<PS_SphereSegment *> &detectedSph
 
     }
 
+    statistics.elapsedTime = timer.elapsed();
+
+}
+
+/*!
+ * \brief PS_SphereSegment::getFocusOffset
+ * Returns the distance of the main focus of the sphere from its center
+ * \param s
+ * \return
+ */
+float PS_SphereSegment::getFocusOffset(const PS_SphereSegment *s){
+    float *focus = s->getMainFocus();
+    float *center = s->getXYZ();
+    return qSqrt( (focus[0]-center[0])*(focus[0]-center[0]) + (focus[1]-center[1])*(focus[1]-center[1]) + (focus[2]-center[2])*(focus[2]-center[2]) );
 }
 
 /*!
@@ -841,7 +799,7 @@ void PS_SphereSegment::reviewNodes(const QList<PS_SphereSegment *> &detectedSphe
     int numAdded = 0; //number of added points
 
     //list to save all unmerged points of each node
-    QList<PS_Point_PC *> unmergedPoints;
+    vector<quint32> unmergedPoints;
 
     foreach(PS_SphereSegment *s, detectedSpheres){
 
@@ -849,11 +807,11 @@ void PS_SphereSegment::reviewNodes(const QList<PS_SphereSegment *> &detectedSphe
         foreach(PS_Node *n, s->getUsedNodes()){
 
             //try to add points that were not added yet
-            n->getUnmergedPoints(unmergedPoints);
+            n->getUnmergedPoints(unmergedPoints, s->getPointStore());
             numAdded = PS_SphereSegment::checkPointsInSphere(s, unmergedPoints, param, 3);
-            QList<PS_Point_PC *> spherePoints = s->getPoints();
+            const vector<quint32> &spherePoints = s->getPoints();
             for(int i = 0; i < numAdded; ++i){
-                spherePoints.at(spherePoints.size()-1-i)->isUsed = true;
+                s->getPointStore()->setUsed(spherePoints[spherePoints.size()-1-i], true);
             }
 
             if(numAdded > 0){
@@ -888,75 +846,16 @@ void PS_SphereSegment::reviewNodes(const QList<PS_SphereSegment *> &detectedSphe
  */
 void PS_SphereSegment::verifySpheres(const QList<PS_SphereSegment *> &detectedSpheres, QList<PS_SphereSegment *> &verifiedSpheres, const PS_InputParameter &param){
 
-    //initialize variables
-    double centroid[3]; //main focus of sphere points
-    //vector<OiVec> crCoord; //centroid reduced coordinates
-    int numPoints;
-    double eVal; //smallest eigen-value
-    double planeSigma; //sigma of a fitted plane
-    OiMat ata(3,3);
-
+    /*
+     * the standard deviation of a plane through the shape points is derived from the running sums of the points,
+     * so no shape points have to be iterated here
+     */
     foreach(PS_SphereSegment *sphere, detectedSpheres){
-
-        //crCoord.clear();
-
-        numPoints = sphere->getPointCount();
-
-        //calc centroid of sphere points
-        centroid[0] = 0.0;
-        centroid[1] = 0.0;
-        centroid[2] = 0.0;
-        for(unsigned int i = 0; i < numPoints; ++i){
-            PS_Point_PC *p = sphere->getPoints().at(i);
-            centroid[0] += p->xyz[0];
-            centroid[1] += p->xyz[1];
-            centroid[2] += p->xyz[2];
-        }
-        centroid[0] = centroid[0] / (double)numPoints;
-        centroid[1] = centroid[1] / (double)numPoints;
-        centroid[2] = centroid[2] / (double)numPoints;
-
-        //calc centroid reduced coordinates
-        /*for(unsigned int i = 0; i < numPoints; ++i){
-            PS_Point_PC *p = sphere->getPoints().at(i);
-            PS_SphereSegment::verify_xyz.setAt(0, p->xyz[0] - centroid[0]);
-            PS_SphereSegment::verify_xyz.setAt(1, p->xyz[1] - centroid[1]);
-            PS_SphereSegment::verify_xyz.setAt(2, p->xyz[2] - centroid[2]);
-            crCoord.push_back( PS_SphereSegment::verify_xyz );
-        }*/
-
-        double value = 0.0;
-        for(int i = 0; i < 3; ++i){
-            for(int j = 0; j < 3; ++j){
-                value = 0.0;
-                for(unsigned int k = 0; k < numPoints; ++k){
-                    PS_Point_PC *p = sphere->getPoints().at(k);
-                    value += (p->xyz[i] - centroid[i]) * (p->xyz[j] - centroid[j]);
-                }
-                ata.setAt(i, j, value);
-            }
-        }
-
-        ata.svd(PS_SphereSegment::verify_u, PS_SphereSegment::verify_d, PS_SphereSegment::verify_v);
-
-        eVal = numeric_limits<double>::max();
-        for(int i = 0; i < 3; ++i){
-            if(PS_SphereSegment::verify_d.getAt(i) < eVal){
-                eVal = PS_SphereSegment::verify_d.getAt(i);
-            }
-        }
-
-        planeSigma = qSqrt(eVal / (double)(numPoints - 3.0));
-
-        if( 3.0 * planeSigma > sphere->getSigma()){//3.0*param.sphereParams.maxDistance ){
-
-            //qDebug() << "sigma plane " << planeSigma;
+        if( 3.0 * sphere->getPlaneSigma() > sphere->getSigma()){//3.0*param.sphereParams.maxDistance ){
             verifiedSpheres.append(sphere);
-
         }else{
             delete sphere;
         }
-
     }
 
 }
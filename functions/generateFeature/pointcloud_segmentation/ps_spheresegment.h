@@ -3,15 +3,20 @@
 
 #include <QList>
 #include <QtMath>
+#include <QElapsedTimer>
 #include <math.h>
 
 #include "oivec.h"
 #include "oimat.h"
+#include "fixedmatrix.h"
 
 #include "ps_pointcloud.h"
 #include "ps_generalmath.h"
-#include "ps_point_pc.h"
+#include "ps_pointstore.h"
 #include "ps_shapesegment.h"
+#include "ps_distancekernels.h"
+#include "ps_ransac.h"
+#include "ps_mergeindex.h"
 
 //! \brief sphere specific attributes
 struct SphereState : ShapeState{
@@ -57,15 +62,18 @@ class PS_SphereSegment : public PS_ShapeSegment
 {
 
 public:
-    PS_SphereSegment();
+    PS_SphereSegment(PS_PointStore *store);
     ~PS_SphereSegment();
 
     bool writeToX3D(const QString &filePath);
 
     void fit();
     void fitBySample(int numPoints);
+    void fitByMoments();
 
-    void minimumSolution(const QList<PS_Point_PC *> &points);
+    void minimumSolution(const vector<quint32> &points);
+    bool isPlausible(const PS_InputParameter &param) const;
+    unsigned int checkInliers(const quint32 *points, const unsigned int &count, const float &threshold, unsigned char *mask) const;
 
     //! \brief Returns the radius of the sphere
     inline float getRadius() const{
@@ -79,33 +87,17 @@ public:
 
     void setApproximation(const float &radius, const float &x, const float &y, const float &z);
 
-    static PS_SphereSegment *detectSphere(const QList<PS_Point_PC*> &points, const PS_InputParameter &param);
-    static int checkPointsInSphere(PS_SphereSegment *mySphere, const QList<PS_Point_PC*> &myPoints, const PS_InputParameter &param, const int &toleranceFactor); //check wether a point is in the given sphere
+    static PS_SphereSegment *detectSphere(PS_PointStore *store, const vector<quint32> &points, const PS_InputParameter &param, PS_Random &generator);
+    static int checkPointsInSphere(PS_SphereSegment *mySphere, const vector<quint32> &myPoints, const PS_InputParameter &param, const int &toleranceFactor,
+                                   vector<unsigned char> *inlierMask = NULL); //check wether a point is in the given sphere
     static void sortOut(PS_SphereSegment *mySphere, const PS_InputParameter &param, const int &toleranceFactor);
-    static void mergeSpheres(const QList<PS_SphereSegment *> &detectedSpheres, QList<PS_SphereSegment *> &mergedSpheres, const PS_InputParameter &param);
+    static void mergeSpheres(const QList<PS_SphereSegment *> &detectedSpheres, QList<PS_SphereSegment *> &mergedSpheres, const PS_InputParameter &param, PS_MergeStatistics &statistics,
+                             const bool &compareAllPairs = false);
     static void reviewNodes(const QList<PS_SphereSegment *> &detectedSpheres, const PS_InputParameter &param);
     static void verifySpheres(const QList<PS_SphereSegment *> &detectedSpheres, QList<PS_SphereSegment *> &verifiedSpheres, const PS_InputParameter &param);
 
 private:
-    //fitting helpers (static to not have to instanciate every time)
-
-    //minimum solution of a sphere
-    static OiMat min_A;
-    static OiMat min_AReplaced;
-    static OiVec min_C;
-    static OiVec min_X;
-
-    //fitting of a sphere
-    static OiMat fitting_N;
-    static OiVec fitting_n;
-    static OiMat fitting_Q;
-    static OiVec fitting_a;
-    static OiVec fitting_x;
-
-    //sphere verification
-    static OiMat verify_u;
-    static OiMat verify_v;
-    static OiVec verify_d;
+    static float getFocusOffset(const PS_SphereSegment *s);
 
     //current sphere state pointer to access special sphere attributes
     SphereState *mySphereState;
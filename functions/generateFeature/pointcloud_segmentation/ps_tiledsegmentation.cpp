@@ -0,0 +1,681 @@
+#include "ps_tiledsegmentation.h"
+
+#include <cmath>
+#include <limits>
+
+#include "ps_planesegment.h"
+#include "ps_spheresegment.h"
+#include "ps_cylindersegment.h"
+
+const int PS_TiledSegmentation::resolution;
+const quint64 PS_TiledSegmentation::bytesPerPoint;
+const unsigned int PS_TiledSegmentation::maxShapePoints;
+const unsigned int PS_TiledSegmentation::tileBufferSize;
+
+PS_TiledSegmentation::PS_TiledSegmentation(QObject *parent) : QObject(parent)
+{
+    this->memoryBudget = Q_UINT64_C(1) << 30;
+    this->overlap = 0.0f;
+    this->canceled = NULL;
+    this->numPoints = 0;
+    this->shapePoints = new PS_PointStore();
+}
+
+PS_TiledSegmentation::~PS_TiledSegmentation()
+{
+    this->clear();
+    delete this->shapePoints;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::setMemoryBudget
+ * Set the memory in bytes that may be used to segment one tile
+ * \param memoryBudget
+ */
+void PS_TiledSegmentation::setMemoryBudget(const quint64 &memoryBudget){
+    this->memoryBudget = memoryBudget;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::setOverlap
+ * Set the distance by which each tile is extended into its neighbours. Shapes that are smaller than the overlap are detected
+ * completely in at least one tile, so it should be about the size of the largest sphere or cylinder that shall be detected.
+ * \param overlap
+ */
+void PS_TiledSegmentation::setOverlap(const float &overlap){
+    this->overlap = qMax(overlap, 0.0f);
+}
+
+/*!
+ * \brief PS_TiledSegmentation::setCancelFlag
+ * Set a flag that is polled during the segmentation (see PS_PointCloud::setCancelFlag)
+ * \param canceled
+ */
+void PS_TiledSegmentation::setCancelFlag(const QAtomicInt *canceled){
+    this->canceled = canceled;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::getDetectedPlanes
+ * Returns the planes of the last segmentation. Each shape keeps at most maxShapePoints (10000) evenly spaced points per tile
+ * that it was detected in (enough to fit and stitch it), so the number of points of a shape is not the number of points of
+ * the cloud that lie on it. The points are stored in a store of this object, not in the input file.
+ * \return
+ */
+const QList<PS_PlaneSegment *> &PS_TiledSegmentation::getDetectedPlanes() const{
+    return this->detectedPlanes;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::getDetectedSpheres
+ * Returns the spheres of the last segmentation (at most maxShapePoints points per tile, see getDetectedPlanes)
+ * \return
+ */
+const QList<PS_SphereSegment *> &PS_TiledSegmentation::getDetectedSpheres() const{
+    return this->detectedSpheres;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::getDetectedCylinders
+ * Returns the cylinders of the last segmentation (at most maxShapePoints points per tile, see getDetectedPlanes)
+ * \return
+ */
+const QList<PS_CylinderSegment *> &PS_TiledSegmentation::getDetectedCylinders() const{
+    return this->detectedCylinders;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::segment
+ * Segment the point cloud file tile by tile
+ * \param fileName
+ * \param param
+ * \return false if the file cannot be read or the tiles cannot be written
+ */
+bool PS_TiledSegmentation::segment(const QString &fileName, PS_InputParameter param){
+
+    this->clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    PS_PointCloudReader reader(fileName, 64 << 20, param.numThreads);
+    if(!reader.open()){
+        emit this->updateStatus(QString("Cannot open %1").arg(fileName), 0);
+        return false;
+    }
+
+    //first pass: bounding box and histogram of the points
+    if(!this->computeHistogram(reader)){
+        reader.close();
+        return false;
+    }
+    emit this->updateStatus(QString("%1 points read, splitting them into tiles...").arg(this->numPoints), 10);
+
+    //split the cloud until each tile (including its overlap) fits into the memory budget
+    const quint64 maxTilePoints = qMax(this->memoryBudget / PS_TiledSegmentation::bytesPerPoint, (quint64)1000);
+    const quint32 cellMin[3] = {0, 0, 0};
+    const quint32 cellMax[3] = {PS_TiledSegmentation::resolution, PS_TiledSegmentation::resolution, PS_TiledSegmentation::resolution};
+    this->splitTiles(cellMin, cellMax, maxTilePoints);
+    this->setUpCellTiles();
+
+    //second pass: write the points of each tile to a temporary file
+    QTemporaryDir tileDir;
+    if(!tileDir.isValid()){
+        emit this->updateStatus("Cannot create a temporary directory for the tiles", 10);
+        reader.close();
+        return false;
+    }
+    reader.rewind();
+    bool success = this->writeTiles(reader, tileDir.path());
+    reader.close();
+    if(!success){
+        emit this->updateStatus("Cannot write the tiles", 20);
+        return false;
+    }
+    emit this->updateStatus(QString("Points written to %1 tiles in %2 ms").arg(this->tiles.size()).arg(timer.elapsed()), 20);
+
+    //segment the tiles one after the other, so that only one tile is in memory at once
+    quint64 numConsumedPoints = 0;
+    for(unsigned int i = 0; i < this->tiles.size(); i++){
+
+        if(this->isStopRequested(param, timer)){
+            emit this->updateStatus(QString("Segmentation stopped after %1 of %2 tiles").arg(i).arg(this->tiles.size()), 95);
+            break;
+        }
+
+        //each tile may use the remaining time (the shapes of the tiles are post-processed, because they are stitched before they are reported)
+        PS_InputParameter tileParam = param;
+        tileParam.streamShapes = false;
+        if(param.timeBudget > 0.0){
+            tileParam.timeBudget = qMax(param.timeBudget - timer.elapsed() / 1000.0, 0.001);
+        }
+        this->segmentTile(i, tileParam);
+        QFile::remove(this->tiles[i].fileName);
+
+        numConsumedPoints += this->tiles[i].numCorePoints;
+        double fraction = (this->numPoints > 0) ? (double)numConsumedPoints / (double)this->numPoints : 1.0;
+        emit this->updateProgress(fraction);
+        emit this->updateStatus(QString("%1 of %2 tiles segmented (%3 planes, %4 spheres, %5 cylinders)").arg(i + 1).arg(this->tiles.size())
+                                .arg(this->detectedPlanes.size()).arg(this->detectedSpheres.size()).arg(this->detectedCylinders.size()),
+                                20 + (int)(75.0 * fraction));
+
+    }
+
+    //merge the parts of shapes that cross tile borders
+    this->stitchShapes(param);
+
+    emit this->updateStatus(QString("Segmentation done in %1 ms: %2 planes, %3 spheres and %4 cylinders").arg(timer.elapsed())
+                            .arg(this->detectedPlanes.size()).arg(this->detectedSpheres.size()).arg(this->detectedCylinders.size()), 99);
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::computeHistogram
+ * Read all points to get the bounding box, then read them again to count the points per histogram cell
+ * \param reader
+ * \return
+ */
+bool PS_TiledSegmentation::computeHistogram(PS_PointCloudReader &reader){
+
+    vector<PS_LoaderChunk> chunks;
+
+    //bounding box
+    for(int k = 0; k < 3; k++){
+        this->myBoundingBox.min[k] = numeric_limits<float>::max();
+        this->myBoundingBox.max[k] = -numeric_limits<float>::max();
+    }
+    this->numPoints = 0;
+    while(reader.readNext(chunks)){
+        for(unsigned int i = 0; i < chunks.size(); i++){
+            if(chunks[i].x.size() > 0){
+                for(int k = 0; k < 3; k++){
+                    this->myBoundingBox.min[k] = qMin(this->myBoundingBox.min[k], chunks[i].min[k]);
+                    this->myBoundingBox.max[k] = qMax(this->myBoundingBox.max[k], chunks[i].max[k]);
+                }
+                this->numPoints += chunks[i].x.size();
+            }
+        }
+    }
+    if(this->numPoints == 0){
+        emit this->updateStatus("The point cloud does not contain any points", 0);
+        return false;
+    }
+    for(int k = 0; k < 3; k++){
+        this->cellSize[k] = qMax((this->myBoundingBox.max[k] - this->myBoundingBox.min[k]) / (float)PS_TiledSegmentation::resolution,
+                                 numeric_limits<float>::min());
+    }
+
+    //number of points per cell
+    const int r = PS_TiledSegmentation::resolution;
+    vector<quint64> histogram(r * r * r, 0);
+    reader.rewind();
+    while(reader.readNext(chunks)){
+        for(unsigned int i = 0; i < chunks.size(); i++){
+            const PS_LoaderChunk &chunk = chunks[i];
+            for(unsigned int j = 0; j < chunk.x.size(); j++){
+                histogram[this->getCell(chunk.x[j], chunk.y[j], chunk.z[j])]++;
+            }
+        }
+    }
+
+    //summed area table, so that the points of any cell box can be counted in constant time
+    const int s = r + 1;
+    this->summedHistogram.assign(s * s * s, 0);
+    for(int z = 1; z < s; z++){
+        for(int y = 1; y < s; y++){
+            for(int x = 1; x < s; x++){
+                this->summedHistogram[(z * s + y) * s + x] = histogram[((z - 1) * r + (y - 1)) * r + (x - 1)]
+                        + this->summedHistogram[((z - 1) * s + y) * s + x] + this->summedHistogram[(z * s + y - 1) * s + x]
+                        + this->summedHistogram[(z * s + y) * s + x - 1] - this->summedHistogram[((z - 1) * s + y - 1) * s + x]
+                        - this->summedHistogram[((z - 1) * s + y) * s + x - 1] - this->summedHistogram[(z * s + y - 1) * s + x - 1]
+                        + this->summedHistogram[((z - 1) * s + y - 1) * s + x - 1];
+            }
+        }
+    }
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::countPoints
+ * Returns the number of points in the cells cellMin until cellMax (exclusive)
+ * \param cellMin
+ * \param cellMax
+ * \return
+ */
+quint64 PS_TiledSegmentation::countPoints(const quint32 cellMin[3], const quint32 cellMax[3]) const{
+    const int s = PS_TiledSegmentation::resolution + 1;
+    const vector<quint64> &h = this->summedHistogram;
+    const quint32 x0 = cellMin[0], y0 = cellMin[1], z0 = cellMin[2];
+    const quint32 x1 = cellMax[0], y1 = cellMax[1], z1 = cellMax[2];
+    return h[(z1 * s + y1) * s + x1] - h[(z0 * s + y1) * s + x1] - h[(z1 * s + y0) * s + x1] - h[(z1 * s + y1) * s + x0]
+            + h[(z0 * s + y0) * s + x1] + h[(z0 * s + y1) * s + x0] + h[(z1 * s + y0) * s + x0] - h[(z0 * s + y0) * s + x0];
+}
+
+/*!
+ * \brief PS_TiledSegmentation::splitTiles
+ * Recursively split the cell box at the median of its points along its longest axis until the points of the box
+ * (including the overlap) fit into the memory budget
+ * \param cellMin
+ * \param cellMax
+ * \param maxTilePoints
+ */
+void PS_TiledSegmentation::splitTiles(const quint32 cellMin[3], const quint32 cellMax[3], const quint64 &maxTilePoints){
+
+    //box of the tile including the overlap (in cells)
+    quint32 outerMin[3], outerMax[3];
+    for(int k = 0; k < 3; k++){
+        quint32 overlapCells = (quint32)std::ceil(this->overlap / this->cellSize[k]);
+        outerMin[k] = (cellMin[k] > overlapCells) ? cellMin[k] - overlapCells : 0;
+        outerMax[k] = qMin(cellMax[k] + overlapCells, (quint32)PS_TiledSegmentation::resolution);
+    }
+
+    //split along the longest axis that consists of more than one cell
+    int axis = -1;
+    float longest = 0.0f;
+    for(int k = 0; k < 3; k++){
+        float length = (cellMax[k] - cellMin[k]) * this->cellSize[k];
+        if(cellMax[k] - cellMin[k] > 1 && length > longest){
+            longest = length;
+            axis = k;
+        }
+    }
+
+    quint64 numCorePoints = this->countPoints(cellMin, cellMax);
+    if(numCorePoints == 0){
+        return;
+    }
+
+    if(axis < 0 || this->countPoints(outerMin, outerMax) <= maxTilePoints){
+        PS_Tile tile;
+        for(int k = 0; k < 3; k++){
+            tile.cellMin[k] = cellMin[k];
+            tile.cellMax[k] = cellMax[k];
+            tile.min[k] = this->myBoundingBox.min[k] + cellMin[k] * this->cellSize[k] - this->overlap;
+            tile.max[k] = this->myBoundingBox.min[k] + cellMax[k] * this->cellSize[k] + this->overlap;
+        }
+        this->tiles.push_back(tile);
+        return;
+    }
+
+    //first cell boundary at which the lower part contains at least half of the points
+    quint32 lowerMax[3] = {cellMax[0], cellMax[1], cellMax[2]};
+    quint32 split = cellMin[axis] + 1;
+    for(; split < cellMax[axis] - 1; split++){
+        lowerMax[axis] = split;
+        if(2 * this->countPoints(cellMin, lowerMax) >= numCorePoints){
+            break;
+        }
+    }
+
+    quint32 upperMin[3] = {cellMin[0], cellMin[1], cellMin[2]};
+    lowerMax[axis] = split;
+    upperMin[axis] = split;
+    this->splitTiles(cellMin, lowerMax, maxTilePoints);
+    this->splitTiles(upperMin, cellMax, maxTilePoints);
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::setUpCellTiles
+ * Assign each cell to the tile whose core region contains it and list the other tiles whose overlap reaches into the cell
+ */
+void PS_TiledSegmentation::setUpCellTiles(){
+
+    const int r = PS_TiledSegmentation::resolution;
+    this->cellTiles.assign(r * r * r, -1);
+    vector<quint32> numOverlaps(r * r * r + 1, 0);
+
+    //first count the overlapping tiles of each cell, then fill them in
+    for(int pass = 0; pass < 2; pass++){
+        for(unsigned int t = 0; t < this->tiles.size(); t++){
+            const PS_Tile &tile = this->tiles[t];
+            quint32 outerMin[3], outerMax[3];
+            for(int k = 0; k < 3; k++){
+                quint32 overlapCells = (quint32)std::ceil(this->overlap / this->cellSize[k]);
+                outerMin[k] = (tile.cellMin[k] > overlapCells) ? tile.cellMin[k] - overlapCells : 0;
+                outerMax[k] = qMin(tile.cellMax[k] + overlapCells, (quint32)r);
+            }
+            for(quint32 z = outerMin[2]; z < outerMax[2]; z++){
+                for(quint32 y = outerMin[1]; y < outerMax[1]; y++){
+                    for(quint32 x = outerMin[0]; x < outerMax[0]; x++){
+                        quint32 cell = (z * r + y) * r + x;
+                        bool isCore = x >= tile.cellMin[0] && x < tile.cellMax[0] && y >= tile.cellMin[1] && y < tile.cellMax[1]
+                                && z >= tile.cellMin[2] && z < tile.cellMax[2];
+                        if(isCore){
+                            this->cellTiles[cell] = t;
+                        }else if(pass == 0){
+                            numOverlaps[cell + 1]++;
+                        }else{
+                            this->cellOverlapTiles[numOverlaps[cell]++] = t;
+                        }
+                    }
+                }
+            }
+        }
+        if(pass == 0){
+            for(int i = 0; i < r * r * r; i++){
+                numOverlaps[i + 1] += numOverlaps[i];
+            }
+            this->cellOverlapOffsets = numOverlaps;
+            this->cellOverlapTiles.resize(numOverlaps[r * r * r]);
+        }
+    }
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::writeTiles
+ * Read all points and append each one to the file of its tile and to the files of all tiles whose overlap contains it
+ * \param reader
+ * \param tileDir
+ * \return
+ */
+bool PS_TiledSegmentation::writeTiles(PS_PointCloudReader &reader, const QString &tileDir){
+
+    for(unsigned int t = 0; t < this->tiles.size(); t++){
+        PS_Tile &tile = this->tiles[t];
+        tile.fileName = QString("%1/tile_%2.bin").arg(tileDir).arg(t);
+        tile.buffer.reserve(3 * PS_TiledSegmentation::tileBufferSize);
+        QFile file(tile.fileName);
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+            return false;
+        }
+        file.close();
+    }
+
+    vector<PS_LoaderChunk> chunks;
+    while(reader.readNext(chunks)){
+        for(unsigned int i = 0; i < chunks.size(); i++){
+            const PS_LoaderChunk &chunk = chunks[i];
+            for(unsigned int j = 0; j < chunk.x.size(); j++){
+
+                const float x = chunk.x[j], y = chunk.y[j], z = chunk.z[j];
+                const quint32 cell = this->getCell(x, y, z);
+
+                //core tile
+                PS_Tile &tile = this->tiles[this->cellTiles[cell]];
+                tile.buffer.push_back(x);
+                tile.buffer.push_back(y);
+                tile.buffer.push_back(z);
+                tile.numCorePoints++;
+                if(tile.buffer.size() >= 3 * PS_TiledSegmentation::tileBufferSize && !this->flushTile(tile)){
+                    return false;
+                }
+
+                //tiles whose overlap contains the point
+                for(quint32 o = this->cellOverlapOffsets[cell]; o < this->cellOverlapOffsets[cell + 1]; o++){
+                    PS_Tile &neighbour = this->tiles[this->cellOverlapTiles[o]];
+                    if(x < neighbour.min[0] || x > neighbour.max[0] || y < neighbour.min[1] || y > neighbour.max[1]
+                            || z < neighbour.min[2] || z > neighbour.max[2]){
+                        continue;
+                    }
+                    neighbour.buffer.push_back(x);
+                    neighbour.buffer.push_back(y);
+                    neighbour.buffer.push_back(z);
+                    if(neighbour.buffer.size() >= 3 * PS_TiledSegmentation::tileBufferSize && !this->flushTile(neighbour)){
+                        return false;
+                    }
+                }
+
+            }
+        }
+    }
+
+    for(unsigned int t = 0; t < this->tiles.size(); t++){
+        if(!this->flushTile(this->tiles[t])){
+            return false;
+        }
+        vector<float>().swap(this->tiles[t].buffer);
+    }
+
+    return true;
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::flushTile
+ * Append the buffered points of the tile to its file
+ * \param tile
+ * \return
+ */
+bool PS_TiledSegmentation::flushTile(PS_Tile &tile){
+
+    if(tile.buffer.empty()){
+        return true;
+    }
+
+    QFile file(tile.fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Append)){
+        return false;
+    }
+    qint64 numBytes = tile.buffer.size() * sizeof(float);
+    bool success = file.write((const char *)tile.buffer.data(), numBytes) == numBytes;
+    file.close();
+
+    tile.numPoints += tile.buffer.size() / 3;
+    tile.buffer.clear();
+
+    return success;
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::loadTile
+ * Read the points of the tile file into the store
+ * \param tile
+ * \param store
+ * \param bbox
+ * \return
+ */
+bool PS_TiledSegmentation::loadTile(const PS_Tile &tile, PS_PointStore *store, PS_BoundingBox_PC &bbox) const{
+
+    QFile file(tile.fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    for(int k = 0; k < 3; k++){
+        bbox.min[k] = numeric_limits<float>::max();
+        bbox.max[k] = -numeric_limits<float>::max();
+    }
+
+    const quint32 blockSize = 65536;
+    vector<float> block(3 * blockSize);
+    vector<float> x(blockSize), y(blockSize), z(blockSize);
+    store->reserve((quint32)tile.numPoints);
+
+    quint64 numRead = 0;
+    while(numRead < tile.numPoints){
+        quint32 count = (quint32)qMin((quint64)blockSize, tile.numPoints - numRead);
+        qint64 numBytes = 3 * count * sizeof(float);
+        if(file.read((char *)block.data(), numBytes) != numBytes){
+            file.close();
+            return false;
+        }
+        for(quint32 i = 0; i < count; i++){
+            x[i] = block[3*i];
+            y[i] = block[3*i+1];
+            z[i] = block[3*i+2];
+            bbox.min[0] = qMin(bbox.min[0], x[i]);
+            bbox.min[1] = qMin(bbox.min[1], y[i]);
+            bbox.min[2] = qMin(bbox.min[2], z[i]);
+            bbox.max[0] = qMax(bbox.max[0], x[i]);
+            bbox.max[1] = qMax(bbox.max[1], y[i]);
+            bbox.max[2] = qMax(bbox.max[2], z[i]);
+        }
+        store->append(x.data(), y.data(), z.data(), count);
+        numRead += count;
+    }
+
+    file.close();
+    return true;
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::segmentTile
+ * Segment the points of one tile and keep the core points of all detected shapes
+ * \param tileIndex
+ * \param param
+ */
+void PS_TiledSegmentation::segmentTile(const int &tileIndex, const PS_InputParameter &param){
+
+    const PS_Tile &tile = this->tiles[tileIndex];
+    if(tile.numCorePoints == 0){
+        return;
+    }
+
+    //the point store addresses the points with 32 bit indices
+    if(tile.numPoints > 0xFFFFFFFF){
+        emit this->updateStatus(QString("Tile %1 is skipped, because it contains %2 points (at most %3 points per tile are supported, "
+                                        "use a smaller memory budget)").arg(tileIndex).arg(tile.numPoints).arg(0xFFFFFFFF), 0);
+        return;
+    }
+
+    PS_PointStore *store = new PS_PointStore();
+    PS_BoundingBox_PC bbox;
+    if(!this->loadTile(tile, store, bbox) || store->size() <= 10){
+        delete store;
+        return;
+    }
+
+    PS_PointCloud cloud;
+    cloud.setCloud(store, bbox);
+    cloud.setWriteOutput(false);
+    cloud.setCancelFlag(this->canceled);
+    cloud.setUpOctree(param);
+    cloud.detectShapes(param);
+
+    foreach(PS_PlaneSegment *p, cloud.getDetectedPlanes()){
+        PS_PlaneSegment *plane = new PS_PlaneSegment(this->shapePoints);
+        if(this->takeShape(p, plane, tileIndex)){
+            this->detectedPlanes.append(plane);
+        }else{
+            delete plane;
+        }
+        delete p;
+    }
+    foreach(PS_SphereSegment *s, cloud.getDetectedSpheres()){
+        PS_SphereSegment *sphere = new PS_SphereSegment(this->shapePoints);
+        if(this->takeShape(s, sphere, tileIndex)){
+            this->detectedSpheres.append(sphere);
+        }else{
+            delete sphere;
+        }
+        delete s;
+    }
+    foreach(PS_CylinderSegment *c, cloud.getDetectedCylinders()){
+        PS_CylinderSegment *cylinder = new PS_CylinderSegment(this->shapePoints);
+        if(this->takeShape(c, cylinder, tileIndex)){
+            this->detectedCylinders.append(cylinder);
+        }else{
+            delete cylinder;
+        }
+        delete c;
+    }
+
+    cloud.deleteOctree();
+    delete store;
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::takeShape
+ * Copy the parameters and the core points of a shape of a tile to a shape in the shape store. At most maxShapePoints evenly
+ * spaced points are kept. The shape is refit with the kept points.
+ * \param source
+ * \param target
+ * \param tileIndex
+ * \return false if the shape has (almost) no points in the core region of the tile
+ */
+bool PS_TiledSegmentation::takeShape(PS_ShapeSegment *source, PS_ShapeSegment *target, const int &tileIndex){
+
+    const PS_PointStore *store = source->getPointStore();
+    const vector<quint32> &points = source->getPoints();
+
+    //the points of the overlap are taken from the neighbouring tiles
+    vector<quint32> corePoints;
+    corePoints.reserve(points.size());
+    for(unsigned int i = 0; i < points.size(); i++){
+        const quint32 p = points[i];
+        if(this->cellTiles[this->getCell(store->getX(p), store->getY(p), store->getZ(p))] == tileIndex){
+            corePoints.push_back(p);
+        }
+    }
+    if(corePoints.size() <= 10){
+        return false;
+    }
+
+    target->copyState(*source);
+    target->setRandomSeed(source->getRandomGenerator().next());
+    const double step = qMax((double)corePoints.size() / (double)PS_TiledSegmentation::maxShapePoints, 1.0);
+    for(double i = 0.0; i < (double)corePoints.size(); i += step){
+        const quint32 p = corePoints[(unsigned int)i];
+        target->addPoint(this->shapePoints->append(store->getX(p), store->getY(p), store->getZ(p)));
+    }
+
+    target->fit();
+    return target->getIsValid();
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::stitchShapes
+ * Merge the parts of shapes that were detected in several tiles
+ * \param param
+ */
+void PS_TiledSegmentation::stitchShapes(const PS_InputParameter &param){
+
+    PS_MergeStatistics sphereStatistics, cylinderStatistics, planeStatistics;
+
+    QList<PS_SphereSegment *> mergedSpheres;
+    PS_SphereSegment::mergeSpheres(this->detectedSpheres, mergedSpheres, param, sphereStatistics);
+    this->detectedSpheres = mergedSpheres;
+
+    QList<PS_CylinderSegment *> mergedCylinders;
+    PS_CylinderSegment::mergeCylinders(this->detectedCylinders, mergedCylinders, param, cylinderStatistics);
+    this->detectedCylinders = mergedCylinders;
+
+    QList<PS_PlaneSegment *> mergedPlanes;
+    PS_PlaneSegment::mergePlanes(this->detectedPlanes, mergedPlanes, param, planeStatistics);
+    this->detectedPlanes = mergedPlanes;
+
+    emit this->updateStatus(QString("Stitched %1 of %2 spheres, %3 of %4 cylinders and %5 of %6 planes across tile borders")
+                            .arg(sphereStatistics.numMerges).arg(sphereStatistics.numShapes).arg(cylinderStatistics.numMerges)
+                            .arg(cylinderStatistics.numShapes).arg(planeStatistics.numMerges).arg(planeStatistics.numShapes), 99);
+
+}
+
+/*!
+ * \brief PS_TiledSegmentation::clear
+ * Delete the shapes and tiles of the last segmentation
+ */
+void PS_TiledSegmentation::clear(){
+    qDeleteAll(this->detectedPlanes);
+    qDeleteAll(this->detectedSpheres);
+    qDeleteAll(this->detectedCylinders);
+    this->detectedPlanes.clear();
+    this->detectedSpheres.clear();
+    this->detectedCylinders.clear();
+    this->shapePoints->clear();
+    this->tiles.clear();
+    this->numPoints = 0;
+}
+
+/*!
+ * \brief PS_TiledSegmentation::isStopRequested
+ * Check wether no further tiles shall be segmented (canceled or time budget exceeded)
+ * \param param
+ * \param timer
+ * \return
+ */
+bool PS_TiledSegmentation::isStopRequested(const PS_InputParameter &param, const QElapsedTimer &timer) const{
+    if(this->canceled != NULL && this->canceled->loadAcquire() != 0){
+        return true;
+    }
+    return param.timeBudget > 0.0 && timer.elapsed() > (qint64)(param.timeBudget * 1000.0);
+}
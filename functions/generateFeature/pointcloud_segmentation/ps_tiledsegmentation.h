@@ -0,0 +1,127 @@
+#ifndef PS_TILEDSEGMENTATION_H
+#define PS_TILEDSEGMENTATION_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <vector>
+
+#include "ps_pointcloud.h"
+#include "ps_pointstore.h"
+#include "ps_pointcloudloader.h"
+
+class PS_ShapeSegment;
+class PS_PlaneSegment;
+class PS_SphereSegment;
+class PS_CylinderSegment;
+
+using namespace std;
+
+//! axis aligned part of a point cloud that is segmented on its own
+struct PS_Tile{
+    PS_Tile() : numPoints(0), numCorePoints(0){}
+
+    quint32 cellMin[3]; //first histogram cell of the core region
+    quint32 cellMax[3]; //last histogram cell of the core region + 1
+    float min[3]; //box of the tile including the overlap
+    float max[3];
+    quint64 numPoints; //number of points in the tile file (including the overlap)
+    quint64 numCorePoints; //number of points in the core region
+    QString fileName; //temporary file that holds the points of the tile (x, y, z interleaved)
+    vector<float> buffer; //points that were not written to the tile file yet
+};
+
+/*!
+ * \brief The PS_TiledSegmentation class
+ * Out-of-core segmentation of point clouds that do not fit into memory. The file is read window by window (see PS_PointCloudReader)
+ * and the points are bucketed into overlapping axis aligned tiles on disk. The tiles are split along a histogram of the points,
+ * so that each tile (including its overlap) fits into the memory budget. Each tile is segmented on its own by PS_PointCloud.
+ * Each tile keeps only the points of its core region (these are unique across the tiles), reduced to at most maxShapePoints
+ * points per shape. The shapes that cross tile borders are then stitched with the merge step of the in-memory segmentation.
+ * The detected shapes and their point store are owned by this object.
+ */
+class PS_TiledSegmentation : public QObject
+{
+    Q_OBJECT
+
+public:
+    PS_TiledSegmentation(QObject *parent = NULL);
+    ~PS_TiledSegmentation();
+
+    bool segment(const QString &fileName, PS_InputParameter param);
+
+    void setMemoryBudget(const quint64 &memoryBudget);
+    void setOverlap(const float &overlap);
+    void setCancelFlag(const QAtomicInt *canceled);
+
+    //! \brief Returns the number of tiles of the last segmentation
+    inline int getTileCount() const{
+        return this->tiles.size();
+    }
+
+    const QList<PS_PlaneSegment *> &getDetectedPlanes() const;
+    const QList<PS_SphereSegment *> &getDetectedSpheres() const;
+    const QList<PS_CylinderSegment *> &getDetectedCylinders() const;
+
+signals:
+    void updateStatus(QString msg, int status);
+    void updateProgress(double fraction);
+
+private:
+    bool computeHistogram(PS_PointCloudReader &reader);
+    void splitTiles(const quint32 cellMin[3], const quint32 cellMax[3], const quint64 &maxTilePoints);
+    void setUpCellTiles();
+    bool writeTiles(PS_PointCloudReader &reader, const QString &tileDir);
+    bool flushTile(PS_Tile &tile);
+    bool loadTile(const PS_Tile &tile, PS_PointStore *store, PS_BoundingBox_PC &bbox) const;
+    void segmentTile(const int &tileIndex, const PS_InputParameter &param);
+    bool takeShape(PS_ShapeSegment *source, PS_ShapeSegment *target, const int &tileIndex);
+    void stitchShapes(const PS_InputParameter &param);
+    void clear();
+
+    bool isStopRequested(const PS_InputParameter &param, const QElapsedTimer &timer) const;
+
+    quint64 countPoints(const quint32 cellMin[3], const quint32 cellMax[3]) const;
+
+    //! \brief Returns the histogram cell of a point
+    inline quint32 getCell(const float &x, const float &y, const float &z) const{
+        const float v[3] = {x, y, z};
+        quint32 c[3];
+        for(int k = 0; k < 3; k++){
+            float f = (v[k] - this->myBoundingBox.min[k]) / this->cellSize[k];
+            c[k] = (f <= 0.0f) ? 0 : qMin((quint32)f, (quint32)(PS_TiledSegmentation::resolution - 1));
+        }
+        return (c[2] * PS_TiledSegmentation::resolution + c[1]) * PS_TiledSegmentation::resolution + c[0];
+    }
+
+    static const int resolution = 64; //number of histogram cells along each axis
+    static const quint64 bytesPerPoint = 64; //estimated peak memory per point of a tile (coordinates, octree, sort buffers and shape indices)
+    static const unsigned int maxShapePoints = 10000; //maximum number of points of a shape that are kept for stitching
+    static const unsigned int tileBufferSize = 4096; //number of points that are buffered per tile before they are written
+
+    quint64 memoryBudget; //memory in bytes that may be used to segment one tile
+    float overlap; //distance by which each tile is extended into its neighbours
+    const QAtomicInt *canceled;
+
+    PS_BoundingBox_PC myBoundingBox;
+    float cellSize[3];
+    quint64 numPoints;
+
+    vector<quint64> summedHistogram; //summed area table of the number of points per cell ((resolution + 1)^3 entries)
+    vector<qint32> cellTiles; //tile whose core region contains the cell
+    vector<quint32> cellOverlapOffsets; //overlapping tiles of cell i are cellOverlapTiles[cellOverlapOffsets[i]] until cellOverlapOffsets[i+1]
+    vector<qint32> cellOverlapTiles;
+    vector<PS_Tile> tiles;
+
+    PS_PointStore *shapePoints; //coordinates of the kept points of all detected shapes
+    QList<PS_PlaneSegment *> detectedPlanes;
+    QList<PS_SphereSegment *> detectedSpheres;
+    QList<PS_CylinderSegment *> detectedCylinders;
+
+};
+
+#endif // PS_TILEDSEGMENTATION_H
@@ -17,6 +17,8 @@ void PS_LoadingDialog::reset(){
 
     this->ui->progressBar_status->setValue(0);
     this->ui->listwidget_msg->clear();
+    this->ui->label_progress->clear();
+    this->ui->pushButton_cancel->setEnabled(true);
 
 }
 
@@ -26,3 +28,17 @@ void PS_LoadingDialog::setStatus(QString msg, int status){
     this->ui->progressBar_status->setValue(status);
 
 }
+
+void PS_LoadingDialog::setProgress(double fraction){
+
+    this->ui->label_progress->setText(QString("%1 % of the points considered").arg(100.0 * fraction, 0, 'f', 1));
+
+}
+
+void PS_LoadingDialog::on_pushButton_cancel_clicked(){
+
+    this->ui->pushButton_cancel->setEnabled(false);
+    this->ui->listwidget_msg->addItem("Canceling, the shapes found so far are kept...");
+    emit this->cancelRequested();
+
+}
@@ -18,6 +18,13 @@ public:
 public slots:
     void reset();
     void setStatus(QString msg, int status);
+    void setProgress(double fraction);
+
+signals:
+    void cancelRequested();
+
+private slots:
+    void on_pushButton_cancel_clicked();
 
 private:
     Ui::PS_LoadingDialog *ui;
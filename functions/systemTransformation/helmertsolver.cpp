@@ -0,0 +1,496 @@
+#include "helmertsolver.h"
+
+#include <cmath>
+#include <QThread>
+#include <QThreadPool>
+
+//Gauss-Newton iterations stop as soon as the norm of the increments falls below this value
+#define HELMERT_CONVERGENCE 1.0e-10
+
+/*!
+ * \brief HelmertSolution::getRotationMatrix
+ * Returns the rotation as homogeneous 4x4 matrix (as used by TrafoParam)
+ * \return
+ */
+OiMat HelmertSolution::getRotationMatrix() const{
+
+    OiMat result(4, 4);
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            result.setAt(i, j, this->rotation(i, j));
+        }
+    }
+    result.setAt(3, 3, 1.0);
+    return result;
+
+}
+
+/*!
+ * \brief HelmertSolution::getTranslationMatrix
+ * Returns the translation as homogeneous 4x4 matrix (as used by TrafoParam)
+ * \return
+ */
+OiMat HelmertSolution::getTranslationMatrix() const{
+
+    OiMat result(4, 4);
+    for(int i = 0; i < 4; i++){
+        result.setAt(i, i, 1.0);
+    }
+    for(int i = 0; i < 3; i++){
+        result.setAt(i, 3, this->translation(i));
+    }
+    return result;
+
+}
+
+/*!
+ * \brief HelmertSolution::getScaleMatrix
+ * Returns the scale as homogeneous 4x4 matrix (as used by TrafoParam)
+ * \return
+ */
+OiMat HelmertSolution::getScaleMatrix() const{
+
+    OiMat result(4, 4);
+    for(int i = 0; i < 3; i++){
+        result.setAt(i, i, this->scale);
+    }
+    result.setAt(3, 3, 1.0);
+    return result;
+
+}
+
+/*!
+ * \brief HelmertSolver::HelmertSolver
+ */
+HelmertSolver::HelmertSolver() : estimateScale(true), fixedScale(1.0), maxIterations(20){
+
+}
+
+/*!
+ * \brief HelmertSolver::clear
+ * Removes all common points
+ */
+void HelmertSolver::clear(){
+    this->start.clear();
+    this->destination.clear();
+}
+
+/*!
+ * \brief HelmertSolver::reserve
+ * Allocates the memory for the given number of common points
+ * \param numPoints
+ */
+void HelmertSolver::reserve(const int &numPoints){
+    this->start.reserve(3 * numPoints);
+    this->destination.reserve(3 * numPoints);
+}
+
+/*!
+ * \brief HelmertSolver::addPoint
+ * Adds a common point
+ * \param start x, y, z in the start system
+ * \param destination x, y, z in the destination system
+ */
+void HelmertSolver::addPoint(const double start[3], const double destination[3]){
+    this->start.insert(this->start.end(), start, start + 3);
+    this->destination.insert(this->destination.end(), destination, destination + 3);
+}
+
+/*!
+ * \brief HelmertSolver::addPoint
+ * Adds a common point given as (homogeneous) coordinate vectors
+ * \param start
+ * \param destination
+ */
+void HelmertSolver::addPoint(const OiVec &start, const OiVec &destination){
+    const double s[3] = {start.getAt(0), start.getAt(1), start.getAt(2)};
+    const double d[3] = {destination.getAt(0), destination.getAt(1), destination.getAt(2)};
+    this->addPoint(s, d);
+}
+
+/*!
+ * \brief HelmertSolver::approximate
+ * Closed-form solution (Horn): the rotation quaternion is the eigenvector of the largest eigenvalue of the 4x4 matrix
+ * built from the cross covariance of the centroid reduced coordinates. The scale is sum(d^T * R * s) / sum(s^T * s)
+ * and the translation maps the start centroid to the destination centroid.
+ * \param solution
+ * \return
+ */
+bool HelmertSolver::approximate(HelmertSolution &solution) const{
+
+    solution = HelmertSolution();
+
+    const int numPoints = this->getPointCount();
+    if(numPoints < 3){
+        solution.errorMessage = "At least 3 common points are needed";
+        return false;
+    }
+
+    fixed::Vec<3> centroidStart, centroidDestination;
+    this->getCentroids(centroidStart, centroidDestination);
+
+    //cross covariance s(i, j) = sum(start_i * destination_j)
+    fixed::Mat<3, 3> s;
+    double sumStart = 0.0;
+    for(int k = 0; k < numPoints; k++){
+        const double *ps = &this->start[3*k];
+        const double *pd = &this->destination[3*k];
+        double a[3], b[3];
+        for(int i = 0; i < 3; i++){
+            a[i] = ps[i] - centroidStart(i);
+            b[i] = pd[i] - centroidDestination(i);
+            sumStart += a[i] * a[i];
+        }
+        for(int i = 0; i < 3; i++){
+            for(int j = 0; j < 3; j++){
+                s(i, j) += a[i] * b[j];
+            }
+        }
+    }
+    if(sumStart <= 0.0){
+        solution.errorMessage = "The common points of the start system coincide";
+        return false;
+    }
+
+    fixed::Mat<4, 4> n;
+    n(0, 0) = s(0, 0) + s(1, 1) + s(2, 2);
+    n(0, 1) = s(1, 2) - s(2, 1);
+    n(0, 2) = s(2, 0) - s(0, 2);
+    n(0, 3) = s(0, 1) - s(1, 0);
+    n(1, 1) = s(0, 0) - s(1, 1) - s(2, 2);
+    n(1, 2) = s(0, 1) + s(1, 0);
+    n(1, 3) = s(2, 0) + s(0, 2);
+    n(2, 2) = -s(0, 0) + s(1, 1) - s(2, 2);
+    n(2, 3) = s(1, 2) + s(2, 1);
+    n(3, 3) = -s(0, 0) - s(1, 1) + s(2, 2);
+    for(int i = 0; i < 4; i++){
+        for(int j = 0; j < i; j++){
+            n(i, j) = n(j, i);
+        }
+    }
+
+    fixed::Vec<4> values;
+    fixed::Mat<4, 4> vectors;
+    if(!fixed::eigenSymmetric(n, values, vectors)){
+        solution.errorMessage = "Cannot compute the eigenvectors of the quaternion matrix";
+        return false;
+    }
+    fixed::Vec<4> q = vectors.getCol(0);
+    q = q / q.norm();
+
+    fixed::Mat<3, 3> &r = solution.rotation;
+    r(0, 0) = q(0)*q(0) + q(1)*q(1) - q(2)*q(2) - q(3)*q(3);
+    r(0, 1) = 2.0 * (q(1)*q(2) - q(0)*q(3));
+    r(0, 2) = 2.0 * (q(1)*q(3) + q(0)*q(2));
+    r(1, 0) = 2.0 * (q(1)*q(2) + q(0)*q(3));
+    r(1, 1) = q(0)*q(0) - q(1)*q(1) + q(2)*q(2) - q(3)*q(3);
+    r(1, 2) = 2.0 * (q(2)*q(3) - q(0)*q(1));
+    r(2, 0) = 2.0 * (q(3)*q(1) - q(0)*q(2));
+    r(2, 1) = 2.0 * (q(3)*q(2) + q(0)*q(1));
+    r(2, 2) = q(0)*q(0) - q(1)*q(1) - q(2)*q(2) + q(3)*q(3);
+
+    //sum(d^T * R * s) = trace(R * S)
+    if(this->estimateScale){
+        double sumDRS = 0.0;
+        for(int i = 0; i < 3; i++){
+            for(int j = 0; j < 3; j++){
+                sumDRS += r(i, j) * s(j, i);
+            }
+        }
+        solution.scale = sumDRS / sumStart;
+    }else{
+        solution.scale = this->fixedScale;
+    }
+
+    solution.translation = centroidDestination - solution.scale * (r * centroidStart);
+    solution.isValid = true;
+
+    return true;
+
+}
+
+/*!
+ * \brief HelmertSolver::refine
+ * Refines an approximate solution by Gauss-Newton iterations (6 unknowns with fixed scale, 7 unknowns otherwise)
+ * \param solution
+ * \return
+ */
+bool HelmertSolver::refine(HelmertSolution &solution) const{
+
+    if(this->getPointCount() < 3){
+        solution.isValid = false;
+        solution.errorMessage = "At least 3 common points are needed";
+        return false;
+    }
+
+    if(this->estimateScale){
+        return this->refineParameters<7>(solution);
+    }
+    solution.scale = this->fixedScale;
+    return this->refineParameters<6>(solution);
+
+}
+
+/*!
+ * \brief HelmertSolver::solve
+ * Closed-form approximation followed by the Gauss-Newton refinement
+ * \param solution
+ * \return
+ */
+bool HelmertSolver::solve(HelmertSolution &solution) const{
+
+    if(!this->approximate(solution)){
+        return false;
+    }
+    return this->refine(solution);
+
+}
+
+/*!
+ * \brief HelmertSolver::solveBatch
+ * Solves the transformations of all solvers (e.g. the stations of a network) in parallel
+ * \param solvers
+ * \param solutions one solution for each solver
+ * \param numThreads number of threads (0 = ideal thread count, 1 = serial)
+ */
+void HelmertSolver::solveBatch(const vector<HelmertSolver> &solvers, vector<HelmertSolution> &solutions, const int &numThreads){
+
+    solutions.assign(solvers.size(), HelmertSolution());
+
+    int threadCount = numThreads > 0 ? numThreads : QThread::idealThreadCount();
+    threadCount = qMin(threadCount, (int)solvers.size());
+
+    QAtomicInt nextSolver(0);
+    if(threadCount <= 1){
+        HelmertSolverTask(&solvers, &solutions, &nextSolver).run();
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    for(int i = 0; i < threadCount; i++){
+        pool.start(new HelmertSolverTask(&solvers, &solutions, &nextSolver));
+    }
+    pool.waitForDone();
+
+}
+
+/*!
+ * \brief HelmertSolver::getRotationMatrix
+ * Returns the rotation matrix of the angles alpha, beta and gamma (convention of the helmert transformations)
+ * \param alpha
+ * \param beta
+ * \param gamma
+ * \return
+ */
+fixed::Mat<3, 3> HelmertSolver::getRotationMatrix(const double &alpha, const double &beta, const double &gamma){
+
+    fixed::Mat<3, 3> result;
+    const double ca = std::cos(alpha);
+    const double sa = std::sin(alpha);
+    const double cb = std::cos(beta);
+    const double sb = std::sin(beta);
+    const double cg = std::cos(gamma);
+    const double sg = std::sin(gamma);
+    result(0,0) = cb*cg;
+    result(0,1) = ca*sg+sa*sb*cg;
+    result(0,2) = sa*sg-ca*sb*cg;
+    result(1,0) = -cb*sg;
+    result(1,1) = ca*cg-sa*sb*sg;
+    result(1,2) = sa*cg+ca*sb*sg;
+    result(2,0) = sb;
+    result(2,1) = -sa*cb;
+    result(2,2) = ca*cb;
+    return result;
+
+}
+
+/*!
+ * \brief HelmertSolver::getRotationAngles
+ * Returns the angles alpha, beta and gamma of a rotation matrix (inverse of getRotationMatrix)
+ * \param r
+ * \return
+ */
+fixed::Vec<3> HelmertSolver::getRotationAngles(const fixed::Mat<3, 3> &r){
+
+    fixed::Vec<3> rot;
+    rot(0) = std::atan2(-r(2,1), r(2,2)); //alpha
+    rot(1) = std::asin(qBound(-1.0, r(2,0), 1.0)); //beta
+    rot(2) = std::atan2(-r(1,0), r(0,0)); //gamma
+    for(int i = 0; i < 3; i++){
+        if(rot(i) == 0.0){
+            rot(i) = 0.0; //no -0.0
+        }
+    }
+    return rot;
+
+}
+
+/*!
+ * \brief HelmertSolver::refineParameters
+ * Gauss-Newton iterations of destination = t + m * R * (start - centroid of start). The rotation is updated
+ * multiplicatively by small rotations dw (R = R(dw) * R), so the linearization holds for arbitrary angles.
+ * Unknowns: dw (3), t (3) and the scale m (U = 7 only). The normal equations are accumulated point by point.
+ * \param solution approximation on input
+ * \return
+ */
+template<int U>
+bool HelmertSolver::refineParameters(HelmertSolution &solution) const{
+
+    const int numPoints = this->getPointCount();
+
+    fixed::Vec<3> centroidStart, centroidDestination;
+    this->getCentroids(centroidStart, centroidDestination);
+
+    //the translation is estimated at the centroid of the start system to decouple it from rotation and scale
+    fixed::Mat<3, 3> r = solution.rotation;
+    double m = solution.scale;
+    fixed::Vec<3> t = solution.translation + m * (r * centroidStart);
+
+    fixed::Mat<U, U> qxx;
+    double vtv = 0.0;
+    int iterations = 0;
+    bool converged = false;
+    while(!converged && iterations < this->maxIterations){
+
+        fixed::Mat<U, U> n;
+        fixed::Vec<U> c;
+        vtv = 0.0;
+        for(int k = 0; k < numPoints; k++){
+            fixed::Vec<3> a;
+            for(int i = 0; i < 3; i++){
+                a(i) = this->start[3*k+i] - centroidStart(i);
+            }
+            const fixed::Vec<3> q = r * a;
+
+            fixed::Vec<3> l;
+            for(int i = 0; i < 3; i++){
+                l(i) = this->destination[3*k+i] - t(i) - m * q(i);
+            }
+            vtv += l.dot(l);
+
+            //derivatives with respect to dw (-m * [q]x), t (I) and m (q)
+            fixed::Mat<3, U> design;
+            design(0, 1) = m * q(2);
+            design(0, 2) = -m * q(1);
+            design(1, 0) = -m * q(2);
+            design(1, 2) = m * q(0);
+            design(2, 0) = m * q(1);
+            design(2, 1) = -m * q(0);
+            for(int i = 0; i < 3; i++){
+                design(i, 3 + i) = 1.0;
+                if(U == 7){
+                    design(i, U - 1) = q(i);
+                }
+            }
+            fixed::addNormalEquations(n, c, design, l);
+        }
+
+        if(!fixed::invertSymmetric(n, qxx)){
+            solution.isValid = false;
+            solution.errorMessage = "The normal equations of the helmert transformation are singular (collinear points?)";
+            return false;
+        }
+
+        const fixed::Vec<U> x = qxx * c;
+        iterations++;
+        converged = x.norm() < HELMERT_CONVERGENCE * (1.0 + t.norm());
+
+        //R = R(dw) * R (Rodrigues)
+        fixed::Vec<3> w;
+        w(0) = x(0);
+        w(1) = x(1);
+        w(2) = x(2);
+        const double angle = w.norm();
+        if(angle > 0.0){
+            fixed::Mat<3, 3> k;
+            k(0, 1) = -w(2);
+            k(0, 2) = w(1);
+            k(1, 0) = w(2);
+            k(1, 2) = -w(0);
+            k(2, 0) = -w(1);
+            k(2, 1) = w(0);
+            const fixed::Mat<3, 3> dr = fixed::Mat<3, 3>::identity() + (std::sin(angle) / angle) * k
+                    + ((1.0 - std::cos(angle)) / (angle * angle)) * (k * k);
+            r = dr * r;
+        }
+        for(int i = 0; i < 3; i++){
+            t(i) += x(3 + i);
+        }
+        if(U == 7){
+            m += x(U - 1);
+        }
+
+    }
+
+    //residuals of the final parameters
+    vtv = 0.0;
+    for(int k = 0; k < numPoints; k++){
+        fixed::Vec<3> a;
+        for(int i = 0; i < 3; i++){
+            a(i) = this->start[3*k+i] - centroidStart(i);
+        }
+        const fixed::Vec<3> q = r * a;
+        for(int i = 0; i < 3; i++){
+            const double v = this->destination[3*k+i] - t(i) - m * q(i);
+            vtv += v * v;
+        }
+    }
+
+    solution.rotation = r;
+    solution.scale = m;
+    solution.translation = t - m * (r * centroidStart);
+    solution.iterations = iterations;
+    solution.stdev = 3 * numPoints > U ? std::sqrt(vtv / (3 * numPoints - U)) : 0.0;
+    solution.qxx = fixed::Mat<7, 7>();
+    for(int i = 0; i < U; i++){
+        for(int j = 0; j < U; j++){
+            solution.qxx(i, j) = qxx(i, j);
+        }
+    }
+    solution.isValid = true;
+    solution.errorMessage.clear();
+
+    return true;
+
+}
+
+/*!
+ * \brief HelmertSolver::getCentroids
+ * \param centroidStart
+ * \param centroidDestination
+ */
+void HelmertSolver::getCentroids(fixed::Vec<3> &centroidStart, fixed::Vec<3> &centroidDestination) const{
+
+    centroidStart = fixed::Vec<3>();
+    centroidDestination = fixed::Vec<3>();
+
+    const int numPoints = this->getPointCount();
+    if(numPoints == 0){
+        return;
+    }
+    for(int k = 0; k < numPoints; k++){
+        for(int i = 0; i < 3; i++){
+            centroidStart(i) += this->start[3*k+i];
+            centroidDestination(i) += this->destination[3*k+i];
+        }
+    }
+    centroidStart *= 1.0 / numPoints;
+    centroidDestination *= 1.0 / numPoints;
+
+}
+
+/*!
+ * \brief HelmertSolverTask::run
+ * Solves the next unsolved transformation until all are done
+ */
+void HelmertSolverTask::run(){
+
+    const int numSolvers = this->solvers->size();
+    int i = this->nextSolver->fetchAndAddRelaxed(1);
+    while(i < numSolvers){
+        this->solvers->at(i).solve(this->solutions->at(i));
+        i = this->nextSolver->fetchAndAddRelaxed(1);
+    }
+
+}
@@ -0,0 +1,120 @@
+#ifndef HELMERTSOLVER_H
+#define HELMERTSOLVER_H
+
+#include <QString>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <vector>
+
+#include "oivec.h"
+#include "oimat.h"
+#include "fixedmatrix.h"
+
+using namespace oi;
+using namespace std;
+
+/*!
+ * \brief The HelmertSolution struct
+ * Parameters of the similarity transformation destination = translation + scale * rotation * start
+ */
+struct HelmertSolution{
+
+    HelmertSolution() : isValid(false), scale(1.0), stdev(0.0), iterations(0){}
+
+    bool isValid;
+
+    fixed::Mat<3, 3> rotation;
+    fixed::Vec<3> translation;
+    double scale;
+
+    double stdev; //a posteriori standard deviation of the coordinates (0 without redundancy)
+    int iterations; //number of Gauss-Newton iterations
+    fixed::Mat<7, 7> qxx; //cofactors of the rotation increments, the translation of the start centroid and the scale
+
+    QString errorMessage;
+
+    OiMat getRotationMatrix() const;
+    OiMat getTranslationMatrix() const;
+    OiMat getScaleMatrix() const;
+
+};
+
+/*!
+ * \brief The HelmertSolver class
+ * Estimates a 6 parameter (fixed scale) or 7 parameter helmert transformation between the common points of a start and
+ * a destination system. The closed-form solution (quaternion approach of Horn, the rotation is the eigenvector of a
+ * 4x4 matrix that is built from the centroid reduced coordinates) is refined by Gauss-Newton iterations whose 6x6 / 7x7
+ * normal equations are accumulated point by point. solveBatch solves the transformations of many stations at once.
+ */
+class HelmertSolver
+{
+public:
+    HelmertSolver();
+
+    void clear();
+    void reserve(const int &numPoints);
+
+    void addPoint(const double start[3], const double destination[3]);
+    void addPoint(const OiVec &start, const OiVec &destination);
+
+    //! \brief Returns the number of common points
+    inline int getPointCount() const{
+        return this->start.size() / 3;
+    }
+
+    //! \brief Estimates the scale (7 parameters, default)
+    inline void setEstimateScale(const bool &estimateScale){
+        this->estimateScale = estimateScale;
+    }
+
+    //! \brief Keeps the scale fixed to the given value (6 parameters, e.g. 1.0 or a scale from temperature)
+    inline void setFixedScale(const double &scale){
+        this->estimateScale = false;
+        this->fixedScale = scale;
+    }
+
+    //! \brief Sets the maximum number of Gauss-Newton iterations
+    inline void setMaxIterations(const int &maxIterations){
+        this->maxIterations = maxIterations;
+    }
+
+    bool approximate(HelmertSolution &solution) const;
+    bool refine(HelmertSolution &solution) const;
+    bool solve(HelmertSolution &solution) const;
+
+    static void solveBatch(const vector<HelmertSolver> &solvers, vector<HelmertSolution> &solutions, const int &numThreads = 0);
+
+    static fixed::Mat<3, 3> getRotationMatrix(const double &alpha, const double &beta, const double &gamma);
+    static fixed::Vec<3> getRotationAngles(const fixed::Mat<3, 3> &r);
+
+private:
+    template<int U>
+    bool refineParameters(HelmertSolution &solution) const;
+
+    void getCentroids(fixed::Vec<3> &centroidStart, fixed::Vec<3> &centroidDestination) const;
+
+    vector<double> start; //x, y, z of each common point in the start system
+    vector<double> destination; //x, y, z of each common point in the destination system
+
+    bool estimateScale;
+    double fixedScale;
+    int maxIterations;
+
+};
+
+//! solves the transformations of a batch of HelmertSolver objects in a worker thread
+class HelmertSolverTask : public QRunnable
+{
+public:
+    HelmertSolverTask(const vector<HelmertSolver> *solvers, vector<HelmertSolution> *solutions, QAtomicInt *nextSolver)
+        : solvers(solvers), solutions(solutions), nextSolver(nextSolver){}
+
+    void run();
+
+private:
+    const vector<HelmertSolver> *solvers;
+    vector<HelmertSolution> *solutions;
+    QAtomicInt *nextSolver;
+};
+
+#endif // HELMERTSOLVER_H
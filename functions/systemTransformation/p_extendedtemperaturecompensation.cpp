@@ -43,6 +43,10 @@ bool ExtendedTemperatureCompensation::exec(TrafoParam &trafoParam){
 
         //get translation and rotation from loc to ref system, so you can transform later
         this->rotation = this->approxRotation();
+        if(this->svdError){
+            emit this->sendMessage("Cannot approximate the rotation between the systems", eErrorMessage);
+            return false;
+        }
         this->scale = this->approxScale(this->rotation);
         this->translation = this->approxTranslation(this->rotation, this->scale);
 
@@ -50,11 +54,11 @@ bool ExtendedTemperatureCompensation::exec(TrafoParam &trafoParam){
             return this->calc(trafoParam);
 
         }else{
-            OiMat rot = this->getRotationMatrix(this->rotation);
-            OiMat s = this->getScaleMatrix(this->scale);
-            OiMat t = this->getTranslationMatrix(this->translation);
+            fixed::Mat<4, 4> rot = this->getRotationMatrix(this->rotation);
+            fixed::Mat<4, 4> s = this->getScaleMatrix(this->scale);
+            fixed::Mat<4, 4> t = this->getTranslationMatrix(this->translation);
 
-            trafoParam.setTransformationParameters(rot, t, s);
+            trafoParam.setTransformationParameters(rot.toOiMat(), t.toOiMat(), s.toOiMat());
             return true;
         }
 
@@ -110,54 +114,44 @@ bool ExtendedTemperatureCompensation::calc(TrafoParam &tp)
     OiVec tmpTranslation = this->approxTranslation(tmpRotation,tmpScale);
 
     //approximation
-    OiVec x0(9);
-
-    x0.setAt(0,tmpRotation.getAt(0));
-    x0.setAt(1,tmpRotation.getAt(1));
-    x0.setAt(2,tmpRotation.getAt(2));
-    x0.setAt(3,tmpScale.getAt(0));
-    x0.setAt(4,tmpScale.getAt(1));
-    x0.setAt(5,tmpScale.getAt(2));
-    x0.setAt(6,tmpTranslation.getAt(0));
-    x0.setAt(7,tmpTranslation.getAt(1));
-    x0.setAt(8,tmpTranslation.getAt(2));
-
-    //observations
-    OiVec l = this->fillLVector();
-
-    OiVec l_diff;
-    OiMat a;
-    OiVec x;
-    OiMat qxx;
-
-    //A matrix
-    a = this->fillAMatrix(x0);
-    //normal equation
-    OiMat n = a.t()*a;
-
-    try{
-        qxx = n.inv(); // try to calc the inverse
-    }catch(runtime_error e){
-       return false;
-    }catch(logic_error e){
-        return false;
+    fixed::Vec<9> x0;
+
+    x0(0) = tmpRotation.getAt(0);
+    x0(1) = tmpRotation.getAt(1);
+    x0(2) = tmpRotation.getAt(2);
+    x0(3) = tmpScale.getAt(0);
+    x0(4) = tmpScale.getAt(1);
+    x0(5) = tmpScale.getAt(2);
+    x0(6) = tmpTranslation.getAt(0);
+    x0(7) = tmpTranslation.getAt(1);
+    x0(8) = tmpTranslation.getAt(2);
+
+    //normal equation and right side (accumulated point by point instead of setting up the 3n x 9 A matrix)
+    fixed::Mat<9, 9> n;
+    fixed::Vec<9> c;
+    for(int i = 0; i < this->locSystem.length(); i++){
+        fixed::Vec<3> l_diff = this->fillLVector(this->locSystem.at(i)) - this->fillL0Vector(this->locSystem.at(i), x0);
+        fixed::addNormalEquations(n, c, this->fillAMatrix(this->locSystem.at(i), x0), l_diff);
     }
 
-    //differential l vector
-    OiVec l0 = this->fillL0Vector(x0);
-    l_diff = l -l0;
-
-    //right side
-    OiVec c = a.t()*l_diff;
+    //try to calc the inverse
+    fixed::Mat<9, 9> qxx;
+    if(!fixed::invertSymmetric(n, qxx)){
+        return false;
+    }
 
     //calc x
-    x = qxx*c;
-    x0 = x0+x;
+    fixed::Vec<9> x = qxx*c;
 
-    OiVec v = a * x - l_diff;
-    OiVec vtv = v.t() * v;
-    double s0_post = sqrt(vtv.getAt(0) / (3 * this->locSystem.length() - 9));
-    OiMat sxx = s0_post * s0_post * qxx;
+    double vtv = 0.0;
+    for(int i = 0; i < this->locSystem.length(); i++){
+        fixed::Vec<3> l_diff = this->fillLVector(this->locSystem.at(i)) - this->fillL0Vector(this->locSystem.at(i), x0);
+        fixed::Vec<3> v = this->fillAMatrix(this->locSystem.at(i), x0) * x - l_diff;
+        vtv += v.dot(v);
+    }
+    x0 += x;
+    double s0_post = sqrt(vtv / (3 * this->locSystem.length() - 9));
+    fixed::Mat<9, 9> sxx = s0_post * s0_post * qxx;
 
     //tp.getStatistic()->stdev = s0_post;
 
@@ -176,11 +170,11 @@ bool ExtendedTemperatureCompensation::calc(TrafoParam &tp)
     this->scale.setAt(1,this->scale.getAt(1)*x0.getAt(4));
     this->scale.setAt(2,this->scale.getAt(2)*x0.getAt(5));
 
-    OiMat s = this->getScaleMatrix(this->scale);
-    OiMat r = this->getRotationMatrix(this->rotation);
-    OiMat t = this->getTranslationMatrix(this->translation);
+    fixed::Mat<4, 4> s = this->getScaleMatrix(this->scale);
+    fixed::Mat<4, 4> r = this->getRotationMatrix(this->rotation);
+    fixed::Mat<4, 4> t = this->getTranslationMatrix(this->translation);
 
-    tp.setTransformationParameters(r,t,s);
+    tp.setTransformationParameters(r.toOiMat(), t.toOiMat(), s.toOiMat());
 
     return true;
 }
@@ -234,67 +228,57 @@ void ExtendedTemperatureCompensation::initPoints(){
 OiVec ExtendedTemperatureCompensation::approxTranslation(OiVec rot, OiVec s)
 {
     //get rotation matrix of approx values
-    OiMat r = this->getRotationMatrix(rot);
+    fixed::Mat<4, 4> r = this->getRotationMatrix(rot);
 
     //get scale matrix of approx valies
-    OiMat scaleMat = this->scaleMatrix(s);
+    fixed::Mat<4, 4> scaleMat = this->scaleMatrix(s);
 
     //centroid point of reference system
-    OiVec centroidPref = this->calcCentroidPoint(this->refSystem);
-    centroidPref.add(1.0);
+    fixed::Vec<4> centroidPref = fixed::homogeneous(this->calcCentroidPoint(this->refSystem));
 
     //get centroid point of loc system
-    OiVec centroidPloc = this->calcCentroidPoint(this->locSystem);
-    centroidPloc.add(1.0);
+    fixed::Vec<4> centroidPloc = fixed::homogeneous(this->calcCentroidPoint(this->locSystem));
 
     //rotate and scale local centroid point to reference system
-    OiVec tmp = centroidPloc;
-    OiVec st = scaleMat*tmp;
-    OiVec rst = r *st;
-    OiVec trans = centroidPref - rst;
-    trans.setAt(3,1.0);
+    fixed::Vec<4> st = scaleMat*centroidPloc;
+    fixed::Vec<4> rst = r *st;
+    fixed::Vec<4> trans = centroidPref - rst;
+    trans(3) = 1.0;
 
-    return trans;
+    return trans.toOiVec();
 }
 
 /*!
  * \brief approxRotation calculates the rotation between the given local and reference system
- * \param Translation t
  * \return
  */
 OiVec ExtendedTemperatureCompensation::approxRotation()
 {
-    //calculate approximated rotation angles with Drixler algorithm
+    //calculate approximated rotation angles with the closed-form solution of the helmert transformation
     //=> good approximation of preliminary transformation, so a rotation matrix with small angles can be used later at
     //adjusting the parameters iterativ
 
-    vector<OiVec> centroidCoords;
-    //get centroid coords
-    centroidCoords.push_back(this->calcCentroidPoint(this->locSystem));
-    centroidCoords.push_back(this->calcCentroidPoint(this->refSystem));
-    if(centroidCoords.size() == 2){
-        //centroid reduced coords
-        vector<OiVec> locC = this->centroidReducedCoord(locSystem, centroidCoords.at(0));
-        vector<OiVec> refC = this->centroidReducedCoord(refSystem, centroidCoords.at(1));
-        vector<OiMat> modelMatrices = this->modelMatrix(locC, refC);
-        OiMat n = this->normalEquationMatrix(modelMatrices);
-        OiVec q = this->quaternion(n);
-        if(!svdError){
-            OiMat r = this->rotationMatrix(q);
-            OiVec result = this->getRotationAngles(r);
-            if(result.getAt(0) == -0.0){
-                result.setAt(0,0.0);
-            }
-            if(result.getAt(1) == -0.0){
-                result.setAt(1,0.0);
-            }
-            if(result.getAt(2) == -0.0){
-                result.setAt(2,0.0);
-            }
-            return result;
-        }
+    HelmertSolver solver;
+    solver.setFixedScale(1.0);
+    solver.reserve(this->locSystem.count());
+    for(int i = 0; i < this->locSystem.count(); i++){
+        solver.addPoint(this->locSystem.at(i), this->refSystem.at(i));
+    }
+
+    OiVec result(4);
+    result.setAt(3, 1.0);
+
+    HelmertSolution solution;
+    if(!solver.approximate(solution)){
+        this->svdError = true;
+        return result;
     }
 
+    fixed::Vec<3> angles = HelmertSolver::getRotationAngles(solution.rotation);
+    for(int i = 0; i < 3; i++){
+        result.setAt(i, angles(i));
+    }
+    return result;
 }
 
 /*!
@@ -310,22 +294,14 @@ OiVec ExtendedTemperatureCompensation::approxScale(OiVec rot)
     double sy = 0.0;
     double sz = 0.0;
 
-    //get the current rotation matrix
-    OiMat rotMat;
-
-    try{
-       rotMat = this->getRotationMatrix(rot).inv(); // try to calc the inverse
-    }catch(runtime_error e){
-       return false;
-    }catch(logic_error e){
-        return false;
-    }
+    //get the inverse of the current rotation matrix (which is its transpose)
+    fixed::Mat<4, 4> rotMat = this->getRotationMatrix(rot).t();
 
-    QList<OiVec> tmpRefList;
+    QList<fixed::Vec<4> > tmpRefList;
 
     //rotate the reference system to local system
     for(int i=0; i<this->refSystem.size(); i++){
-        OiVec tmpRef = rotMat*this->refSystem.at(i);
+        fixed::Vec<4> tmpRef = rotMat*fixed::homogeneous(this->refSystem.at(i));
         tmpRefList.append(tmpRef);
     }
 
@@ -426,72 +402,48 @@ OiVec ExtendedTemperatureCompensation::calcCentroidPoint(QList<OiVec> points)
 }
 
 /*!
- * \brief fillLVector with observations
+ * \brief fillLVector with the observations of one common point
+ * \param loc
  * \return
  */
-OiVec ExtendedTemperatureCompensation::fillLVector()
+fixed::Vec<3> ExtendedTemperatureCompensation::fillLVector(const OiVec &loc)
 {
-    OiVec l(this->locSystem.length()*3);
-    for(int row=0;row<this->locSystem.length()*3;row++){
-        if((row+1)%3 == 1){ //x observation
-            l.setAt(row,this->locSystem.at(row/3).getAt(0));
-        }
-        if((row+1)%3 == 2){ // y observation
-            l.setAt(row,this->locSystem.at(row/3).getAt(1));
-        }
-        if((row+1)%3 == 0){ // z observation
-            l.setAt(row,this->locSystem.at(row/3).getAt(2));
-        }
-    }
+    fixed::Vec<3> l;
+    l(0) = loc.getAt(0); //x observation
+    l(1) = loc.getAt(1); // y observation
+    l(2) = loc.getAt(2); // z observation
     return l;
 }
 
 /*!
- * \brief fillAMatrix fills the A matrix
+ * \brief fillAMatrix fills the rows of the A matrix that belong to one common point
  * rotation x, rotation y, rotation z, scale x, scale y, scale z, tx, ty, tz
+ * \param loc
  * \param x0
  * \return
  */
-OiMat ExtendedTemperatureCompensation::fillAMatrix(OiVec x0)
+fixed::Mat<3, 9> ExtendedTemperatureCompensation::fillAMatrix(const OiVec &loc, const fixed::Vec<9> &x0)
 {
-    OiMat a(locSystem.length()*3,9);
+    fixed::Mat<3, 9> a;
 
     //loc system is transformed with approx values of translation and rotation. Scale is always near 1.00000, so
     //this should be approxed enough for the pre transformation.
     //That´s why I can use the rotation matrix for small angles.
-    for(int row=0; row<locSystem.length()*3; row++){
-        if((row+1) % 3 == 1){ // x
-            a.setAt(row,0,0.0);
-            a.setAt(row,1,-locSystem.at(row/3).getAt(2)*(x0.getAt(3)));
-            a.setAt(row,2,locSystem.at(row/3).getAt(1)*(x0.getAt(3)));
-            a.setAt(row,3,(locSystem.at(row/3).getAt(0)+x0.getAt(2)*locSystem.at(row/3).getAt(1)-x0.getAt(1)*locSystem.at(row/3).getAt(2)));
-            a.setAt(row,4,0.0);
-            a.setAt(row,5,0.0);
-            a.setAt(row,6,1.0);
-            a.setAt(row,7,0.0);
-            a.setAt(row,8,0.0);
-        }else if((row+1) % 3 == 2){ //y
-            a.setAt(row,0,locSystem.at(row/3).getAt(2)*(x0.getAt(4)));
-            a.setAt(row,1,0.0);
-            a.setAt(row,2,-locSystem.at(row/3).getAt(0)*(x0.getAt(4)));
-            a.setAt(row,3,0.0);
-            a.setAt(row,4,(-x0.getAt(2)*locSystem.at(row/3).getAt(0)+locSystem.at(row/3).getAt(1)+x0.getAt(0)*locSystem.at(row/3).getAt(2)));
-            a.setAt(row,5,0.0);
-            a.setAt(row,6,0.0);
-            a.setAt(row,7,1.0);
-            a.setAt(row,8,0.0);
-        }else if((row+1) % 3 == 0){ //z
-            a.setAt(row,0,-locSystem.at(row/3).getAt(1)*(x0.getAt(5)));
-            a.setAt(row,1,locSystem.at(row/3).getAt(0)*(x0.getAt(5)));
-            a.setAt(row,2,0.0);
-            a.setAt(row,3,0.0);
-            a.setAt(row,4,0.0);
-            a.setAt(row,5,(x0.getAt(1)*locSystem.at(row/3).getAt(0)-x0.getAt(0)*locSystem.at(row/3).getAt(1)+locSystem.at(row/3).getAt(2)));
-            a.setAt(row,6,0.0);
-            a.setAt(row,7,0.0);
-            a.setAt(row,8,1.0);
-        }
-    }
+    // x
+    a(0,1) = -loc.getAt(2)*(x0(3));
+    a(0,2) = loc.getAt(1)*(x0(3));
+    a(0,3) = (loc.getAt(0)+x0(2)*loc.getAt(1)-x0(1)*loc.getAt(2));
+    a(0,6) = 1.0;
+    //y
+    a(1,0) = loc.getAt(2)*(x0(4));
+    a(1,2) = -loc.getAt(0)*(x0(4));
+    a(1,4) = (-x0(2)*loc.getAt(0)+loc.getAt(1)+x0(0)*loc.getAt(2));
+    a(1,7) = 1.0;
+    //z
+    a(2,0) = -loc.getAt(1)*(x0(5));
+    a(2,1) = loc.getAt(0)*(x0(5));
+    a(2,5) = (x0(1)*loc.getAt(0)-x0(0)*loc.getAt(1)+loc.getAt(2));
+    a(2,8) = 1.0;
     return a;
 }
 
@@ -499,28 +451,17 @@ OiMat ExtendedTemperatureCompensation::fillAMatrix(OiVec x0)
  * \brief rotationMatrix sets up the rotation matrix
  * \return
  */
-OiMat ExtendedTemperatureCompensation::getRotationMatrix(OiVec rot)
+fixed::Mat<4, 4> ExtendedTemperatureCompensation::getRotationMatrix(const OiVec &rot)
 {
-    OiMat result(4,4);
-    double alpha = rot.getAt(0);
-    double beta = rot.getAt(1);
-    double gamma = rot.getAt(2);
-    result.setAt(0,0,qCos(beta)*qCos(gamma));
-    result.setAt(0,1,qCos(alpha)*qSin(gamma)+qSin(alpha)*qSin(beta)*qCos(gamma));
-    result.setAt(0,2,qSin(alpha)*qSin(gamma)-qCos(alpha)*qSin(beta)*qCos(gamma));
-    result.setAt(0,3,0.0);
-    result.setAt(1,0,-qCos(beta)*qSin(gamma));
-    result.setAt(1,1,qCos(alpha)*qCos(gamma)-qSin(alpha)*qSin(beta)*qSin(gamma));
-    result.setAt(1,2,qSin(alpha)*qCos(gamma)+qCos(alpha)*qSin(beta)*qSin(gamma));
-    result.setAt(1,3,0.0);
-    result.setAt(2,0,qSin(beta));
-    result.setAt(2,1,-qSin(alpha)*qCos(beta));
-    result.setAt(2,2,qCos(alpha)*qCos(beta));
-    result.setAt(2,3,0.0);
-    result.setAt(3,0,0.0);
-    result.setAt(3,1,0.0);
-    result.setAt(3,2,0.0);
-    result.setAt(3,3,1.0);
+    fixed::Mat<3, 3> r = HelmertSolver::getRotationMatrix(rot.getAt(0), rot.getAt(1), rot.getAt(2));
+
+    fixed::Mat<4, 4> result;
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            result(i, j) = r(i, j);
+        }
+    }
+    result(3,3) = 1.0;
 
     return result;
 }
@@ -531,26 +472,27 @@ OiMat ExtendedTemperatureCompensation::getRotationMatrix(OiVec rot)
 void ExtendedTemperatureCompensation::preliminaryTransformation()
 {
     //get rotation matrix of current rotation angles
-    OiMat rot = this->getRotationMatrix(this->rotation);
+    fixed::Mat<4, 4> rot = this->getRotationMatrix(this->rotation);
 
     //get scale matrix of current scales
-    OiMat s = this->scaleMatrix(this->scale);
+    fixed::Mat<4, 4> s = this->scaleMatrix(this->scale);
+
+    //scale and rotate in one step
+    fixed::Mat<4, 4> rs = rot*s;
+    fixed::Vec<4> translation(this->translation);
 
     QList<OiVec> tmpLoc;
     for(int i=0; i<this->locSystem.size();i++){
         //get vector point i
-        OiVec tmp = this->locSystem.at(i);
-        tmp.setAt(3,1.0);
+        fixed::Vec<4> tmp = fixed::homogeneous(this->locSystem.at(i));
 
-        //scale the point
-        OiVec st = s*tmp;
-        //rotate the point
-        OiVec rst = rot*st;
+        //scale and rotate the point
+        fixed::Vec<4> rst = rs*tmp;
 
         //add translation
-        OiVec tmptrafo = this->translation + rst;
-        tmptrafo.setAt(3,1.0);
-        tmpLoc.append(tmptrafo);
+        fixed::Vec<4> tmptrafo = translation + rst;
+        tmptrafo(3) = 1.0;
+        tmpLoc.append(tmptrafo.toOiVec());
     }
     this->locSystem = tmpLoc;
 }
@@ -559,180 +501,38 @@ void ExtendedTemperatureCompensation::preliminaryTransformation()
  * \brief scaleMatrix generates a matrix with the 3 scales on the main diagonal
  * \return
  */
-OiMat ExtendedTemperatureCompensation::scaleMatrix(OiVec s)
+fixed::Mat<4, 4> ExtendedTemperatureCompensation::scaleMatrix(const OiVec &s)
 {
-    OiMat scaleMat(4,4);
-    scaleMat.setAt(0,0,s.getAt(0));
-    scaleMat.setAt(0,1,0.0);
-    scaleMat.setAt(0,2,0.0);
-    scaleMat.setAt(0,3,0.0);
-    scaleMat.setAt(1,0,0.0);
-    scaleMat.setAt(1,1,s.getAt(1));
-    scaleMat.setAt(1,2,0.0);
-    scaleMat.setAt(1,3,0.0);
-    scaleMat.setAt(2,0,0.0);
-    scaleMat.setAt(2,1,0.0);
-    scaleMat.setAt(2,2,s.getAt(2));
-    scaleMat.setAt(2,3,0.0);
-    scaleMat.setAt(3,0,0.0);
-    scaleMat.setAt(3,1,0.0);
-    scaleMat.setAt(3,2,0.0);
-    scaleMat.setAt(3,3,1.0);
+    fixed::Mat<4, 4> scaleMat;
+    scaleMat(0,0) = s.getAt(0);
+    scaleMat(1,1) = s.getAt(1);
+    scaleMat(2,2) = s.getAt(2);
+    scaleMat(3,3) = 1.0;
 
     return scaleMat;
 }
 
 /*!
- * \brief fillL0Vector fills the l0 vector
+ * \brief fillL0Vector fills the l0 vector of one common point
+ * \param loc
  * \param x0
  * \return
  */
-OiVec ExtendedTemperatureCompensation::fillL0Vector(OiVec x0)
+fixed::Vec<3> ExtendedTemperatureCompensation::fillL0Vector(const OiVec &loc, const fixed::Vec<9> &x0)
 {
-    OiVec l0(this->locSystem.length() * 3);
+    fixed::Vec<3> l0;
 
     double sx, sy, sz;
 
-    sx = x0.getAt(3);
-    sy = x0.getAt(4);
-    sz = x0.getAt(5);
-
-    for(int row = 0; row < this->locSystem.length() * 3; row++){
-        if( (row+1) % 3 == 1 ){ //observation of x
-            l0.setAt(row, sx * this->locSystem.at(row/3).getAt(0) + sx * x0.getAt(2) * this->locSystem.at(row/3).getAt(1) - sx * x0.getAt(1) * this->locSystem.at(row/3).getAt(2) + x0.getAt(6));
-        }else if( (row+1) % 3 == 2 ){ //observation of y
-            l0.setAt(row, sy * this->locSystem.at(row/3).getAt(1) - sy * x0.getAt(2) * this->locSystem.at(row/3).getAt(0) + sy * x0.getAt(0) * this->locSystem.at(row/3).getAt(2) + x0.getAt(7));
-        }else if( (row+1) % 3 == 0 ){ //observation of z
-            l0.setAt(row, sz * this->locSystem.at(row/3).getAt(2) + sz * x0.getAt(1) * this->locSystem.at(row/3).getAt(0) - sz * x0.getAt(0) * this->locSystem.at(row/3).getAt(1) + x0.getAt(8));
-        }
-    }
-    return l0;
-}
-
-/*!
- * \brief centroidReducedCoord calculates the centroid reduced coordinates
- * \param input
- * \param centroid
- * \return
- */
-vector<OiVec> ExtendedTemperatureCompensation::centroidReducedCoord(QList<OiVec> input, OiVec centroid)
-{
-    vector<OiVec> result;
-    foreach (OiVec coord, input) {
-       OiVec c;
-       c.add(coord.getAt(0));
-       c.add(coord.getAt(1));
-       c.add(coord.getAt(2));
-       OiVec rc;
-       rc = c-centroid;
-       result.push_back(rc);
-    }
-
-    return result;
-}
-
-/*!
- * \brief modelMatrix
- * \param locC
- * \param refC
- * \return
- */
-vector<OiMat> ExtendedTemperatureCompensation::modelMatrix(vector<OiVec> locC, vector<OiVec> refC)
-{
-    vector<OiMat> result;
-    if(locC.size() == refC.size()){
-        for(int i = 0; i < locC.size(); i++){
-            OiMat a(4, 4);
-            a.setAt(0, 1, -( locC.at(i).getAt(0) - refC.at(i).getAt(0) ));
-            a.setAt(0, 2, -( locC.at(i).getAt(1) - refC.at(i).getAt(1) ));
-            a.setAt(0, 3, -( locC.at(i).getAt(2) - refC.at(i).getAt(2) ));
-            a.setAt(1, 0, ( locC.at(i).getAt(0) - refC.at(i).getAt(0) ));
-            a.setAt(1, 2, ( locC.at(i).getAt(2) + refC.at(i).getAt(2) ));
-            a.setAt(1, 3, -( locC.at(i).getAt(1) + refC.at(i).getAt(1) ));
-            a.setAt(2, 0, ( locC.at(i).getAt(1) - refC.at(i).getAt(1) ));
-            a.setAt(2, 1, -( locC.at(i).getAt(2) + refC.at(i).getAt(2) ));
-            a.setAt(2, 3, ( locC.at(i).getAt(0) + refC.at(i).getAt(0) ));
-            a.setAt(3, 0, ( locC.at(i).getAt(2) - refC.at(i).getAt(2) ));
-            a.setAt(3, 1, ( locC.at(i).getAt(1) + refC.at(i).getAt(1) ));
-            a.setAt(3, 2, -( locC.at(i).getAt(0) + refC.at(i).getAt(0) ));
-            result.push_back(a);
-        }
-    }
-    return result;
-}
-
-/*!
- * \brief normalEquationMatrix
- * \param vecA
- * \return
- */
-OiMat ExtendedTemperatureCompensation::normalEquationMatrix(vector<OiMat> vecA)
-{
-    OiMat result(4, 4);
-    foreach(OiMat a, vecA){
-        result +=  a.t() * a;
-    }
-    return result;
-}
-
-/*!
- * \brief quaternion; SVD to get the transformation vector (quaternion)
- * \param n
- * \return
- */
-OiVec ExtendedTemperatureCompensation::quaternion(OiMat n)
-{
-    OiVec q(4);
-    try{
-        OiMat u(4,4);
-        OiMat v(4,4);
-        OiVec s(4);
-        n.svd(u, s, v);
-        u.getCol(q, 3);
-    }catch(runtime_error& e){
-        svdError = true;
-    }
-    return q;
-}
-
-/*!
- * \brief rotationMatrix
- * \param q
- * \return
- */
-OiMat ExtendedTemperatureCompensation::rotationMatrix(OiVec q)
-{
-    OiMat result(3, 3);
-    result.setAt(0, 0, q.getAt(0)*q.getAt(0) + q.getAt(1)*q.getAt(1) - q.getAt(2)*q.getAt(2) - q.getAt(3)*q.getAt(3));
-    result.setAt(0, 1, 2*(q.getAt(1)*q.getAt(2) - q.getAt(0)*q.getAt(3)));
-    result.setAt(0, 2, 2*(q.getAt(1)*q.getAt(3) + q.getAt(0)*q.getAt(2)));
-    result.setAt(1, 0, 2*(q.getAt(1)*q.getAt(2) + q.getAt(0)*q.getAt(3)));
-    result.setAt(1, 1, q.getAt(0)*q.getAt(0) - q.getAt(1)*q.getAt(1) + q.getAt(2)*q.getAt(2) - q.getAt(3)*q.getAt(3));
-    result.setAt(1, 2, 2*(q.getAt(2)*q.getAt(3) - q.getAt(0)*q.getAt(1)));
-    result.setAt(2, 0, 2*(q.getAt(3)*q.getAt(1) - q.getAt(0)*q.getAt(2)));
-    result.setAt(2, 1, 2*(q.getAt(3)*q.getAt(2) + q.getAt(0)*q.getAt(1)));
-    result.setAt(2, 2, q.getAt(0)*q.getAt(0) - q.getAt(1)*q.getAt(1) - q.getAt(2)*q.getAt(2) + q.getAt(3)*q.getAt(3));
+    sx = x0(3);
+    sy = x0(4);
+    sz = x0(5);
 
-    return result;
-}
+    l0(0) = sx * loc.getAt(0) + sx * x0(2) * loc.getAt(1) - sx * x0(1) * loc.getAt(2) + x0(6); //observation of x
+    l0(1) = sy * loc.getAt(1) - sy * x0(2) * loc.getAt(0) + sy * x0(0) * loc.getAt(2) + x0(7); //observation of y
+    l0(2) = sz * loc.getAt(2) + sz * x0(1) * loc.getAt(0) - sz * x0(0) * loc.getAt(1) + x0(8); //observation of z
 
-/*!
- * \brief getRotationAngles
- * \param r
- * \return
- */
-OiVec ExtendedTemperatureCompensation::getRotationAngles(OiMat r)
-{
-    OiVec rot(3);
-    rot.setAt(0, qAtan2(-r.getAt(2,1), r.getAt(2,2))); //alpha
-    rot.setAt(1, qAsin(r.getAt(2,0))); //beta
-    rot.setAt(2, qAtan2(-r.getAt(1,0), r.getAt(0,0))); //gamma
-    if( qFabs(qCos(rot.getAt(1)) * qCos(rot.getAt(2))) - qFabs(r.getAt(0,0)) > 0.01 ){
-        rot.setAt(1, PI - rot.getAt(1));
-    }
-    rot.add(1.0);
-
-    return rot;
+    return l0;
 }
 
 /*!
@@ -740,26 +540,12 @@ OiVec ExtendedTemperatureCompensation::getRotationAngles(OiMat r)
  * \param trans
  * \return
  */
-OiMat ExtendedTemperatureCompensation::getTranslationMatrix(OiVec trans)
+fixed::Mat<4, 4> ExtendedTemperatureCompensation::getTranslationMatrix(const OiVec &trans)
 {
-    OiMat tmpTranslation(4,4);
-
-    tmpTranslation.setAt(0,0,1.0);
-    tmpTranslation.setAt(0,1,0.0);
-    tmpTranslation.setAt(0,2,0.0);
-    tmpTranslation.setAt(0,3,trans.getAt(0));
-    tmpTranslation.setAt(1,0,0.0);
-    tmpTranslation.setAt(1,1,1.0);
-    tmpTranslation.setAt(1,2,0.0);
-    tmpTranslation.setAt(1,3,trans.getAt(1));
-    tmpTranslation.setAt(2,0,0.0);
-    tmpTranslation.setAt(2,1,0.0);
-    tmpTranslation.setAt(2,2,1.0);
-    tmpTranslation.setAt(2,3,trans.getAt(2));
-    tmpTranslation.setAt(3,0,0.0);
-    tmpTranslation.setAt(3,1,0.0);
-    tmpTranslation.setAt(3,2,0.0);
-    tmpTranslation.setAt(3,3,1.0);
+    fixed::Mat<4, 4> tmpTranslation = fixed::Mat<4, 4>::identity();
+    tmpTranslation(0,3) = trans.getAt(0);
+    tmpTranslation(1,3) = trans.getAt(1);
+    tmpTranslation(2,3) = trans.getAt(2);
 
     return tmpTranslation;
 }
@@ -769,26 +555,13 @@ OiMat ExtendedTemperatureCompensation::getTranslationMatrix(OiVec trans)
  * \param s
  * \return
  */
-OiMat ExtendedTemperatureCompensation::getScaleMatrix(OiVec s)
+fixed::Mat<4, 4> ExtendedTemperatureCompensation::getScaleMatrix(const OiVec &s)
 {
-    OiMat tmpScale(4,4);
-
-    tmpScale.setAt(0,0,s.getAt(0));
-    tmpScale.setAt(0,1,0.0);
-    tmpScale.setAt(0,2,0.0);
-    tmpScale.setAt(0,3,0.0);
-    tmpScale.setAt(1,0,0.0);
-    tmpScale.setAt(1,1,s.getAt(1));
-    tmpScale.setAt(1,2,0.0);
-    tmpScale.setAt(1,3,0.0);
-    tmpScale.setAt(2,0,0.0);
-    tmpScale.setAt(2,1,0.0);
-    tmpScale.setAt(2,2,s.getAt(2));
-    tmpScale.setAt(2,3,0.0);
-    tmpScale.setAt(3,0,0.0);
-    tmpScale.setAt(3,1,0.0);
-    tmpScale.setAt(3,2,0.0);
-    tmpScale.setAt(3,3,1.0);
+    fixed::Mat<4, 4> tmpScale;
+    tmpScale(0,0) = s.getAt(0);
+    tmpScale(1,1) = s.getAt(1);
+    tmpScale(2,2) = s.getAt(2);
+    tmpScale(3,3) = 1.0;
 
     return tmpScale;
 }
@@ -3,6 +3,7 @@
 
 #include "systemtransformation.h"
 #include "pluginmetadata.h"
+#include "helmertsolver.h"
 #include <QtCore/qmath.h>
 
 using namespace oi;
@@ -61,26 +62,17 @@ private:
     OiVec approxRotation();
     OiVec approxScale(OiVec rot);
     OiVec calcCentroidPoint(QList<OiVec> points);
-    OiVec fillLVector();
-    OiMat fillAMatrix(OiVec x0);
-    OiMat getRotationMatrix(OiVec rot);
+    fixed::Vec<3> fillLVector(const OiVec &loc);
+    fixed::Mat<3, 9> fillAMatrix(const OiVec &loc, const fixed::Vec<9> &x0);
+    fixed::Mat<4, 4> getRotationMatrix(const OiVec &rot);
     void preliminaryTransformation();
-    OiMat scaleMatrix(OiVec s);
-    OiVec fillL0Vector(OiVec x0);
-
-    //for approx of rotation
-    vector<OiVec> centroidReducedCoord(QList<OiVec> input, OiVec centroid);
-    vector<OiMat> modelMatrix(vector<OiVec> locC, vector<OiVec> refC);
-    OiMat normalEquationMatrix(vector<OiMat>vecA);
-    OiVec quaternion(OiMat n);
-    OiMat rotationMatrix(OiVec q);
-    OiVec getRotationAngles(OiMat r);
-
+    fixed::Mat<4, 4> scaleMatrix(const OiVec &s);
+    fixed::Vec<3> fillL0Vector(const OiVec &loc, const fixed::Vec<9> &x0);
 
     //to save the values in the transformation parameter
     //rotation matrix see functions above "getRoationMatrix(OiVec rot)"
-    OiMat getTranslationMatrix(OiVec trans);
-    OiMat getScaleMatrix(OiVec s);
+    fixed::Mat<4, 4> getTranslationMatrix(const OiVec &trans);
+    fixed::Mat<4, 4> getScaleMatrix(const OiVec &s);
 };
 
 #endif // P_EXTENDEDTEMPERATURECOMPENSATION_H
@@ -21,11 +21,25 @@
 #include "p_pointfrompoints.h"
 #include "p_register.h"
 #include "p_factory.h"
+#include "helmertsolver.h"
+#include "fixedmatrix.h"
+#include "p_helmert7Param.h"
+#include "trafoparam.h"
 
 #include "test_defines.h"
 
 using namespace oi;
 
+//! Helmert7Param with access to its common points (they are set by OpenIndy otherwise)
+class TestHelmert7Param : public Helmert7Param
+{
+public:
+    void addCommonPoint(const OiVec &start, const OiVec &destination){
+        this->inputPointsStartSystem.append(Point(false, Position(start)));
+        this->inputPointsDestinationSystem.append(Point(false, Position(destination)));
+    }
+};
+
 class FunctionTest : public QObject
 {
     Q_OBJECT
@@ -59,6 +73,20 @@ private Q_SLOTS:
     void testPointFromPoints_circle();
 
     void testBestFitSphere_residuals();
+    void testBestFitSphere_manyPoints();
+    void testHelmertSolver_batch();
+    void testFixedMatrix_cholesky();
+    void testFixedMatrix_ldlt();
+    void testFixedMatrix_solveSymmetric();
+    void testFixedMatrix_solvePositiveDefinite();
+    void testFixedMatrix_solve();
+    void testFixedMatrix_invertSymmetric();
+    void testFixedMatrix_eigenSymmetric();
+    void testFixedMatrix_singular();
+    void testFixedMatrix_indefinite();
+    void testHelmert7Param_scale();
+    void testHelmert7Param_noScale();
+    void testHelmert7Param_temperatureScale();
     void testBestFitCircleInPlane_residuals2();
     void testBestFitCircleInPlane_residuals();
     void testBestFitLine_residuals();    
@@ -162,6 +190,11 @@ private:
     QPointer<Circle> createCircle(double x, double y, double z, double i, double j, double k, double r);
     QPointer<Line> createLine(double x, double y, double z, double i, double j, double k);
 
+    fixed::Mat<6, 6> createPositiveDefiniteMatrix();
+    fixed::Mat<4, 4> createIndefiniteMatrix();
+
+    bool execHelmert7Param(const ScalarInputParams &params, const fixed::Mat<3, 3> &rotation, const fixed::Vec<3> &translation, const double &scale, OiMat &homogenMatrix);
+
 };
 
 FunctionTest::FunctionTest()
@@ -479,6 +512,58 @@ QPointer<Line> FunctionTest::createLine(double x, double y, double z, double i,
     return feature;
 }
 
+fixed::Mat<6, 6> FunctionTest::createPositiveDefiniteMatrix() {
+    // m^T * m + I
+    fixed::Mat<6, 6> m;
+    for(int i = 0; i < 6; i++){
+        for(int j = 0; j < 6; j++){
+            m(i, j) = qSin(1.1 * i * i + 0.7 * j * j + 0.3 * i * j + 0.5);
+        }
+    }
+    return m.t() * m + fixed::Mat<6, 6>::identity();
+}
+
+fixed::Mat<4, 4> FunctionTest::createIndefiniteMatrix() {
+    fixed::Mat<4, 4> a;
+    const double values[4][4] = {{4.0, 1.0, 2.0, 0.5}, {1.0, -3.0, 0.5, 1.0}, {2.0, 0.5, 2.0, 1.0}, {0.5, 1.0, 1.0, -1.0}};
+    for(int i = 0; i < 4; i++){
+        for(int j = 0; j < 4; j++){
+            a(i, j) = values[i][j];
+        }
+    }
+    return a;
+}
+
+bool FunctionTest::execHelmert7Param(const ScalarInputParams &params, const fixed::Mat<3, 3> &rotation, const fixed::Vec<3> &translation, const double &scale, OiMat &homogenMatrix) {
+    TestHelmert7Param *helmert = new TestHelmert7Param();
+    QPointer<Function> function = helmert;
+    function->init();
+    QObject::connect(function.data(), &Function::sendMessage, this, &FunctionTest::printMessage, Qt::AutoConnection);
+    function->setScalarInputParams(params);
+
+    // destination = translation + scale * rotation * start
+    for(int i = 0; i < 8; i++){
+        fixed::Vec<3> start;
+        start(0) = 10.0 * qCos(0.8 * i);
+        start(1) = 5.0 * qSin(1.1 * i);
+        start(2) = 0.5 * i;
+        fixed::Vec<3> destination = translation + scale * (rotation * start);
+        helmert->addCommonPoint(start.toOiVec(), destination.toOiVec());
+    }
+
+    QPointer<TrafoParam> trafoParam = new TrafoParam();
+    QPointer<FeatureWrapper> trafoParamFeature = new FeatureWrapper();
+    trafoParamFeature->setTrafoParam(trafoParam);
+
+    bool res = function->exec(trafoParamFeature);
+    if(res){
+        homogenMatrix = trafoParam->getHomogenMatrix();
+    }
+
+    delete function.data();
+    return res;
+}
+
 void FunctionTest::testRegisterPoint()
 {
 
@@ -2958,6 +3043,473 @@ void FunctionTest::testBestFitSphere_residuals()
     delete function.data();
 }
 
+void FunctionTest::testBestFitSphere_manyPoints()
+{
+    QPointer<Function> function = new BestFitSphere();
+    function->init();
+    QObject::connect(function.data(), &Function::sendMessage, this, &FunctionTest::printMessage, Qt::AutoConnection);
+
+    QPointer<Sphere> feature = new Sphere(false);
+    QPointer<FeatureWrapper> wrapper = new FeatureWrapper();
+    wrapper->setSphere(feature);
+
+    // 20000 points on a sphere (center 1 2 3, radius 0.5) with alternating radial deviations of +-0.001
+    // (the dense adjustment was not able to handle that many observations)
+    QString data;
+    const int numPoints = 20000;
+    for(int i = 0; i < numPoints; i++){
+        double z = 1.0 - (2.0 * i + 1.0) / numPoints;
+        double rz = qSqrt(1.0 - z * z);
+        double phi = i * 2.399963229728653;
+        double r = 0.5 + (i % 2 == 0 ? 0.001 : -0.001);
+        data.append(QString("%1 %2 %3\n").arg(1.0 + r * rz * qCos(phi), 0, 'f', 9)
+                    .arg(2.0 + r * rz * qSin(phi), 0, 'f', 9).arg(3.0 + r * z, 0, 'f', 9));
+    }
+    addInputObservations(data, function);
+
+    bool res = function->exec(wrapper);
+    QVERIFY2(res, "exec");
+
+    DEBUG_SPHERE(feature);
+
+    COMPARE_DOUBLE(feature->getPosition().getVector().getAt(0), 1.0, 0.0001);
+    COMPARE_DOUBLE(feature->getPosition().getVector().getAt(1), 2.0, 0.0001);
+    COMPARE_DOUBLE(feature->getPosition().getVector().getAt(2), 3.0, 0.0001);
+    COMPARE_DOUBLE(feature->getRadius().getRadius(), 0.5, 0.0001);
+
+    COMPARE_DOUBLE(function->getStatistic().getDisplayResidual(1000).corrections.value("vr", -1), (0.001), 0.0001);
+    COMPARE_DOUBLE(function->getStatistic().getDisplayResidual(1001).corrections.value("vr", -1), (-0.001), 0.0001);
+
+    delete function.data();
+}
+
+
+void FunctionTest::testHelmertSolver_batch()
+{
+    // 40 stations with 50 common points each, every station with its own rotation, translation and scale
+    const int numStations = 40;
+    const int numPoints = 50;
+
+    vector<HelmertSolver> solvers(numStations);
+    vector<fixed::Vec<3> > angles(numStations);
+    vector<fixed::Vec<3> > translations(numStations);
+    vector<double> scales(numStations);
+    for(int s = 0; s < numStations; s++){
+        angles[s](0) = -3.0 + 0.15 * s;
+        angles[s](1) = 1.2 * qSin(0.7 * s);
+        angles[s](2) = 3.0 - 0.13 * s;
+        translations[s](0) = 1000.0 + 10.0 * s;
+        translations[s](1) = -500.0 + 25.0 * qCos(s);
+        translations[s](2) = 20.0 * s;
+        scales[s] = 1.0 + 0.00001 * (s - 20);
+
+        // scale estimated for even stations, fixed for odd stations
+        if(s % 2 == 1){
+            solvers[s].setFixedScale(scales[s]);
+        }
+
+        fixed::Mat<3, 3> r = HelmertSolver::getRotationMatrix(angles[s](0), angles[s](1), angles[s](2));
+        for(int i = 0; i < numPoints; i++){
+            double start[3] = {5000.0 + 20.0 * qCos(0.9 * i), -2000.0 + 15.0 * qSin(1.3 * i), 300.0 + 0.2 * i};
+            fixed::Vec<3> p;
+            for(int k = 0; k < 3; k++){
+                p(k) = start[k];
+            }
+            fixed::Vec<3> q = translations[s] + scales[s] * (r * p);
+            double destination[3];
+            for(int k = 0; k < 3; k++){
+                destination[k] = q(k) + ((i + k) % 2 == 0 ? 0.00001 : -0.00001);
+            }
+            solvers[s].addPoint(start, destination);
+        }
+    }
+
+    vector<HelmertSolution> solutions;
+    HelmertSolver::solveBatch(solvers, solutions);
+    QCOMPARE((int)solutions.size(), numStations);
+
+    for(int s = 0; s < numStations; s++){
+        QVERIFY2(solutions[s].isValid, qPrintable(solutions[s].errorMessage));
+
+        fixed::Vec<3> rot = HelmertSolver::getRotationAngles(solutions[s].rotation);
+        COMPARE_DOUBLE(rot(0), angles[s](0), 0.000001);
+        COMPARE_DOUBLE(rot(1), angles[s](1), 0.000001);
+        COMPARE_DOUBLE(rot(2), angles[s](2), 0.000001);
+        COMPARE_DOUBLE(solutions[s].translation(0), translations[s](0), 0.01);
+        COMPARE_DOUBLE(solutions[s].translation(1), translations[s](1), 0.01);
+        COMPARE_DOUBLE(solutions[s].translation(2), translations[s](2), 0.01);
+        COMPARE_DOUBLE(solutions[s].scale, scales[s], 0.000001);
+        QVERIFY(solutions[s].stdev < 0.0001);
+    }
+
+    // the serial solution is the same
+    vector<HelmertSolution> serial;
+    HelmertSolver::solveBatch(solvers, serial, 1);
+    for(int s = 0; s < numStations; s++){
+        COMPARE_DOUBLE(serial[s].translation(0), solutions[s].translation(0), 0.0000001);
+        COMPARE_DOUBLE(serial[s].scale, solutions[s].scale, 0.0000001);
+    }
+
+    // collinear points do not define the rotation
+    HelmertSolver collinear;
+    for(int i = 0; i < 5; i++){
+        double point[3] = {1.0 * i, 2.0 * i, 3.0 * i};
+        collinear.addPoint(point, point);
+    }
+    HelmertSolution solution;
+    QVERIFY(!collinear.solve(solution));
+}
+
+void FunctionTest::testFixedMatrix_cholesky()
+{
+    fixed::Mat<6, 6> a = createPositiveDefiniteMatrix();
+
+    fixed::Mat<6, 6> l;
+    QVERIFY(fixed::cholesky(a, l));
+
+    // l is lower triangular with a positive diagonal and l * l^T is a
+    OiMat llt = l.toOiMat() * l.toOiMat().t();
+    for(int i = 0; i < 6; i++){
+        QVERIFY(l(i, i) > 0.0);
+        for(int j = 0; j < 6; j++){
+            if(j > i){
+                QCOMPARE(l(i, j), 0.0);
+            }
+            COMPARE_DOUBLE(llt.getAt(i, j), a(i, j), 0.000000001);
+        }
+    }
+}
+
+void FunctionTest::testFixedMatrix_ldlt()
+{
+    fixed::Mat<6, 6> a = createPositiveDefiniteMatrix();
+
+    fixed::Mat<6, 6> l;
+    fixed::Vec<6> d;
+    QVERIFY(fixed::ldlt(a, l, d));
+
+    // l is unit lower triangular, d is positive and l * diag(d) * l^T is a
+    OiMat dm(6, 6);
+    for(int i = 0; i < 6; i++){
+        QCOMPARE(l(i, i), 1.0);
+        QVERIFY(d(i) > 0.0);
+        dm.setAt(i, i, d(i));
+        for(int j = i + 1; j < 6; j++){
+            QCOMPARE(l(i, j), 0.0);
+        }
+    }
+    OiMat ldlt = l.toOiMat() * dm * l.toOiMat().t();
+    for(int i = 0; i < 6; i++){
+        for(int j = 0; j < 6; j++){
+            COMPARE_DOUBLE(ldlt.getAt(i, j), a(i, j), 0.000000001);
+        }
+    }
+
+    // the diagonal of the Cholesky factor is the square root of d
+    fixed::Mat<6, 6> c;
+    QVERIFY(fixed::cholesky(a, c));
+    for(int i = 0; i < 6; i++){
+        COMPARE_DOUBLE(c(i, i), qSqrt(d(i)), 0.000000001);
+    }
+}
+
+void FunctionTest::testFixedMatrix_solveSymmetric()
+{
+    fixed::Mat<6, 6> a = createPositiveDefiniteMatrix();
+    fixed::Vec<6> b;
+    for(int i = 0; i < 6; i++){
+        b(i) = 1.0 + 0.5 * i - 0.1 * i * i;
+    }
+
+    fixed::Vec<6> x;
+    QVERIFY(fixed::solveSymmetric(a, b, x));
+
+    OiVec expected = a.toOiMat().inv() * b.toOiVec();
+    for(int i = 0; i < 6; i++){
+        COMPARE_DOUBLE(x(i), expected.getAt(i), 0.000000001);
+    }
+}
+
+void FunctionTest::testFixedMatrix_solvePositiveDefinite()
+{
+    fixed::Mat<6, 6> a = createPositiveDefiniteMatrix();
+    fixed::Vec<6> b;
+    for(int i = 0; i < 6; i++){
+        b(i) = 1.0 + 0.5 * i - 0.1 * i * i;
+    }
+
+    fixed::Vec<6> x;
+    QVERIFY(fixed::solvePositiveDefinite(a, b, x));
+
+    OiVec expected = a.toOiMat().inv() * b.toOiVec();
+    for(int i = 0; i < 6; i++){
+        COMPARE_DOUBLE(x(i), expected.getAt(i), 0.000000001);
+    }
+}
+
+void FunctionTest::testFixedMatrix_solve()
+{
+    // not symmetric and with a small first pivot, so the rows have to be swapped
+    fixed::Mat<5, 5> a;
+    fixed::Vec<5> b;
+    for(int i = 0; i < 5; i++){
+        for(int j = 0; j < 5; j++){
+            a(i, j) = qSin(0.9 * i + 1.7 * j) + (i == j ? 3.0 : 0.0);
+        }
+        b(i) = 2.0 - 0.3 * i;
+    }
+    a(0, 0) = 0.001;
+
+    fixed::Vec<5> x;
+    QVERIFY(fixed::solve(a, b, x));
+
+    OiVec expected = a.toOiMat().inv() * b.toOiVec();
+    for(int i = 0; i < 5; i++){
+        COMPARE_DOUBLE(x(i), expected.getAt(i), 0.000000001);
+    }
+}
+
+void FunctionTest::testFixedMatrix_invertSymmetric()
+{
+    fixed::Mat<6, 6> a = createPositiveDefiniteMatrix();
+
+    fixed::Mat<6, 6> inverse;
+    QVERIFY(fixed::invertSymmetric(a, inverse));
+
+    OiMat expected = a.toOiMat().inv();
+    for(int i = 0; i < 6; i++){
+        for(int j = 0; j < 6; j++){
+            COMPARE_DOUBLE(inverse(i, j), expected.getAt(i, j), 0.000000001);
+            QCOMPARE(inverse(i, j), inverse(j, i));
+        }
+    }
+}
+
+void FunctionTest::testFixedMatrix_eigenSymmetric()
+{
+    // positive definite: the eigenvalues are the singular values of OiMat::svd
+    fixed::Mat<6, 6> a = createPositiveDefiniteMatrix();
+
+    fixed::Vec<6> values;
+    fixed::Mat<6, 6> vectors;
+    QVERIFY(fixed::eigenSymmetric(a, values, vectors));
+
+    OiMat u(6, 6);
+    OiVec d(6);
+    OiMat v(6, 6);
+    a.toOiMat().svd(u, d, v);
+
+    for(int i = 0; i < 6; i++){
+        if(i > 0){
+            QVERIFY(values(i) < values(i - 1));
+        }
+
+        // the singular value and vector of the same eigenvalue (the vectors are equal up to their sign)
+        int index = 0;
+        for(int j = 1; j < 6; j++){
+            if(qAbs(d.getAt(j) - values(i)) < qAbs(d.getAt(index) - values(i))){
+                index = j;
+            }
+        }
+        COMPARE_DOUBLE(values(i), d.getAt(index), 0.000000001);
+        double dot = 0.0;
+        for(int k = 0; k < 6; k++){
+            dot += vectors(k, i) * u.getAt(k, index);
+        }
+        COMPARE_DOUBLE(qAbs(dot), 1.0, 0.000000001);
+    }
+
+    // indefinite: a * v = lambda * v and the vectors are orthonormal
+    fixed::Mat<4, 4> b = createIndefiniteMatrix();
+
+    fixed::Vec<4> indefiniteValues;
+    fixed::Mat<4, 4> indefiniteVectors;
+    QVERIFY(fixed::eigenSymmetric(b, indefiniteValues, indefiniteVectors));
+    QVERIFY(indefiniteValues(0) > 0.0);
+    QVERIFY(indefiniteValues(3) < 0.0);
+
+    OiMat av = b.toOiMat() * indefiniteVectors.toOiMat();
+    OiMat vtv = indefiniteVectors.toOiMat().t() * indefiniteVectors.toOiMat();
+    for(int i = 0; i < 4; i++){
+        for(int j = 0; j < 4; j++){
+            const double lambdaV = indefiniteValues(j) * indefiniteVectors(i, j);
+            COMPARE_DOUBLE(av.getAt(i, j), lambdaV, 0.000000001);
+            COMPARE_DOUBLE(vtv.getAt(i, j), (i == j ? 1.0 : 0.0), 0.000000001);
+        }
+    }
+}
+
+void FunctionTest::testFixedMatrix_singular()
+{
+    // symmetric with rank 2: the third pivot is exactly 0
+    fixed::Mat<3, 3> a;
+    const double values[3][3] = {{1.0, 2.0, 3.0}, {2.0, 4.0, 6.0}, {3.0, 6.0, 10.0}};
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            a(i, j) = values[i][j];
+        }
+    }
+    fixed::Vec<3> b;
+    b(0) = 1.0;
+    b(1) = 2.0;
+    b(2) = 3.0;
+
+    fixed::Mat<3, 3> l;
+    fixed::Vec<3> d;
+    fixed::Vec<3> x;
+    fixed::Mat<3, 3> inverse;
+    QVERIFY(!fixed::cholesky(a, l));
+    QVERIFY(!fixed::ldlt(a, l, d));
+    QVERIFY(!fixed::solveSymmetric(a, b, x));
+    QVERIFY(!fixed::solvePositiveDefinite(a, b, x));
+    QVERIFY(!fixed::invertSymmetric(a, inverse));
+    QVERIFY(!fixed::solve(a, b, x));
+
+    // not symmetric with two proportional columns
+    fixed::Mat<3, 3> g;
+    const double general[3][3] = {{4.0, 8.0, 1.0}, {2.0, 4.0, 3.0}, {1.0, 2.0, 5.0}};
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            g(i, j) = general[i][j];
+        }
+    }
+    QVERIFY(!fixed::solve(g, b, x));
+}
+
+void FunctionTest::testFixedMatrix_indefinite()
+{
+    fixed::Mat<4, 4> a = createIndefiniteMatrix();
+    fixed::Vec<4> b;
+    for(int i = 0; i < 4; i++){
+        b(i) = 1.0 - 0.4 * i;
+    }
+
+    // Cholesky needs a positive definite matrix
+    fixed::Mat<4, 4> l;
+    fixed::Vec<4> x;
+    fixed::Mat<4, 4> inverse;
+    QVERIFY(!fixed::cholesky(a, l));
+    QVERIFY(!fixed::solvePositiveDefinite(a, b, x));
+    QVERIFY(!fixed::invertSymmetric(a, inverse));
+
+    // LDL^T does not, d has negative elements then
+    fixed::Vec<4> d;
+    QVERIFY(fixed::ldlt(a, l, d));
+    bool negative = false;
+    for(int i = 0; i < 4; i++){
+        negative = negative || d(i) < 0.0;
+    }
+    QVERIFY(negative);
+
+    QVERIFY(fixed::solveSymmetric(a, b, x));
+    OiVec expected = a.toOiMat().inv() * b.toOiVec();
+    for(int i = 0; i < 4; i++){
+        COMPARE_DOUBLE(x(i), expected.getAt(i), 0.000000001);
+    }
+}
+
+void FunctionTest::testHelmert7Param_scale()
+{
+    fixed::Mat<3, 3> rotation = HelmertSolver::getRotationMatrix(0.01, -0.02, 0.5);
+    fixed::Vec<3> translation;
+    translation(0) = 100.0;
+    translation(1) = -50.0;
+    translation(2) = 2.0;
+    const double scale = 1.0001;
+
+    ScalarInputParams scalarInputParams;
+    scalarInputParams.stringParameter.insert("calculate scale", "yes");
+    scalarInputParams.stringParameter.insert("use temperature", "no");
+
+    OiMat h;
+    QVERIFY(execHelmert7Param(scalarInputParams, rotation, translation, scale, h));
+
+    // h = translation * scale * rotation
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            const double expected = scale * rotation(i, j);
+            COMPARE_DOUBLE(h.getAt(i, j), expected, 0.000000001);
+        }
+        COMPARE_DOUBLE(h.getAt(i, 3), translation(i), 0.000001);
+        COMPARE_DOUBLE(h.getAt(3, i), 0.0, 0.000000001);
+    }
+    COMPARE_DOUBLE(h.getAt(3, 3), 1.0, 0.000000001);
+}
+
+void FunctionTest::testHelmert7Param_noScale()
+{
+    fixed::Mat<3, 3> rotation = HelmertSolver::getRotationMatrix(0.01, -0.02, 0.5);
+    fixed::Vec<3> translation;
+    translation(0) = 100.0;
+    translation(1) = -50.0;
+    translation(2) = 2.0;
+
+    ScalarInputParams scalarInputParams;
+    scalarInputParams.stringParameter.insert("calculate scale", "no");
+    scalarInputParams.stringParameter.insert("use temperature", "no");
+
+    // the points are scaled, but the scale is fixed to 1.0
+    const double scale = 1.0001;
+    OiMat h;
+    QVERIFY(execHelmert7Param(scalarInputParams, rotation, translation, scale, h));
+
+    // the rotation is unaffected and the translation maps the centroids onto each other
+    fixed::Vec<3> startCentroid;
+    fixed::Vec<3> destinationCentroid;
+    for(int i = 0; i < 8; i++){
+        fixed::Vec<3> start;
+        start(0) = 10.0 * qCos(0.8 * i);
+        start(1) = 5.0 * qSin(1.1 * i);
+        start(2) = 0.5 * i;
+        startCentroid += start / 8.0;
+        destinationCentroid += (translation + scale * (rotation * start)) / 8.0;
+    }
+    fixed::Vec<3> expectedTranslation = destinationCentroid - rotation * startCentroid;
+
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            COMPARE_DOUBLE(h.getAt(i, j), rotation(i, j), 0.000000001);
+        }
+        COMPARE_DOUBLE(h.getAt(i, 3), expectedTranslation(i), 0.000001);
+        COMPARE_DOUBLE(h.getAt(3, i), 0.0, 0.000000001);
+    }
+    COMPARE_DOUBLE(h.getAt(3, 3), 1.0, 0.000000001);
+}
+
+void FunctionTest::testHelmert7Param_temperatureScale()
+{
+    fixed::Mat<3, 3> rotation = HelmertSolver::getRotationMatrix(0.01, -0.02, 0.5);
+    fixed::Vec<3> translation;
+    translation(0) = 100.0;
+    translation(1) = -50.0;
+    translation(2) = 2.0;
+
+    // steel at 30 degrees, measured in a system at 20 degrees
+    QVERIFY(getMaterials().contains("steel"));
+    const double scale = getTemperatureExpansion("steel", 30.0, 20.0);
+    QVERIFY(scale > 1.0);
+
+    ScalarInputParams scalarInputParams;
+    scalarInputParams.stringParameter.insert("calculate scale", "yes");
+    scalarInputParams.stringParameter.insert("use temperature", "yes");
+    scalarInputParams.stringParameter.insert("use reference temperature", "yes");
+    scalarInputParams.stringParameter.insert("material", "steel");
+    scalarInputParams.doubleParameter.insert("reference", 20.0);
+    scalarInputParams.doubleParameter.insert("actual", 30.0);
+
+    OiMat h;
+    QVERIFY(execHelmert7Param(scalarInputParams, rotation, translation, scale, h));
+
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            const double expected = scale * rotation(i, j);
+            COMPARE_DOUBLE(h.getAt(i, j), expected, 0.000000001);
+        }
+        COMPARE_DOUBLE(h.getAt(i, 3), translation(i), 0.000001);
+        COMPARE_DOUBLE(h.getAt(3, i), 0.0, 0.000000001);
+    }
+    COMPARE_DOUBLE(h.getAt(3, 3), 1.0, 0.000000001);
+}
 
 void FunctionTest::testPointFromPoints_point()
 {
@@ -0,0 +1,74 @@
+#-------------------------------------------------
+#
+# Tests of the point cloud segmentation
+#
+#-------------------------------------------------
+CONFIG += c++11
+QT       += testlib
+
+QT       += core gui widgets xml
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += \
+    tst_pointcloudsegmentation.cpp \
+    ../segmentationbenchmark/ps_syntheticscene.cpp \
+    ../../functions/fit/pointmoments.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_cylindersegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_distancekernels.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_downsampling.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_generalmath.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_instrumentation.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_linearoctree.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_mergeindex.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_node.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_octree.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_planesegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloud.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloudcache.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloudloader.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointstore.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_ransac.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_shapesegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_spheresegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_tiledsegmentation.cpp
+
+HEADERS += \
+    ../segmentationbenchmark/ps_syntheticscene.h \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloud.h \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_tiledsegmentation.h
+
+DEFINES += SRCDIR=$$shell_quote($$PWD)
+
+# test dependencies
+INCLUDEPATH += \
+    ../include \
+    ../segmentationbenchmark \
+    ../../functions/fit \
+    ../../functions/generateFeature/pointcloud_segmentation
+
+include(../../build/dependencies.pri)
+
+CONFIG(debug, debug|release) {
+    BUILD_DIR=debug
+} else {
+    BUILD_DIR=release
+}
+
+linux-g++ {
+LIBS += \
+    -L../../lib/OpenIndy-Core/lib/OpenIndy-Math/bin/$$BUILD_DIR -lopenIndyMath
+} else : win32 {
+LIBS += \
+    -L../../lib/OpenIndy-Core/lib/OpenIndy-Math/bin/$$BUILD_DIR -lopenIndyMath1
+}
+
+QMAKE_EXTRA_TARGETS += run-test
+win32{
+run-test.commands = $$shell_quote($$OUT_PWD/$$BUILD_DIR/$$TARGET) -o $$shell_path(../reports/$${TARGET}.xml),xml
+}else:linux{
+run-test.commands = $$shell_quote($$OUT_PWD/$$TARGET) -o $$shell_path(../reports/$${TARGET}.xml),xml
+}
@@ -0,0 +1,1178 @@
+#include <QString>
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "ps_pointcloud.h"
+#include "ps_pointcloudloader.h"
+#include "ps_pointcloudcache.h"
+#include "ps_octree.h"
+#include "ps_linearoctree.h"
+#include "ps_distancekernels.h"
+#include "ps_random.h"
+#include "ps_planesegment.h"
+#include "ps_spheresegment.h"
+#include "ps_cylindersegment.h"
+#include "ps_tiledsegmentation.h"
+
+#include "ps_syntheticscene.h"
+
+using namespace std;
+
+//! identifies an octree node by its depth and center (the same in PS_Octree and PS_LinearOctree), empty for no node
+typedef vector<float> NodeKey;
+
+//! the sorted points and the keys of the top, bottom, left, right, front and back neighbours of a leaf
+struct OctreeLeaf{
+    vector<quint32> points;
+    NodeKey neighbours[6];
+};
+
+//! sets a flag after a delay to cancel a segmentation from another thread
+class CancelTask : public QRunnable
+{
+public:
+    CancelTask(QAtomicInt *canceled, const unsigned long &delay) : canceled(canceled), delay(delay){}
+
+    void run(){
+        QThread::msleep(this->delay);
+        this->canceled->storeRelease(1);
+    }
+
+private:
+    QAtomicInt *canceled;
+    unsigned long delay; //in ms
+};
+
+class PointCloudSegmentationTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PointCloudSegmentationTest();
+
+private Q_SLOTS:
+    void testDetectShapes_deterministic();
+    void testDistanceKernels();
+    void testLoader_parseFloat();
+    void testLoader_parseChunk();
+    void testLoader_chunkBoundaries();
+    void testCache_invalidation();
+    void testOctree_equivalence();
+    void testMerge_compareAllPairs();
+    void testDownsampling_assignPoints();
+    void testTiledSegmentation_stitchShapes();
+    void testDetectShapes_stopEarly();
+
+private:
+    static PS_BoundingBox_PC getEmptyBoundingBox();
+    static bool writeFile(const QString &fileName, const QByteArray &data);
+    static void getGridPoint(const int &index, float (&xyz)[3]);
+
+    static NodeKey getNodeKey(const PS_Node *node);
+    static map<NodeKey, OctreeLeaf> getOctreeLeafs(PS_Octree &octree);
+    static QString compareOctrees(PS_Octree &first, PS_Octree &second);
+
+    static vector<quint32> addPlanePiece(PS_PointStore &store, PS_Random &random, const double (&origin)[3], const double (&u)[3], const double (&v)[3],
+                                         const int &numPoints);
+    static vector<quint32> addSpherePiece(PS_PointStore &store, PS_Random &random, const double (&center)[3], const double &radius,
+                                          const double &minAzimuth, const double &maxAzimuth, const int &numPoints);
+    static vector<quint32> addCylinderPiece(PS_PointStore &store, PS_Random &random, const double (&origin)[3], const double (&axis)[3], const double &radius,
+                                            const double &minHeight, const double &maxHeight, const int &numPoints);
+    static vector<vector<quint32> > mergePieces(PS_PointStore &store, const vector<vector<quint32> > (&pieces)[3], const PS_InputParameter &param,
+                                                const bool &compareAllPairs, PS_MergeStatistics (&statistics)[3]);
+
+    static PS_InputParameter getParameter(const PS_SyntheticScene &scene, const PS_SceneParameter &sceneParam);
+    static vector<vector<quint32> > getShapePoints(PS_PointCloud &cloud);
+    static bool detectShapes(const QString &fileName, const PS_InputParameter &param, vector<vector<quint32> > &shapes);
+    static double getOverlap(const vector<quint32> &shape, const vector<quint32> &other);
+    static QString comparePartialShapes(const vector<vector<quint32> > &partialShapes, const vector<vector<quint32> > &shapes);
+
+    static double nextUniform(PS_Random &random, const double &min, const double &max);
+    static double nextOffset(PS_Random &random, const double &threshold);
+    static QString compareInliers(const vector<unsigned char> &mask, const unsigned int &numInliers,
+                                  const vector<unsigned char> &reference, const quint32 *indices, const unsigned int &count);
+};
+
+PointCloudSegmentationTest::PointCloudSegmentationTest()
+{
+}
+
+// segmentation parameters derived from the scene (see segmentationbenchmark/main.cpp)
+PS_InputParameter PointCloudSegmentationTest::getParameter(const PS_SyntheticScene &scene, const PS_SceneParameter &sceneParam)
+{
+    PS_InputParameter param;
+    param.leafSize = 100;
+    param.outlierPercentage = 0.5;
+    param.fitSampleSize = 50;
+    param.finalFit = true;
+    param.randomSeed = sceneParam.seed;
+    param.numThreads = 1;
+    param.linearOctree = true;
+    param.timeBudget = 0.0;
+    param.streamShapes = false;
+    param.downsampling = eNoDownsampling;
+    param.voxelSize = 0.0;
+    param.samplingRate = 0.1;
+
+    float maxDistance = qMax(3.0 * sceneParam.noise, 0.0005 * sceneParam.size);
+    unsigned int minPoints = (unsigned int)qMax(50.0, 0.2 * scene.getDensity() * scene.getMinArea());
+    param.planeParams.detectPlanes = true;
+    param.planeParams.minPoints = minPoints;
+    param.planeParams.maxDistance = maxDistance;
+    param.sphereParams.detectSpheres = true;
+    param.sphereParams.minPoints = minPoints;
+    param.sphereParams.maxDistance = maxDistance;
+    param.sphereParams.minRadius = 0.5 * scene.getMinRadius();
+    param.sphereParams.maxRadius = 1.5 * scene.getMaxRadius();
+    param.cylinderParams.detectCylinders = true;
+    param.cylinderParams.minPoints = minPoints;
+    param.cylinderParams.maxDistance = maxDistance;
+    param.cylinderParams.minRadius = 0.5 * scene.getMinRadius();
+    param.cylinderParams.maxRadius = 1.5 * scene.getMaxRadius();
+    return param;
+}
+
+// point indices of all detected planes, spheres and cylinders (in the order they are reported)
+vector<vector<quint32> > PointCloudSegmentationTest::getShapePoints(PS_PointCloud &cloud)
+{
+    vector<vector<quint32> > shapes;
+    foreach(PS_PlaneSegment *plane, cloud.getDetectedPlanes()){
+        shapes.push_back(plane->getPoints());
+    }
+    foreach(PS_SphereSegment *sphere, cloud.getDetectedSpheres()){
+        shapes.push_back(sphere->getPoints());
+    }
+    foreach(PS_CylinderSegment *cylinder, cloud.getDetectedCylinders()){
+        shapes.push_back(cylinder->getPoints());
+    }
+    return shapes;
+}
+
+// loads the point cloud, detects its shapes and returns their points (see getShapePoints)
+bool PointCloudSegmentationTest::detectShapes(const QString &fileName, const PS_InputParameter &param, vector<vector<quint32> > &shapes)
+{
+    PS_PointCloud cloud;
+    cloud.setWriteOutput(false);
+    if(!cloud.loadPointCloud(fileName) || !cloud.setUpOctree(param) || !cloud.detectShapes(param)){
+        return false;
+    }
+    shapes = getShapePoints(cloud);
+    return true;
+}
+
+// fraction of the points of a shape that are also points of another shape
+double PointCloudSegmentationTest::getOverlap(const vector<quint32> &shape, const vector<quint32> &other)
+{
+    vector<quint32> a = shape, b = other, common;
+    sort(a.begin(), a.end());
+    sort(b.begin(), b.end());
+    set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(common));
+    return a.empty() ? 1.0 : (double)common.size() / (double)a.size();
+}
+
+// checks that a stopped segmentation kept shapes that are contained in the shapes of a complete one (empty if it did)
+QString PointCloudSegmentationTest::comparePartialShapes(const vector<vector<quint32> > &partialShapes, const vector<vector<quint32> > &shapes)
+{
+    if(partialShapes.empty()){
+        return "no shapes kept";
+    }
+    for(size_t i = 0; i < partialShapes.size(); i++){
+        double overlap = 0.0;
+        for(size_t j = 0; j < shapes.size(); j++){
+            overlap = qMax(overlap, getOverlap(partialShapes[i], shapes[j]));
+        }
+        if(overlap < 0.9){
+            return QString("only %1 of the points of shape %2 belong to one shape of the complete segmentation").arg(overlap).arg(i);
+        }
+    }
+    return QString();
+}
+
+// uniformly distributed random number in [min, max)
+double PointCloudSegmentationTest::nextUniform(PS_Random &random, const double &min, const double &max)
+{
+    return min + (max - min) * (double)(random.next() >> 11) / 9007199254740992.0;
+}
+
+// distance from a surface in [-2 * threshold, 2 * threshold] that is not close to +-threshold (no rounding dependent results)
+double PointCloudSegmentationTest::nextOffset(PS_Random &random, const double &threshold)
+{
+    double offset = 0.0;
+    do{
+        offset = nextUniform(random, -2.0 * threshold, 2.0 * threshold);
+    }while(qAbs(qAbs(offset) - threshold) < 0.05 * threshold);
+    return offset;
+}
+
+// compares the inlier mask and the number of inliers of a kernel with the reference of the first count (indexed) points
+QString PointCloudSegmentationTest::compareInliers(const vector<unsigned char> &mask, const unsigned int &numInliers,
+                                                   const vector<unsigned char> &reference, const quint32 *indices, const unsigned int &count)
+{
+    unsigned int expected = 0;
+    for(unsigned int i = 0; i < count; i++){
+        const unsigned char inlier = reference[indices != NULL ? indices[i] : i];
+        if(mask[i] != inlier){
+            return QString("mask of point %1 is %2 instead of %3 (count %4)").arg(i).arg(mask[i]).arg(inlier).arg(count);
+        }
+        expected += inlier;
+    }
+    if(numInliers != expected){
+        return QString("%1 inliers instead of %2 (count %3)").arg(numInliers).arg(expected).arg(count);
+    }
+    if(mask[count] != 2){
+        return QString("mask written behind the last point (count %1)").arg(count);
+    }
+    return QString();
+}
+
+// bounding box that is extended by the first point (see PS_PointCloud)
+PS_BoundingBox_PC PointCloudSegmentationTest::getEmptyBoundingBox()
+{
+    PS_BoundingBox_PC bbox;
+    for(int k = 0; k < 3; k++){
+        bbox.min[k] = numeric_limits<float>::max();
+        bbox.max[k] = -numeric_limits<float>::max();
+    }
+    return bbox;
+}
+
+bool PointCloudSegmentationTest::writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+    bool result = (file.write(data) == data.size());
+    file.close();
+    return result;
+}
+
+// coordinates of the point with the given index that are exactly representable as float (no rounding dependent results)
+void PointCloudSegmentationTest::getGridPoint(const int &index, float (&xyz)[3])
+{
+    xyz[0] = 0.25f * index;
+    xyz[1] = -0.125f * (index % 1000);
+    xyz[2] = 0.5f * index + 0.0625f;
+}
+
+NodeKey PointCloudSegmentationTest::getNodeKey(const PS_Node *node)
+{
+    NodeKey key;
+    if(node != NULL){
+        key.push_back(node->depth);
+        key.insert(key.end(), node->position, node->position + 3);
+    }
+    return key;
+}
+
+// all leafs of the octree by their key
+map<NodeKey, OctreeLeaf> PointCloudSegmentationTest::getOctreeLeafs(PS_Octree &octree)
+{
+    map<NodeKey, OctreeLeaf> leafs;
+    foreach(PS_Node *node, *octree.getLeafs()){
+        OctreeLeaf &leaf = leafs[getNodeKey(node)];
+        leaf.points.assign(node->points, node->points + node->numPoints);
+        sort(leaf.points.begin(), leaf.points.end());
+        const PS_Node *neighbours[6] = {node->top, node->bottom, node->left, node->right, node->front, node->back};
+        for(int k = 0; k < 6; k++){
+            leaf.neighbours[k] = getNodeKey(neighbours[k]);
+        }
+    }
+    return leafs;
+}
+
+// compares the leafs, their points and their neighbours of two octrees over the same points
+QString PointCloudSegmentationTest::compareOctrees(PS_Octree &first, PS_Octree &second)
+{
+    if(first.getLeafs()->size() != second.getLeafs()->size()){
+        return QString("%1 leafs instead of %2").arg(second.getLeafs()->size()).arg(first.getLeafs()->size());
+    }
+    map<NodeKey, OctreeLeaf> firstLeafs = getOctreeLeafs(first);
+    map<NodeKey, OctreeLeaf> secondLeafs = getOctreeLeafs(second);
+    if((int)firstLeafs.size() != first.getLeafs()->size()){
+        return QString("leafs with the same depth and center");
+    }
+    int index = 0;
+    for(map<NodeKey, OctreeLeaf>::const_iterator it = firstLeafs.begin(); it != firstLeafs.end(); ++it, index++){
+        map<NodeKey, OctreeLeaf>::const_iterator other = secondLeafs.find(it->first);
+        if(other == secondLeafs.end()){
+            return QString("leaf %1 (depth %2) is missing").arg(index).arg(it->first[0]);
+        }
+        if(it->second.points != other->second.points){
+            return QString("points of leaf %1 (depth %2) differ").arg(index).arg(it->first[0]);
+        }
+        for(int k = 0; k < 6; k++){
+            if(it->second.neighbours[k] != other->second.neighbours[k]){
+                return QString("neighbour %1 of leaf %2 (depth %3) differs").arg(k).arg(index).arg(it->first[0]);
+            }
+        }
+    }
+    return QString();
+}
+
+// appends points on the plane patch origin + s * u + t * v (0 <= s, t < 1) with a small offset along the normal
+vector<quint32> PointCloudSegmentationTest::addPlanePiece(PS_PointStore &store, PS_Random &random, const double (&origin)[3], const double (&u)[3],
+                                                          const double (&v)[3], const int &numPoints)
+{
+    double normal[3] = {u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0]};
+    double length = qSqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+    vector<quint32> piece;
+    for(int i = 0; i < numPoints; i++){
+        double s = nextUniform(random, 0.0, 1.0);
+        double t = nextUniform(random, 0.0, 1.0);
+        double offset = nextUniform(random, -0.0005, 0.0005) / length;
+        piece.push_back(store.append(origin[0] + s*u[0] + t*v[0] + offset*normal[0], origin[1] + s*u[1] + t*v[1] + offset*normal[1],
+                                     origin[2] + s*u[2] + t*v[2] + offset*normal[2]));
+    }
+    return piece;
+}
+
+// appends points on the part of a sphere between two azimuths with a small radial offset
+vector<quint32> PointCloudSegmentationTest::addSpherePiece(PS_PointStore &store, PS_Random &random, const double (&center)[3], const double &radius,
+                                                           const double &minAzimuth, const double &maxAzimuth, const int &numPoints)
+{
+    vector<quint32> piece;
+    for(int i = 0; i < numPoints; i++){
+        double z = nextUniform(random, -1.0, 1.0);
+        double azimuth = nextUniform(random, minAzimuth, maxAzimuth);
+        double r = radius + nextUniform(random, -0.0005, 0.0005);
+        double xy = qSqrt(1.0 - z*z);
+        piece.push_back(store.append(center[0] + r*xy*qCos(azimuth), center[1] + r*xy*qSin(azimuth), center[2] + r*z));
+    }
+    return piece;
+}
+
+// appends points on the part origin + h * axis (minHeight <= h < maxHeight) of a cylinder with a small radial offset (axis of length 1)
+vector<quint32> PointCloudSegmentationTest::addCylinderPiece(PS_PointStore &store, PS_Random &random, const double (&origin)[3], const double (&axis)[3],
+                                                             const double &radius, const double &minHeight, const double &maxHeight, const int &numPoints)
+{
+    //two directions perpendicular to the axis
+    double a[3] = {axis[1], -axis[0], 0.0};
+    if(qAbs(axis[2]) > 0.9){
+        a[0] = 0.0;
+        a[1] = axis[2];
+        a[2] = -axis[1];
+    }
+    double length = qSqrt(a[0]*a[0] + a[1]*a[1] + a[2]*a[2]);
+    for(int k = 0; k < 3; k++){
+        a[k] /= length;
+    }
+    double b[3] = {axis[1]*a[2] - axis[2]*a[1], axis[2]*a[0] - axis[0]*a[2], axis[0]*a[1] - axis[1]*a[0]};
+
+    vector<quint32> piece;
+    for(int i = 0; i < numPoints; i++){
+        double h = nextUniform(random, minHeight, maxHeight);
+        double angle = nextUniform(random, 0.0, 2.0 * M_PI);
+        double r = radius + nextUniform(random, -0.0005, 0.0005);
+        double xyz[3];
+        for(int k = 0; k < 3; k++){
+            xyz[k] = origin[k] + h*axis[k] + r*qCos(angle)*a[k] + r*qSin(angle)*b[k];
+        }
+        piece.push_back(store.append(xyz[0], xyz[1], xyz[2]));
+    }
+    return piece;
+}
+
+// detects a plane, sphere or cylinder in each piece, fits it to all points of the piece near it, merges the shapes and returns the points of the merged shapes
+vector<vector<quint32> > PointCloudSegmentationTest::mergePieces(PS_PointStore &store, const vector<vector<quint32> > (&pieces)[3], const PS_InputParameter &param,
+                                                                 const bool &compareAllPairs, PS_MergeStatistics (&statistics)[3])
+{
+    store.resetUsed();
+    PS_Random generator(param.randomSeed);
+
+    QList<PS_PlaneSegment *> planes, mergedPlanes;
+    QList<PS_SphereSegment *> spheres, mergedSpheres;
+    QList<PS_CylinderSegment *> cylinders, mergedCylinders;
+    for(size_t i = 0; i < pieces[0].size(); i++){
+        PS_PlaneSegment *p = PS_PlaneSegment::detectPlane(&store, pieces[0][i], param, generator);
+        if(p->getIsValid()){
+            p->fitBySample(param.fitSampleSize);
+            for(int iteration = 0; iteration < 10 && p->getIsValid(); iteration++){
+                p->removeAllPoints();
+                PS_PlaneSegment::checkPointsInPlane(p, pieces[0][i], param, 10);
+                p->fit();
+            }
+        }
+        if(p->getIsValid()){
+            planes.append(p);
+        }else{
+            delete p;
+        }
+    }
+    for(size_t i = 0; i < pieces[1].size(); i++){
+        PS_SphereSegment *s = PS_SphereSegment::detectSphere(&store, pieces[1][i], param, generator);
+        if(s->getIsValid()){
+            s->fitBySample(param.fitSampleSize);
+            for(int iteration = 0; iteration < 10 && s->getIsValid(); iteration++){
+                s->removeAllPoints();
+                PS_SphereSegment::checkPointsInSphere(s, pieces[1][i], param, 10);
+                s->fit();
+            }
+        }
+        if(s->getIsValid()){
+            spheres.append(s);
+        }else{
+            delete s;
+        }
+    }
+    for(size_t i = 0; i < pieces[2].size(); i++){
+        PS_CylinderSegment *c = PS_CylinderSegment::detectCylinder(&store, pieces[2][i], param, generator);
+        if(c->getIsValid()){
+            c->fitBySample(param.fitSampleSize);
+            for(int iteration = 0; iteration < 10 && c->getIsValid(); iteration++){
+                c->removeAllPoints();
+                PS_CylinderSegment::checkPointsInCylinder(c, pieces[2][i], param, 10);
+                c->fit();
+            }
+        }
+        if(c->getIsValid()){
+            cylinders.append(c);
+        }else{
+            delete c;
+        }
+    }
+
+    PS_PlaneSegment::mergePlanes(planes, mergedPlanes, param, statistics[0], compareAllPairs);
+    PS_SphereSegment::mergeSpheres(spheres, mergedSpheres, param, statistics[1], compareAllPairs);
+    PS_CylinderSegment::mergeCylinders(cylinders, mergedCylinders, param, statistics[2], compareAllPairs);
+
+    vector<vector<quint32> > shapes;
+    foreach(PS_PlaneSegment *plane, mergedPlanes){
+        shapes.push_back(plane->getPoints());
+        delete plane;
+    }
+    foreach(PS_SphereSegment *sphere, mergedSpheres){
+        shapes.push_back(sphere->getPoints());
+        delete sphere;
+    }
+    foreach(PS_CylinderSegment *cylinder, mergedCylinders){
+        shapes.push_back(cylinder->getPoints());
+        delete cylinder;
+    }
+    return shapes;
+}
+
+void PointCloudSegmentationTest::testDetectShapes_deterministic()
+{
+    PS_SceneParameter sceneParam;
+    sceneParam.numPoints = 200000;
+    PS_SyntheticScene scene(sceneParam);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/scene.xyz";
+    QVERIFY(scene.write(fileName));
+
+    PS_InputParameter param = getParameter(scene, sceneParam);
+    param.numThreads = 1;
+    vector<vector<quint32> > reference;
+    QVERIFY(detectShapes(fileName, param, reference));
+    QVERIFY(!reference.empty());
+
+    // the same seed yields the same shapes with the same points on any number of threads (0 = all available cores) and in every run
+    const int numThreads[] = {4, 0, 4};
+    for(int t = 0; t < 3; t++){
+        param.numThreads = numThreads[t];
+        vector<vector<quint32> > shapes;
+        QVERIFY(detectShapes(fileName, param, shapes));
+        QVERIFY2(shapes.size() == reference.size(), qPrintable(QString("%1 instead of %2 shapes on %3 threads")
+                                                               .arg(shapes.size()).arg(reference.size()).arg(numThreads[t])));
+        for(size_t i = 0; i < shapes.size(); i++){
+            QVERIFY2(shapes[i] == reference[i], qPrintable(QString("points of shape %1 differ on %2 threads").arg(i).arg(numThreads[t])));
+        }
+    }
+
+    // another seed draws other samples, so the points of the shapes differ
+    param.numThreads = 4;
+    param.randomSeed = sceneParam.seed + 1;
+    vector<vector<quint32> > otherSeed;
+    QVERIFY(detectShapes(fileName, param, otherSeed));
+    QVERIFY(!otherSeed.empty());
+    QVERIFY2(otherSeed != reference, "the random seed is not used");
+}
+
+void PointCloudSegmentationTest::testDistanceKernels()
+{
+    // counts that are no multiple of the SIMD width (4 or 8 floats) or of the block size of the indexed kernels
+    const unsigned int counts[] = {1, 3, 5, 7, 9, 13, 31, 255, 257, 519, 1001};
+    const unsigned int numPoints = 1001;
+    const double threshold = 0.01;
+
+    const float ijk[3] = {0.0f, 0.6f, 0.8f};
+    const float d = 1.5f;
+    const float center[3] = {1.0f, -2.0f, 0.5f};
+    const float sphereRadius = 0.75f;
+    const float x0[3] = {-1.0f, 0.5f, 2.0f};
+    const float n0[3] = {0.6f, 0.0f, 0.8f};
+    const float cylinderRadius = 0.4f;
+
+    // points near the plane, the sphere and the cylinder and the scalar reference of their inlier state
+    PS_Random random(7);
+    vector<float> px(numPoints), py(numPoints), pz(numPoints);
+    vector<float> sx(numPoints), sy(numPoints), sz(numPoints);
+    vector<float> cx(numPoints), cy(numPoints), cz(numPoints);
+    vector<unsigned char> planeReference(numPoints), sphereReference(numPoints), cylinderReference(numPoints);
+    for(unsigned int i = 0; i < numPoints; i++){
+
+        // plane: d * ijk + s * (1, 0, 0) + t * (0, 0.8, -0.6) + offset * ijk
+        double s = nextUniform(random, -2.0, 2.0);
+        double t = nextUniform(random, -2.0, 2.0);
+        double offset = d + nextOffset(random, threshold);
+        px[i] = s;
+        py[i] = 0.8 * t + offset * ijk[1];
+        pz[i] = -0.6 * t + offset * ijk[2];
+        double distance = px[i] * ijk[0] + py[i] * ijk[1] + pz[i] * ijk[2] - d;
+        planeReference[i] = qAbs(distance) < threshold;
+
+        // sphere: center + (radius + offset) * random direction
+        double u[3];
+        double length = 0.0;
+        do{
+            for(int k = 0; k < 3; k++){
+                u[k] = nextUniform(random, -1.0, 1.0);
+            }
+            length = qSqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+        }while(length < 0.1 || length > 1.0);
+        offset = sphereRadius + nextOffset(random, threshold);
+        sx[i] = center[0] + offset * u[0] / length;
+        sy[i] = center[1] + offset * u[1] / length;
+        sz[i] = center[2] + offset * u[2] / length;
+        distance = qSqrt((sx[i] - center[0]) * (sx[i] - center[0]) + (sy[i] - center[1]) * (sy[i] - center[1])
+                         + (sz[i] - center[2]) * (sz[i] - center[2])) - sphereRadius;
+        sphereReference[i] = qAbs(distance) < threshold;
+
+        // cylinder: x0 + t * n0 + (radius + offset) * (cos(a) * (0, 1, 0) + sin(a) * (0.8, 0, -0.6))
+        t = nextUniform(random, -1.0, 1.0);
+        const double a = nextUniform(random, 0.0, 2.0 * M_PI);
+        offset = cylinderRadius + nextOffset(random, threshold);
+        cx[i] = x0[0] + t * n0[0] + offset * 0.8 * qSin(a);
+        cy[i] = x0[1] + offset * qCos(a);
+        cz[i] = x0[2] + t * n0[2] - offset * 0.6 * qSin(a);
+        const double bx = cx[i] - x0[0], by = cy[i] - x0[1], bz = cz[i] - x0[2];
+        const double c[3] = {n0[1] * bz - n0[2] * by, n0[2] * bx - n0[0] * bz, n0[0] * by - n0[1] * bx};
+        distance = qSqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]) - cylinderRadius;
+        cylinderReference[i] = qAbs(distance) < threshold;
+
+    }
+
+    // random order of all points for the indexed kernels
+    vector<quint32> indices(numPoints);
+    for(unsigned int i = 0; i < numPoints; i++){
+        indices[i] = i;
+    }
+    for(unsigned int i = numPoints - 1; i > 0; i--){
+        std::swap(indices[i], indices[random.nextInRange(i)]);
+    }
+
+    for(unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++){
+        const unsigned int count = counts[c];
+        vector<unsigned char> mask(count + 1);
+        QString error;
+
+        mask.assign(count + 1, 2);
+        unsigned int numInliers = PS_DistanceKernels::planeInliers(px.data(), py.data(), pz.data(), count, ijk, d, threshold, mask.data());
+        error = compareInliers(mask, numInliers, planeReference, NULL, count);
+        QVERIFY2(error.isEmpty(), qPrintable("plane: " + error));
+
+        mask.assign(count + 1, 2);
+        numInliers = PS_DistanceKernels::planeInliers(px.data(), py.data(), pz.data(), indices.data(), count, ijk, d, threshold, mask.data());
+        error = compareInliers(mask, numInliers, planeReference, indices.data(), count);
+        QVERIFY2(error.isEmpty(), qPrintable("indexed plane: " + error));
+
+        mask.assign(count + 1, 2);
+        numInliers = PS_DistanceKernels::sphereInliers(sx.data(), sy.data(), sz.data(), count, center, sphereRadius, threshold, mask.data());
+        error = compareInliers(mask, numInliers, sphereReference, NULL, count);
+        QVERIFY2(error.isEmpty(), qPrintable("sphere: " + error));
+
+        mask.assign(count + 1, 2);
+        numInliers = PS_DistanceKernels::sphereInliers(sx.data(), sy.data(), sz.data(), indices.data(), count, center, sphereRadius, threshold, mask.data());
+        error = compareInliers(mask, numInliers, sphereReference, indices.data(), count);
+        QVERIFY2(error.isEmpty(), qPrintable("indexed sphere: " + error));
+
+        mask.assign(count + 1, 2);
+        numInliers = PS_DistanceKernels::cylinderInliers(cx.data(), cy.data(), cz.data(), count, x0, n0, cylinderRadius, threshold, mask.data());
+        error = compareInliers(mask, numInliers, cylinderReference, NULL, count);
+        QVERIFY2(error.isEmpty(), qPrintable("cylinder: " + error));
+
+        mask.assign(count + 1, 2);
+        numInliers = PS_DistanceKernels::cylinderInliers(cx.data(), cy.data(), cz.data(), indices.data(), count, x0, n0, cylinderRadius, threshold, mask.data());
+        error = compareInliers(mask, numInliers, cylinderReference, indices.data(), count);
+        QVERIFY2(error.isEmpty(), qPrintable("indexed cylinder: " + error));
+    }
+}
+
+void PointCloudSegmentationTest::testLoader_parseFloat()
+{
+    const char *valid[] = {"12.5", "-0.125e2", "+3", "1E-3", ".5", "7.", "0012", "-0", "2.5e+1"};
+    const float expected[] = {12.5f, -12.5f, 3.0f, 0.001f, 0.5f, 7.0f, 12.0f, 0.0f, 25.0f};
+    for(size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++){
+        const char *end = valid[i] + strlen(valid[i]);
+        const char *c = valid[i];
+        float value = -1.0f;
+        QVERIFY2(PS_PointCloudLoader::parseFloat(c, end, value), valid[i]);
+        QCOMPARE(value, expected[i]);
+        QVERIFY2(c == end, valid[i]);
+    }
+
+    // the number ends at a separator, which is not consumed
+    const char *separated[] = {"1.5 2", "1.5\t2", "1.5,2", "1.5;2", "1.5\r\n"};
+    for(size_t i = 0; i < sizeof(separated) / sizeof(separated[0]); i++){
+        const char *c = separated[i];
+        float value = -1.0f;
+        QVERIFY(PS_PointCloudLoader::parseFloat(c, separated[i] + strlen(separated[i]), value));
+        QCOMPARE(value, 1.5f);
+        QVERIFY(c == separated[i] + 3);
+    }
+
+    // the end of the buffer ends the number even if a digit follows
+    const char *truncated = "123";
+    const char *c = truncated;
+    float value = -1.0f;
+    QVERIFY(PS_PointCloudLoader::parseFloat(c, truncated + 2, value));
+    QCOMPARE(value, 12.0f);
+
+    // no digits, no exponent digits or no separator behind the number
+    const char *invalid[] = {"abc", "-", ".", "-.e1", "1e", "1e+", "1.2x", "12a", "1.5.2"};
+    for(size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++){
+        c = invalid[i];
+        QVERIFY2(!PS_PointCloudLoader::parseFloat(c, invalid[i] + strlen(invalid[i]), value), invalid[i]);
+    }
+}
+
+void PointCloudSegmentationTest::testLoader_parseChunk()
+{
+    // PTS file with CRLF line endings: number of points in the first line, intensity and RGB behind the coordinates
+    QByteArray data("5\r\n"
+                    "1.0 2.0 3.0 -1200 255 128 0\r\n"
+                    "-4.5\t5.5\t-6.5\t17\r\n"
+                    "\r\n"
+                    "1.0 2.0\r\n"
+                    "x y z\r\n"
+                    "7,8,9\r\n"
+                    "10;-11;12 0 0 0\n"
+                    "13 14 15");
+    const float expected[5][3] = {{1.0f, 2.0f, 3.0f}, {-4.5f, 5.5f, -6.5f}, {7.0f, 8.0f, 9.0f}, {10.0f, -11.0f, 12.0f}, {13.0f, 14.0f, 15.0f}};
+    const float expectedMin[3] = {-4.5f, -11.0f, -6.5f};
+    const float expectedMax[3] = {13.0f, 14.0f, 15.0f};
+
+    PS_LoaderChunk chunk;
+    chunk.begin = data.constData();
+    chunk.end = data.constData() + data.size();
+    PS_PointCloudLoader::parseChunk(chunk);
+
+    QCOMPARE((int)chunk.x.size(), 5);
+    QCOMPARE((int)chunk.y.size(), 5);
+    QCOMPARE((int)chunk.z.size(), 5);
+    for(int i = 0; i < 5; i++){
+        QCOMPARE(chunk.x[i], expected[i][0]);
+        QCOMPARE(chunk.y[i], expected[i][1]);
+        QCOMPARE(chunk.z[i], expected[i][2]);
+    }
+    for(int k = 0; k < 3; k++){
+        QCOMPARE(chunk.min[k], expectedMin[k]);
+        QCOMPARE(chunk.max[k], expectedMax[k]);
+    }
+
+    // the same points are loaded from a file
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/cloud.pts";
+    QVERIFY(writeFile(fileName, data));
+
+    PS_PointStore store;
+    PS_BoundingBox_PC bbox = getEmptyBoundingBox();
+    QVERIFY(PS_PointCloudLoader::load(fileName, &store, bbox));
+    QCOMPARE((int)store.size(), 5);
+    for(quint32 i = 0; i < 5; i++){
+        QCOMPARE(store.getX(i), expected[i][0]);
+        QCOMPARE(store.getY(i), expected[i][1]);
+        QCOMPARE(store.getZ(i), expected[i][2]);
+    }
+    for(int k = 0; k < 3; k++){
+        QCOMPARE(bbox.min[k], expectedMin[k]);
+        QCOMPARE(bbox.max[k], expectedMax[k]);
+    }
+}
+
+void PointCloudSegmentationTest::testLoader_chunkBoundaries()
+{
+    // several MB, so that the file is split into several chunks (and reader windows) that are aligned to lines
+    const int numPoints = 100000;
+    QByteArray data("100000\n");
+    for(int i = 0; i < numPoints; i++){
+        float xyz[3];
+        getGridPoint(i, xyz);
+        data.append(QByteArray::number(xyz[0], 'f', 4)).append(' ');
+        data.append(QByteArray::number(xyz[1], 'f', 4)).append(' ');
+        data.append(QByteArray::number(xyz[2], 'f', 4));
+        if(i % 3 == 0){
+            data.append(" 200 10 20 30");
+        }
+        data.append(i % 2 == 0 ? "\r\n" : "\n");
+    }
+    QVERIFY(data.size() > (2 << 20));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/grid.pts";
+    QVERIFY(writeFile(fileName, data));
+
+    // all points are loaded in file order
+    PS_PointStore store;
+    PS_BoundingBox_PC bbox = getEmptyBoundingBox();
+    QVERIFY(PS_PointCloudLoader::load(fileName, &store, bbox, 4));
+    QCOMPARE((int)store.size(), numPoints);
+    for(int i = 0; i < numPoints; i++){
+        float xyz[3];
+        getGridPoint(i, xyz);
+        if(store.getX(i) != xyz[0] || store.getY(i) != xyz[1] || store.getZ(i) != xyz[2]){
+            QFAIL(qPrintable(QString("point %1 differs").arg(i)));
+        }
+    }
+    float first[3], last[3];
+    getGridPoint(0, first);
+    getGridPoint(numPoints - 1, last);
+    QCOMPARE(bbox.min[0], first[0]);
+    QCOMPARE(bbox.min[1], -124.875f);
+    QCOMPARE(bbox.min[2], first[2]);
+    QCOMPARE(bbox.max[0], last[0]);
+    QCOMPARE(bbox.max[1], 0.0f);
+    QCOMPARE(bbox.max[2], last[2]);
+
+    // a small window (no multiple of the line length) splits the file into many windows
+    PS_PointCloudReader reader(fileName, 4099, 2);
+    QVERIFY(reader.open());
+    int index = 0;
+    int numWindows = 0;
+    vector<PS_LoaderChunk> chunks;
+    while(reader.readNext(chunks)){
+        numWindows++;
+        for(size_t c = 0; c < chunks.size(); c++){
+            for(size_t k = 0; k < chunks[c].x.size(); k++){
+                float xyz[3];
+                getGridPoint(index, xyz);
+                if(chunks[c].x[k] != xyz[0] || chunks[c].y[k] != xyz[1] || chunks[c].z[k] != xyz[2]){
+                    QFAIL(qPrintable(QString("point %1 of window %2 differs").arg(index).arg(numWindows)));
+                }
+                index++;
+            }
+        }
+    }
+    reader.close();
+    QCOMPARE(index, numPoints);
+    QVERIFY(numWindows > 1);
+    QCOMPARE(reader.getPosition(), reader.getSize());
+}
+
+void PointCloudSegmentationTest::testCache_invalidation()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/cloud.xyz";
+    QVERIFY(writeFile(fileName, QByteArray("1 2 3\n4 5 6\n")));
+
+    PS_PointStore source;
+    PS_BoundingBox_PC sourceBox = getEmptyBoundingBox();
+    QVERIFY(PS_PointCloudLoader::load(fileName, &source, sourceBox));
+    QCOMPARE((int)source.size(), 2);
+
+    // no cache file yet
+    PS_PointStore store;
+    PS_BoundingBox_PC bbox = getEmptyBoundingBox();
+    QVERIFY(!PS_PointCloudCache::read(fileName, &store, bbox));
+
+    // the cache holds the points of the unchanged source file
+    QVERIFY(PS_PointCloudCache::write(fileName, &source, sourceBox));
+    QVERIFY(QFile::exists(PS_PointCloudCache::getCacheFileName(fileName)));
+    QVERIFY(PS_PointCloudCache::read(fileName, &store, bbox));
+    QCOMPARE((int)store.size(), 2);
+    for(quint32 i = 0; i < 2; i++){
+        QCOMPARE(store.getX(i), source.getX(i));
+        QCOMPARE(store.getY(i), source.getY(i));
+        QCOMPARE(store.getZ(i), source.getZ(i));
+    }
+    for(int k = 0; k < 3; k++){
+        QCOMPARE(bbox.min[k], sourceBox.min[k]);
+        QCOMPARE(bbox.max[k], sourceBox.max[k]);
+    }
+
+    // the size of the source file changes
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+        QCOMPARE(file.write(QByteArray("7 8 9\n")), (qint64)6);
+        file.close();
+    }
+    PS_PointStore changedSize;
+    bbox = getEmptyBoundingBox();
+    QVERIFY(!PS_PointCloudCache::read(fileName, &changedSize, bbox));
+    QCOMPARE((int)changedSize.size(), 0);
+
+    // rewriting the cache makes it valid again
+    source.clear();
+    sourceBox = getEmptyBoundingBox();
+    QVERIFY(PS_PointCloudLoader::load(fileName, &source, sourceBox));
+    QVERIFY(PS_PointCloudCache::write(fileName, &source, sourceBox));
+    PS_PointStore rewritten;
+    bbox = getEmptyBoundingBox();
+    QVERIFY(PS_PointCloudCache::read(fileName, &rewritten, bbox));
+    QCOMPARE((int)rewritten.size(), 3);
+
+    // only the modification time of the source file changes
+    {
+        QFile file(fileName);
+        QDateTime modified = QFileInfo(fileName).lastModified();
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(modified.addSecs(-60), QFileDevice::FileModificationTime));
+        file.close();
+    }
+    PS_PointStore changedTime;
+    bbox = getEmptyBoundingBox();
+    QVERIFY(!PS_PointCloudCache::read(fileName, &changedTime, bbox));
+    QCOMPARE((int)changedTime.size(), 0);
+}
+
+void PointCloudSegmentationTest::testOctree_equivalence()
+{
+    PS_SceneParameter sceneParam;
+    sceneParam.numPoints = 100000;
+    PS_SyntheticScene scene(sceneParam);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/scene.xyz";
+    QVERIFY(scene.write(fileName));
+
+    PS_PointStore store;
+    PS_BoundingBox_PC bbox = getEmptyBoundingBox();
+    QVERIFY(PS_PointCloudLoader::load(fileName, &store, bbox));
+    const unsigned int minPoints = 100;
+
+    // both octrees partition the points into the same leafs with the same neighbours
+    PS_Octree octree;
+    octree.setNumThreads(4);
+    QVERIFY(octree.setUp(&store, &bbox, minPoints));
+    PS_LinearOctree linearOctree;
+    linearOctree.setNumThreads(4);
+    QVERIFY(linearOctree.setUp(&store, &bbox, minPoints));
+    QVERIFY(octree.getLeafs()->size() > 1);
+
+    quint32 numLeafPoints = 0;
+    foreach(PS_Node *node, *octree.getLeafs()){
+        numLeafPoints += node->numPoints;
+    }
+    QCOMPARE(numLeafPoints, store.size());
+
+    QString error = compareOctrees(octree, linearOctree);
+    QVERIFY2(error.isEmpty(), qPrintable("linear octree: " + error));
+
+    // the cache may restore the layout of one octree type into the other (see PS_PointCloud::setUpOctree)
+    PS_OctreeLayout layout, linearLayout;
+    octree.getLayout(layout);
+    linearOctree.getLayout(linearLayout);
+
+    PS_LinearOctree restoredLinear;
+    restoredLinear.setNumThreads(4);
+    QVERIFY(restoredLinear.setUp(&store, &bbox, minPoints, &layout));
+    PS_OctreeLayout restoredLayout;
+    restoredLinear.getLayout(restoredLayout);
+    QVERIFY2(restoredLayout.indices == layout.indices, "the layout of PS_Octree was not restored");
+    error = compareOctrees(linearOctree, restoredLinear);
+    QVERIFY2(error.isEmpty(), qPrintable("restored linear octree: " + error));
+
+    PS_Octree restored;
+    restored.setNumThreads(4);
+    QVERIFY(restored.setUp(&store, &bbox, minPoints, &linearLayout));
+    restored.getLayout(restoredLayout);
+    QVERIFY2(restoredLayout.indices == linearLayout.indices, "the layout of PS_LinearOctree was not restored");
+    error = compareOctrees(octree, restored);
+    QVERIFY2(error.isEmpty(), qPrintable("restored octree: " + error));
+}
+
+void PointCloudSegmentationTest::testMerge_compareAllPairs()
+{
+    PS_InputParameter param;
+    param.leafSize = 100;
+    param.outlierPercentage = 0.5;
+    param.fitSampleSize = 50;
+    param.finalFit = true;
+    param.randomSeed = 7;
+    param.numThreads = 1;
+    param.linearOctree = true;
+    param.timeBudget = 0.0;
+    param.streamShapes = false;
+    param.downsampling = eNoDownsampling;
+    param.voxelSize = 0.0;
+    param.samplingRate = 0.1;
+    const float maxDistance = 0.002f;
+    param.planeParams.detectPlanes = true;
+    param.planeParams.minPoints = 50;
+    param.planeParams.maxDistance = maxDistance;
+    param.sphereParams.detectSpheres = true;
+    param.sphereParams.minPoints = 50;
+    param.sphereParams.maxDistance = maxDistance;
+    param.sphereParams.minRadius = 0.05f;
+    param.sphereParams.maxRadius = 1.0f;
+    param.cylinderParams.detectCylinders = true;
+    param.cylinderParams.minPoints = 50;
+    param.cylinderParams.maxDistance = maxDistance;
+    param.cylinderParams.minRadius = 0.05f;
+    param.cylinderParams.maxRadius = 1.0f;
+
+    // shapes that were detected in several pieces, neighbours that are close enough to be compared and shapes that are far apart
+    PS_PointStore store;
+    PS_Random random(1);
+    vector<vector<quint32> > pieces[3];
+    const double x[3] = {2.0, 0.0, 0.0}, y[3] = {0.0, 2.0, 0.0}, z[3] = {0.0, 0.0, 2.0};
+    for(int i = 0; i < 4; i++){
+        const double floor[3] = {2.0 * (i % 2), 2.0 * (i / 2), 0.0};
+        pieces[0].push_back(addPlanePiece(store, random, floor, x, y, 400));
+    }
+    const double step[3] = {4.0, 0.0, 0.01}, wall[3] = {0.0, 0.0, 0.0}, upperWall[3] = {0.0, 2.0, 0.0};
+    pieces[0].push_back(addPlanePiece(store, random, step, x, y, 400));
+    pieces[0].push_back(addPlanePiece(store, random, wall, y, z, 400));
+    pieces[0].push_back(addPlanePiece(store, random, upperWall, y, z, 400));
+    const double rampOrigin[3] = {1.0, 5.0, -0.1763}, rampU[3] = {2.0, 0.0, 0.3527}, rampV[3] = {0.0, 1.0, 0.0}; //10 degrees through the floor
+    pieces[0].push_back(addPlanePiece(store, random, rampOrigin, rampU, rampV, 400));
+
+    const double ball[3] = {10.0, 2.0, 0.5}, smallBall[3] = {10.9, 2.0, 0.3}, farBall[3] = {20.0, 10.0, 1.0};
+    for(int i = 0; i < 3; i++){
+        pieces[1].push_back(addSpherePiece(store, random, ball, 0.5, i * 2.0 * M_PI / 3.0, (i + 1) * 2.0 * M_PI / 3.0, 400));
+    }
+    pieces[1].push_back(addSpherePiece(store, random, smallBall, 0.3, 0.0, 2.0 * M_PI, 400));
+    pieces[1].push_back(addSpherePiece(store, random, farBall, 0.8, 0.0, M_PI, 400));
+    pieces[1].push_back(addSpherePiece(store, random, farBall, 0.8, M_PI, 2.0 * M_PI, 400));
+
+    const double pipe[3] = {14.0, 2.0, 0.0}, parallelPipe[3] = {14.5, 2.0, 0.0}, crossingPipe[3] = {13.8, 2.0, 0.3}, farPipe[3] = {20.0, 0.0, 0.3};
+    const double zAxis[3] = {0.0, 0.0, 1.0}, xAxis[3] = {1.0, 0.0, 0.0}, yAxis[3] = {0.0, 1.0, 0.0};
+    for(int i = 0; i < 3; i++){
+        pieces[2].push_back(addCylinderPiece(store, random, pipe, zAxis, 0.2, 0.15 * i, 0.15 * i + 0.3, 1000));
+    }
+    pieces[2].push_back(addCylinderPiece(store, random, parallelPipe, zAxis, 0.2, 0.0, 0.3, 1000));
+    pieces[2].push_back(addCylinderPiece(store, random, crossingPipe, xAxis, 0.1, 0.0, 0.4, 1000));
+    pieces[2].push_back(addCylinderPiece(store, random, farPipe, yAxis, 0.3, 0.0, 0.3, 1000));
+    pieces[2].push_back(addCylinderPiece(store, random, farPipe, yAxis, 0.3, 0.3, 0.6, 1000));
+
+    // the merge index only skips pairs that do not satisfy the merge criteria, so it yields the same shapes as a comparison of all pairs
+    PS_MergeStatistics statistics[3], allPairsStatistics[3];
+    vector<vector<quint32> > shapes = mergePieces(store, pieces, param, false, statistics);
+    vector<vector<quint32> > allPairsShapes = mergePieces(store, pieces, param, true, allPairsStatistics);
+    QVERIFY2(shapes.size() == allPairsShapes.size(), qPrintable(QString("%1 instead of %2 shapes").arg(shapes.size()).arg(allPairsShapes.size())));
+    for(size_t i = 0; i < shapes.size(); i++){
+        QVERIFY2(shapes[i] == allPairsShapes[i], qPrintable(QString("points of shape %1 differ").arg(i)));
+    }
+
+    const char *types[3] = {"planes", "spheres", "cylinders"};
+    for(int t = 0; t < 3; t++){
+        QVERIFY2(allPairsStatistics[t].numMerges > 0, qPrintable(QString("no %1 merged").arg(types[t])));
+        QVERIFY2(statistics[t].numMerges == allPairsStatistics[t].numMerges, qPrintable(QString("%1 instead of %2 merges of %3")
+                                                                                      .arg(statistics[t].numMerges).arg(allPairsStatistics[t].numMerges).arg(types[t])));
+        QVERIFY2(statistics[t].numComparisons < allPairsStatistics[t].numComparisons, qPrintable(QString("the index compares all pairs of %1").arg(types[t])));
+    }
+}
+
+void PointCloudSegmentationTest::testDownsampling_assignPoints()
+{
+    PS_SceneParameter sceneParam;
+    sceneParam.numPoints = 200000;
+    PS_SyntheticScene scene(sceneParam);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/scene.xyz";
+    QVERIFY(scene.write(fileName));
+
+    PS_InputParameter param = getParameter(scene, sceneParam);
+    param.numThreads = 4;
+    vector<vector<quint32> > reference;
+    QVERIFY(detectShapes(fileName, param, reference));
+    QVERIFY(!reference.empty());
+
+    /*
+     * the shapes are detected in the reduced cloud and assignPoints gives them the points of the full cloud: each shape of
+     * the scene that is found without downsampling is found with nearly the same points (small shapes are fragments or
+     * false positives that either run may yield)
+     */
+    const unsigned int minShapeSize = 1000;
+    const PS_DownsamplingMethod methods[2] = {eVoxelGridDownsampling, eRandomDownsampling};
+    const char *names[2] = {"voxel grid", "random"};
+    for(int m = 0; m < 2; m++){
+        param.downsampling = methods[m];
+        param.voxelSize = 3.0 / qSqrt(scene.getDensity()); //see segmentationbenchmark/main.cpp
+        param.samplingRate = 0.1;
+        vector<vector<quint32> > shapes;
+        QVERIFY(detectShapes(fileName, param, shapes));
+
+        for(size_t i = 0; i < reference.size(); i++){
+            if(reference[i].size() < minShapeSize){
+                continue;
+            }
+            double overlap = 0.0;
+            for(size_t j = 0; j < shapes.size(); j++){
+                overlap = qMax(overlap, getOverlap(reference[i], shapes[j]));
+            }
+            QVERIFY2(overlap > 0.9, qPrintable(QString("only %1 of the points of shape %2 are assigned to one shape with %3 downsampling")
+                                               .arg(overlap).arg(i).arg(names[m])));
+        }
+
+        for(size_t j = 0; j < shapes.size(); j++){
+            if(shapes[j].size() < minShapeSize){
+                continue;
+            }
+            double overlap = 0.0;
+            for(size_t i = 0; i < reference.size(); i++){
+                overlap = qMax(overlap, getOverlap(shapes[j], reference[i]));
+            }
+            QVERIFY2(overlap > 0.75, qPrintable(QString("only %1 of the points of shape %2 with %3 downsampling belong to one shape without it")
+                                                .arg(overlap).arg(j).arg(names[m])));
+        }
+    }
+}
+
+void PointCloudSegmentationTest::testTiledSegmentation_stitchShapes()
+{
+    PS_InputParameter param;
+    param.leafSize = 100;
+    param.outlierPercentage = 0.5;
+    param.fitSampleSize = 50;
+    param.finalFit = true;
+    param.randomSeed = 3;
+    param.numThreads = 1;
+    param.linearOctree = false;
+    param.timeBudget = 0.0;
+    param.streamShapes = false;
+    param.downsampling = eNoDownsampling;
+    param.voxelSize = 0.0;
+    param.samplingRate = 0.1;
+    const float maxDistance = 0.002f;
+    param.planeParams.detectPlanes = true;
+    param.planeParams.minPoints = 500;
+    param.planeParams.maxDistance = maxDistance;
+    param.sphereParams.detectSpheres = true;
+    param.sphereParams.minPoints = 500;
+    param.sphereParams.maxDistance = maxDistance;
+    param.sphereParams.minRadius = 0.05f;
+    param.sphereParams.maxRadius = 1.0f;
+    param.cylinderParams.detectCylinders = true;
+    param.cylinderParams.minPoints = 500;
+    param.cylinderParams.maxDistance = maxDistance;
+    param.cylinderParams.minRadius = 0.05f;
+    param.cylinderParams.maxRadius = 1.0f;
+
+    // a floor and a pipe above it that both reach through the whole cloud along x
+    PS_PointStore store;
+    PS_Random random(1);
+    const double floor[3] = {0.0, 0.0, 0.0}, u[3] = {4.0, 0.0, 0.0}, v[3] = {0.0, 2.0, 0.0};
+    addPlanePiece(store, random, floor, u, v, 24000);
+    const double pipe[3] = {0.0, 1.0, 0.5}, xAxis[3] = {1.0, 0.0, 0.0};
+    addCylinderPiece(store, random, pipe, xAxis, 0.2, 0.0, 4.0, 12000);
+
+    QByteArray data;
+    for(quint32 i = 0; i < store.size(); i++){
+        data.append(QString("%1 %2 %3\n").arg(store.getX(i), 0, 'g', 9).arg(store.getY(i), 0, 'g', 9).arg(store.getZ(i), 0, 'g', 9).toLatin1());
+    }
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/shapes.xyz";
+    QVERIFY(writeFile(fileName, data));
+
+    // the memory budget only allows a third of the points per tile, so both shapes are cut at the tile borders
+    PS_TiledSegmentation tiled;
+    tiled.setMemoryBudget(12000 * 64);
+    QVERIFY(tiled.segment(fileName, param));
+    QVERIFY2(tiled.getTileCount() > 1, qPrintable(QString("%1 tiles").arg(tiled.getTileCount())));
+
+    // the parts of the tiles are stitched to one plane and one cylinder that cover the whole length
+    QVERIFY2(tiled.getDetectedPlanes().size() == 1, qPrintable(QString("%1 planes").arg(tiled.getDetectedPlanes().size())));
+    QVERIFY2(tiled.getDetectedCylinders().size() == 1, qPrintable(QString("%1 cylinders").arg(tiled.getDetectedCylinders().size())));
+
+    PS_PlaneSegment *plane = tiled.getDetectedPlanes().first();
+    QVERIFY2(qAbs(plane->getIJK()[2]) > 0.999f && qAbs(plane->getDistance()) < maxDistance,
+             qPrintable(QString("plane (%1, %2, %3), %4").arg(plane->getIJK()[0]).arg(plane->getIJK()[1]).arg(plane->getIJK()[2])
+                        .arg(plane->getDistance())));
+    PS_CylinderSegment *cylinder = tiled.getDetectedCylinders().first();
+    float ijk[3];
+    cylinder->getIJK(ijk);
+    QVERIFY2(qAbs(ijk[0]) > 0.999f && qAbs(cylinder->getRadius() - 0.2f) < maxDistance,
+             qPrintable(QString("cylinder (%1, %2, %3), radius %4").arg(ijk[0]).arg(ijk[1]).arg(ijk[2]).arg(cylinder->getRadius())));
+
+    PS_ShapeSegment *shapes[2] = {plane, cylinder};
+    for(int i = 0; i < 2; i++){
+        float minX = numeric_limits<float>::max(), maxX = -numeric_limits<float>::max();
+        const vector<quint32> &points = shapes[i]->getPoints();
+        for(size_t j = 0; j < points.size(); j++){
+            minX = qMin(minX, shapes[i]->getPointStore()->getX(points[j]));
+            maxX = qMax(maxX, shapes[i]->getPointStore()->getX(points[j]));
+        }
+        QVERIFY2(minX < 0.2f && maxX > 3.8f, qPrintable(QString("shape %1 only covers x = %2 until %3").arg(i).arg(minX).arg(maxX)));
+    }
+}
+
+void PointCloudSegmentationTest::testDetectShapes_stopEarly()
+{
+    PS_SceneParameter sceneParam;
+    sceneParam.numPoints = 200000;
+    PS_SyntheticScene scene(sceneParam);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/scene.xyz";
+    QVERIFY(scene.write(fileName));
+
+    PS_InputParameter param = getParameter(scene, sceneParam);
+    vector<vector<quint32> > shapes;
+    qint64 detectionTime = 0;
+    {
+        PS_PointCloud cloud;
+        cloud.setWriteOutput(false);
+        QVERIFY(cloud.loadPointCloud(fileName) && cloud.setUpOctree(param) && cloud.detectShapes(param));
+        shapes = getShapePoints(cloud);
+        detectionTime = cloud.getStageTimes().detect;
+    }
+    QVERIFY2(detectionTime >= 30, qPrintable(QString("the detection only takes %1 ms").arg(detectionTime)));
+
+    // the time budget stops the detection after a third of the time, the shapes found until then are kept
+    {
+        PS_InputParameter budgetParam = param;
+        budgetParam.timeBudget = detectionTime / 3000.0;
+        PS_PointCloud cloud;
+        cloud.setWriteOutput(false);
+        QVERIFY(cloud.loadPointCloud(fileName) && cloud.setUpOctree(budgetParam) && cloud.detectShapes(budgetParam));
+        QVERIFY2(cloud.getStageTimes().detect < 2 * detectionTime / 3, qPrintable(QString("detection stopped after %1 of %2 ms")
+                                                                                   .arg(cloud.getStageTimes().detect).arg(detectionTime)));
+        QString error = comparePartialShapes(getShapePoints(cloud), shapes);
+        QVERIFY2(error.isEmpty(), qPrintable(QString("time budget: %1").arg(error)));
+    }
+
+    // the same for a cancel request from another thread (the streamed shapes are kept without post-processing)
+    for(int stream = 0; stream < 2; stream++){
+        PS_InputParameter cancelParam = param;
+        cancelParam.streamShapes = (stream == 1);
+        PS_PointCloud cloud;
+        cloud.setWriteOutput(false);
+        QAtomicInt canceled(0);
+        cloud.setCancelFlag(&canceled);
+        QVERIFY(cloud.loadPointCloud(fileName) && cloud.setUpOctree(cancelParam));
+        QThreadPool pool;
+        pool.start(new CancelTask(&canceled, detectionTime / 3));
+        QVERIFY(cloud.detectShapes(cancelParam));
+        pool.waitForDone();
+        QVERIFY2(cloud.getStageTimes().detect < 2 * detectionTime / 3, qPrintable(QString("detection stopped after %1 of %2 ms")
+                                                                                   .arg(cloud.getStageTimes().detect).arg(detectionTime)));
+        QString error = comparePartialShapes(getShapePoints(cloud), shapes);
+        QVERIFY2(error.isEmpty(), qPrintable(QString("cancel%1: %2").arg(stream == 1 ? " (streamed)" : "").arg(error)));
+        cloud.setCancelFlag(NULL);
+    }
+}
+
+QTEST_APPLESS_MAIN(PointCloudSegmentationTest)
+
+#include "tst_pointcloudsegmentation.moc"
@@ -0,0 +1,286 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QtMath>
+
+#include "ps_pointcloud.h"
+#include "ps_tiledsegmentation.h"
+#include "ps_planesegment.h"
+#include "ps_spheresegment.h"
+#include "ps_cylindersegment.h"
+
+#include "ps_syntheticscene.h"
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/*
+ * Benchmark of the point cloud segmentation.
+ * A synthetic scene with known planes, spheres and cylinders is written to an XYZ file and segmented
+ * (load -> octree -> detect -> review -> merge -> verify -> final sort out and fit). The time of each stage,
+ * the peak memory, the throughput and the precision and recall of the detected shapes are written as JSON.
+ */
+
+//! \brief Returns the peak resident memory of the process in bytes
+static qint64 getPeakMemory(){
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))){
+        return (qint64)counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+#ifdef Q_OS_MAC
+    return (qint64)usage.ru_maxrss;
+#else
+    return (qint64)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+//! \brief Returns the detection result as JSON object
+static QJsonObject toJson(const PS_DetectionResult &result){
+    QJsonObject object;
+    object.insert("truth", result.numTruth);
+    object.insert("detected", result.numDetected);
+    object.insert("matched", result.numMatched);
+    object.insert("precision", result.getPrecision());
+    object.insert("recall", result.getRecall());
+    return object;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("segmentationbenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark of the point cloud segmentation on synthetic scenes");
+    parser.addHelpOption();
+    QCommandLineOption pointsOption("points", "Number of points of the scene (default 1000000).", "n", "1000000");
+    QCommandLineOption noiseOption("noise", "Standard deviation of the points in m (default 0.001).", "sigma", "0.001");
+    QCommandLineOption outliersOption("outliers", "Fraction of uniformly distributed outliers (default 0.05).", "rate", "0.05");
+    QCommandLineOption planesOption("planes", "Number of planes, at most 4 (default 4).", "n", "4");
+    QCommandLineOption spheresOption("spheres", "Number of spheres (default 4).", "n", "4");
+    QCommandLineOption cylindersOption("cylinders", "Number of cylinders (default 4).", "n", "4");
+    QCommandLineOption sizeOption("size", "Edge length of the scene in m (default 10).", "m", "10");
+    QCommandLineOption seedOption("seed", "Seed of the scene and of the segmentation (default 1).", "seed", "1");
+    QCommandLineOption threadsOption("threads", "Number of threads, 0 = all cores (default 0).", "n", "0");
+    QCommandLineOption leafSizeOption("leaf-size", "Maximum number of points per octree leaf (default 100).", "n", "100");
+    QCommandLineOption downsamplingOption("downsampling", "Reduce the scene before the detection: none, voxel or random (default none).", "method", "none");
+    QCommandLineOption voxelSizeOption("voxel-size", "Edge length of the downsampling voxels in m, 0 = three times the mean point distance (default 0).", "m", "0");
+    QCommandLineOption samplingRateOption("sampling-rate", "Fraction of the points kept by the random downsampling (default 0.1).", "rate", "0.1");
+    QCommandLineOption budgetOption("memory-budget", "Segment the scene out-of-core in tiles of at most this many MB.", "mb", "0");
+    QCommandLineOption fileOption("file", "Keep the scene in this XYZ file (it is reused if it exists).", "file");
+    QCommandLineOption outputOption("output", "Write the results to this JSON file instead of stdout.", "file");
+    QCommandLineOption verboseOption("verbose", "Print the status messages of the segmentation.");
+    parser.addOptions(QList<QCommandLineOption>() << pointsOption << noiseOption << outliersOption << planesOption << spheresOption
+                      << cylindersOption << sizeOption << seedOption << threadsOption << leafSizeOption << downsamplingOption
+                      << voxelSizeOption << samplingRateOption << budgetOption << fileOption << outputOption << verboseOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    //set up the scene
+    PS_SceneParameter sceneParam;
+    sceneParam.numPoints = parser.value(pointsOption).toULongLong();
+    sceneParam.noise = parser.value(noiseOption).toDouble();
+    sceneParam.outlierRate = parser.value(outliersOption).toDouble();
+    sceneParam.numPlanes = qBound(0, parser.value(planesOption).toInt(), 4);
+    sceneParam.numSpheres = parser.value(spheresOption).toInt();
+    sceneParam.numCylinders = parser.value(cylindersOption).toInt();
+    sceneParam.size = parser.value(sizeOption).toDouble();
+    sceneParam.seed = parser.value(seedOption).toULongLong();
+    PS_SyntheticScene scene(sceneParam);
+
+    //write the points to a temporary file (or to the given file if it does not exist yet)
+    QTemporaryDir tempDir;
+    QString fileName = parser.isSet(fileOption) ? parser.value(fileOption) : tempDir.path() + "/scene.xyz";
+    QElapsedTimer timer;
+    timer.start();
+    qint64 generateTime = 0;
+    if(!parser.isSet(fileOption) || !QFile::exists(fileName)){
+        if(!scene.write(fileName)){
+            err << "could not write the scene to " << fileName << endl;
+            return 1;
+        }
+        generateTime = timer.elapsed();
+    }
+
+    //segmentation parameters derived from the scene
+    PS_InputParameter param;
+    param.leafSize = parser.value(leafSizeOption).toUInt();
+    param.outlierPercentage = 0.5;
+    param.fitSampleSize = 50;
+    param.finalFit = true;
+    param.randomSeed = sceneParam.seed;
+    param.numThreads = parser.value(threadsOption).toInt();
+    param.linearOctree = true;
+    param.timeBudget = 0.0;
+    param.streamShapes = false;
+    param.downsampling = eNoDownsampling;
+    if(parser.value(downsamplingOption) == "voxel"){
+        param.downsampling = eVoxelGridDownsampling;
+    }else if(parser.value(downsamplingOption) == "random"){
+        param.downsampling = eRandomDownsampling;
+    }
+    param.voxelSize = parser.value(voxelSizeOption).toFloat();
+    if(param.voxelSize <= 0.0f){
+        param.voxelSize = 3.0 / qSqrt(scene.getDensity());
+    }
+    param.samplingRate = parser.value(samplingRateOption).toFloat();
+
+    float maxDistance = qMax(3.0 * sceneParam.noise, 0.0005 * sceneParam.size);
+    unsigned int minPoints = (unsigned int)qMax(50.0, 0.2 * scene.getDensity() * scene.getMinArea());
+    param.planeParams.detectPlanes = true;
+    param.planeParams.minPoints = minPoints;
+    param.planeParams.maxDistance = maxDistance;
+    param.sphereParams.detectSpheres = true;
+    param.sphereParams.minPoints = minPoints;
+    param.sphereParams.maxDistance = maxDistance;
+    param.sphereParams.minRadius = 0.5 * scene.getMinRadius();
+    param.sphereParams.maxRadius = 1.5 * scene.getMaxRadius();
+    param.cylinderParams.detectCylinders = true;
+    param.cylinderParams.minPoints = minPoints;
+    param.cylinderParams.maxDistance = maxDistance;
+    param.cylinderParams.minRadius = 0.5 * scene.getMinRadius();
+    param.cylinderParams.maxRadius = 1.5 * scene.getMaxRadius();
+
+    QJsonObject stages;
+    QJsonObject counters;
+    PS_DetectionResult planes, spheres, cylinders;
+    qint64 totalTime = 0;
+    int numTiles = 0;
+
+    quint64 memoryBudget = parser.value(budgetOption).toULongLong() << 20;
+    if(memoryBudget == 0){
+
+        PS_PointCloud cloud;
+        cloud.setWriteOutput(false);
+        if(parser.isSet(verboseOption)){
+            QObject::connect(&cloud, &PS_PointCloud::updateStatus, [&err](QString msg, int){ err << msg << endl; });
+        }
+
+        if(!cloud.loadPointCloud(fileName) || !cloud.setUpOctree(param) || !cloud.detectShapes(param)){
+            err << "segmentation failed" << endl;
+            return 1;
+        }
+
+        const PS_StageTimes &times = cloud.getStageTimes();
+        stages.insert("load_ms", times.load);
+        stages.insert("octree_ms", times.octree);
+        stages.insert("detect_ms", times.detect);
+        stages.insert("review_ms", times.review);
+        stages.insert("merge_ms", times.merge);
+        stages.insert("verify_ms", times.verify);
+        stages.insert("sort_out_ms", times.sortOut);
+        stages.insert("assign_ms", times.assign);
+        stages.insert("final_fit_ms", times.finalFit);
+        totalTime = times.load + times.getSegmentationTime();
+
+        //counters and timers of the detection (only if the segmentation was built with PS_WITH_INSTRUMENTATION)
+        if(PS_Instrumentation::isEnabled()){
+            const PS_Statistics &statistics = cloud.getStatistics();
+            for(int i = 0; i < PS_Instrumentation::eNumCounters; i++){
+                counters.insert(PS_Instrumentation::getName((PS_Instrumentation::Counter)i), (double)statistics.counters[i]);
+            }
+            for(int i = 0; i < PS_Instrumentation::eNumTimers; i++){
+                counters.insert(QString("%1_ms").arg(PS_Instrumentation::getName((PS_Instrumentation::Timer)i)),
+                                statistics.getTime((PS_Instrumentation::Timer)i));
+            }
+        }
+
+        planes = scene.evaluate(cloud.getDetectedPlanes());
+        spheres = scene.evaluate(cloud.getDetectedSpheres());
+        cylinders = scene.evaluate(cloud.getDetectedCylinders());
+
+    }else{
+
+        PS_TiledSegmentation tiled;
+        tiled.setMemoryBudget(memoryBudget);
+        if(parser.isSet(verboseOption)){
+            QObject::connect(&tiled, &PS_TiledSegmentation::updateStatus, [&err](QString msg, int){ err << msg << endl; });
+        }
+
+        timer.restart();
+        if(!tiled.segment(fileName, param)){
+            err << "segmentation failed" << endl;
+            return 1;
+        }
+        totalTime = timer.elapsed();
+        numTiles = tiled.getTileCount();
+        stages.insert("tiled_ms", totalTime);
+
+        planes = scene.evaluate(tiled.getDetectedPlanes());
+        spheres = scene.evaluate(tiled.getDetectedSpheres());
+        cylinders = scene.evaluate(tiled.getDetectedCylinders());
+
+    }
+
+    //collect the results
+    QJsonObject sceneObject;
+    sceneObject.insert("points", (double)sceneParam.numPoints);
+    sceneObject.insert("noise", sceneParam.noise);
+    sceneObject.insert("outliers", sceneParam.outlierRate);
+    sceneObject.insert("size", sceneParam.size);
+    sceneObject.insert("seed", (double)sceneParam.seed);
+    sceneObject.insert("generate_ms", generateTime);
+
+    QJsonObject parameterObject;
+    parameterObject.insert("threads", param.numThreads > 0 ? param.numThreads : QThread::idealThreadCount());
+    parameterObject.insert("leaf_size", (int)param.leafSize);
+    parameterObject.insert("min_points", (int)minPoints);
+    parameterObject.insert("max_distance", maxDistance);
+    parameterObject.insert("downsampling", parser.value(downsamplingOption));
+    parameterObject.insert("voxel_size", param.voxelSize);
+    parameterObject.insert("sampling_rate", param.samplingRate);
+    parameterObject.insert("memory_budget", (double)memoryBudget);
+    parameterObject.insert("tiles", numTiles);
+
+    QJsonObject detectionObject;
+    detectionObject.insert("planes", toJson(planes));
+    detectionObject.insert("spheres", toJson(spheres));
+    detectionObject.insert("cylinders", toJson(cylinders));
+
+    QJsonObject result;
+    result.insert("scene", sceneObject);
+    result.insert("parameter", parameterObject);
+    result.insert("stages", stages);
+    if(!counters.isEmpty()){
+        result.insert("counters", counters);
+    }
+    result.insert("total_ms", totalTime);
+    result.insert("peak_memory_bytes", (double)getPeakMemory());
+    result.insert("points_per_second", totalTime > 0 ? sceneParam.numPoints * 1000.0 / totalTime : 0.0);
+    result.insert("detection", detectionObject);
+
+    QByteArray json = QJsonDocument(result).toJson();
+    if(parser.isSet(outputOption)){
+        QFile file(parser.value(outputOption));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()){
+            err << "could not write the results to " << parser.value(outputOption) << endl;
+            return 1;
+        }
+    }else{
+        QTextStream(stdout) << json;
+    }
+
+    return 0;
+}
@@ -0,0 +1,516 @@
+#include "ps_syntheticscene.h"
+
+#include <QFile>
+#include <QByteArray>
+#include <QtMath>
+#include <vector>
+
+#include "ps_planesegment.h"
+#include "ps_spheresegment.h"
+#include "ps_cylindersegment.h"
+
+using namespace std;
+
+namespace{
+
+//! \brief Normalizes v to length 1
+inline void normalize(double (&v)[3]){
+    const double length = qSqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    for(int i = 0; i < 3; i++){
+        v[i] /= length;
+    }
+}
+
+//! \brief Returns the scalar product of a and b
+template<class A, class B>
+inline double dot(const A &a, const B &b){
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//! \brief Returns the distance of the point p from the line through x0 with the unit direction n
+inline double distanceToLine(const double (&p)[3], const double (&x0)[3], const double (&n)[3]){
+    const double d[3] = {p[0] - x0[0], p[1] - x0[1], p[2] - x0[2]};
+    const double t = dot(d, n);
+    return qSqrt(qMax(dot(d, d) - t * t, 0.0));
+}
+
+}
+
+/*!
+ * \brief PS_SyntheticScene::PS_SyntheticScene
+ * Sets up the shapes of the scene (the points are generated in write)
+ * \param param
+ */
+PS_SyntheticScene::PS_SyntheticScene(const PS_SceneParameter &param) : param(param)
+{
+    const double size = this->param.size;
+    this->height = 0.3 * size;
+
+    //the shape parameters are drawn from another stream than the points
+    PS_Random generator(PS_Random::deriveSeed(this->param.seed, 0));
+
+    //floor, walls and a ramp that rises by 30 degrees along x
+    const double o[3] = {0.0, 0.0, 0.0}, ex[3] = {1.0, 0.0, 0.0}, ey[3] = {0.0, 1.0, 0.0}, ez[3] = {0.0, 0.0, 1.0};
+    const double rampOrigin[3] = {0.88 * size, 0.1 * size, 0.0};
+    const double rampV[3] = {qCos(M_PI / 6.0), 0.0, qSin(M_PI / 6.0)};
+    if(this->param.numPlanes > 0){
+        this->addPlane(o, ex, ey, size, size);
+    }
+    if(this->param.numPlanes > 1){
+        this->addPlane(o, ey, ez, size, this->height);
+    }
+    if(this->param.numPlanes > 2){
+        this->addPlane(o, ex, ez, size, this->height);
+    }
+    if(this->param.numPlanes > 3){
+        this->addPlane(rampOrigin, ey, rampV, 0.8 * size, 0.1 * size / rampV[0]);
+    }
+
+    //the spheres and cylinders stand alternately on a grid in front of the walls
+    int numObjects = this->param.numSpheres + this->param.numCylinders;
+    if(numObjects == 0){
+        return;
+    }
+    int numColumns = qCeil(qSqrt((double)numObjects));
+    int numRows = (numObjects + numColumns - 1) / numColumns;
+    double cell = qMin(0.73 * size / numColumns, 0.76 * size / numRows);
+
+    int numSpheres = 0, numCylinders = 0;
+    for(int k = 0; k < numObjects; k++){
+
+        double center[3] = {0.12 * size + (k % numColumns + 0.5) * cell, 0.12 * size + (k / numColumns + 0.5) * cell, 0.0};
+
+        if(numCylinders >= this->param.numCylinders || (k % 2 == 0 && numSpheres < this->param.numSpheres)){
+
+            PS_SyntheticSphere sphere;
+            sphere.radius = cell * (0.15 + 0.15 * PS_SyntheticScene::nextUniform(generator));
+            sphere.center[0] = center[0];
+            sphere.center[1] = center[1];
+            sphere.center[2] = sphere.radius + 0.1 * cell;
+            this->spheres.append(sphere);
+            numSpheres++;
+
+        }else{
+
+            //the axis is tilted by up to 30 degrees, so that the cylinder stays within its cell and above the floor
+            PS_SyntheticCylinder cylinder;
+            cylinder.radius = cell * (0.08 + 0.07 * PS_SyntheticScene::nextUniform(generator));
+            cylinder.height = cell * (0.4 + 0.2 * PS_SyntheticScene::nextUniform(generator));
+            double tilt = M_PI / 6.0 * PS_SyntheticScene::nextUniform(generator);
+            double azimuth = 2.0 * M_PI * PS_SyntheticScene::nextUniform(generator);
+            cylinder.axis[0] = qSin(tilt) * qCos(azimuth);
+            cylinder.axis[1] = qSin(tilt) * qSin(azimuth);
+            cylinder.axis[2] = qCos(tilt);
+            cylinder.center[0] = center[0];
+            cylinder.center[1] = center[1];
+            cylinder.center[2] = 0.5 * cell;
+            this->cylinders.append(cylinder);
+            numCylinders++;
+
+        }
+
+    }
+}
+
+/*!
+ * \brief PS_SyntheticScene::write
+ * Generates the points of the scene and writes them to an XYZ file (one point per line)
+ * \param fileName
+ * \return
+ */
+bool PS_SyntheticScene::write(const QString &fileName) const{
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+
+    PS_Random generator(PS_Random::deriveSeed(this->param.seed, 1));
+
+    //distribute the inliers over the shapes proportional to their area
+    int numShapes = this->planes.size() + this->spheres.size() + this->cylinders.size();
+    quint64 numOutliers = (quint64)qRound64(this->param.outlierRate * this->param.numPoints);
+    quint64 numInliers = this->param.numPoints - numOutliers;
+    double totalArea = 0.0;
+    for(int i = 0; i < numShapes; i++){
+        totalArea += this->getArea(i);
+    }
+    vector<quint64> numShapePoints(numShapes, 0);
+    quint64 numAssigned = 0;
+    for(int i = 0; i < numShapes; i++){
+        numShapePoints[i] = (quint64)(numInliers * this->getArea(i) / totalArea);
+        numAssigned += numShapePoints[i];
+    }
+    if(numShapes > 0){
+        numShapePoints[0] += numInliers - numAssigned;
+    }else{
+        numOutliers = this->param.numPoints;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(1 << 20);
+    char line[128];
+    const double noise = this->param.noise;
+
+    for(int i = 0; i <= numShapes; i++){
+
+        quint64 count = (i < numShapes) ? numShapePoints[i] : numOutliers;
+
+        for(quint64 k = 0; k < count; k++){
+
+            double p[3];
+
+            if(i < this->planes.size()){
+
+                const PS_SyntheticPlane &plane = this->planes.at(i);
+                double s = plane.sizeU * PS_SyntheticScene::nextUniform(generator);
+                double t = plane.sizeV * PS_SyntheticScene::nextUniform(generator);
+                double e = noise * PS_SyntheticScene::nextGaussian(generator);
+                for(int j = 0; j < 3; j++){
+                    p[j] = plane.origin[j] + s * plane.u[j] + t * plane.v[j] + e * plane.normal[j];
+                }
+
+            }else if(i < this->planes.size() + this->spheres.size()){
+
+                const PS_SyntheticSphere &sphere = this->spheres.at(i - this->planes.size());
+                double d[3] = {PS_SyntheticScene::nextGaussian(generator), PS_SyntheticScene::nextGaussian(generator),
+                               PS_SyntheticScene::nextGaussian(generator)};
+                normalize(d);
+                double r = sphere.radius + noise * PS_SyntheticScene::nextGaussian(generator);
+                for(int j = 0; j < 3; j++){
+                    p[j] = sphere.center[j] + r * d[j];
+                }
+
+            }else if(i < numShapes){
+
+                const PS_SyntheticCylinder &cylinder = this->cylinders.at(i - this->planes.size() - this->spheres.size());
+
+                //two unit vectors perpendicular to the axis
+                double e1[3] = {0.0, 0.0, 0.0};
+                e1[(qAbs(cylinder.axis[2]) < 0.9) ? 2 : 0] = 1.0;
+                double e2[3] = {cylinder.axis[1] * e1[2] - cylinder.axis[2] * e1[1],
+                                cylinder.axis[2] * e1[0] - cylinder.axis[0] * e1[2],
+                                cylinder.axis[0] * e1[1] - cylinder.axis[1] * e1[0]};
+                normalize(e2);
+                e1[0] = e2[1] * cylinder.axis[2] - e2[2] * cylinder.axis[1];
+                e1[1] = e2[2] * cylinder.axis[0] - e2[0] * cylinder.axis[2];
+                e1[2] = e2[0] * cylinder.axis[1] - e2[1] * cylinder.axis[0];
+
+                double a = 2.0 * M_PI * PS_SyntheticScene::nextUniform(generator);
+                double t = cylinder.height * (PS_SyntheticScene::nextUniform(generator) - 0.5);
+                double r = cylinder.radius + noise * PS_SyntheticScene::nextGaussian(generator);
+                for(int j = 0; j < 3; j++){
+                    p[j] = cylinder.center[j] + t * cylinder.axis[j] + r * (qCos(a) * e1[j] + qSin(a) * e2[j]);
+                }
+
+            }else{
+
+                p[0] = this->param.size * PS_SyntheticScene::nextUniform(generator);
+                p[1] = this->param.size * PS_SyntheticScene::nextUniform(generator);
+                p[2] = this->height * PS_SyntheticScene::nextUniform(generator);
+
+            }
+
+            int length = qsnprintf(line, sizeof(line), "%.5f %.5f %.5f\n", p[0], p[1], p[2]);
+            buffer.append(line, length);
+            if(buffer.size() >= (1 << 20) - (int)sizeof(line)){
+                if(file.write(buffer) != buffer.size()){
+                    return false;
+                }
+                buffer.clear();
+            }
+
+        }
+
+    }
+
+    if(file.write(buffer) != buffer.size()){
+        return false;
+    }
+    file.close();
+    return true;
+
+}
+
+/*!
+ * \brief PS_SyntheticScene::evaluate
+ * Matches the detected planes with the planes of the scene (same orientation within 2 degrees and
+ * the center of the patch within the tolerance from the detected plane). Each plane is matched at most once.
+ * \param planes
+ * \return
+ */
+PS_DetectionResult PS_SyntheticScene::evaluate(const QList<PS_PlaneSegment *> &planes) const{
+
+    PS_DetectionResult result;
+    result.numTruth = this->planes.size();
+    result.numDetected = planes.size();
+
+    const double minCosine = qCos(qDegreesToRadians(2.0));
+    const double tolerance = this->getMatchTolerance(0.0);
+
+    vector<bool> matched(planes.size(), false);
+    foreach(const PS_SyntheticPlane &truth, this->planes){
+
+        double center[3];
+        for(int j = 0; j < 3; j++){
+            center[j] = truth.origin[j] + 0.5 * truth.sizeU * truth.u[j] + 0.5 * truth.sizeV * truth.v[j];
+        }
+
+        int best = -1;
+        double bestDistance = tolerance;
+        for(int i = 0; i < planes.size(); i++){
+            const float *ijk = planes.at(i)->getIJK();
+            if(matched[i] || qAbs(dot(ijk, truth.normal)) < minCosine){
+                continue;
+            }
+            double distance = qAbs(dot(ijk, center) - planes.at(i)->getDistance());
+            if(distance < bestDistance){
+                best = i;
+                bestDistance = distance;
+            }
+        }
+
+        if(best >= 0){
+            matched[best] = true;
+            result.numMatched++;
+        }
+
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_SyntheticScene::evaluate
+ * Matches the detected spheres with the spheres of the scene (center and radius within the tolerance).
+ * Each sphere is matched at most once.
+ * \param spheres
+ * \return
+ */
+PS_DetectionResult PS_SyntheticScene::evaluate(const QList<PS_SphereSegment *> &spheres) const{
+
+    PS_DetectionResult result;
+    result.numTruth = this->spheres.size();
+    result.numDetected = spheres.size();
+
+    vector<bool> matched(spheres.size(), false);
+    foreach(const PS_SyntheticSphere &truth, this->spheres){
+
+        const double tolerance = this->getMatchTolerance(truth.radius);
+
+        int best = -1;
+        double bestDistance = tolerance;
+        for(int i = 0; i < spheres.size(); i++){
+            if(matched[i] || qAbs(spheres.at(i)->getRadius() - truth.radius) > tolerance){
+                continue;
+            }
+            const float *xyz = spheres.at(i)->getXYZ();
+            const double d[3] = {xyz[0] - truth.center[0], xyz[1] - truth.center[1], xyz[2] - truth.center[2]};
+            double distance = qSqrt(dot(d, d));
+            if(distance < bestDistance){
+                best = i;
+                bestDistance = distance;
+            }
+        }
+
+        if(best >= 0){
+            matched[best] = true;
+            result.numMatched++;
+        }
+
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_SyntheticScene::evaluate
+ * Matches the detected cylinders with the cylinders of the scene (axis within 3 degrees, center of the cylinder
+ * near the detected axis and radius within the tolerance). Each cylinder is matched at most once.
+ * \param cylinders
+ * \return
+ */
+PS_DetectionResult PS_SyntheticScene::evaluate(const QList<PS_CylinderSegment *> &cylinders) const{
+
+    PS_DetectionResult result;
+    result.numTruth = this->cylinders.size();
+    result.numDetected = cylinders.size();
+
+    const double minCosine = qCos(qDegreesToRadians(3.0));
+
+    vector<bool> matched(cylinders.size(), false);
+    foreach(const PS_SyntheticCylinder &truth, this->cylinders){
+
+        const double tolerance = this->getMatchTolerance(truth.radius);
+
+        int best = -1;
+        double bestDistance = tolerance;
+        for(int i = 0; i < cylinders.size(); i++){
+            if(matched[i] || qAbs(cylinders.at(i)->getRadius() - truth.radius) > tolerance){
+                continue;
+            }
+            float x0[3], ijk[3];
+            cylinders.at(i)->getX0(x0);
+            cylinders.at(i)->getIJK(ijk);
+            if(qAbs(dot(ijk, truth.axis)) < minCosine){
+                continue;
+            }
+            const double axisX0[3] = {x0[0], x0[1], x0[2]};
+            double axisN0[3] = {ijk[0], ijk[1], ijk[2]};
+            normalize(axisN0);
+            double distance = distanceToLine(truth.center, axisX0, axisN0);
+            if(distance < bestDistance){
+                best = i;
+                bestDistance = distance;
+            }
+        }
+
+        if(best >= 0){
+            matched[best] = true;
+            result.numMatched++;
+        }
+
+    }
+
+    return result;
+
+}
+
+/*!
+ * \brief PS_SyntheticScene::getDensity
+ * Returns the number of inliers per square meter of shape surface
+ * \return
+ */
+double PS_SyntheticScene::getDensity() const{
+    double totalArea = 0.0;
+    int numShapes = this->planes.size() + this->spheres.size() + this->cylinders.size();
+    for(int i = 0; i < numShapes; i++){
+        totalArea += this->getArea(i);
+    }
+    return totalArea > 0.0 ? (1.0 - this->param.outlierRate) * this->param.numPoints / totalArea : 0.0;
+}
+
+/*!
+ * \brief PS_SyntheticScene::getMinRadius
+ * Returns the smallest radius of all spheres and cylinders
+ * \return
+ */
+double PS_SyntheticScene::getMinRadius() const{
+    double result = this->param.size;
+    foreach(const PS_SyntheticSphere &sphere, this->spheres){
+        result = qMin(result, sphere.radius);
+    }
+    foreach(const PS_SyntheticCylinder &cylinder, this->cylinders){
+        result = qMin(result, cylinder.radius);
+    }
+    return result;
+}
+
+/*!
+ * \brief PS_SyntheticScene::getMaxRadius
+ * Returns the largest radius of all spheres and cylinders
+ * \return
+ */
+double PS_SyntheticScene::getMaxRadius() const{
+    double result = 0.0;
+    foreach(const PS_SyntheticSphere &sphere, this->spheres){
+        result = qMax(result, sphere.radius);
+    }
+    foreach(const PS_SyntheticCylinder &cylinder, this->cylinders){
+        result = qMax(result, cylinder.radius);
+    }
+    return result;
+}
+
+/*!
+ * \brief PS_SyntheticScene::getMinArea
+ * Returns the area of the smallest shape
+ * \return
+ */
+double PS_SyntheticScene::getMinArea() const{
+    double result = 0.0;
+    int numShapes = this->planes.size() + this->spheres.size() + this->cylinders.size();
+    for(int i = 0; i < numShapes; i++){
+        result = (i == 0) ? this->getArea(i) : qMin(result, this->getArea(i));
+    }
+    return result;
+}
+
+/*!
+ * \brief PS_SyntheticScene::addPlane
+ * Adds the plane patch origin + s * u + t * v
+ * \param origin
+ * \param u
+ * \param v
+ * \param sizeU
+ * \param sizeV
+ */
+void PS_SyntheticScene::addPlane(const double (&origin)[3], const double (&u)[3], const double (&v)[3], const double &sizeU, const double &sizeV){
+
+    PS_SyntheticPlane plane;
+    for(int j = 0; j < 3; j++){
+        plane.origin[j] = origin[j];
+        plane.u[j] = u[j];
+        plane.v[j] = v[j];
+    }
+    plane.normal[0] = u[1] * v[2] - u[2] * v[1];
+    plane.normal[1] = u[2] * v[0] - u[0] * v[2];
+    plane.normal[2] = u[0] * v[1] - u[1] * v[0];
+    normalize(plane.normal);
+    plane.sizeU = sizeU;
+    plane.sizeV = sizeV;
+
+    this->planes.append(plane);
+
+}
+
+/*!
+ * \brief PS_SyntheticScene::getArea
+ * Returns the area of the shape with the given index (planes, then spheres, then cylinders)
+ * \param shape
+ * \return
+ */
+double PS_SyntheticScene::getArea(const int &shape) const{
+    if(shape < this->planes.size()){
+        return this->planes.at(shape).sizeU * this->planes.at(shape).sizeV;
+    }else if(shape < this->planes.size() + this->spheres.size()){
+        double r = this->spheres.at(shape - this->planes.size()).radius;
+        return 4.0 * M_PI * r * r;
+    }
+    const PS_SyntheticCylinder &cylinder = this->cylinders.at(shape - this->planes.size() - this->spheres.size());
+    return 2.0 * M_PI * cylinder.radius * cylinder.height;
+}
+
+/*!
+ * \brief PS_SyntheticScene::getMatchTolerance
+ * Returns the maximum deviation of a detected shape from a shape of the scene with the given radius (0 for planes)
+ * \param radius
+ * \return
+ */
+double PS_SyntheticScene::getMatchTolerance(const double &radius) const{
+    return qMax(5.0 * this->param.noise, 0.001 * this->param.size) + 0.05 * radius;
+}
+
+/*!
+ * \brief PS_SyntheticScene::nextUniform
+ * Returns a uniformly distributed random number in [0, 1)
+ * \param generator
+ * \return
+ */
+double PS_SyntheticScene::nextUniform(PS_Random &generator){
+    return (generator.next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*!
+ * \brief PS_SyntheticScene::nextGaussian
+ * Returns a standard normal distributed random number (Box-Muller)
+ * \param generator
+ * \return
+ */
+double PS_SyntheticScene::nextGaussian(PS_Random &generator){
+    double u1 = 1.0 - PS_SyntheticScene::nextUniform(generator);
+    double u2 = PS_SyntheticScene::nextUniform(generator);
+    return qSqrt(-2.0 * qLn(u1)) * qCos(2.0 * M_PI * u2);
+}
@@ -0,0 +1,128 @@
+#ifndef PS_SYNTHETICSCENE_H
+#define PS_SYNTHETICSCENE_H
+
+#include <QString>
+#include <QList>
+#include <QtGlobal>
+
+#include "ps_random.h"
+
+class PS_PlaneSegment;
+class PS_SphereSegment;
+class PS_CylinderSegment;
+
+//! parameters of a synthetic scene (lengths in m)
+struct PS_SceneParameter{
+    PS_SceneParameter() : numPoints(1000000), noise(0.001), outlierRate(0.05), numPlanes(4), numSpheres(4), numCylinders(4),
+        size(10.0), seed(1){}
+
+    quint64 numPoints; //number of points including the outliers
+    double noise; //standard deviation of the points perpendicular to the shape surfaces
+    double outlierRate; //fraction of points that are uniformly distributed in the bounding box of the scene
+    int numPlanes; //number of plane patches (floor, two walls and a ramp, at most 4)
+    int numSpheres; //number of spheres
+    int numCylinders; //number of cylinders
+    double size; //edge length of the floor
+    quint64 seed; //seed of the point generation
+};
+
+//! rectangular plane patch origin + s * u + t * v (0 <= s <= sizeU, 0 <= t <= sizeV)
+struct PS_SyntheticPlane{
+    double origin[3];
+    double u[3];
+    double v[3];
+    double normal[3];
+    double sizeU;
+    double sizeV;
+};
+
+//! full sphere
+struct PS_SyntheticSphere{
+    double center[3];
+    double radius;
+};
+
+//! cylinder with the axis center + t * axis (-height / 2 <= t <= height / 2)
+struct PS_SyntheticCylinder{
+    double center[3];
+    double axis[3];
+    double radius;
+    double height;
+};
+
+//! number of shapes of one type and how many of them match (see PS_SyntheticScene::evaluate)
+struct PS_DetectionResult{
+    PS_DetectionResult() : numTruth(0), numDetected(0), numMatched(0){}
+
+    //! \brief Returns the fraction of detected shapes that match a shape of the scene
+    inline double getPrecision() const{
+        return this->numDetected > 0 ? (double)this->numMatched / (double)this->numDetected : 1.0;
+    }
+
+    //! \brief Returns the fraction of shapes of the scene that were detected
+    inline double getRecall() const{
+        return this->numTruth > 0 ? (double)this->numMatched / (double)this->numTruth : 1.0;
+    }
+
+    int numTruth;
+    int numDetected;
+    int numMatched;
+};
+
+/*!
+ * \brief The PS_SyntheticScene class
+ * Synthetic point cloud with known planes, spheres and cylinders that is used to benchmark the segmentation.
+ * The scene consists of a floor, two walls and a ramp. The spheres and cylinders stand on a grid on the floor.
+ * The points are distributed over the shapes proportional to their area (same density on all shapes),
+ * disturbed by gaussian noise perpendicular to the surface and mixed with uniformly distributed outliers.
+ */
+class PS_SyntheticScene
+{
+public:
+    PS_SyntheticScene(const PS_SceneParameter &param);
+
+    bool write(const QString &fileName) const;
+
+    PS_DetectionResult evaluate(const QList<PS_PlaneSegment *> &planes) const;
+    PS_DetectionResult evaluate(const QList<PS_SphereSegment *> &spheres) const;
+    PS_DetectionResult evaluate(const QList<PS_CylinderSegment *> &cylinders) const;
+
+    double getDensity() const;
+    double getMinRadius() const;
+    double getMaxRadius() const;
+    double getMinArea() const;
+
+    //! \brief Returns the plane patches of the scene
+    inline const QList<PS_SyntheticPlane> &getPlanes() const{
+        return this->planes;
+    }
+
+    //! \brief Returns the spheres of the scene
+    inline const QList<PS_SyntheticSphere> &getSpheres() const{
+        return this->spheres;
+    }
+
+    //! \brief Returns the cylinders of the scene
+    inline const QList<PS_SyntheticCylinder> &getCylinders() const{
+        return this->cylinders;
+    }
+
+private:
+    void addPlane(const double (&origin)[3], const double (&u)[3], const double (&v)[3], const double &sizeU, const double &sizeV);
+
+    double getArea(const int &shape) const;
+    double getMatchTolerance(const double &radius) const;
+
+    static double nextUniform(PS_Random &generator);
+    static double nextGaussian(PS_Random &generator);
+
+    PS_SceneParameter param;
+    double height; //height of the walls
+
+    QList<PS_SyntheticPlane> planes;
+    QList<PS_SyntheticSphere> spheres;
+    QList<PS_SyntheticCylinder> cylinders;
+
+};
+
+#endif // PS_SYNTHETICSCENE_H
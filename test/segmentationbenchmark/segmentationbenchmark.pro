@@ -0,0 +1,79 @@
+#-------------------------------------------------
+#
+# Benchmark of the point cloud segmentation on synthetic scenes
+#
+#-------------------------------------------------
+CONFIG += c++11
+
+QT       += core gui widgets xml
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += \
+    main.cpp \
+    ps_syntheticscene.cpp \
+    ../../functions/fit/pointmoments.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_cylindersegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_distancekernels.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_downsampling.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_generalmath.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_instrumentation.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_linearoctree.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_mergeindex.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_node.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_octree.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_planesegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloud.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloudcache.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloudloader.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointstore.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_ransac.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_shapesegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_spheresegment.cpp \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_tiledsegmentation.cpp
+
+HEADERS += \
+    ps_syntheticscene.h \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_pointcloud.h \
+    ../../functions/generateFeature/pointcloud_segmentation/ps_tiledsegmentation.h
+
+INCLUDEPATH += \
+    ../../functions/fit \
+    ../../functions/generateFeature/pointcloud_segmentation
+
+include(../../build/dependencies.pri)
+
+# counters and timers of the segmentation (see ps_instrumentation.h), in release builds enabled with CONFIG+=ps_instrumentation
+CONFIG(debug, debug|release)|ps_instrumentation {
+    DEFINES += PS_WITH_INSTRUMENTATION
+}
+
+CONFIG(debug, debug|release) {
+    BUILD_DIR=debug
+} else {
+    BUILD_DIR=release
+}
+
+linux-g++ {
+LIBS += \
+    -L../../lib/OpenIndy-Core/lib/OpenIndy-Math/bin/$$BUILD_DIR -lopenIndyMath
+} else : win32 {
+LIBS += \
+    -L../../lib/OpenIndy-Core/lib/OpenIndy-Math/bin/$$BUILD_DIR -lopenIndyMath1 \
+    -lpsapi
+}
+
+# the benchmark is not part of run-test, it is started explicitly (results are written to ../reports)
+QMAKE_EXTRA_TARGETS += run-benchmark
+win32{
+run-benchmark.commands = \
+    $$shell_quote($$OUT_PWD/$$BUILD_DIR/$$TARGET) --points 1000000 --output $$shell_path(../reports/$${TARGET}_1M.json) & \
+    $$shell_quote($$OUT_PWD/$$BUILD_DIR/$$TARGET) --points 10000000 --output $$shell_path(../reports/$${TARGET}_10M.json)
+}else:linux{
+run-benchmark.commands = \
+    $$shell_quote($$OUT_PWD/$$TARGET) --points 1000000 --output $$shell_path(../reports/$${TARGET}_1M.json) ; \
+    $$shell_quote($$OUT_PWD/$$TARGET) --points 10000000 --output $$shell_path(../reports/$${TARGET}_10M.json)
+}
@@ -2,7 +2,9 @@ TEMPLATE = subdirs
 
 SUBDIRS = oiexchangeascii \
     function \
-    loadplugin
+    loadplugin \
+    pointcloudsegmentation \
+    segmentationbenchmark
 
 INSTALLS = 
 
@@ -14,17 +16,32 @@ run-test.commands = \
     if not exist reports mkdir reports & if not exist reports exit 1 $$escape_expand(\n\t)\
     cd $$shell_quote($$OUT_PWD/function) && $(MAKE) run-test & \
     cd $$shell_quote($$OUT_PWD/loadplugin) && $(MAKE) run-test & \
-    cd $$shell_quote($$OUT_PWD/oiexchangeascii) && $(MAKE) run-test
+    cd $$shell_quote($$OUT_PWD/oiexchangeascii) && $(MAKE) run-test & \
+    cd $$shell_quote($$OUT_PWD/pointcloudsegmentation) && $(MAKE) run-test
 } else:win32-g++ {
 run-test.commands = \
     [ -e "reports" ] || mkdir reports ; \
     $(MAKE) -C $$shell_quote($$OUT_PWD/function) run-test & \
     $(MAKE) -C $$shell_quote($$OUT_PWD/loadplugin) run-test & \
-    $(MAKE) -C $$shell_quote($$OUT_PWD/oiexchangeascii) run-test
+    $(MAKE) -C $$shell_quote($$OUT_PWD/oiexchangeascii) run-test & \
+    $(MAKE) -C $$shell_quote($$OUT_PWD/pointcloudsegmentation) run-test
 } else:linux {
 run-test.commands = \
     [ -e "reports" ] || mkdir reports ; \
     $(MAKE) -C oiexchangeascii run-test ; \
     $(MAKE) -C loadplugin run-test ; \
-    $(MAKE) -C function run-test
+    $(MAKE) -C function run-test ; \
+    $(MAKE) -C pointcloudsegmentation run-test
+}
+
+# segmentation benchmark (not part of run-test, see segmentationbenchmark/segmentationbenchmark.pro)
+QMAKE_EXTRA_TARGETS += run-benchmark
+win32 {
+run-benchmark.commands = \
+    if not exist reports mkdir reports & if not exist reports exit 1 $$escape_expand(\n\t)\
+    cd $$shell_quote($$OUT_PWD/segmentationbenchmark) && $(MAKE) run-benchmark
+} else:linux {
+run-benchmark.commands = \
+    [ -e "reports" ] || mkdir reports ; \
+    $(MAKE) -C segmentationbenchmark run-benchmark
 }